@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Byte-level helpers shared by the binary formats: the FNV-1a hash the texture and mesh caches
+// are keyed and validated with, little-endian u32 fields (region tables, GLB headers), and the
+// LEB128 varints with zigzag signed values that region chunks and input recordings are packed
+// with. Everything here is byte-order independent, so the files read the same on every platform.
+namespace vengine
+{
+    constexpr uint64_t kFnv1aOffsetBasis = 1469598103934665603ull;
+
+    // 64-bit FNV-1a. Pass the previous result as hash to continue over data read in pieces.
+    inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = kFnv1aOffsetBasis)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    inline void PutU32(unsigned char* out, uint32_t value)
+    {
+        out[0] = static_cast<unsigned char>(value);
+        out[1] = static_cast<unsigned char>(value >> 8);
+        out[2] = static_cast<unsigned char>(value >> 16);
+        out[3] = static_cast<unsigned char>(value >> 24);
+    }
+
+    inline uint32_t GetU32(const unsigned char* in)
+    {
+        return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) | (static_cast<uint32_t>(in[2]) << 16) |
+               (static_cast<uint32_t>(in[3]) << 24);
+    }
+
+    // Appends value seven bits at a time, low bits first; Buffer is any byte container with push_back.
+    template <typename Buffer>
+    void WriteVarint(Buffer& out, uint64_t value)
+    {
+        using Byte = typename Buffer::value_type;
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<Byte>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<Byte>(value));
+    }
+
+    // Zigzag keeps small negative values (mouse deltas, wheel steps, heights) down to one byte.
+    template <typename Buffer>
+    void WriteSigned(Buffer& out, int64_t value)
+    {
+        WriteVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    // Reads the fields above back out of a buffer it doesn't own. Every read fails, rather than
+    // running off the end, once the buffer is exhausted.
+    class ByteReader
+    {
+    public:
+        ByteReader(const void* data, size_t size) : m_bytes(static_cast<const unsigned char*>(data)), m_size(size) {}
+
+        bool Byte(uint8_t& value)
+        {
+            if (m_offset >= m_size)
+            {
+                return false;
+            }
+            value = m_bytes[m_offset++];
+            return true;
+        }
+
+        bool Bytes(void* target, size_t size)
+        {
+            if (m_size - m_offset < size)
+            {
+                return false;
+            }
+            std::memcpy(target, m_bytes + m_offset, size);
+            m_offset += size;
+            return true;
+        }
+
+        bool Varint(uint64_t& value)
+        {
+            value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                uint8_t byte = 0;
+                if (!Byte(byte))
+                {
+                    return false;
+                }
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool Signed(int64_t& value)
+        {
+            uint64_t raw = 0;
+            if (!Varint(raw))
+            {
+                return false;
+            }
+            value = static_cast<int64_t>((raw >> 1) ^ (~(raw & 1) + 1));
+            return true;
+        }
+
+        size_t Remaining() const { return m_size - m_offset; }
+
+    private:
+        const unsigned char* m_bytes;
+        size_t m_size;
+        size_t m_offset = 0;
+    };
+}
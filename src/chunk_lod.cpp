@@ -0,0 +1,269 @@
+#include "chunk_lod.h"
+
+#include <algorithm>
+
+namespace vengine
+{
+    namespace
+    {
+        // Meshes unused for this many frames are dropped; a chunk scrolling back into view pays
+        // for one rebuild rather than the cache growing with everything ever seen.
+        constexpr uint64_t kEvictAfterFrames = 300;
+
+        int FloorDiv(int value, int divisor)
+        {
+            return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+        }
+
+        uint64_t CoarseKey(int cx, int cy, int cz)
+        {
+            const uint64_t mask = (1u << 21) - 1u;
+            return ((static_cast<uint64_t>(cx) & mask) << 42) | ((static_cast<uint64_t>(cy) & mask) << 21) | (static_cast<uint64_t>(cz) & mask);
+        }
+
+        // One coarse voxel. Its vertical extent shrinks to the cells actually present, so a flat
+        // one-cube-thick floor stays flat at every level instead of growing to the block height.
+        struct CoarseCell
+        {
+            int cx = 0;
+            int cy = 0;
+            int cz = 0;
+            int yMin = 0;
+            int yMax = 0; // Exclusive.
+            float r = 0.0f;
+            float g = 0.0f;
+            float b = 0.0f;
+            int count = 0;
+        };
+
+        // Corner i of a box has x = bit 0, y = bit 1, z = bit 2. Each face lists its corners
+        // counter-clockwise seen from outside.
+        struct FaceDesc
+        {
+            int dx;
+            int dy;
+            int dz;
+            int corners[4];
+        };
+
+        constexpr FaceDesc kFaces[6] = {
+            {-1, 0, 0, {0, 4, 6, 2}},
+            {1, 0, 0, {1, 3, 7, 5}},
+            {0, -1, 0, {0, 1, 5, 4}},
+            {0, 1, 0, {2, 6, 7, 3}},
+            {0, 0, -1, {0, 2, 3, 1}},
+            {0, 0, 1, {4, 5, 7, 6}},
+        };
+
+        bool FaceHidden(const CoarseCell& cell, const CoarseCell* neighbour, const FaceDesc& face, int factor)
+        {
+            if (!neighbour)
+            {
+                return false;
+            }
+            if (face.dy == 0)
+            {
+                // A side face is covered only where the neighbour spans at least the same height.
+                return neighbour->yMin <= cell.yMin && neighbour->yMax >= cell.yMax;
+            }
+            // Top and bottom faces touch only when both voxels reach the shared block boundary.
+            if (face.dy > 0)
+            {
+                const int boundary = (cell.cy + 1) * factor;
+                return cell.yMax == boundary && neighbour->yMin == boundary;
+            }
+            const int boundary = cell.cy * factor;
+            return cell.yMin == boundary && neighbour->yMax == boundary;
+        }
+    }
+
+    LodMesh BuildLodMesh(const std::vector<LodCell>& cells, int level)
+    {
+        const int factor = 1 << std::clamp(level, 0, kLodLevelCount - 1);
+        std::unordered_map<uint64_t, CoarseCell> coarse;
+        coarse.reserve(cells.size());
+        for (const LodCell& cell : cells)
+        {
+            const int cx = FloorDiv(cell.x, factor);
+            const int cy = FloorDiv(cell.y, factor);
+            const int cz = FloorDiv(cell.z, factor);
+            CoarseCell& target = coarse[CoarseKey(cx, cy, cz)];
+            if (target.count == 0)
+            {
+                target.cx = cx;
+                target.cy = cy;
+                target.cz = cz;
+                target.yMin = cell.y;
+                target.yMax = cell.y + 1;
+            }
+            target.yMin = std::min(target.yMin, cell.y);
+            target.yMax = std::max(target.yMax, cell.y + 1);
+            target.r += cell.r;
+            target.g += cell.g;
+            target.b += cell.b;
+            ++target.count;
+        }
+
+        LodMesh mesh;
+        for (const auto& entry : coarse)
+        {
+            const CoarseCell& cell = entry.second;
+            const float inv = 1.0f / static_cast<float>(cell.count);
+            const float color[3] = {cell.r * inv, cell.g * inv, cell.b * inv};
+            // Grid cells are centred on integer x/z and stand on integer y.
+            const float xs[2] = {static_cast<float>(cell.cx * factor) - 0.5f, static_cast<float>((cell.cx + 1) * factor) - 0.5f};
+            const float ys[2] = {static_cast<float>(cell.yMin), static_cast<float>(cell.yMax)};
+            const float zs[2] = {static_cast<float>(cell.cz * factor) - 0.5f, static_cast<float>((cell.cz + 1) * factor) - 0.5f};
+
+            for (const FaceDesc& face : kFaces)
+            {
+                const auto found = coarse.find(CoarseKey(cell.cx + face.dx, cell.cy + face.dy, cell.cz + face.dz));
+                if (FaceHidden(cell, found != coarse.end() ? &found->second : nullptr, face, factor))
+                {
+                    continue;
+                }
+                for (int corner : face.corners)
+                {
+                    mesh.positions.insert(mesh.positions.end(), {xs[corner & 1], ys[(corner >> 1) & 1], zs[(corner >> 2) & 1]});
+                    mesh.normals.insert(mesh.normals.end(), {static_cast<float>(face.dx), static_cast<float>(face.dy), static_cast<float>(face.dz)});
+                    mesh.colors.insert(mesh.colors.end(), std::begin(color), std::end(color));
+                }
+            }
+        }
+        return mesh;
+    }
+
+    void ShadeLodCells(std::vector<LodCell>& cells, const CubeLightField& lighting)
+    {
+        for (LodCell& cell : cells)
+        {
+            if (cell.glowing)
+            {
+                continue;
+            }
+            const float shading = CubeShadeForLight(lighting.LightAtCube(cell.x, cell.y, cell.z));
+            cell.r = std::clamp(cell.r * shading, 0.0f, 1.0f);
+            cell.g = std::clamp(cell.g * shading, 0.0f, 1.0f);
+            cell.b = std::clamp(cell.b * shading, 0.0f, 1.0f);
+        }
+    }
+
+    ChunkLodCache::~ChunkLodCache()
+    {
+        Stop();
+    }
+
+    void ChunkLodCache::BeginFrame()
+    {
+        ++m_frame;
+        std::vector<Result> results;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            results.swap(m_results);
+        }
+        for (Result& result : results)
+        {
+            const auto found = m_entries.find(result.slot);
+            if (result.generation != m_generation || found == m_entries.end())
+            {
+                continue;
+            }
+            found->second.mesh = std::make_unique<LodMesh>(std::move(result.mesh));
+        }
+    }
+
+    void ChunkLodCache::EndFrame()
+    {
+        for (auto it = m_entries.begin(); it != m_entries.end();)
+        {
+            if (m_frame - it->second.lastUsedFrame < kEvictAfterFrames)
+            {
+                ++it;
+                continue;
+            }
+            it = m_entries.erase(it);
+        }
+    }
+
+    void ChunkLodCache::Clear()
+    {
+        m_entries.clear();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_generation;
+        m_order.clear();
+        m_jobs.clear();
+        m_results.clear();
+    }
+
+    void ChunkLodCache::Stop()
+    {
+        Clear();
+        if (m_thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopRequested = true;
+            }
+            m_wake.notify_all();
+            m_thread.join();
+        }
+        m_stopRequested = false;
+    }
+
+    size_t ChunkLodCache::PendingBuildCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_jobs.size();
+    }
+
+    void ChunkLodCache::Enqueue(const SlotKey& slot, std::vector<LodCell> cells, std::shared_ptr<const CubeLightField> lighting)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const auto inserted = m_jobs.try_emplace(slot);
+            if (inserted.second)
+            {
+                m_order.push_back(slot);
+            }
+            inserted.first->second.cells = std::move(cells);
+            inserted.first->second.lighting = std::move(lighting);
+            inserted.first->second.generation = m_generation;
+        }
+        if (!m_thread.joinable())
+        {
+            m_thread = std::thread(&ChunkLodCache::Run, this);
+        }
+        m_wake.notify_one();
+    }
+
+    void ChunkLodCache::Run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
+        {
+            m_wake.wait(lock, [this] { return m_stopRequested || !m_order.empty(); });
+            if (m_stopRequested)
+            {
+                return;
+            }
+            const SlotKey slot = m_order.front();
+            m_order.pop_front();
+            const auto found = m_jobs.find(slot);
+            if (found == m_jobs.end())
+            {
+                continue;
+            }
+            Job job = std::move(found->second);
+            m_jobs.erase(found);
+
+            lock.unlock();
+            if (job.lighting)
+            {
+                ShadeLodCells(job.cells, *job.lighting);
+            }
+            LodMesh mesh = BuildLodMesh(job.cells, slot.level);
+            lock.lock();
+            m_results.push_back(Result{slot, std::move(mesh), job.generation});
+        }
+    }
+}
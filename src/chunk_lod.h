@@ -0,0 +1,158 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "cube_lighting.h"
+
+// Level-of-detail meshes for distant cube chunks. Level L merges blocks of 2^L x 2^L x 2^L grid
+// cells into one coarse voxel (occupied when any cell in it is, coloured by their average) and
+// keeps only the faces no neighbouring voxel covers. Faces on the chunk border are always kept,
+// so every chunk mesh is closed: those faces act as skirts over the cracks where chunks drawn at
+// different levels meet. Level 0 is full detail and stays with the frontend's per-cube path.
+//
+// Meshes are built lazily on a worker thread, glow lighting included: the caller hands over the
+// chunk's raw cells and a CubeLightField snapshot, and the worker shades each cell before merging.
+// Until a chunk's mesh lands the caller keeps drawing whatever it had before (the previous mesh,
+// or full-detail cubes).
+namespace vengine
+{
+    constexpr int kLodLevelCount = 3;
+
+    // A grid cell as the builder sees it. Glowing cells are drawn at full brightness; the rest
+    // are shaded by the job's light field, if it has one.
+    struct LodCell
+    {
+        int x = 0;
+        int y = 0;
+        int z = 0;
+        float r = 1.0f;
+        float g = 1.0f;
+        float b = 1.0f;
+        bool glowing = false;
+    };
+
+    // Counter-clockwise GL_QUADS, four vertices per face, in the grid's world space.
+    struct LodMesh
+    {
+        std::vector<float> positions; // xyz per vertex
+        std::vector<float> normals;   // xyz per vertex
+        std::vector<float> colors;    // rgb per vertex
+
+        size_t VertexCount() const { return positions.size() / 3; }
+        size_t QuadCount() const { return positions.size() / 12; }
+    };
+
+    // cells must all belong to one chunk whose size is a multiple of 2^level.
+    LodMesh BuildLodMesh(const std::vector<LodCell>& cells, int level);
+
+    // Multiplies each non-glowing cell's colour by CubeShadeForLight of the light on it.
+    void ShadeLodCells(std::vector<LodCell>& cells, const CubeLightField& lighting);
+
+    class ChunkLodCache
+    {
+    public:
+        ChunkLodCache() = default;
+        ~ChunkLodCache();
+        ChunkLodCache(const ChunkLodCache&) = delete;
+        ChunkLodCache& operator=(const ChunkLodCache&) = delete;
+
+        // Installs meshes the worker has finished since the last frame.
+        void BeginFrame();
+
+        // Returns the newest mesh built for (key, level), or nullptr if none has landed yet. When
+        // contentHash differs from the last request, snapshot() is called for the chunk's cells
+        // and a rebuild is queued; the returned mesh may be the stale one until it completes.
+        // snapshot() should only copy cells: lighting (when lighting is set) runs on the worker.
+        template <typename Snapshot>
+        const LodMesh* Acquire(uint64_t key, int level, uint64_t contentHash, Snapshot&& snapshot,
+                               std::shared_ptr<const CubeLightField> lighting = nullptr)
+        {
+            Entry& entry = m_entries[SlotKey{key, level}];
+            entry.lastUsedFrame = m_frame;
+            if (!entry.requested || entry.requestedHash != contentHash)
+            {
+                entry.requested = true;
+                entry.requestedHash = contentHash;
+                Enqueue(SlotKey{key, level}, snapshot(), std::move(lighting));
+            }
+            return entry.mesh.get();
+        }
+
+        // Drops meshes that have not been acquired for a while.
+        void EndFrame();
+
+        // Forgets every mesh and queued build; builds already running are discarded on arrival.
+        void Clear();
+
+        // Clears and joins the worker; call before shutdown.
+        void Stop();
+
+        size_t PendingBuildCount() const;
+        size_t CachedMeshCount() const { return m_entries.size(); }
+
+    private:
+        struct SlotKey
+        {
+            uint64_t chunk = 0;
+            int level = 0;
+
+            bool operator==(const SlotKey& other) const { return chunk == other.chunk && level == other.level; }
+        };
+
+        struct SlotKeyHash
+        {
+            size_t operator()(const SlotKey& key) const
+            {
+                return static_cast<size_t>(key.chunk * 0x9E3779B97F4A7C15ull) ^ static_cast<size_t>(key.level);
+            }
+        };
+
+        struct Entry
+        {
+            std::unique_ptr<LodMesh> mesh;
+            uint64_t requestedHash = 0;
+            bool requested = false;
+            uint64_t lastUsedFrame = 0;
+        };
+
+        struct Job
+        {
+            std::vector<LodCell> cells;
+            std::shared_ptr<const CubeLightField> lighting;
+            uint64_t generation = 0;
+        };
+
+        struct Result
+        {
+            SlotKey slot;
+            LodMesh mesh;
+            uint64_t generation = 0;
+        };
+
+        void Enqueue(const SlotKey& slot, std::vector<LodCell> cells, std::shared_ptr<const CubeLightField> lighting);
+        void Run();
+
+        // Main thread only.
+        std::unordered_map<SlotKey, Entry, SlotKeyHash> m_entries;
+        uint64_t m_frame = 0;
+
+        // Shared with the worker. A slot has at most one queued job; re-requesting it replaces
+        // the cells in place, so a chunk edited every frame never backs the queue up.
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::deque<SlotKey> m_order;
+        std::unordered_map<SlotKey, Job, SlotKeyHash> m_jobs;
+        std::vector<Result> m_results;
+        uint64_t m_generation = 0;
+        bool m_stopRequested = false;
+        std::thread m_thread;
+    };
+}
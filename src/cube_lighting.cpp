@@ -0,0 +1,177 @@
+#include "cube_lighting.h"
+
+#include <cmath>
+#include <limits>
+
+namespace vengine
+{
+    namespace
+    {
+        constexpr float kGlowIntensity = 2.6f;
+        constexpr float kGlowFalloff = 0.45f;
+        constexpr float kGlowReachSq = static_cast<float>(CubeLightField::kGlowReach * CubeLightField::kGlowReach);
+
+        // The glow bucket holding cell coordinate cell, on any axis.
+        int BucketOf(int cell)
+        {
+            constexpr int kSize = CubeLightField::kGlowReach;
+            return cell >= 0 ? cell / kSize : -((-cell + kSize - 1) / kSize);
+        }
+    }
+
+    void CubeLightField::Build(const CubeStore& cubes)
+    {
+        m_glowBuckets.clear();
+        m_glowCount = 0;
+        m_opaqueCells.clear();
+        m_opaqueCells.reserve(cubes.Size());
+        const std::vector<uint64_t>& cells = cubes.Cells();
+        const std::vector<uint8_t>& flags = cubes.Flags();
+        for (size_t i = 0; i < cells.size(); ++i)
+        {
+            if ((flags[i] & kCubeTransparent) == 0)
+            {
+                m_opaqueCells.insert(cells[i]);
+            }
+            if ((flags[i] & kCubeGlowing) != 0)
+            {
+                Glow glow;
+                UnpackCubeCell(cells[i], glow.x, glow.y, glow.z);
+                m_glowBuckets[PackCubeCell(BucketOf(glow.x), BucketOf(glow.y), BucketOf(glow.z))].push_back(glow);
+                ++m_glowCount;
+            }
+        }
+    }
+
+    float CubeLightField::LightAt(float x, float y, float z) const
+    {
+        return Light(x, y, z, nullptr);
+    }
+
+    float CubeLightField::LightAtCube(int x, int y, int z) const
+    {
+        const uint64_t receiver = PackCubeCell(x, y, z);
+        return Light(static_cast<float>(x), static_cast<float>(y) + 0.5f, static_cast<float>(z), &receiver);
+    }
+
+    float CubeLightField::Light(float x, float y, float z, const uint64_t* receiver) const
+    {
+        if (m_glowCount == 0)
+        {
+            return 0.35f;
+        }
+        // A glow within reach sits on a cell at most kGlowReach from the point's cell on every
+        // axis, so it is in the point's bucket or a neighbouring one.
+        const int bucketX = BucketOf(static_cast<int>(std::floor(x + 0.5f)));
+        const int bucketY = BucketOf(static_cast<int>(std::floor(y)));
+        const int bucketZ = BucketOf(static_cast<int>(std::floor(z + 0.5f)));
+        float total = 0.2f;
+        for (int bz = bucketZ - 1; bz <= bucketZ + 1; ++bz)
+        {
+            for (int by = bucketY - 1; by <= bucketY + 1; ++by)
+            {
+                for (int bx = bucketX - 1; bx <= bucketX + 1; ++bx)
+                {
+                    const auto bucket = m_glowBuckets.find(PackCubeCell(bx, by, bz));
+                    if (bucket == m_glowBuckets.end())
+                    {
+                        continue;
+                    }
+                    for (const Glow& glow : bucket->second)
+                    {
+                        const float dx = x - static_cast<float>(glow.x);
+                        const float dy = y - (static_cast<float>(glow.y) + 0.5f);
+                        const float dz = z - static_cast<float>(glow.z);
+                        const float distSq = dx * dx + dy * dy + dz * dz;
+                        if (distSq > kGlowReachSq || Occluded(glow, x, y, z, receiver))
+                        {
+                            continue;
+                        }
+                        total += distSq < 1e-4f ? 1.0f : kGlowIntensity / (1.0f + distSq * kGlowFalloff);
+                    }
+                }
+            }
+        }
+        return std::clamp(total, 0.0f, 1.0f);
+    }
+
+    bool CubeLightField::Occluded(const Glow& glow, float x, float y, float z, const uint64_t* receiver) const
+    {
+        // Shifted so that cell (i, j, k) spans [i, i + 1) on every axis: cubes are centred on
+        // integer x and z and stand on integer y.
+        const float origin[3] = {static_cast<float>(glow.x) + 0.5f, static_cast<float>(glow.y) + 0.5f, static_cast<float>(glow.z) + 0.5f};
+        const float dir[3] = {x + 0.5f - origin[0], y - origin[1], z + 0.5f - origin[2]};
+        if (dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2] < 1e-6f)
+        {
+            return false;
+        }
+
+        // Amanatides-Woo traversal from the light's cell towards the target; t runs 0..1 along dir.
+        int cell[3] = {glow.x, glow.y, glow.z};
+        int step[3] = {0, 0, 0};
+        float tMax[3];
+        float tDelta[3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (dir[axis] > 0.0f)
+            {
+                step[axis] = 1;
+                tMax[axis] = (static_cast<float>(cell[axis] + 1) - origin[axis]) / dir[axis];
+                tDelta[axis] = 1.0f / dir[axis];
+            }
+            else if (dir[axis] < 0.0f)
+            {
+                step[axis] = -1;
+                tMax[axis] = (static_cast<float>(cell[axis]) - origin[axis]) / dir[axis];
+                tDelta[axis] = -1.0f / dir[axis];
+            }
+            else
+            {
+                tMax[axis] = std::numeric_limits<float>::max();
+                tDelta[axis] = std::numeric_limits<float>::max();
+            }
+        }
+
+        for (;;)
+        {
+            const float tEnter = std::min(tMax[0], std::min(tMax[1], tMax[2]));
+            if (tEnter >= 1.0f)
+            {
+                return false;
+            }
+            // A ray through an edge or corner touches every cell meeting there, and touching
+            // counts as blocked (as the box test this replaced had it), so ties check them all.
+            int crossing = 0;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (tMax[axis] - tEnter <= 1e-6f)
+                {
+                    crossing |= 1 << axis;
+                }
+            }
+            for (int subset = crossing; subset != 0; subset = (subset - 1) & crossing)
+            {
+                if (tEnter <= 1e-4f)
+                {
+                    break;
+                }
+                const int x = cell[0] + ((subset & 1) ? step[0] : 0);
+                const int y = cell[1] + ((subset & 2) ? step[1] : 0);
+                const int z = cell[2] + ((subset & 4) ? step[2] : 0);
+                const uint64_t packed = PackCubeCell(x, y, z);
+                if ((!receiver || packed != *receiver) && m_opaqueCells.count(packed) != 0)
+                {
+                    return true;
+                }
+            }
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if ((crossing & (1 << axis)) != 0)
+                {
+                    cell[axis] += step[axis];
+                    tMax[axis] += tDelta[axis];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "cube_store.h"
+
+// Glow lighting for the cube grid, as the editor shades opaque cubes. Every glowing cube is a
+// point light at the centre of its cell; a light reaches a point unless an opaque cube other than
+// the light itself (and the receiving cube) stands on the segment between them. The segment is
+// walked cell by cell through a hash set of opaque cells, so a test costs its length in cells
+// rather than a pass over every cube.
+//
+// Glows further than kGlowReach cells from a point are left out: each would add less than 1/255
+// to the shade CubeShadeForLight gives. Glows are bucketed by kGlowReach-sized blocks, so a point
+// only looks at the glows in the 27 blocks around it, however many the level holds.
+//
+// A CubeLightField is a snapshot: Build copies what it needs out of the store and the result is
+// never modified afterwards, so one field can be shared with worker threads (the LOD builder
+// bakes lighting with it) while the editor keeps editing the store.
+namespace vengine
+{
+    class CubeLightField
+    {
+    public:
+        static constexpr int kGlowReach = 32;
+
+        void Build(const CubeStore& cubes);
+
+        // 0.35 when the scene has no glow at all; otherwise 0.2 ambient plus the falloff of every
+        // glow within kGlowReach that reaches the point, clamped to 1.
+        float LightAt(float x, float y, float z) const;
+
+        // LightAt for the cube on cell (x, y, z), sampled halfway up it; the cube does not shadow
+        // itself.
+        float LightAtCube(int x, int y, int z) const;
+
+        bool HasGlow() const { return m_glowCount > 0; }
+
+    private:
+        struct Glow
+        {
+            int x = 0;
+            int y = 0;
+            int z = 0;
+        };
+
+        float Light(float x, float y, float z, const uint64_t* receiver) const;
+        bool Occluded(const Glow& glow, float x, float y, float z, const uint64_t* receiver) const;
+
+        std::unordered_map<uint64_t, std::vector<Glow>> m_glowBuckets; // PackCubeCell of the block -> its glows.
+        size_t m_glowCount = 0;
+        std::unordered_set<uint64_t> m_opaqueCells; // PackCubeCell of every non-transparent cube.
+    };
+
+    // The factor the renderer multiplies an opaque cube's colour by for a light amount.
+    inline float CubeShadeForLight(float light)
+    {
+        return std::clamp(0.4f + 0.6f * light, 0.2f, 1.0f);
+    }
+}
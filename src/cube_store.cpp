@@ -0,0 +1,170 @@
+#include "cube_store.h"
+
+#include <cstring>
+#include <utility>
+
+namespace vengine
+{
+    size_t CubeStore::ColorKeyHash::operator()(const ColorKey& key) const
+    {
+        uint64_t hash = 1469598103934665603ull;
+        for (uint32_t bits : key.bits)
+        {
+            hash = (hash ^ bits) * 1099511628211ull;
+        }
+        return static_cast<size_t>(hash);
+    }
+
+    void CubeStore::Reserve(size_t count)
+    {
+        m_cells.reserve(count);
+        m_flags.reserve(count);
+        m_colorIndices.reserve(count);
+        m_textureHandles.reserve(count);
+        m_details.reserve(count);
+    }
+
+    void CubeStore::Clear()
+    {
+        m_cells.clear();
+        m_flags.clear();
+        m_colorIndices.clear();
+        m_textureHandles.clear();
+        m_details.clear();
+        m_palette.clear();
+        m_paletteLookup.clear();
+    }
+
+    void CubeStore::Swap(CubeStore& other) noexcept
+    {
+        m_cells.swap(other.m_cells);
+        m_flags.swap(other.m_flags);
+        m_colorIndices.swap(other.m_colorIndices);
+        m_textureHandles.swap(other.m_textureHandles);
+        m_details.swap(other.m_details);
+        m_palette.swap(other.m_palette);
+        m_paletteLookup.swap(other.m_paletteLookup);
+    }
+
+    bool CubeStore::Append(CubeRecord cube)
+    {
+        if (!CubeCellInRange(cube.gridX, cube.gridY, cube.gridZ))
+        {
+            return false;
+        }
+        m_cells.push_back(PackCubeCell(cube.gridX, cube.gridY, cube.gridZ));
+        m_flags.push_back(static_cast<uint8_t>((cube.glowing ? kCubeGlowing : 0) | (cube.transparent ? kCubeTransparent : 0)));
+        m_colorIndices.push_back(InternColor(CubeColor{cube.r, cube.g, cube.b}));
+        m_textureHandles.push_back(cube.textureHandle);
+        m_details.push_back(Details{cube.presetIndex, std::move(cube.texturePath)});
+        return true;
+    }
+
+    void CubeStore::Erase(size_t index)
+    {
+        for (size_t i = index + 1; i < m_cells.size(); ++i)
+        {
+            MoveCube(i, i - 1);
+        }
+        Truncate(m_cells.size() - 1);
+    }
+
+    CubeRecord CubeStore::Record(size_t index) const
+    {
+        CubeRecord cube;
+        Cell(index, cube.gridX, cube.gridY, cube.gridZ);
+        const CubeColor& color = Color(index);
+        cube.r = color.r;
+        cube.g = color.g;
+        cube.b = color.b;
+        cube.glowing = Glowing(index);
+        cube.transparent = Transparent(index);
+        cube.textureHandle = m_textureHandles[index];
+        cube.presetIndex = m_details[index].presetIndex;
+        cube.texturePath = m_details[index].texturePath;
+        return cube;
+    }
+
+    int CubeStore::Find(int x, int y, int z) const
+    {
+        if (!CubeCellInRange(x, y, z))
+        {
+            return -1;
+        }
+        const uint64_t cell = PackCubeCell(x, y, z);
+        for (size_t i = 0; i < m_cells.size(); ++i)
+        {
+            if (m_cells[i] == cell)
+            {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    size_t CubeStore::BytesPerCube()
+    {
+        return sizeof(uint64_t) + sizeof(uint8_t) + sizeof(uint32_t) + sizeof(int) + sizeof(Details);
+    }
+
+    CubeStore::ColorKey CubeStore::KeyOf(const CubeColor& color)
+    {
+        // Bitwise, so the palette keeps colours exactly as saved.
+        ColorKey key;
+        std::memcpy(&key.bits[0], &color.r, sizeof(float));
+        std::memcpy(&key.bits[1], &color.g, sizeof(float));
+        std::memcpy(&key.bits[2], &color.b, sizeof(float));
+        return key;
+    }
+
+    uint32_t CubeStore::InternColor(const CubeColor& color)
+    {
+        const auto inserted = m_paletteLookup.emplace(KeyOf(color), static_cast<uint32_t>(m_palette.size()));
+        if (inserted.second)
+        {
+            m_palette.push_back(color);
+        }
+        return inserted.first->second;
+    }
+
+    void CubeStore::CompactPaletteIfSparse()
+    {
+        if (m_palette.size() <= 2 * m_cells.size() + 256)
+        {
+            return;
+        }
+        std::vector<CubeColor> palette;
+        m_paletteLookup.clear();
+        std::vector<uint32_t> remap(m_palette.size(), UINT32_MAX);
+        for (uint32_t& colorIndex : m_colorIndices)
+        {
+            if (remap[colorIndex] == UINT32_MAX)
+            {
+                remap[colorIndex] = static_cast<uint32_t>(palette.size());
+                m_paletteLookup.emplace(KeyOf(m_palette[colorIndex]), remap[colorIndex]);
+                palette.push_back(m_palette[colorIndex]);
+            }
+            colorIndex = remap[colorIndex];
+        }
+        m_palette.swap(palette);
+    }
+
+    void CubeStore::MoveCube(size_t from, size_t to)
+    {
+        m_cells[to] = m_cells[from];
+        m_flags[to] = m_flags[from];
+        m_colorIndices[to] = m_colorIndices[from];
+        m_textureHandles[to] = m_textureHandles[from];
+        m_details[to] = std::move(m_details[from]);
+    }
+
+    void CubeStore::Truncate(size_t count)
+    {
+        m_cells.resize(count);
+        m_flags.resize(count);
+        m_colorIndices.resize(count);
+        m_textureHandles.resize(count);
+        m_details.resize(count);
+        CompactPaletteIfSparse();
+    }
+}
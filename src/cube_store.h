@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The editor's placed cubes, stored as parallel arrays rather than a vector of structs. The scans
+// that run over every cube (collision, light occlusion, picking rays) only need a cube's cell and
+// sometimes its flags, so those live in their own contiguous arrays: a scan reads 8 or 9 bytes per
+// cube instead of pulling a whole record, texture path string included, through the cache.
+//
+//   cells           packed grid position, 21 bits per axis (PackCubeCell), so +-2^20 cells
+//   flags           kCubeGlowing | kCubeTransparent
+//   colorIndices    into a palette of distinct colours; most scenes use a handful
+//   textureHandles  renderer texture handle, -1 for none
+//   details         cold side table: preset index and stored texture path
+//
+// All arrays share one index, which is also the item the culling chunks refer to. CubeRecord is
+// the whole cube in one piece, for the paths that build, drag or save single cubes.
+namespace vengine
+{
+    struct CubeRecord
+    {
+        int gridX = 0;
+        int gridY = 0;
+        int gridZ = 0;
+        float r = 1.0f;
+        float g = 1.0f;
+        float b = 1.0f;
+        bool glowing = false;
+        bool transparent = false;
+        int textureHandle = -1;
+        int presetIndex = -1;
+        std::string texturePath;
+    };
+
+    struct CubeColor
+    {
+        float r = 1.0f;
+        float g = 1.0f;
+        float b = 1.0f;
+    };
+
+    enum CubeFlags : uint8_t
+    {
+        kCubeGlowing = 1u << 0,
+        kCubeTransparent = 1u << 1,
+    };
+
+    // The cells PackCubeCell can hold: 21-bit two's complement per axis.
+    constexpr int kCubeCellMin = -(1 << 20);
+    constexpr int kCubeCellMax = (1 << 20) - 1;
+
+    inline bool CubeCellInRange(int x, int y, int z)
+    {
+        return x >= kCubeCellMin && x <= kCubeCellMax && y >= kCubeCellMin && y <= kCubeCellMax && z >= kCubeCellMin && z <= kCubeCellMax;
+    }
+
+    // Two's complement per axis. Cells outside CubeCellInRange alias others, so callers check first.
+    inline uint64_t PackCubeCell(int x, int y, int z)
+    {
+        constexpr uint64_t kMask = (uint64_t{1} << 21) - 1;
+        return ((static_cast<uint64_t>(x) & kMask) << 42) | ((static_cast<uint64_t>(y) & kMask) << 21) | (static_cast<uint64_t>(z) & kMask);
+    }
+
+    inline void UnpackCubeCell(uint64_t cell, int& x, int& y, int& z)
+    {
+        // Move each field to the top of 32 bits, then shift back down arithmetically to sign-extend.
+        x = static_cast<int32_t>(static_cast<uint32_t>(cell >> 42) << 11) >> 11;
+        y = static_cast<int32_t>(static_cast<uint32_t>(cell >> 21) << 11) >> 11;
+        z = static_cast<int32_t>(static_cast<uint32_t>(cell) << 11) >> 11;
+    }
+
+    class CubeStore
+    {
+    public:
+        size_t Size() const { return m_cells.size(); }
+        bool Empty() const { return m_cells.empty(); }
+        void Reserve(size_t count);
+        void Clear();
+        void Swap(CubeStore& other) noexcept;
+
+        // Refuses (and returns false for) a cube whose cell is outside CubeCellInRange.
+        bool Append(CubeRecord cube);
+        // Keeps the order of the cubes after index, as vector::erase does.
+        void Erase(size_t index);
+        // Removes every cube remove(index) returns true for, keeping the order of the rest.
+        // remove is called once per index in ascending order, before that cube has moved.
+        template <typename Predicate>
+        void RemoveIf(Predicate remove);
+
+        // Gathers one cube back out of the arrays, strings included; for edits and saves, not scans.
+        CubeRecord Record(size_t index) const;
+
+        // Index of the cube on cell (x, y, z), or -1 (always for cells outside CubeCellInRange).
+        int Find(int x, int y, int z) const;
+
+        // Hot arrays, one entry per cube.
+        const std::vector<uint64_t>& Cells() const { return m_cells; }
+        const std::vector<uint8_t>& Flags() const { return m_flags; }
+        const std::vector<uint32_t>& ColorIndices() const { return m_colorIndices; }
+        const std::vector<int>& TextureHandles() const { return m_textureHandles; }
+        const std::vector<CubeColor>& Palette() const { return m_palette; }
+
+        void Cell(size_t index, int& x, int& y, int& z) const { UnpackCubeCell(m_cells[index], x, y, z); }
+        bool Glowing(size_t index) const { return (m_flags[index] & kCubeGlowing) != 0; }
+        bool Transparent(size_t index) const { return (m_flags[index] & kCubeTransparent) != 0; }
+        const CubeColor& Color(size_t index) const { return m_palette[m_colorIndices[index]]; }
+        int TextureHandle(size_t index) const { return m_textureHandles[index]; }
+
+        // Cold side table.
+        int PresetIndex(size_t index) const { return m_details[index].presetIndex; }
+        const std::string& TexturePath(size_t index) const { return m_details[index].texturePath; }
+
+        // Approximate resident bytes per cube, for memory budgets.
+        static size_t BytesPerCube();
+
+    private:
+        struct Details
+        {
+            int presetIndex = -1;
+            std::string texturePath;
+        };
+
+        struct ColorKey
+        {
+            uint32_t bits[3];
+            bool operator==(const ColorKey& other) const { return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2]; }
+        };
+
+        struct ColorKeyHash
+        {
+            size_t operator()(const ColorKey& key) const;
+        };
+
+        static ColorKey KeyOf(const CubeColor& color);
+        uint32_t InternColor(const CubeColor& color);
+        // Drops palette entries no cube uses once they outnumber the cubes, so a streamed world
+        // that keeps paging tinted terrain in and out does not grow the palette without bound.
+        void CompactPaletteIfSparse();
+        void MoveCube(size_t from, size_t to);
+        void Truncate(size_t count);
+
+        std::vector<uint64_t> m_cells;
+        std::vector<uint8_t> m_flags;
+        std::vector<uint32_t> m_colorIndices;
+        std::vector<int> m_textureHandles;
+        std::vector<Details> m_details;
+        std::vector<CubeColor> m_palette;
+        std::unordered_map<ColorKey, uint32_t, ColorKeyHash> m_paletteLookup;
+    };
+
+    template <typename Predicate>
+    void CubeStore::RemoveIf(Predicate remove)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < m_cells.size(); ++i)
+        {
+            if (remove(i))
+            {
+                continue;
+            }
+            if (kept != i)
+            {
+                MoveCube(i, kept);
+            }
+            ++kept;
+        }
+        if (kept != m_cells.size())
+        {
+            Truncate(kept);
+        }
+    }
+}
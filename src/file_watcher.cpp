@@ -0,0 +1,392 @@
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__) && !defined(__EMSCRIPTEN__)
+#define VENGINE_FILE_WATCHER_INOTIFY
+#include <cstdint>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace vengine
+{
+#if defined(_WIN32)
+
+    // One overlapped ReadDirectoryChangesW covers the whole tree; a second event wakes the worker
+    // for shutdown.
+    struct FileWatcher::Backend
+    {
+        HANDLE directory = INVALID_HANDLE_VALUE;
+        HANDLE ioEvent = nullptr;
+        HANDLE wakeEvent = nullptr;
+        OVERLAPPED overlapped{};
+        bool readPending = false;
+        alignas(DWORD) unsigned char buffer[64 * 1024];
+
+        ~Backend()
+        {
+            if (directory != INVALID_HANDLE_VALUE)
+            {
+                if (readPending)
+                {
+                    // The kernel writes into buffer until the cancelled read completes.
+                    CancelIo(directory);
+                    DWORD ignored = 0;
+                    GetOverlappedResult(directory, &overlapped, &ignored, TRUE);
+                }
+                CloseHandle(directory);
+            }
+            if (ioEvent)
+            {
+                CloseHandle(ioEvent);
+            }
+            if (wakeEvent)
+            {
+                CloseHandle(wakeEvent);
+            }
+        }
+
+        // Paths are UTF-8 on both sides, as everywhere else in the editor; the ANSI code page
+        // would mangle any name outside it.
+        bool Open(const std::string& root, std::string& error)
+        {
+            directory = CreateFileW(std::filesystem::u8path(root).wstring().c_str(),
+                                    FILE_LIST_DIRECTORY,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    nullptr,
+                                    OPEN_EXISTING,
+                                    FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                                    nullptr);
+            if (directory == INVALID_HANDLE_VALUE)
+            {
+                error = "Unable to open directory for watching";
+                return false;
+            }
+            ioEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+            wakeEvent = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+            if (!ioEvent || !wakeEvent)
+            {
+                error = "CreateEvent failed";
+                return false;
+            }
+            if (!IssueRead())
+            {
+                error = "ReadDirectoryChangesW failed";
+                return false;
+            }
+            return true;
+        }
+
+        bool IssueRead()
+        {
+            overlapped = OVERLAPPED{};
+            overlapped.hEvent = ioEvent;
+            ResetEvent(ioEvent);
+            const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+            readPending = ReadDirectoryChangesW(directory, buffer, sizeof(buffer), TRUE, filter, nullptr, &overlapped, nullptr) != FALSE;
+            return readPending;
+        }
+
+        void Poll(FileWatcher& watcher, int timeoutMs)
+        {
+            const HANDLE handles[2] = {ioEvent, wakeEvent};
+            const DWORD wait = WaitForMultipleObjects(2, handles, FALSE, timeoutMs < 0 ? INFINITE : static_cast<DWORD>(timeoutMs));
+            if (wait != WAIT_OBJECT_0)
+            {
+                return;
+            }
+
+            DWORD bytes = 0;
+            const bool completed = GetOverlappedResult(directory, &overlapped, &bytes, FALSE) != FALSE;
+            readPending = false;
+            // bytes == 0 means the kernel buffer overflowed; those events are lost.
+            if (completed && bytes > 0)
+            {
+                const Clock::time_point now = Clock::now();
+                size_t offset = 0;
+                for (;;)
+                {
+                    const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer + offset);
+                    const int wideLength = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+                    const int length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, nullptr, 0, nullptr, nullptr);
+                    if (length > 0)
+                    {
+                        std::string path(static_cast<size_t>(length), '\0');
+                        WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, &path[0], length, nullptr, nullptr);
+                        std::replace(path.begin(), path.end(), '\\', '/');
+                        watcher.Record(std::move(path), now);
+                    }
+                    if (info->NextEntryOffset == 0)
+                    {
+                        break;
+                    }
+                    offset += info->NextEntryOffset;
+                }
+            }
+            IssueRead();
+        }
+
+        void Wake()
+        {
+            SetEvent(wakeEvent);
+        }
+    };
+
+#elif defined(VENGINE_FILE_WATCHER_INOTIFY)
+
+    // inotify watches are per directory, so every directory in the tree gets one and new
+    // directories are added as they appear. An eventfd wakes the worker for shutdown.
+    struct FileWatcher::Backend
+    {
+        static constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+        int inotifyFd = -1;
+        int wakeFd = -1;
+        std::filesystem::path root;
+        std::unordered_map<int, std::string> directories; // Watch descriptor -> relative prefix ("" or "dir/").
+
+        ~Backend()
+        {
+            if (inotifyFd >= 0)
+            {
+                close(inotifyFd);
+            }
+            if (wakeFd >= 0)
+            {
+                close(wakeFd);
+            }
+        }
+
+        bool Open(const std::string& rootPath, std::string& error)
+        {
+            inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (inotifyFd < 0 || wakeFd < 0)
+            {
+                error = "inotify/eventfd unavailable";
+                return false;
+            }
+            root = std::filesystem::path(rootPath);
+            if (!AddTree(std::string()))
+            {
+                error = "Unable to watch directory";
+                return false;
+            }
+            return true;
+        }
+
+        bool AddTree(const std::string& relative)
+        {
+            namespace fs = std::filesystem;
+            const fs::path full = relative.empty() ? root : root / fs::path(relative);
+            const int wd = inotify_add_watch(inotifyFd, full.c_str(), kWatchMask);
+            if (wd < 0)
+            {
+                return false;
+            }
+            directories[wd] = relative;
+
+            std::error_code ec;
+            for (fs::directory_iterator it(full, ec), end; !ec && it != end; it.increment(ec))
+            {
+                if (it->is_directory(ec) && !it->is_symlink(ec))
+                {
+                    AddTree(relative + it->path().filename().string() + "/");
+                }
+            }
+            return true;
+        }
+
+        void Poll(FileWatcher& watcher, int timeoutMs)
+        {
+            pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+            if (poll(fds, 2, timeoutMs) <= 0)
+            {
+                return;
+            }
+            if (fds[1].revents & POLLIN)
+            {
+                uint64_t value = 0;
+                [[maybe_unused]] const ssize_t drained = read(wakeFd, &value, sizeof(value));
+            }
+            if (!(fds[0].revents & POLLIN))
+            {
+                return;
+            }
+
+            const Clock::time_point now = Clock::now();
+            alignas(inotify_event) char buffer[16 * 1024];
+            for (;;)
+            {
+                const ssize_t bytes = read(inotifyFd, buffer, sizeof(buffer));
+                if (bytes <= 0)
+                {
+                    break;
+                }
+                for (ssize_t offset = 0; offset < bytes;)
+                {
+                    const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                    offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                    const auto dir = directories.find(event->wd);
+                    if (dir == directories.end())
+                    {
+                        continue;
+                    }
+                    if (event->mask & IN_IGNORED)
+                    {
+                        directories.erase(dir);
+                        continue;
+                    }
+                    if (event->len == 0)
+                    {
+                        continue;
+                    }
+                    std::string path = dir->second + event->name;
+                    if (event->mask & IN_ISDIR)
+                    {
+                        if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                        {
+                            AddTree(path + "/");
+                        }
+                        continue;
+                    }
+                    watcher.Record(std::move(path), now);
+                }
+            }
+        }
+
+        void Wake()
+        {
+            const uint64_t one = 1;
+            [[maybe_unused]] const ssize_t written = write(wakeFd, &one, sizeof(one));
+        }
+    };
+
+#else
+
+    struct FileWatcher::Backend
+    {
+        bool Open(const std::string&, std::string& error)
+        {
+            error = "File watching is not supported on this platform";
+            return false;
+        }
+
+        void Poll(FileWatcher&, int)
+        {
+        }
+
+        void Wake()
+        {
+        }
+    };
+
+#endif
+
+    FileWatcher::FileWatcher() = default;
+
+    FileWatcher::~FileWatcher()
+    {
+        Stop();
+    }
+
+    bool FileWatcher::Supported()
+    {
+#if defined(_WIN32) || defined(VENGINE_FILE_WATCHER_INOTIFY)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool FileWatcher::Start(const std::string& directory, std::chrono::milliseconds debounce)
+    {
+        Stop();
+        auto backend = std::make_unique<Backend>();
+        if (!backend->Open(directory, m_lastError))
+        {
+            return false;
+        }
+        m_backend = std::move(backend);
+        m_debounce = debounce;
+        m_stopRequested = false;
+        m_lastError.clear();
+        m_thread = std::thread(&FileWatcher::Run, this);
+        return true;
+    }
+
+    void FileWatcher::Stop()
+    {
+        if (m_thread.joinable())
+        {
+            m_stopRequested = true;
+            m_backend->Wake();
+            m_thread.join();
+        }
+        m_backend.reset();
+        m_pending.clear();
+        std::lock_guard<std::mutex> lock(m_readyMutex);
+        m_ready.clear();
+    }
+
+    void FileWatcher::TakeChanges(std::vector<std::string>& out)
+    {
+        out.clear();
+        std::lock_guard<std::mutex> lock(m_readyMutex);
+        out.swap(m_ready);
+    }
+
+    void FileWatcher::Run()
+    {
+        while (!m_stopRequested)
+        {
+            m_backend->Poll(*this, NextTimeoutMilliseconds(Clock::now()));
+            PromoteSettled(Clock::now());
+        }
+    }
+
+    void FileWatcher::Record(std::string relativePath, Clock::time_point now)
+    {
+        m_pending[std::move(relativePath)] = now;
+    }
+
+    void FileWatcher::PromoteSettled(Clock::time_point now)
+    {
+        std::lock_guard<std::mutex> lock(m_readyMutex);
+        for (auto it = m_pending.begin(); it != m_pending.end();)
+        {
+            if (now - it->second < m_debounce)
+            {
+                ++it;
+                continue;
+            }
+            if (std::find(m_ready.begin(), m_ready.end(), it->first) == m_ready.end())
+            {
+                m_ready.push_back(it->first);
+            }
+            it = m_pending.erase(it);
+        }
+    }
+
+    int FileWatcher::NextTimeoutMilliseconds(Clock::time_point now) const
+    {
+        if (m_pending.empty())
+        {
+            return -1;
+        }
+        Clock::time_point earliest = Clock::time_point::max();
+        for (const auto& entry : m_pending)
+        {
+            earliest = std::min(earliest, entry.second);
+        }
+        const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(earliest + m_debounce - now);
+        return static_cast<int>(std::max<std::chrono::milliseconds::rep>(1, remaining.count()));
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Background file-change watcher used for hot reload. One worker thread blocks on the platform
+// notification API (inotify on Linux, ReadDirectoryChangesW on Win32) for a whole directory tree,
+// coalesces bursts of events per file and hands settled paths to the main loop through
+// TakeChanges, so editors that write a file in several steps trigger a single reload.
+namespace vengine
+{
+    class FileWatcher
+    {
+    public:
+        FileWatcher();
+        ~FileWatcher();
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        static bool Supported();
+
+        // Watches directory and everything below it. A path is reported once no further event
+        // has arrived for it within debounce.
+        bool Start(const std::string& directory, std::chrono::milliseconds debounce = std::chrono::milliseconds(150));
+        void Stop();
+        bool Running() const { return m_thread.joinable(); }
+
+        // Moves the settled paths into out (replacing its contents). Paths are relative to the
+        // watched directory and use '/' separators; each appears at most once per call.
+        void TakeChanges(std::vector<std::string>& out);
+
+        const std::string& LastError() const { return m_lastError; }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+        struct Backend;
+
+        void Run();
+        void Record(std::string relativePath, Clock::time_point now);
+        void PromoteSettled(Clock::time_point now);
+        int NextTimeoutMilliseconds(Clock::time_point now) const; // -1 waits indefinitely.
+
+        std::unique_ptr<Backend> m_backend;
+        std::thread m_thread;
+        std::atomic<bool> m_stopRequested{false};
+        std::chrono::milliseconds m_debounce{150};
+        std::string m_lastError;
+
+        // Worker-only: last event time per path still inside its debounce window.
+        std::unordered_map<std::string, Clock::time_point> m_pending;
+
+        std::mutex m_readyMutex;
+        std::vector<std::string> m_ready;
+    };
+}
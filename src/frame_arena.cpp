@@ -0,0 +1,167 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local uint64_t t_heapAllocations = 0;
+
+    void* CountedAllocate(std::size_t size)
+    {
+        ++t_heapAllocations;
+        if (size == 0)
+        {
+            size = 1;
+        }
+        for (;;)
+        {
+            if (void* memory = std::malloc(size))
+            {
+                return memory;
+            }
+            const std::new_handler handler = std::get_new_handler();
+            if (!handler)
+            {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void* CountedAllocateNoThrow(std::size_t size) noexcept
+    {
+        try
+        {
+            return CountedAllocate(size);
+        }
+        catch (...)
+        {
+            return nullptr;
+        }
+    }
+}
+
+// Replacements for the global allocation functions; the aligned overloads keep their library
+// definitions and are not counted (nothing in the engine over-aligns).
+void* operator new(std::size_t size)
+{
+    return CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return CountedAllocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedAllocateNoThrow(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedAllocateNoThrow(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+namespace vengine
+{
+    FrameArena::FrameArena(size_t initialBytes)
+    {
+        Block block;
+        block.size = std::max<size_t>(initialBytes, 4096);
+        block.data.reset(new unsigned char[block.size]);
+        m_blocks.push_back(std::move(block));
+    }
+
+    void* FrameArena::Allocate(size_t bytes, size_t alignment)
+    {
+        for (;;)
+        {
+            Block& block = m_blocks[m_current];
+            const uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+            const size_t aligned = static_cast<size_t>(((base + m_offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1)) - base);
+            if (aligned <= block.size && bytes <= block.size - aligned)
+            {
+                m_offset = aligned + bytes;
+                return block.data.get() + aligned;
+            }
+
+            m_usedBeforeCurrent += m_offset;
+            m_offset = 0;
+            if (++m_current == m_blocks.size())
+            {
+                // Spill: at least double, so a frame that keeps growing needs few extra blocks.
+                Block spill;
+                spill.size = std::max(block.size * 2, bytes + alignment);
+                spill.data.reset(new unsigned char[spill.size]);
+                m_blocks.push_back(std::move(spill));
+            }
+        }
+    }
+
+    void FrameArena::Reset()
+    {
+        m_lastFrameBytes = BytesUsed();
+        if (m_blocks.size() > 1)
+        {
+            // Coalesce so next frame fits in one block; alignment padding is covered by the slack
+            // the doubling spills already left.
+            const size_t total = Capacity();
+            m_blocks.clear();
+            Block block;
+            block.size = total;
+            block.data.reset(new unsigned char[block.size]);
+            m_blocks.push_back(std::move(block));
+        }
+        m_current = 0;
+        m_offset = 0;
+        m_usedBeforeCurrent = 0;
+    }
+
+    size_t FrameArena::Capacity() const
+    {
+        size_t total = 0;
+        for (const Block& block : m_blocks)
+        {
+            total += block.size;
+        }
+        return total;
+    }
+
+    uint64_t ThreadHeapAllocationCount()
+    {
+        return t_heapAllocations;
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Scratch memory for work that lives exactly one frame. The frontends reset one FrameArena at the
+// top of their frame loop; everything a frame needs for culling lists, batches and the like is
+// bump-allocated from it and dropped wholesale at the next reset. ArenaAllocator plugs it into
+// standard containers, so a per-frame std::vector becomes a FrameVector with the arena passed in.
+//
+// When a frame outgrows the arena it spills into extra blocks; the next Reset replaces them with
+// one block big enough for the whole frame, so a steady workload stops touching the heap after
+// its first frames.
+//
+// frame_arena.cpp also replaces the global operator new to count heap allocations per thread, so
+// the frontends can show how many allocations a frame still makes (the goal is zero).
+namespace vengine
+{
+    class FrameArena
+    {
+    public:
+        FrameArena() : FrameArena(256 * 1024) {}
+        explicit FrameArena(size_t initialBytes);
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        // Never returns null; alignment must be a power of two.
+        void* Allocate(size_t bytes, size_t alignment);
+
+        // Releases everything allocated since the previous Reset.
+        void Reset();
+
+        size_t BytesUsed() const { return m_usedBeforeCurrent + m_offset; }
+        // High-water mark of the frame that the last Reset ended.
+        size_t LastFrameBytes() const { return m_lastFrameBytes; }
+        size_t Capacity() const;
+
+    private:
+        struct Block
+        {
+            std::unique_ptr<unsigned char[]> data;
+            size_t size = 0;
+        };
+
+        std::vector<Block> m_blocks;
+        size_t m_current = 0;           // Block being bumped.
+        size_t m_offset = 0;            // Next free byte in it.
+        size_t m_usedBeforeCurrent = 0; // Bytes handed out from earlier blocks this frame.
+        size_t m_lastFrameBytes = 0;
+    };
+
+    // Deallocation is a no-op: memory comes back when the arena resets, so a container holding
+    // one must not outlive the frame.
+    template <typename T>
+    class ArenaAllocator
+    {
+    public:
+        using value_type = T;
+
+        explicit ArenaAllocator(FrameArena& arena) noexcept : m_arena(&arena) {}
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.Arena())
+        {
+        }
+
+        T* allocate(size_t count) { return static_cast<T*>(m_arena->Allocate(count * sizeof(T), alignof(T))); }
+        void deallocate(T*, size_t) noexcept {}
+
+        FrameArena* Arena() const noexcept { return m_arena; }
+
+    private:
+        FrameArena* m_arena;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept
+    {
+        return a.Arena() == b.Arena();
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept
+    {
+        return a.Arena() != b.Arena();
+    }
+
+    template <typename T>
+    using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+    // Global operator new calls made by the calling thread since it started. Worker threads count
+    // separately, so a frontend sampling this on its main thread sees only its own frame's work.
+    uint64_t ThreadHeapAllocationCount();
+}
@@ -0,0 +1,133 @@
+#include "frustum.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vengine
+{
+    namespace
+    {
+        uint64_t ChunkKey(int cx, int cy, int cz)
+        {
+            // 21 bits per axis covers +-1M chunks, far beyond any level the editor can hold.
+            const uint64_t mask = (1u << 21) - 1u;
+            return ((static_cast<uint64_t>(cx) & mask) << 42) | ((static_cast<uint64_t>(cy) & mask) << 21) | (static_cast<uint64_t>(cz) & mask);
+        }
+    }
+
+    void MultiplyColumnMajor(const float* a, const float* b, float* out)
+    {
+        for (int col = 0; col < 4; ++col)
+        {
+            for (int row = 0; row < 4; ++row)
+            {
+                float value = 0.0f;
+                for (int k = 0; k < 4; ++k)
+                {
+                    value += a[k * 4 + row] * b[col * 4 + k];
+                }
+                out[col * 4 + row] = value;
+            }
+        }
+    }
+
+    void Frustum::Extract(const float* clip)
+    {
+        // Gribb/Hartmann: each plane is row 3 of the clip matrix plus or minus one of rows 0..2.
+        auto row = [clip](int r, int c) { return clip[c * 4 + r]; };
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            for (int side = 0; side < 2; ++side)
+            {
+                const float sign = side == 0 ? 1.0f : -1.0f;
+                std::array<float, 4>& plane = m_planes[static_cast<size_t>(axis * 2 + side)];
+                for (int c = 0; c < 4; ++c)
+                {
+                    plane[static_cast<size_t>(c)] = row(3, c) + sign * row(axis, c);
+                }
+                const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+                if (length > 0.0f)
+                {
+                    for (float& value : plane)
+                    {
+                        value /= length;
+                    }
+                }
+            }
+        }
+    }
+
+    bool Frustum::Intersects(const Aabb& box) const
+    {
+        for (const std::array<float, 4>& plane : m_planes)
+        {
+            // The box corner furthest along the plane normal; if even it is behind, so is the box.
+            const float x = plane[0] >= 0.0f ? box.maxX : box.minX;
+            const float y = plane[1] >= 0.0f ? box.maxY : box.minY;
+            const float z = plane[2] >= 0.0f ? box.maxZ : box.minZ;
+            if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint64_t CubeChunkIndex::KeyForCell(int x, int y, int z)
+    {
+        return ChunkKey(ChunkOf(x), ChunkOf(y), ChunkOf(z));
+    }
+
+    const std::vector<uint32_t>* CubeChunkIndex::ItemsInChunk(int cx, int cy, int cz) const
+    {
+        const auto found = m_chunkByKey.find(ChunkKey(cx, cy, cz));
+        return found == m_chunkByKey.end() ? nullptr : &m_chunks[found->second].items;
+    }
+
+    void CubeChunkIndex::Clear()
+    {
+        // Chunks keep their item storage so per-frame rebuilds stop allocating once warmed up.
+        for (Chunk& chunk : m_chunks)
+        {
+            chunk.items.clear();
+        }
+        m_chunkCount = 0;
+        m_chunkByKey.clear();
+    }
+
+    void CubeChunkIndex::Insert(uint32_t item, int x, int y, int z)
+    {
+        const int coords[3] = {x, y, z};
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            m_minCell[axis] = m_chunkCount == 0 ? coords[axis] : std::min(m_minCell[axis], coords[axis]);
+            m_maxCell[axis] = m_chunkCount == 0 ? coords[axis] : std::max(m_maxCell[axis], coords[axis]);
+        }
+        const uint64_t key = KeyForCell(x, y, z);
+        const Aabb cell = CubeCellBounds(x, y, z);
+        const auto found = m_chunkByKey.find(key);
+        if (found == m_chunkByKey.end())
+        {
+            if (m_chunkCount == m_chunks.size())
+            {
+                m_chunks.emplace_back();
+            }
+            Chunk& chunk = m_chunks[m_chunkCount];
+            chunk.key = key;
+            chunk.bounds = cell;
+            chunk.items.push_back(item);
+            m_chunkByKey.emplace(key, static_cast<uint32_t>(m_chunkCount));
+            ++m_chunkCount;
+            return;
+        }
+
+        Chunk& chunk = m_chunks[found->second];
+        chunk.bounds.minX = std::min(chunk.bounds.minX, cell.minX);
+        chunk.bounds.minY = std::min(chunk.bounds.minY, cell.minY);
+        chunk.bounds.minZ = std::min(chunk.bounds.minZ, cell.minZ);
+        chunk.bounds.maxX = std::max(chunk.bounds.maxX, cell.maxX);
+        chunk.bounds.maxY = std::max(chunk.bounds.maxY, cell.maxY);
+        chunk.bounds.maxZ = std::max(chunk.bounds.maxZ, cell.maxZ);
+        chunk.items.push_back(item);
+    }
+}
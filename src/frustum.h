@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+// View-frustum culling for the cube grid. Frustum holds the six clip planes of a combined
+// projection * view matrix; CubeChunkIndex buckets grid cells into fixed-size chunks with tight
+// bounds so whole chunks outside the view are rejected before any of their cubes are touched.
+// The same chunks answer the editor's spatial queries (collision boxes, surface columns, picking
+// rays), which then touch the cubes near the query instead of every cube in the level.
+namespace vengine
+{
+    struct Aabb
+    {
+        float minX = 0.0f;
+        float minY = 0.0f;
+        float minZ = 0.0f;
+        float maxX = 0.0f;
+        float maxY = 0.0f;
+        float maxZ = 0.0f;
+    };
+
+    // Bounds of the unit cube standing on grid cell (x, y, z), grown by padding on every side.
+    inline Aabb CubeCellBounds(int x, int y, int z, float padding = 0.0f)
+    {
+        const float fx = static_cast<float>(x);
+        const float fy = static_cast<float>(y);
+        const float fz = static_cast<float>(z);
+        return Aabb{fx - 0.5f - padding, fy - padding, fz - 0.5f - padding,
+                    fx + 0.5f + padding, fy + 1.0f + padding, fz + 0.5f + padding};
+    }
+
+    // out = a * b for 4x4 matrices in OpenGL's column-major layout. out may not alias a or b.
+    void MultiplyColumnMajor(const float* a, const float* b, float* out);
+
+    class Frustum
+    {
+    public:
+        // clip maps world space to clip space (projection * view), column-major as passed to GL.
+        void Extract(const float* clip);
+
+        // Conservative: true when box is at least partly inside. Boxes straddling a frustum edge
+        // outside a corner can be accepted, never the other way round.
+        bool Intersects(const Aabb& box) const;
+
+    private:
+        std::array<std::array<float, 4>, 6> m_planes{}; // a, b, c, d with the normal pointing inward.
+    };
+
+    class CubeChunkIndex
+    {
+    public:
+        static constexpr int kChunkSize = 8;
+
+        // The key of the chunk holding grid cell (x, y, z), as passed to the visitors below.
+        static uint64_t KeyForCell(int x, int y, int z);
+
+        // The chunk coordinate holding cell coordinate cell, on any axis.
+        static int ChunkOf(int cell) { return cell >= 0 ? cell / kChunkSize : -((-cell + kChunkSize - 1) / kChunkSize); }
+
+        void Clear();
+
+        // Adds item for the cube on grid cell (x, y, z); the chunk's bounds grow to cover it.
+        void Insert(uint32_t item, int x, int y, int z);
+
+        // Calls visit(key, bounds, items) for every chunk whose bounds, grown by padding, intersect
+        // the frustum. key identifies the chunk's grid position and is stable across rebuilds.
+        template <typename Visit>
+        void ForEachChunkInFrustum(const Frustum& frustum, float padding, Visit&& visit) const
+        {
+            for (size_t i = 0; i < m_chunkCount; ++i)
+            {
+                const Chunk& chunk = m_chunks[i];
+                const Aabb& b = chunk.bounds;
+                const Aabb grown{b.minX - padding, b.minY - padding, b.minZ - padding,
+                                 b.maxX + padding, b.maxY + padding, b.maxZ + padding};
+                if (frustum.Intersects(grown))
+                {
+                    visit(chunk.key, chunk.bounds, chunk.items);
+                }
+            }
+        }
+
+        // Calls visit(item) for every item in a chunk whose bounds, grown by padding, intersect the
+        // frustum. Items still need their own test; padding lets one walk serve effects that reach
+        // past the cube (glow auras) as well as the cubes themselves.
+        template <typename Visit>
+        void ForEachInFrustum(const Frustum& frustum, float padding, Visit&& visit) const
+        {
+            ForEachChunkInFrustum(frustum, padding, [&](uint64_t, const Aabb&, const std::vector<uint32_t>& items) {
+                for (uint32_t item : items)
+                {
+                    visit(item);
+                }
+            });
+        }
+
+        // Calls visit(item) for every item in a chunk that holds cells of the box from cell
+        // (minX, minY, minZ) to cell (maxX, maxY, maxZ), inclusive. Items still need their own test.
+        template <typename Visit>
+        void ForEachInCellBox(int minX, int minY, int minZ, int maxX, int maxY, int maxZ, Visit&& visit) const
+        {
+            if (m_chunkCount == 0)
+            {
+                return;
+            }
+            const int lo[3] = {ChunkOf(std::max(minX, m_minCell[0])), ChunkOf(std::max(minY, m_minCell[1])), ChunkOf(std::max(minZ, m_minCell[2]))};
+            const int hi[3] = {ChunkOf(std::min(maxX, m_maxCell[0])), ChunkOf(std::min(maxY, m_maxCell[1])), ChunkOf(std::min(maxZ, m_maxCell[2]))};
+            for (int cz = lo[2]; cz <= hi[2]; ++cz)
+            {
+                for (int cy = lo[1]; cy <= hi[1]; ++cy)
+                {
+                    for (int cx = lo[0]; cx <= hi[0]; ++cx)
+                    {
+                        if (const std::vector<uint32_t>* items = ItemsInChunk(cx, cy, cz))
+                        {
+                            for (uint32_t item : *items)
+                            {
+                                visit(item);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Walks the chunks the ray origin + t * dir passes through for t in [0, maxT], nearest
+        // first, and calls visit(items, tExit) for each one holding cubes, where tExit is the t at
+        // which the ray leaves it. Stops when visit returns false: every cube in a later chunk is
+        // entered at or after tExit, so a nearest-hit search can stop once it has a hit before it.
+        template <typename Visit>
+        void ForEachChunkAlongRay(const float origin[3], const float dir[3], float maxT, Visit&& visit) const
+        {
+            if (m_chunkCount == 0)
+            {
+                return;
+            }
+            // Shifted so that cell c spans [c, c + 1) on every axis (cubes are centred on integer x
+            // and z and stand on integer y), and chunk c spans [c, c + 1) * kChunkSize. The walk is
+            // clipped to the cells the index holds.
+            const float p[3] = {origin[0] + 0.5f, origin[1], origin[2] + 0.5f};
+            float tStart = 0.0f;
+            float tEnd = maxT;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const float lo = static_cast<float>(m_minCell[axis]);
+                const float hi = static_cast<float>(m_maxCell[axis]) + 1.0f;
+                if (dir[axis] == 0.0f)
+                {
+                    if (p[axis] < lo || p[axis] > hi)
+                    {
+                        return;
+                    }
+                    continue;
+                }
+                const float t0 = (lo - p[axis]) / dir[axis];
+                const float t1 = (hi - p[axis]) / dir[axis];
+                tStart = std::max(tStart, std::min(t0, t1));
+                tEnd = std::min(tEnd, std::max(t0, t1));
+            }
+            if (tStart > tEnd)
+            {
+                return;
+            }
+
+            const float size = static_cast<float>(kChunkSize);
+            int chunk[3];
+            int step[3];
+            float tNext[3];
+            float tDelta[3];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const int cell = static_cast<int>(std::floor(p[axis] + dir[axis] * tStart));
+                chunk[axis] = ChunkOf(std::clamp(cell, m_minCell[axis], m_maxCell[axis]));
+                step[axis] = dir[axis] > 0.0f ? 1 : (dir[axis] < 0.0f ? -1 : 0);
+                if (step[axis] == 0)
+                {
+                    tNext[axis] = std::numeric_limits<float>::max();
+                    tDelta[axis] = std::numeric_limits<float>::max();
+                    continue;
+                }
+                const float boundary = static_cast<float>(step[axis] > 0 ? chunk[axis] + 1 : chunk[axis]) * size;
+                tNext[axis] = (boundary - p[axis]) / dir[axis];
+                tDelta[axis] = size / std::fabs(dir[axis]);
+            }
+            for (;;)
+            {
+                const int axis = tNext[0] < tNext[1] ? (tNext[0] < tNext[2] ? 0 : 2) : (tNext[1] < tNext[2] ? 1 : 2);
+                const std::vector<uint32_t>* items = ItemsInChunk(chunk[0], chunk[1], chunk[2]);
+                if (items && !visit(*items, std::min(tNext[axis], tEnd)))
+                {
+                    return;
+                }
+                if (tNext[axis] >= tEnd)
+                {
+                    return;
+                }
+                chunk[axis] += step[axis];
+                tNext[axis] += tDelta[axis];
+                if (chunk[axis] < ChunkOf(m_minCell[axis]) || chunk[axis] > ChunkOf(m_maxCell[axis]))
+                {
+                    return;
+                }
+            }
+        }
+
+        size_t ChunkCount() const { return m_chunkCount; }
+
+    private:
+        struct Chunk
+        {
+            uint64_t key = 0;
+            Aabb bounds;
+            std::vector<uint32_t> items;
+        };
+
+        // The items of chunk (cx, cy, cz), or null when it holds none.
+        const std::vector<uint32_t>* ItemsInChunk(int cx, int cy, int cz) const;
+
+        std::vector<Chunk> m_chunks; // First m_chunkCount are in use; the rest keep their capacity.
+        size_t m_chunkCount = 0;
+        std::unordered_map<uint64_t, uint32_t> m_chunkByKey;
+        int m_minCell[3] = {0, 0, 0}; // Bounds of every inserted cell, valid while m_chunkCount > 0.
+        int m_maxCell[3] = {0, 0, 0};
+    };
+}
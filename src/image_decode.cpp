@@ -0,0 +1,813 @@
+#include "image_decode.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define VENGINE_HAS_X86_SWIZZLE 1
+#define VENGINE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define VENGINE_HAS_X86_SWIZZLE 0
+#endif
+
+namespace vengine
+{
+    namespace
+    {
+        // ---------------------------------------------------------------- inflate (RFC 1951)
+
+        class BitReader
+        {
+        public:
+            BitReader(const uint8_t* data, size_t size)
+                : m_data(data), m_size(size)
+            {
+            }
+
+            // Reads count (<= 24) bits LSB-first. Past the end the stream reads as zeros; Overrun()
+            // only reports once such padding bits were actually consumed, so peeking is safe.
+            uint32_t Bits(int count)
+            {
+                Refill(count);
+                const uint32_t value = static_cast<uint32_t>(m_buffer & ((1ull << count) - 1ull));
+                m_buffer >>= count;
+                m_bitCount -= count;
+                return value;
+            }
+
+            uint32_t Peek(int count)
+            {
+                Refill(count);
+                return static_cast<uint32_t>(m_buffer & ((1ull << count) - 1ull));
+            }
+
+            void Consume(int count)
+            {
+                m_buffer >>= count;
+                m_bitCount -= count;
+            }
+
+            void AlignToByte()
+            {
+                Consume(m_bitCount & 7);
+            }
+
+            // Copies count whole bytes after AlignToByte; buffered bytes are drained first.
+            bool CopyBytes(size_t count, std::vector<uint8_t>& out)
+            {
+                while (count > 0 && m_bitCount >= 8)
+                {
+                    out.push_back(static_cast<uint8_t>(Bits(8)));
+                    --count;
+                }
+                if (count > m_size - m_pos)
+                {
+                    return false;
+                }
+                out.insert(out.end(), m_data + m_pos, m_data + m_pos + count);
+                m_pos += count;
+                return !Overrun();
+            }
+
+            bool Overrun() const
+            {
+                return m_bitCount < m_paddingBytes * 8;
+            }
+
+        private:
+            void Refill(int count)
+            {
+                while (m_bitCount < count)
+                {
+                    uint64_t byte = 0;
+                    if (m_pos < m_size)
+                    {
+                        byte = m_data[m_pos++];
+                    }
+                    else
+                    {
+                        ++m_paddingBytes;
+                    }
+                    m_buffer |= byte << m_bitCount;
+                    m_bitCount += 8;
+                }
+            }
+
+            const uint8_t* m_data;
+            size_t m_size;
+            size_t m_pos = 0;
+            uint64_t m_buffer = 0;
+            int m_bitCount = 0;
+            int m_paddingBytes = 0;
+        };
+
+        constexpr int kMaxCodeBits = 15;
+        constexpr int kFastBits = 9;
+
+        // Canonical Huffman table with a kFastBits-wide direct lookup; longer codes fall back to a
+        // bit-by-bit canonical walk.
+        struct HuffmanTable
+        {
+            std::array<uint16_t, 1u << kFastBits> fast{}; // (symbol << 4) | length, 0 when the code is longer.
+            std::array<uint16_t, kMaxCodeBits + 1> counts{};
+            std::array<uint16_t, 288> symbols{};
+
+            bool Build(const uint8_t* lengths, int symbolCount)
+            {
+                counts.fill(0);
+                fast.fill(0);
+                for (int i = 0; i < symbolCount; ++i)
+                {
+                    ++counts[lengths[i]];
+                }
+                counts[0] = 0;
+
+                int left = 1;
+                for (int len = 1; len <= kMaxCodeBits; ++len)
+                {
+                    left = left * 2 - counts[static_cast<size_t>(len)];
+                    if (left < 0)
+                    {
+                        return false; // Over-subscribed.
+                    }
+                }
+
+                std::array<uint16_t, kMaxCodeBits + 2> offsets{};
+                for (int len = 1; len <= kMaxCodeBits; ++len)
+                {
+                    offsets[static_cast<size_t>(len) + 1] = static_cast<uint16_t>(offsets[static_cast<size_t>(len)] + counts[static_cast<size_t>(len)]);
+                }
+                for (int i = 0; i < symbolCount; ++i)
+                {
+                    if (lengths[i] != 0)
+                    {
+                        symbols[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+                    }
+                }
+
+                uint32_t code = 0;
+                int index = 0;
+                for (int len = 1; len <= kFastBits; ++len)
+                {
+                    for (int n = 0; n < counts[static_cast<size_t>(len)]; ++n, ++code, ++index)
+                    {
+                        uint32_t reversed = 0;
+                        for (int bit = 0; bit < len; ++bit)
+                        {
+                            reversed |= ((code >> bit) & 1u) << (len - 1 - bit);
+                        }
+                        const uint16_t entry = static_cast<uint16_t>((symbols[static_cast<size_t>(index)] << 4) | len);
+                        for (uint32_t fill = reversed; fill < (1u << kFastBits); fill += 1u << len)
+                        {
+                            fast[fill] = entry;
+                        }
+                    }
+                    code <<= 1;
+                }
+                return true;
+            }
+
+            int Decode(BitReader& reader) const
+            {
+                const uint16_t entry = fast[reader.Peek(kFastBits)];
+                if (entry != 0)
+                {
+                    reader.Consume(entry & 15);
+                    return entry >> 4;
+                }
+
+                int code = 0;
+                int first = 0;
+                int index = 0;
+                for (int len = 1; len <= kMaxCodeBits; ++len)
+                {
+                    code |= static_cast<int>(reader.Bits(1));
+                    const int count = counts[static_cast<size_t>(len)];
+                    if (code - count < first)
+                    {
+                        return symbols[static_cast<size_t>(index + (code - first))];
+                    }
+                    index += count;
+                    first += count;
+                    first <<= 1;
+                    code <<= 1;
+                }
+                return -1;
+            }
+        };
+
+        constexpr std::array<uint16_t, 29> kLengthBase = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        constexpr std::array<uint8_t, 29> kLengthExtra = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        constexpr std::array<uint16_t, 30> kDistanceBase = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        constexpr std::array<uint8_t, 30> kDistanceExtra = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        bool InflateBlock(BitReader& reader, const HuffmanTable& literals, const HuffmanTable& distances, std::vector<uint8_t>& out)
+        {
+            for (;;)
+            {
+                const int symbol = literals.Decode(reader);
+                if (symbol < 0 || reader.Overrun())
+                {
+                    return false;
+                }
+                if (symbol < 256)
+                {
+                    out.push_back(static_cast<uint8_t>(symbol));
+                    continue;
+                }
+                if (symbol == 256)
+                {
+                    return true;
+                }
+
+                const int lengthIndex = symbol - 257;
+                if (lengthIndex >= static_cast<int>(kLengthBase.size()))
+                {
+                    return false;
+                }
+                const size_t length = kLengthBase[static_cast<size_t>(lengthIndex)] + reader.Bits(kLengthExtra[static_cast<size_t>(lengthIndex)]);
+                const int distanceSymbol = distances.Decode(reader);
+                if (distanceSymbol < 0 || distanceSymbol >= static_cast<int>(kDistanceBase.size()))
+                {
+                    return false;
+                }
+                const size_t distance = kDistanceBase[static_cast<size_t>(distanceSymbol)] + reader.Bits(kDistanceExtra[static_cast<size_t>(distanceSymbol)]);
+                if (distance > out.size())
+                {
+                    return false;
+                }
+
+                // Byte-wise because the source may overlap the bytes being written (run-length matches).
+                const size_t start = out.size() - distance;
+                for (size_t i = 0; i < length; ++i)
+                {
+                    out.push_back(out[start + i]);
+                }
+            }
+        }
+
+        bool Inflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+        {
+            BitReader reader(data, size);
+            bool finalBlock = false;
+            while (!finalBlock)
+            {
+                finalBlock = reader.Bits(1) != 0;
+                const uint32_t type = reader.Bits(2);
+                if (type == 0)
+                {
+                    reader.AlignToByte();
+                    const uint32_t length = reader.Bits(16);
+                    const uint32_t inverse = reader.Bits(16);
+                    if ((length ^ 0xFFFFu) != inverse || !reader.CopyBytes(length, out))
+                    {
+                        return false;
+                    }
+                }
+                else if (type == 1)
+                {
+                    static const std::array<HuffmanTable, 2> fixedTables = [] {
+                        std::array<HuffmanTable, 2> tables;
+                        std::array<uint8_t, 288> lengths{};
+                        std::fill(lengths.begin(), lengths.begin() + 144, static_cast<uint8_t>(8));
+                        std::fill(lengths.begin() + 144, lengths.begin() + 256, static_cast<uint8_t>(9));
+                        std::fill(lengths.begin() + 256, lengths.begin() + 280, static_cast<uint8_t>(7));
+                        std::fill(lengths.begin() + 280, lengths.end(), static_cast<uint8_t>(8));
+                        tables[0].Build(lengths.data(), 288);
+                        lengths.fill(5);
+                        tables[1].Build(lengths.data(), 30);
+                        return tables;
+                    }();
+                    if (!InflateBlock(reader, fixedTables[0], fixedTables[1], out))
+                    {
+                        return false;
+                    }
+                }
+                else if (type == 2)
+                {
+                    const int literalCount = static_cast<int>(reader.Bits(5)) + 257;
+                    const int distanceCount = static_cast<int>(reader.Bits(5)) + 1;
+                    const int codeLengthCount = static_cast<int>(reader.Bits(4)) + 4;
+                    static constexpr std::array<uint8_t, 19> kCodeLengthOrder = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+                    std::array<uint8_t, 19> codeLengthLengths{};
+                    for (int i = 0; i < codeLengthCount; ++i)
+                    {
+                        codeLengthLengths[kCodeLengthOrder[static_cast<size_t>(i)]] = static_cast<uint8_t>(reader.Bits(3));
+                    }
+                    HuffmanTable codeLengths;
+                    if (!codeLengths.Build(codeLengthLengths.data(), 19))
+                    {
+                        return false;
+                    }
+
+                    std::array<uint8_t, 288 + 32> lengths{};
+                    int index = 0;
+                    while (index < literalCount + distanceCount)
+                    {
+                        const int symbol = codeLengths.Decode(reader);
+                        if (symbol < 0 || reader.Overrun())
+                        {
+                            return false;
+                        }
+                        if (symbol < 16)
+                        {
+                            lengths[static_cast<size_t>(index++)] = static_cast<uint8_t>(symbol);
+                            continue;
+                        }
+                        uint8_t repeatValue = 0;
+                        int repeat = 0;
+                        if (symbol == 16)
+                        {
+                            if (index == 0)
+                            {
+                                return false;
+                            }
+                            repeatValue = lengths[static_cast<size_t>(index - 1)];
+                            repeat = 3 + static_cast<int>(reader.Bits(2));
+                        }
+                        else if (symbol == 17)
+                        {
+                            repeat = 3 + static_cast<int>(reader.Bits(3));
+                        }
+                        else
+                        {
+                            repeat = 11 + static_cast<int>(reader.Bits(7));
+                        }
+                        if (index + repeat > literalCount + distanceCount)
+                        {
+                            return false;
+                        }
+                        std::fill_n(lengths.begin() + index, repeat, repeatValue);
+                        index += repeat;
+                    }
+
+                    HuffmanTable literals;
+                    HuffmanTable distances;
+                    if (!literals.Build(lengths.data(), literalCount) ||
+                        !distances.Build(lengths.data() + literalCount, distanceCount) ||
+                        !InflateBlock(reader, literals, distances, out))
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    return false;
+                }
+                if (reader.Overrun())
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // ---------------------------------------------------------------- PNG (ISO 15948)
+
+        uint32_t ReadBigEndian32(const uint8_t* bytes)
+        {
+            return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+                   (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+        }
+
+        uint8_t PaethPredictor(int a, int b, int c)
+        {
+            const int p = a + b - c;
+            const int pa = std::abs(p - a);
+            const int pb = std::abs(p - b);
+            const int pc = std::abs(p - c);
+            if (pa <= pb && pa <= pc)
+            {
+                return static_cast<uint8_t>(a);
+            }
+            return static_cast<uint8_t>(pb <= pc ? b : c);
+        }
+
+        // Reverses the per-row filters in place. rows holds height * (1 + rowBytes) bytes.
+        bool UnfilterRows(std::vector<uint8_t>& rows, size_t rowBytes, int height, size_t pixelBytes)
+        {
+            const uint8_t* previous = nullptr;
+            for (int y = 0; y < height; ++y)
+            {
+                uint8_t* row = rows.data() + static_cast<size_t>(y) * (rowBytes + 1u);
+                const uint8_t filter = row[0];
+                uint8_t* line = row + 1;
+                switch (filter)
+                {
+                case 0:
+                    break;
+                case 1:
+                    for (size_t i = pixelBytes; i < rowBytes; ++i)
+                    {
+                        line[i] = static_cast<uint8_t>(line[i] + line[i - pixelBytes]);
+                    }
+                    break;
+                case 2:
+                    if (previous)
+                    {
+                        for (size_t i = 0; i < rowBytes; ++i)
+                        {
+                            line[i] = static_cast<uint8_t>(line[i] + previous[i]);
+                        }
+                    }
+                    break;
+                case 3:
+                    for (size_t i = 0; i < rowBytes; ++i)
+                    {
+                        const int left = i >= pixelBytes ? line[i - pixelBytes] : 0;
+                        const int up = previous ? previous[i] : 0;
+                        line[i] = static_cast<uint8_t>(line[i] + ((left + up) >> 1));
+                    }
+                    break;
+                case 4:
+                    for (size_t i = 0; i < rowBytes; ++i)
+                    {
+                        const int left = i >= pixelBytes ? line[i - pixelBytes] : 0;
+                        const int up = previous ? previous[i] : 0;
+                        const int upLeft = (previous && i >= pixelBytes) ? previous[i - pixelBytes] : 0;
+                        line[i] = static_cast<uint8_t>(line[i] + PaethPredictor(left, up, upLeft));
+                    }
+                    break;
+                default:
+                    return false;
+                }
+                previous = line;
+            }
+            return true;
+        }
+
+        // ---------------------------------------------------------------- R/B swizzle kernels
+
+        void SwizzleRowScalar(const uint8_t* src, uint8_t* dst, int width)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                uint32_t pixel;
+                std::memcpy(&pixel, src + static_cast<size_t>(x) * 4u, 4);
+                pixel = (pixel & 0xFF00FF00u) | ((pixel >> 16) & 0xFFu) | ((pixel & 0xFFu) << 16);
+                std::memcpy(dst + static_cast<size_t>(x) * 4u, &pixel, 4);
+            }
+        }
+
+#if VENGINE_HAS_X86_SWIZZLE
+        VENGINE_TARGET("ssse3")
+        void SwizzleRowSsse3(const uint8_t* src, uint8_t* dst, int width)
+        {
+            const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+            int x = 0;
+            for (; x + 4 <= width; x += 4)
+            {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + static_cast<size_t>(x) * 4u));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + static_cast<size_t>(x) * 4u), _mm_shuffle_epi8(pixels, mask));
+            }
+            SwizzleRowScalar(src + static_cast<size_t>(x) * 4u, dst + static_cast<size_t>(x) * 4u, width - x);
+        }
+
+        VENGINE_TARGET("avx2")
+        void SwizzleRowAvx2(const uint8_t* src, uint8_t* dst, int width)
+        {
+            // vpshufb shuffles within each 128-bit lane, so the lane mask is simply repeated.
+            const __m256i mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                                  2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+            int x = 0;
+            for (; x + 16 <= width; x += 16)
+            {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + static_cast<size_t>(x) * 4u));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + static_cast<size_t>(x) * 4u + 32u));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + static_cast<size_t>(x) * 4u), _mm256_shuffle_epi8(a, mask));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + static_cast<size_t>(x) * 4u + 32u), _mm256_shuffle_epi8(b, mask));
+            }
+            for (; x + 8 <= width; x += 8)
+            {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + static_cast<size_t>(x) * 4u));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + static_cast<size_t>(x) * 4u), _mm256_shuffle_epi8(a, mask));
+            }
+            SwizzleRowScalar(src + static_cast<size_t>(x) * 4u, dst + static_cast<size_t>(x) * 4u, width - x);
+        }
+#endif
+
+        using SwizzleRowFn = void (*)(const uint8_t*, uint8_t*, int);
+
+        SwizzleRowFn SwizzleRowFunction(SwizzleKernel kernel)
+        {
+#if VENGINE_HAS_X86_SWIZZLE
+            if (kernel == SwizzleKernel::Avx2)
+            {
+                return SwizzleRowAvx2;
+            }
+            if (kernel == SwizzleKernel::Ssse3)
+            {
+                return SwizzleRowSsse3;
+            }
+#endif
+            (void)kernel;
+            return SwizzleRowScalar;
+        }
+    }
+
+    bool DecodePng(const uint8_t* data, size_t size, DecodedImage& out, std::string& errorMessage)
+    {
+        static constexpr uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+        if (size < sizeof(kSignature) || std::memcmp(data, kSignature, sizeof(kSignature)) != 0)
+        {
+            errorMessage = "Not a PNG file";
+            return false;
+        }
+
+        uint32_t width = 0;
+        uint32_t height = 0;
+        int bitDepth = 0;
+        int colorType = -1;
+        std::vector<uint8_t> compressed;
+        std::array<uint8_t, 256 * 4> palette{};
+        int paletteSize = 0;
+        bool hasColorKey = false;
+        std::array<uint16_t, 3> colorKey{};
+
+        // Chunk CRCs are not verified; the zlib stream and the size checks below catch truncation.
+        size_t offset = sizeof(kSignature);
+        bool sawEnd = false;
+        while (!sawEnd && offset + 12 <= size)
+        {
+            const uint32_t length = ReadBigEndian32(data + offset);
+            const uint8_t* type = data + offset + 4;
+            const uint8_t* payload = data + offset + 8;
+            if (length > size - offset - 12)
+            {
+                errorMessage = "Truncated PNG chunk";
+                return false;
+            }
+
+            if (std::memcmp(type, "IHDR", 4) == 0 && length >= 13)
+            {
+                width = ReadBigEndian32(payload);
+                height = ReadBigEndian32(payload + 4);
+                bitDepth = payload[8];
+                colorType = payload[9];
+                if (payload[12] != 0)
+                {
+                    errorMessage = "Interlaced PNGs are not supported";
+                    return false;
+                }
+            }
+            else if (std::memcmp(type, "PLTE", 4) == 0)
+            {
+                paletteSize = static_cast<int>(std::min<uint32_t>(length / 3u, 256u));
+                for (int i = 0; i < paletteSize; ++i)
+                {
+                    palette[static_cast<size_t>(i) * 4u + 0] = payload[i * 3 + 0];
+                    palette[static_cast<size_t>(i) * 4u + 1] = payload[i * 3 + 1];
+                    palette[static_cast<size_t>(i) * 4u + 2] = payload[i * 3 + 2];
+                    palette[static_cast<size_t>(i) * 4u + 3] = 255;
+                }
+            }
+            else if (std::memcmp(type, "tRNS", 4) == 0)
+            {
+                if (colorType == 3)
+                {
+                    for (uint32_t i = 0; i < length && i < 256u; ++i)
+                    {
+                        palette[static_cast<size_t>(i) * 4u + 3] = payload[i];
+                    }
+                }
+                else if (colorType == 0 && length >= 2)
+                {
+                    hasColorKey = true;
+                    colorKey[0] = static_cast<uint16_t>((payload[0] << 8) | payload[1]);
+                }
+                else if (colorType == 2 && length >= 6)
+                {
+                    hasColorKey = true;
+                    for (size_t c = 0; c < 3; ++c)
+                    {
+                        colorKey[c] = static_cast<uint16_t>((payload[c * 2] << 8) | payload[c * 2 + 1]);
+                    }
+                }
+            }
+            else if (std::memcmp(type, "IDAT", 4) == 0)
+            {
+                compressed.insert(compressed.end(), payload, payload + length);
+            }
+            else if (std::memcmp(type, "IEND", 4) == 0)
+            {
+                sawEnd = true;
+            }
+            offset += 12u + length;
+        }
+
+        int channels = 0;
+        switch (colorType)
+        {
+        case 0: channels = 1; break;
+        case 2: channels = 3; break;
+        case 3: channels = 1; break;
+        case 4: channels = 2; break;
+        case 6: channels = 4; break;
+        default:
+            errorMessage = "Missing or invalid PNG header";
+            return false;
+        }
+        const bool validDepth = bitDepth == 8 || bitDepth == 16 ||
+                                ((colorType == 0 || colorType == 3) && (bitDepth == 1 || bitDepth == 2 || bitDepth == 4));
+        if (!validDepth || (colorType == 3 && (bitDepth == 16 || paletteSize == 0)))
+        {
+            errorMessage = "Unsupported PNG bit depth";
+            return false;
+        }
+        if (width == 0 || height == 0 || width > 16384u || height > 16384u)
+        {
+            errorMessage = "Unsupported PNG dimensions";
+            return false;
+        }
+        if (compressed.size() < 6 || (compressed[0] & 0x0F) != 8 || ((compressed[0] << 8) | compressed[1]) % 31 != 0 || (compressed[1] & 0x20) != 0)
+        {
+            errorMessage = "Invalid zlib stream";
+            return false;
+        }
+
+        const size_t bitsPerPixel = static_cast<size_t>(channels) * static_cast<size_t>(bitDepth);
+        const size_t rowBytes = (static_cast<size_t>(width) * bitsPerPixel + 7u) / 8u;
+        const size_t pixelBytes = std::max<size_t>(1u, bitsPerPixel / 8u);
+        std::vector<uint8_t> rows;
+        rows.reserve(static_cast<size_t>(height) * (rowBytes + 1u));
+        if (!Inflate(compressed.data() + 2, compressed.size() - 2, rows) || rows.size() < static_cast<size_t>(height) * (rowBytes + 1u))
+        {
+            errorMessage = "Corrupt PNG image data";
+            return false;
+        }
+        if (!UnfilterRows(rows, rowBytes, static_cast<int>(height), pixelBytes))
+        {
+            errorMessage = "Invalid PNG row filter";
+            return false;
+        }
+
+        out.width = static_cast<int>(width);
+        out.height = static_cast<int>(height);
+        out.order = PixelOrder::Rgba;
+        out.pixels.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u);
+
+        const int sampleMax = (1 << std::min(bitDepth, 8)) - 1;
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            const uint8_t* line = rows.data() + static_cast<size_t>(y) * (rowBytes + 1u) + 1u;
+            uint8_t* dst = out.pixels.data() + static_cast<size_t>(y) * static_cast<size_t>(width) * 4u;
+            if (colorType == 6 && bitDepth == 8)
+            {
+                std::memcpy(dst, line, static_cast<size_t>(width) * 4u);
+                continue;
+            }
+
+            for (uint32_t x = 0; x < width; ++x, dst += 4)
+            {
+                // Samples are read at full precision for the colour-key test, then reduced to 8 bits.
+                std::array<uint16_t, 4> sample{};
+                for (int c = 0; c < channels; ++c)
+                {
+                    if (bitDepth == 16)
+                    {
+                        const size_t at = (static_cast<size_t>(x) * static_cast<size_t>(channels) + static_cast<size_t>(c)) * 2u;
+                        sample[static_cast<size_t>(c)] = static_cast<uint16_t>((line[at] << 8) | line[at + 1]);
+                    }
+                    else if (bitDepth == 8)
+                    {
+                        sample[static_cast<size_t>(c)] = line[static_cast<size_t>(x) * static_cast<size_t>(channels) + static_cast<size_t>(c)];
+                    }
+                    else
+                    {
+                        const size_t bit = static_cast<size_t>(x) * static_cast<size_t>(bitDepth);
+                        const int shift = 8 - bitDepth - static_cast<int>(bit & 7u);
+                        sample[static_cast<size_t>(c)] = static_cast<uint16_t>((line[bit >> 3] >> shift) & sampleMax);
+                    }
+                }
+
+                const auto to8 = [&](uint16_t value) {
+                    if (bitDepth == 16)
+                    {
+                        return static_cast<uint8_t>(value >> 8);
+                    }
+                    return static_cast<uint8_t>(value * 255 / sampleMax);
+                };
+
+                if (colorType == 3)
+                {
+                    const size_t entry = std::min<size_t>(sample[0], static_cast<size_t>(paletteSize - 1));
+                    std::memcpy(dst, &palette[entry * 4u], 4);
+                }
+                else if (colorType == 0 || colorType == 4)
+                {
+                    const uint8_t gray = to8(sample[0]);
+                    dst[0] = gray;
+                    dst[1] = gray;
+                    dst[2] = gray;
+                    dst[3] = colorType == 4 ? to8(sample[1]) : static_cast<uint8_t>((hasColorKey && sample[0] == colorKey[0]) ? 0 : 255);
+                }
+                else
+                {
+                    dst[0] = to8(sample[0]);
+                    dst[1] = to8(sample[1]);
+                    dst[2] = to8(sample[2]);
+                    if (colorType == 6)
+                    {
+                        dst[3] = to8(sample[3]);
+                    }
+                    else
+                    {
+                        const bool keyed = hasColorKey && sample[0] == colorKey[0] && sample[1] == colorKey[1] && sample[2] == colorKey[2];
+                        dst[3] = keyed ? 0 : 255;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    bool LoadPngFile(const std::string& path, DecodedImage& out, std::string& errorMessage)
+    {
+        std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+        if (!file)
+        {
+            errorMessage = "Unable to open image";
+            return false;
+        }
+        const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return DecodePng(bytes.data(), bytes.size(), out, errorMessage);
+    }
+
+    bool SwizzleKernelSupported(SwizzleKernel kernel)
+    {
+        switch (kernel)
+        {
+        case SwizzleKernel::Scalar:
+            return true;
+#if VENGINE_HAS_X86_SWIZZLE
+        case SwizzleKernel::Ssse3:
+            return __builtin_cpu_supports("ssse3");
+        case SwizzleKernel::Avx2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+        }
+    }
+
+    SwizzleKernel ActiveSwizzleKernel()
+    {
+        static const SwizzleKernel kernel = [] {
+            if (SwizzleKernelSupported(SwizzleKernel::Avx2))
+            {
+                return SwizzleKernel::Avx2;
+            }
+            if (SwizzleKernelSupported(SwizzleKernel::Ssse3))
+            {
+                return SwizzleKernel::Ssse3;
+            }
+            return SwizzleKernel::Scalar;
+        }();
+        return kernel;
+    }
+
+    const char* SwizzleKernelName(SwizzleKernel kernel)
+    {
+        switch (kernel)
+        {
+        case SwizzleKernel::Ssse3:
+            return "ssse3";
+        case SwizzleKernel::Avx2:
+            return "avx2";
+        default:
+            return "scalar";
+        }
+    }
+
+    void SwizzleRedBlueRowsWith(SwizzleKernel kernel, const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, int width, int height)
+    {
+        const SwizzleRowFn swizzleRow = SwizzleRowFunction(kernel);
+        for (int y = 0; y < height; ++y)
+        {
+            swizzleRow(src + static_cast<size_t>(y) * srcStride, dst + static_cast<size_t>(y) * dstStride, width);
+        }
+    }
+
+    void SwizzleRedBlueRows(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, int width, int height)
+    {
+        SwizzleRedBlueRowsWith(ActiveSwizzleKernel(), src, srcStride, dst, dstStride, width, height);
+    }
+
+    void ConvertPixelOrder(DecodedImage& image, PixelOrder order)
+    {
+        if (image.order == order)
+        {
+            return;
+        }
+        const size_t stride = static_cast<size_t>(image.width) * 4u;
+        SwizzleRedBlueRows(image.pixels.data(), stride, image.pixels.data(), stride, image.width, image.height);
+        image.order = order;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Platform-independent image decode pipeline shared by the Win32 editor, the WebGL port and the
+// headless tools. Decoders hand back tightly packed 8-bit pixels plus the channel order they
+// produced, so callers can either upload that order directly or swizzle whole rows at once.
+namespace vengine
+{
+    enum class PixelOrder
+    {
+        Rgba,
+        Bgra,
+    };
+
+    struct DecodedImage
+    {
+        int width = 0;
+        int height = 0;
+        PixelOrder order = PixelOrder::Rgba;
+        std::vector<uint8_t> pixels; // width * height * 4 bytes, no row padding.
+    };
+
+    // Non-interlaced PNG of any colour type at 1-16 bits per channel. Output is always RGBA8.
+    bool DecodePng(const uint8_t* data, size_t size, DecodedImage& out, std::string& errorMessage);
+    bool LoadPngFile(const std::string& path, DecodedImage& out, std::string& errorMessage);
+
+    enum class SwizzleKernel
+    {
+        Scalar,
+        Ssse3,
+        Avx2,
+    };
+
+    // Best kernel the running CPU supports; resolved once on first use.
+    SwizzleKernel ActiveSwizzleKernel();
+    bool SwizzleKernelSupported(SwizzleKernel kernel);
+    const char* SwizzleKernelName(SwizzleKernel kernel);
+
+    // Swaps the R and B channels of width x height 32-bit pixels, row by row. The operation is its
+    // own inverse, so it converts BGRA<->RGBA; src and dst may be the same buffer.
+    void SwizzleRedBlueRows(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, int width, int height);
+    void SwizzleRedBlueRowsWith(SwizzleKernel kernel, const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, int width, int height);
+
+    // Converts image to the requested order in place (no-op when it already matches).
+    void ConvertPixelOrder(DecodedImage& image, PixelOrder order);
+}
@@ -0,0 +1,340 @@
+#include "image_encode.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+
+namespace vengine
+{
+    namespace
+    {
+        const std::array<uint32_t, 256>& CrcTable()
+        {
+            static const std::array<uint32_t, 256> table = [] {
+                std::array<uint32_t, 256> result{};
+                for (uint32_t n = 0; n < 256; ++n)
+                {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; ++k)
+                    {
+                        c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    }
+                    result[n] = c;
+                }
+                return result;
+            }();
+            return table;
+        }
+
+        uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+        {
+            const std::array<uint32_t, 256>& table = CrcTable();
+            crc = ~crc;
+            for (size_t i = 0; i < size; ++i)
+            {
+                crc = table[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8);
+            }
+            return ~crc;
+        }
+
+        uint32_t Adler32(const uint8_t* data, size_t size)
+        {
+            // 5552 is the largest run whose sums cannot overflow 32 bits before the modulo.
+            constexpr uint32_t kModulus = 65521u;
+            uint32_t a = 1;
+            uint32_t b = 0;
+            while (size > 0)
+            {
+                const size_t run = std::min<size_t>(size, 5552);
+                for (size_t i = 0; i < run; ++i)
+                {
+                    a += data[i];
+                    b += a;
+                }
+                a %= kModulus;
+                b %= kModulus;
+                data += run;
+                size -= run;
+            }
+            return (b << 16) | a;
+        }
+
+        // Deflate (RFC 1951) with the fixed Huffman tables and greedy LZ77 over hash chains. Rendered
+        // frames are mostly flat gradients and repeated rows, which this catches; an adaptive
+        // encoder would win a little more at several times the code.
+        class BitWriter
+        {
+        public:
+            explicit BitWriter(std::vector<uint8_t>& out)
+                : m_out(out)
+            {
+            }
+
+            void Write(uint32_t bits, int count)
+            {
+                m_buffer |= static_cast<uint64_t>(bits) << m_count;
+                m_count += count;
+                while (m_count >= 8)
+                {
+                    m_out.push_back(static_cast<uint8_t>(m_buffer));
+                    m_buffer >>= 8;
+                    m_count -= 8;
+                }
+            }
+
+            // Huffman codes are defined MSB-first but packed into the stream LSB-first.
+            void WriteCode(uint32_t code, int length)
+            {
+                uint32_t reversed = 0;
+                for (int i = 0; i < length; ++i)
+                {
+                    reversed |= ((code >> i) & 1u) << (length - 1 - i);
+                }
+                Write(reversed, length);
+            }
+
+            void Flush()
+            {
+                if (m_count > 0)
+                {
+                    m_out.push_back(static_cast<uint8_t>(m_buffer));
+                }
+                m_buffer = 0;
+                m_count = 0;
+            }
+
+        private:
+            std::vector<uint8_t>& m_out;
+            uint64_t m_buffer = 0;
+            int m_count = 0;
+        };
+
+        constexpr uint16_t kLengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        constexpr uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        constexpr uint16_t kDistanceBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        constexpr uint8_t kDistanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        constexpr int kWindowSize = 32768;
+        constexpr int kMinMatch = 3;
+        constexpr int kMaxMatch = 258;
+        constexpr int kMaxChain = 32;
+        constexpr int kHashBits = 15;
+
+        void WriteLiteralOrLength(BitWriter& writer, int symbol)
+        {
+            if (symbol < 144)
+                writer.WriteCode(0x30u + static_cast<uint32_t>(symbol), 8);
+            else if (symbol < 256)
+                writer.WriteCode(0x190u + static_cast<uint32_t>(symbol - 144), 9);
+            else if (symbol < 280)
+                writer.WriteCode(static_cast<uint32_t>(symbol - 256), 7);
+            else
+                writer.WriteCode(0xC0u + static_cast<uint32_t>(symbol - 280), 8);
+        }
+
+        void WriteMatch(BitWriter& writer, int length, int distance)
+        {
+            int code = 28;
+            while (kLengthBase[code] > length)
+            {
+                --code;
+            }
+            WriteLiteralOrLength(writer, 257 + code);
+            writer.Write(static_cast<uint32_t>(length - kLengthBase[code]), kLengthExtra[code]);
+
+            int distanceCode = 29;
+            while (kDistanceBase[distanceCode] > distance)
+            {
+                --distanceCode;
+            }
+            writer.WriteCode(static_cast<uint32_t>(distanceCode), 5);
+            writer.Write(static_cast<uint32_t>(distance - kDistanceBase[distanceCode]), kDistanceExtra[distanceCode]);
+        }
+
+        uint32_t Hash3(const uint8_t* p)
+        {
+            const uint32_t value = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16);
+            return (value * 2654435761u) >> (32 - kHashBits);
+        }
+
+        // Appends one final fixed-Huffman block holding all of data.
+        void DeflateFixed(const std::vector<uint8_t>& data, std::vector<uint8_t>& out)
+        {
+            BitWriter writer(out);
+            writer.Write(1, 1); // BFINAL
+            writer.Write(1, 2); // BTYPE = fixed Huffman
+
+            const int size = static_cast<int>(data.size());
+            std::vector<int> head(size_t{1} << kHashBits, -1);
+            std::vector<int> prev(static_cast<size_t>(kWindowSize), -1);
+            const auto insert = [&](int pos) {
+                if (pos + kMinMatch > size)
+                {
+                    return;
+                }
+                const uint32_t hash = Hash3(&data[static_cast<size_t>(pos)]);
+                prev[static_cast<size_t>(pos & (kWindowSize - 1))] = head[hash];
+                head[hash] = pos;
+            };
+
+            int pos = 0;
+            while (pos < size)
+            {
+                int bestLength = 0;
+                int bestDistance = 0;
+                if (pos + kMinMatch <= size)
+                {
+                    const int maxLength = std::min(kMaxMatch, size - pos);
+                    int candidate = head[Hash3(&data[static_cast<size_t>(pos)])];
+                    for (int chain = 0; chain < kMaxChain && candidate >= 0 && pos - candidate <= kWindowSize; ++chain)
+                    {
+                        int length = 0;
+                        while (length < maxLength && data[static_cast<size_t>(candidate + length)] == data[static_cast<size_t>(pos + length)])
+                        {
+                            ++length;
+                        }
+                        if (length > bestLength)
+                        {
+                            bestLength = length;
+                            bestDistance = pos - candidate;
+                            if (length == maxLength)
+                            {
+                                break;
+                            }
+                        }
+                        const int next = prev[static_cast<size_t>(candidate & (kWindowSize - 1))];
+                        if (next >= candidate)
+                        {
+                            break; // The slot was reused by a newer position; the chain ends here.
+                        }
+                        candidate = next;
+                    }
+                }
+
+                if (bestLength >= kMinMatch)
+                {
+                    WriteMatch(writer, bestLength, bestDistance);
+                    for (int i = 0; i < bestLength; ++i)
+                    {
+                        insert(pos + i);
+                    }
+                    pos += bestLength;
+                }
+                else
+                {
+                    WriteLiteralOrLength(writer, data[static_cast<size_t>(pos)]);
+                    insert(pos);
+                    ++pos;
+                }
+            }
+            WriteLiteralOrLength(writer, 256);
+            writer.Flush();
+        }
+
+        void AppendBigEndian32(std::vector<uint8_t>& out, uint32_t value)
+        {
+            out.push_back(static_cast<uint8_t>(value >> 24));
+            out.push_back(static_cast<uint8_t>(value >> 16));
+            out.push_back(static_cast<uint8_t>(value >> 8));
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        void AppendChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& payload)
+        {
+            AppendBigEndian32(out, static_cast<uint32_t>(payload.size()));
+            const size_t typeOffset = out.size();
+            out.insert(out.end(), type, type + 4);
+            out.insert(out.end(), payload.begin(), payload.end());
+            AppendBigEndian32(out, Crc32(out.data() + typeOffset, out.size() - typeOffset));
+        }
+
+        bool WriteFile(const std::string& path, const uint8_t* data, size_t size, std::string& errorMessage)
+        {
+            std::ofstream file(std::filesystem::u8path(path), std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                errorMessage = "Unable to open " + path + " for writing";
+                return false;
+            }
+            file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+            if (!file)
+            {
+                errorMessage = "Failed writing " + path;
+                return false;
+            }
+            return true;
+        }
+
+        bool HasExtension(const std::string& path, const char* extension)
+        {
+            const std::string ext(extension);
+            if (path.size() < ext.size())
+            {
+                return false;
+            }
+            return std::equal(ext.begin(), ext.end(), path.end() - static_cast<std::ptrdiff_t>(ext.size()),
+                              [](char a, char b) { return a == static_cast<char>(std::tolower(static_cast<unsigned char>(b))); });
+        }
+    }
+
+    std::vector<uint8_t> EncodePng(const uint8_t* pixels, int width, int height)
+    {
+        const size_t rowBytes = static_cast<size_t>(width) * 4u;
+        std::vector<uint8_t> filtered;
+        filtered.reserve(static_cast<size_t>(height) * (rowBytes + 1u));
+        for (int y = 0; y < height; ++y)
+        {
+            const uint8_t* row = pixels + static_cast<size_t>(y) * rowBytes;
+            filtered.push_back(1); // Sub: renders are smooth, so byte deltas turn gradients into runs.
+            for (size_t i = 0; i < rowBytes; ++i)
+            {
+                filtered.push_back(static_cast<uint8_t>(row[i] - (i >= 4 ? row[i - 4] : 0)));
+            }
+        }
+
+        std::vector<uint8_t> zlib = {0x78, 0x01};
+        DeflateFixed(filtered, zlib);
+        AppendBigEndian32(zlib, Adler32(filtered.data(), filtered.size()));
+
+        std::vector<uint8_t> header;
+        AppendBigEndian32(header, static_cast<uint32_t>(width));
+        AppendBigEndian32(header, static_cast<uint32_t>(height));
+        header.insert(header.end(), {8, 6, 0, 0, 0}); // 8-bit RGBA, deflate, adaptive filtering, no interlace.
+
+        std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+        AppendChunk(png, "IHDR", header);
+        AppendChunk(png, "IDAT", zlib);
+        AppendChunk(png, "IEND", {});
+        return png;
+    }
+
+    bool SavePngFile(const std::string& path, const uint8_t* pixels, int width, int height, std::string& errorMessage)
+    {
+        const std::vector<uint8_t> png = EncodePng(pixels, width, height);
+        return WriteFile(path, png.data(), png.size(), errorMessage);
+    }
+
+    bool SavePpmFile(const std::string& path, const uint8_t* pixels, int width, int height, std::string& errorMessage)
+    {
+        const std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+        std::vector<uint8_t> bytes(header.begin(), header.end());
+        bytes.reserve(bytes.size() + static_cast<size_t>(width) * static_cast<size_t>(height) * 3u);
+        const size_t pixelCount = static_cast<size_t>(width) * static_cast<size_t>(height);
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            bytes.insert(bytes.end(), pixels + i * 4u, pixels + i * 4u + 3u);
+        }
+        return WriteFile(path, bytes.data(), bytes.size(), errorMessage);
+    }
+
+    bool SaveImageFile(const std::string& path, const uint8_t* pixels, int width, int height, std::string& errorMessage)
+    {
+        if (HasExtension(path, ".ppm"))
+        {
+            return SavePpmFile(path, pixels, width, height, errorMessage);
+        }
+        return SavePngFile(path, pixels, width, height, errorMessage);
+    }
+}
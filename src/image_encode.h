@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Writers for the headless tools: thumbnails, regression images and reference renders. PNGs use
+// Sub-filtered rows and a single fixed-Huffman deflate block, which keeps the encoder small and
+// still shrinks flat-shaded renders several times over; files are somewhat larger than an
+// optimising encoder's.
+namespace vengine
+{
+    // pixels are width * height * 4 bytes of RGBA8, top row first, no row padding.
+    std::vector<uint8_t> EncodePng(const uint8_t* pixels, int width, int height);
+    bool SavePngFile(const std::string& path, const uint8_t* pixels, int width, int height, std::string& errorMessage);
+
+    // Binary PPM (P6); alpha is dropped.
+    bool SavePpmFile(const std::string& path, const uint8_t* pixels, int width, int height, std::string& errorMessage);
+
+    // Picks the format from the extension: ".ppm" writes PPM, anything else PNG.
+    bool SaveImageFile(const std::string& path, const uint8_t* pixels, int width, int height, std::string& errorMessage);
+}
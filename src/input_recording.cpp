@@ -0,0 +1,303 @@
+#include "input_recording.h"
+#include "byte_codec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace vengine
+{
+    namespace
+    {
+        constexpr char kMagic[4] = {'V', 'I', 'N', 'P'};
+        constexpr uint8_t kVersion = 1;
+
+        uint64_t NowMicros()
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+
+        double Percentile(std::vector<double> values, double fraction)
+        {
+            if (values.empty())
+            {
+                return 0.0;
+            }
+            const size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())));
+            std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+            return values[index];
+        }
+    }
+
+    bool SaveInputRecording(const std::string& path, const InputRecording& recording, std::string& error)
+    {
+        std::vector<uint8_t> bytes(std::begin(kMagic), std::end(kMagic));
+        bytes.push_back(kVersion);
+        bytes.push_back(static_cast<uint8_t>(recording.source));
+        uint8_t deltaBytes[sizeof(float)];
+        std::memcpy(deltaBytes, &recording.fixedDeltaTime, sizeof(float));
+        bytes.insert(bytes.end(), std::begin(deltaBytes), std::end(deltaBytes));
+        WriteSigned(bytes, recording.viewportWidth);
+        WriteSigned(bytes, recording.viewportHeight);
+        WriteVarint(bytes, recording.frameCount);
+        WriteVarint(bytes, recording.events.size());
+
+        uint32_t previousFrame = 0;
+        uint64_t previousTime = 0;
+        for (const InputEvent& event : recording.events)
+        {
+            WriteVarint(bytes, event.frame - previousFrame);
+            WriteVarint(bytes, event.timeMicros - previousTime);
+            WriteVarint(bytes, event.kind);
+            uint8_t mask = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                mask |= event.payload[i] != 0 ? static_cast<uint8_t>(1u << i) : uint8_t{0};
+            }
+            bytes.push_back(mask);
+            for (int i = 0; i < 4; ++i)
+            {
+                if (event.payload[i] != 0)
+                {
+                    WriteSigned(bytes, event.payload[i]);
+                }
+            }
+            previousFrame = event.frame;
+            previousTime = event.timeMicros;
+        }
+
+        std::ofstream file(std::filesystem::u8path(path), std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+        {
+            error = "cannot write " + path;
+            return false;
+        }
+        return true;
+    }
+
+    bool LoadInputRecording(const std::string& path, InputRecording& recording, std::string& error)
+    {
+        std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+        if (!file)
+        {
+            error = "cannot open " + path;
+            return false;
+        }
+        const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        ByteReader reader(bytes.data(), bytes.size());
+        char magic[4] = {};
+        uint8_t version = 0;
+        uint8_t source = 0;
+        if (!reader.Bytes(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 || !reader.Byte(version) || !reader.Byte(source))
+        {
+            error = path + " is not an input recording";
+            return false;
+        }
+        if (version != kVersion)
+        {
+            error = path + " has unsupported version " + std::to_string(version);
+            return false;
+        }
+
+        InputRecording loaded;
+        loaded.source = static_cast<InputSource>(source);
+        int64_t width = 0;
+        int64_t height = 0;
+        uint64_t frameCount = 0;
+        uint64_t eventCount = 0;
+        // Every event takes at least four bytes, which bounds the count before anything is allocated.
+        if (!reader.Bytes(&loaded.fixedDeltaTime, sizeof(float)) || !reader.Signed(width) || !reader.Signed(height) || !reader.Varint(frameCount) ||
+            !reader.Varint(eventCount) || eventCount > reader.Remaining() / 4 || frameCount > UINT32_MAX)
+        {
+            error = path + " has a truncated header";
+            return false;
+        }
+        loaded.viewportWidth = static_cast<int32_t>(width);
+        loaded.viewportHeight = static_cast<int32_t>(height);
+        loaded.frameCount = static_cast<uint32_t>(frameCount);
+        loaded.events.resize(static_cast<size_t>(eventCount));
+
+        uint64_t frame = 0;
+        uint64_t time = 0;
+        for (InputEvent& event : loaded.events)
+        {
+            uint64_t frameDelta = 0;
+            uint64_t timeDelta = 0;
+            uint64_t kind = 0;
+            uint8_t mask = 0;
+            if (!reader.Varint(frameDelta) || !reader.Varint(timeDelta) || !reader.Varint(kind) || !reader.Byte(mask))
+            {
+                error = path + " is truncated";
+                return false;
+            }
+            frame += frameDelta;
+            time += timeDelta;
+            if (frame >= loaded.frameCount)
+            {
+                error = path + " has an event past its last frame";
+                return false;
+            }
+            event.frame = static_cast<uint32_t>(frame);
+            event.timeMicros = time;
+            event.kind = static_cast<uint32_t>(kind);
+            for (int i = 0; i < 4; ++i)
+            {
+                if ((mask & (1u << i)) != 0 && !reader.Signed(event.payload[i]))
+                {
+                    error = path + " is truncated";
+                    return false;
+                }
+            }
+        }
+
+        recording = std::move(loaded);
+        return true;
+    }
+
+    void InputRecorder::Start(InputSource source, int viewportWidth, int viewportHeight)
+    {
+        m_recording = InputRecording{};
+        m_recording.source = source;
+        m_recording.viewportWidth = viewportWidth;
+        m_recording.viewportHeight = viewportHeight;
+        m_startMicros = NowMicros();
+        m_active = true;
+    }
+
+    void InputRecorder::BeginFrame()
+    {
+        if (m_active)
+        {
+            ++m_recording.frameCount;
+        }
+    }
+
+    void InputRecorder::Record(uint32_t kind, int64_t a, int64_t b, int64_t c, int64_t d)
+    {
+        if (!m_active)
+        {
+            return;
+        }
+        // Events that arrive before the first frame play back on it.
+        if (m_recording.frameCount == 0)
+        {
+            m_recording.frameCount = 1;
+        }
+        InputEvent event;
+        event.frame = m_recording.frameCount - 1;
+        event.timeMicros = NowMicros() - m_startMicros;
+        event.kind = kind;
+        event.payload[0] = a;
+        event.payload[1] = b;
+        event.payload[2] = c;
+        event.payload[3] = d;
+        m_recording.events.push_back(event);
+    }
+
+    bool InputRecorder::Stop(const std::string& path, std::string& error)
+    {
+        if (!m_active)
+        {
+            error = "not recording";
+            return false;
+        }
+        m_active = false;
+        const double seconds = static_cast<double>(NowMicros() - m_startMicros) * 1e-6;
+        if (m_recording.frameCount > 0 && seconds > 0.0)
+        {
+            m_recording.fixedDeltaTime = static_cast<float>(seconds / static_cast<double>(m_recording.frameCount));
+        }
+        return SaveInputRecording(path, m_recording, error);
+    }
+
+    bool InputReplayer::Start(const std::string& path, InputSource expectedSource, float fixedDeltaTime, std::string& error)
+    {
+        InputRecording recording;
+        if (!LoadInputRecording(path, recording, error))
+        {
+            return false;
+        }
+        if (recording.source != expectedSource)
+        {
+            error = path + " was recorded by a different frontend";
+            return false;
+        }
+        m_recording = std::move(recording);
+        m_deltaTime = fixedDeltaTime > 0.0f ? fixedDeltaTime : m_recording.fixedDeltaTime;
+        m_frameMs.clear();
+        m_frameEventCounts.clear();
+        m_frameBegin = m_frameEnd = 0;
+        m_frame = 0;
+        m_started = false;
+        m_active = true;
+        return true;
+    }
+
+    bool InputReplayer::BeginFrame()
+    {
+        if (!m_active)
+        {
+            return false;
+        }
+        if (m_started)
+        {
+            ++m_frame;
+        }
+        m_started = true;
+        if (m_frame >= m_recording.frameCount)
+        {
+            m_active = false;
+            m_frameBegin = m_frameEnd = m_recording.events.size();
+            return false;
+        }
+        m_frameBegin = m_frameEnd;
+        while (m_frameEnd < m_recording.events.size() && m_recording.events[m_frameEnd].frame <= m_frame)
+        {
+            ++m_frameEnd;
+        }
+        m_frameEventCounts.push_back(static_cast<uint32_t>(m_frameEnd - m_frameBegin));
+        return true;
+    }
+
+    void InputReplayer::AddFrameTime(double milliseconds)
+    {
+        m_frameMs.push_back(milliseconds);
+    }
+
+    std::string InputReplayer::TimingSummary() const
+    {
+        double total = 0.0;
+        for (double ms : m_frameMs)
+        {
+            total += ms;
+        }
+        const double mean = m_frameMs.empty() ? 0.0 : total / static_cast<double>(m_frameMs.size());
+        const double worst = m_frameMs.empty() ? 0.0 : *std::max_element(m_frameMs.begin(), m_frameMs.end());
+        char line[160];
+        std::snprintf(line, sizeof(line), "%zu frames: mean %.2f ms, median %.2f ms, p95 %.2f ms, max %.2f ms", m_frameMs.size(), mean,
+                      Percentile(m_frameMs, 0.5), Percentile(m_frameMs, 0.95), worst);
+        return line;
+    }
+
+    bool InputReplayer::WriteTimingReport(const std::string& path, std::string& error) const
+    {
+        std::ofstream file(std::filesystem::u8path(path), std::ios::trunc);
+        if (!file)
+        {
+            error = "cannot write " + path;
+            return false;
+        }
+        file << "frame,ms,events\n";
+        for (size_t i = 0; i < m_frameMs.size(); ++i)
+        {
+            file << i << ',' << m_frameMs[i] << ',' << (i < m_frameEventCounts.size() ? m_frameEventCounts[i] : 0u) << '\n';
+        }
+        return static_cast<bool>(file);
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Input capture for reproducing sessions. A frontend records the raw events it receives (Win32
+// messages or SDL events), each tagged with the frame it arrived in. Replay hands the same events
+// back on the same frames while the frame loop runs on a fixed time step, so every replay of a
+// file walks through identical frames no matter how fast the machine is; a slow session seen once
+// can be rerun under a profiler as often as needed.
+//
+// Files are small: events are stored as deltas from the previous one in LEB128 varints, and
+// payload words that are zero are left out entirely.
+namespace vengine
+{
+    // Which frontend wrote a recording; the payload layout is specific to it.
+    enum class InputSource : uint8_t
+    {
+        Win32 = 1,
+        Sdl = 2,
+    };
+
+    // One raw event. kind is the frontend's own type id (a WM_* message or an SDL event type); the
+    // payload words carry whatever the frontend needs to rebuild the event.
+    struct InputEvent
+    {
+        uint32_t frame = 0;
+        uint64_t timeMicros = 0; // Since recording started; informational only, replay goes by frame.
+        uint32_t kind = 0;
+        int64_t payload[4] = {};
+    };
+
+    struct InputRecording
+    {
+        InputSource source = InputSource::Win32;
+        float fixedDeltaTime = 1.0f / 60.0f; // The recorded session's mean frame time.
+        int32_t viewportWidth = 0;
+        int32_t viewportHeight = 0;
+        uint32_t frameCount = 0;
+        std::vector<InputEvent> events; // Sorted by frame.
+    };
+
+    bool SaveInputRecording(const std::string& path, const InputRecording& recording, std::string& error);
+    bool LoadInputRecording(const std::string& path, InputRecording& recording, std::string& error);
+
+    class InputRecorder
+    {
+    public:
+        void Start(InputSource source, int viewportWidth, int viewportHeight);
+        bool Active() const { return m_active; }
+
+        // Call once at the top of every frame, before the frame's events are pumped.
+        void BeginFrame();
+        void Record(uint32_t kind, int64_t a = 0, int64_t b = 0, int64_t c = 0, int64_t d = 0);
+
+        // Writes the file and stops recording.
+        bool Stop(const std::string& path, std::string& error);
+
+        size_t EventCount() const { return m_recording.events.size(); }
+
+    private:
+        InputRecording m_recording;
+        uint64_t m_startMicros = 0;
+        bool m_active = false;
+    };
+
+    class InputReplayer
+    {
+    public:
+        // fixedDeltaTime <= 0 keeps the recorded session's mean frame time.
+        bool Start(const std::string& path, InputSource expectedSource, float fixedDeltaTime, std::string& error);
+        bool Active() const { return m_active; }
+
+        // Advances to the next recorded frame. Returns false, and stops, once the recording is
+        // exhausted.
+        bool BeginFrame();
+
+        // The events recorded on the current frame, in arrival order.
+        const InputEvent* FrameEventsBegin() const { return m_recording.events.data() + m_frameBegin; }
+        const InputEvent* FrameEventsEnd() const { return m_recording.events.data() + m_frameEnd; }
+
+        float FixedDeltaTime() const { return m_deltaTime; }
+        // Seconds of simulated time since replay started; stands in for the wall clock.
+        double VirtualSeconds() const { return static_cast<double>(m_frame) * m_deltaTime; }
+        uint32_t Frame() const { return m_frame; }
+        const InputRecording& Recording() const { return m_recording; }
+
+        // Wall-clock cost of the frame just replayed, for the timing report.
+        void AddFrameTime(double milliseconds);
+        // One line: frame count, mean, median, p95 and worst frame.
+        std::string TimingSummary() const;
+        // frame,ms,events per line.
+        bool WriteTimingReport(const std::string& path, std::string& error) const;
+
+    private:
+        InputRecording m_recording;
+        std::vector<double> m_frameMs;
+        std::vector<uint32_t> m_frameEventCounts;
+        size_t m_frameBegin = 0;
+        size_t m_frameEnd = 0;
+        uint32_t m_frame = 0;
+        float m_deltaTime = 1.0f / 60.0f;
+        bool m_started = false;
+        bool m_active = false;
+    };
+}
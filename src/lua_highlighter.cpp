@@ -0,0 +1,274 @@
+#include "lua_highlighter.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+
+namespace vengine
+{
+    namespace
+    {
+        constexpr std::array<const char*, 22> kLuaKeywords = {
+            "and", "break", "do", "else", "elseif", "end", "false", "for", "function",
+            "goto", "if", "in", "local", "nil", "not", "or", "repeat", "return",
+            "then", "true", "until", "while"};
+
+        // (3 * first + 13 * last + length) & 63 is collision-free over kLuaKeywords, so a keyword
+        // test is one table load plus a length/memcmp check.
+        constexpr size_t kKeywordSlots = 64;
+
+        constexpr size_t KeywordSlot(char first, char last, size_t length)
+        {
+            return (3u * static_cast<unsigned char>(first) + 13u * static_cast<unsigned char>(last) + length) & (kKeywordSlots - 1u);
+        }
+
+        constexpr size_t ConstexprLength(const char* text)
+        {
+            size_t length = 0;
+            while (text[length] != '\0')
+            {
+                ++length;
+            }
+            return length;
+        }
+
+        constexpr std::array<const char*, kKeywordSlots> BuildKeywordTable()
+        {
+            std::array<const char*, kKeywordSlots> table{};
+            for (const char* keyword : kLuaKeywords)
+            {
+                const size_t length = ConstexprLength(keyword);
+                table[KeywordSlot(keyword[0], keyword[length - 1], length)] = keyword;
+            }
+            return table;
+        }
+
+        constexpr std::array<const char*, kKeywordSlots> kKeywordTable = BuildKeywordTable();
+
+        constexpr size_t CountKeywordSlots()
+        {
+            size_t used = 0;
+            for (const char* entry : kKeywordTable)
+            {
+                used += entry != nullptr ? 1u : 0u;
+            }
+            return used;
+        }
+
+        static_assert(CountKeywordSlots() == kLuaKeywords.size(), "Lua keyword hash has a collision");
+
+        bool IsDigit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        bool IsIdentifierChar(char c)
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || IsDigit(c) || c == '_';
+        }
+
+        void PushToken(std::vector<LuaToken>& tokens, const char* lineStart, const char* begin, const char* end, LuaTokenKind kind)
+        {
+            const uint32_t offset = static_cast<uint32_t>(begin - lineStart);
+            const uint32_t length = static_cast<uint32_t>(end - begin);
+            if (kind == LuaTokenKind::Default && !tokens.empty())
+            {
+                LuaToken& previous = tokens.back();
+                if (previous.kind == LuaTokenKind::Default && previous.begin + previous.length == offset)
+                {
+                    previous.length += length;
+                    return;
+                }
+            }
+            LuaToken token;
+            token.begin = offset;
+            token.length = length;
+            token.kind = kind;
+            tokens.push_back(token);
+        }
+
+        void AppendLexedLines(const std::string& text, size_t begin, size_t end, std::vector<LuaLine>& out)
+        {
+            size_t lineStart = begin;
+            for (;;)
+            {
+                const void* newline = lineStart < end ? std::memchr(text.data() + lineStart, '\n', end - lineStart) : nullptr;
+                const size_t lineEnd = newline ? static_cast<size_t>(static_cast<const char*>(newline) - text.data()) : end;
+                LuaLine line;
+                line.offset = lineStart;
+                line.length = lineEnd - lineStart;
+                LexLuaLine(text.data() + lineStart, text.data() + lineEnd, line.tokens);
+                out.push_back(std::move(line));
+                if (!newline)
+                {
+                    break;
+                }
+                lineStart = lineEnd + 1;
+            }
+        }
+
+        // Index of the line containing byte pos (a line owns its terminating '\n').
+        size_t LineContaining(const std::vector<LuaLine>& lines, size_t pos)
+        {
+            const auto it = std::upper_bound(lines.begin(), lines.end(), pos, [](size_t value, const LuaLine& line) {
+                return value < line.offset;
+            });
+            return static_cast<size_t>(std::max<std::ptrdiff_t>(0, (it - lines.begin()) - 1));
+        }
+    }
+
+    bool IsLuaKeyword(const char* begin, size_t length)
+    {
+        if (length < 2 || length > 8)
+        {
+            return false;
+        }
+        const char* candidate = kKeywordTable[KeywordSlot(begin[0], begin[length - 1], length)];
+        return candidate != nullptr && std::strlen(candidate) == length && std::memcmp(candidate, begin, length) == 0;
+    }
+
+    void LexLuaLine(const char* begin, const char* end, std::vector<LuaToken>& tokens)
+    {
+        tokens.clear();
+        const char* ptr = begin;
+        while (ptr < end)
+        {
+            if (*ptr == '\r')
+            {
+                ++ptr;
+                continue;
+            }
+
+            if (*ptr == '-' && (ptr + 1) < end && *(ptr + 1) == '-')
+            {
+                PushToken(tokens, begin, ptr, end, LuaTokenKind::Comment);
+                break;
+            }
+
+            if (*ptr == '"' || *ptr == '\'')
+            {
+                const char quote = *ptr;
+                const char* tokenStart = ptr++;
+                while (ptr < end)
+                {
+                    if (*ptr == '\\' && (ptr + 1) < end)
+                    {
+                        ptr += 2;
+                        continue;
+                    }
+                    if (*ptr == quote)
+                    {
+                        ++ptr;
+                        break;
+                    }
+                    ++ptr;
+                }
+                PushToken(tokens, begin, tokenStart, ptr, LuaTokenKind::String);
+                continue;
+            }
+
+            if (IsDigit(*ptr))
+            {
+                const char* tokenStart = ptr++;
+                while (ptr < end && (IsDigit(*ptr) || *ptr == '.' || *ptr == 'x' || *ptr == 'X'))
+                {
+                    ++ptr;
+                }
+                PushToken(tokens, begin, tokenStart, ptr, LuaTokenKind::Number);
+                continue;
+            }
+
+            if (IsIdentifierChar(*ptr))
+            {
+                const char* tokenStart = ptr++;
+                while (ptr < end && IsIdentifierChar(*ptr))
+                {
+                    ++ptr;
+                }
+                const bool keyword = IsLuaKeyword(tokenStart, static_cast<size_t>(ptr - tokenStart));
+                PushToken(tokens, begin, tokenStart, ptr, keyword ? LuaTokenKind::Keyword : LuaTokenKind::Default);
+                continue;
+            }
+
+            PushToken(tokens, begin, ptr, ptr + 1, LuaTokenKind::Default);
+            ++ptr;
+        }
+    }
+
+    void LuaHighlightCache::Update(const std::string& text)
+    {
+        if (!m_initialized)
+        {
+            m_lines.clear();
+            AppendLexedLines(text, 0, text.size(), m_lines);
+            m_text = text;
+            m_lastRelexed = m_lines.size();
+            m_initialized = true;
+            return;
+        }
+        if (text == m_text)
+        {
+            m_lastRelexed = 0;
+            return;
+        }
+
+        const size_t oldSize = m_text.size();
+        const size_t newSize = text.size();
+        const size_t shared = std::min(oldSize, newSize);
+        const auto mismatch = std::mismatch(m_text.begin(), m_text.begin() + static_cast<std::ptrdiff_t>(shared), text.begin());
+        const size_t prefix = static_cast<size_t>(mismatch.first - m_text.begin());
+        size_t suffix = 0;
+        while (suffix < shared - prefix && m_text[oldSize - 1 - suffix] == text[newSize - 1 - suffix])
+        {
+            ++suffix;
+        }
+
+        // Old lines [first, last] overlap the changed bytes; everything past them only moves.
+        const size_t first = LineContaining(m_lines, prefix);
+        const size_t last = LineContaining(m_lines, oldSize - suffix);
+        const size_t regionStart = m_lines[first].offset;
+        const size_t oldRegionEnd = m_lines[last].offset + m_lines[last].length;
+        const size_t newRegionEnd = oldRegionEnd + newSize - oldSize;
+
+        std::vector<LuaLine> replacement;
+        AppendLexedLines(text, regionStart, newRegionEnd, replacement);
+        m_lastRelexed = replacement.size();
+
+        for (size_t i = last + 1; i < m_lines.size(); ++i)
+        {
+            m_lines[i].offset = m_lines[i].offset + newSize - oldSize;
+        }
+        if (replacement.size() == last - first + 1)
+        {
+            // Typical keystroke: the line count is unchanged, so no lines need to move.
+            std::move(replacement.begin(), replacement.end(), m_lines.begin() + static_cast<std::ptrdiff_t>(first));
+        }
+        else
+        {
+            const auto eraseBegin = m_lines.begin() + static_cast<std::ptrdiff_t>(first);
+            const auto eraseEnd = m_lines.begin() + static_cast<std::ptrdiff_t>(last + 1);
+            const auto insertAt = m_lines.erase(eraseBegin, eraseEnd);
+            m_lines.insert(insertAt, std::make_move_iterator(replacement.begin()), std::make_move_iterator(replacement.end()));
+        }
+        m_text = text;
+    }
+
+    void LuaHighlightCache::SetLayoutKey(const void* font, float fontSize)
+    {
+        if (font != m_layoutFont || fontSize != m_layoutFontSize)
+        {
+            m_layoutFont = font;
+            m_layoutFontSize = fontSize;
+            InvalidateLayout();
+        }
+    }
+
+    void LuaHighlightCache::InvalidateLayout()
+    {
+        for (LuaLine& line : m_lines)
+        {
+            line.measured = false;
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Line-cached Lua lexer behind the code editor overlays. Lexing is per line (comments run to the
+// end of the line, strings do not span lines), so an edit only invalidates the lines whose bytes
+// changed; everything outside that range keeps its tokens and measured layout.
+namespace vengine
+{
+    enum class LuaTokenKind : uint8_t
+    {
+        Default,
+        Keyword,
+        String,
+        Comment,
+        Number,
+    };
+
+    struct LuaToken
+    {
+        uint32_t begin = 0;  // Byte offset from the start of the line.
+        uint32_t length = 0;
+        LuaTokenKind kind = LuaTokenKind::Default;
+        float x = 0.0f;      // Horizontal offset in pixels, filled in by the renderer's measure pass.
+    };
+
+    struct LuaLine
+    {
+        size_t offset = 0; // Byte offset of the line in the text.
+        size_t length = 0; // Excludes the terminating '\n'.
+        bool measured = false;
+        std::vector<LuaToken> tokens;
+    };
+
+    // Allocation-free keyword test backed by a perfect hash over Lua 5.4's reserved words.
+    bool IsLuaKeyword(const char* begin, size_t length);
+
+    // Tokenizes one line. Adjacent punctuation/whitespace is merged into a single Default token.
+    void LexLuaLine(const char* begin, const char* end, std::vector<LuaToken>& tokens);
+
+    class LuaHighlightCache
+    {
+    public:
+        // Brings the cache in line with text. Unchanged text is a no-op; otherwise only the lines
+        // between the first and last differing byte are re-lexed and the rest are shifted in place.
+        void Update(const std::string& text);
+
+        // Drops measured token positions when the font used to measure them changes.
+        void SetLayoutKey(const void* font, float fontSize);
+        void InvalidateLayout();
+
+        const std::vector<LuaLine>& Lines() const { return m_lines; }
+        std::vector<LuaLine>& Lines() { return m_lines; }
+
+        // Lines re-lexed by the most recent Update, for profiling overlays and benchmarks.
+        size_t LastRelexedLineCount() const { return m_lastRelexed; }
+
+    private:
+        std::string m_text;
+        std::vector<LuaLine> m_lines;
+        size_t m_lastRelexed = 0;
+        bool m_initialized = false;
+        const void* m_layoutFont = nullptr;
+        float m_layoutFontSize = 0.0f;
+    };
+}
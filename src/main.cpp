@@ -1,18 +1,26 @@
 #include <windows.h>
 #include <windowsx.h>
+#include <shellapi.h>
 #include <gdiplus.h>
 #include <GL/gl.h>
 #include <GL/glu.h>
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <random>
 #include <fstream>
 #include <string>
 #include <iterator>
-#include <unordered_set>
+#include <unordered_map>
+#include <thread>
 #include <cstring>
 #include <cctype>
 #include <filesystem>
@@ -24,12 +32,42 @@
 #ifndef GL_CLAMP_TO_EDGE
 #define GL_CLAMP_TO_EDGE 0x812F
 #endif
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_BGRA_EXT
+#define GL_BGRA_EXT 0x80E1
+#endif
 
 #include "imgui.h"
 #include "imgui_impl_win32.h"
 #include "imgui_impl_opengl2.h"
 #include "imgui_stdlib.h"
 
+#include "byte_codec.h"
+#include "chunk_lod.h"
+#include "cube_lighting.h"
+#include "cube_store.h"
+#include "file_watcher.h"
+#include "frame_arena.h"
+#include "frustum.h"
+#include "image_decode.h"
+#include "input_recording.h"
+#include "lua_highlighter.h"
+#include "mesh_import.h"
+#include "occlusion.h"
+#include "region_file.h"
+#include "scene_export.h"
+#include "scene_file.h"
+#include "scene_loader.h"
+#include "script_runtime.h"
+#include "texture_compress.h"
+#include "world_gen.h"
+#include "world_stream.h"
+
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 namespace
@@ -74,7 +112,21 @@ namespace
         return result;
     }
 
-    bool LoadImagePixelsGdiplus(const std::string& path, std::vector<unsigned char>& outPixels, UINT& width, UINT& height, std::string& errorMessage)
+    std::string WideToUtf8(const wchar_t* input)
+    {
+        const int required = input ? WideCharToMultiByte(CP_UTF8, 0, input, -1, nullptr, 0, nullptr, nullptr) : 0;
+        if (required <= 1)
+        {
+            return std::string();
+        }
+        std::string result(static_cast<size_t>(required) - 1, '\0');
+        WideCharToMultiByte(CP_UTF8, 0, input, -1, result.data(), required, nullptr, nullptr);
+        return result;
+    }
+
+    // GDI+ locks straight into the caller's buffer in its native BGRA order; converting to another
+    // order is left to the upload path, which can often skip it entirely.
+    bool LoadImagePixelsGdiplus(const std::string& path, vengine::DecodedImage& image, std::string& errorMessage)
     {
         if (!EnsureGdiplusInitialized())
         {
@@ -96,75 +148,810 @@ namespace
             return false;
         }
 
-        width = bitmap.GetWidth();
-        height = bitmap.GetHeight();
+        const UINT width = bitmap.GetWidth();
+        const UINT height = bitmap.GetHeight();
         if (width == 0 || height == 0)
         {
             errorMessage = "Image has no size";
             return false;
         }
 
+        image.width = static_cast<int>(width);
+        image.height = static_cast<int>(height);
+        image.order = vengine::PixelOrder::Bgra;
+        image.pixels.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u);
+
         Gdiplus::Rect rect(0, 0, width, height);
         Gdiplus::BitmapData data;
-        if (bitmap.LockBits(&rect, Gdiplus::ImageLockModeRead, PixelFormat32bppARGB, &data) != Gdiplus::Ok)
+        data.Width = width;
+        data.Height = height;
+        data.Stride = static_cast<INT>(width * 4u);
+        data.PixelFormat = PixelFormat32bppARGB;
+        data.Scan0 = image.pixels.data();
+        data.Reserved = 0;
+        if (bitmap.LockBits(&rect, Gdiplus::ImageLockModeRead | Gdiplus::ImageLockModeUserInputBuf, PixelFormat32bppARGB, &data) != Gdiplus::Ok)
         {
             errorMessage = "LockBits failed";
             return false;
         }
+        bitmap.UnlockBits(&data);
+        return true;
+    }
 
-        outPixels.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u);
-        for (UINT y = 0; y < height; ++y)
+    // Loaded PNGs are packed into shared atlas pages instead of owning a GL texture each, so
+    // every textured cube on a page can be drawn inside one glBegin/glEnd batch.
+    constexpr int kAtlasPageSize = 2048;
+    constexpr int kAtlasCellStride = 256;
+    constexpr int kAtlasCellGutter = 8; // Edge pixels are replicated into the gutter to stop bleeding.
+    constexpr int kAtlasCellContent = kAtlasCellStride - kAtlasCellGutter * 2;
+    constexpr int kAtlasCellsPerRow = kAtlasPageSize / kAtlasCellStride;
+    constexpr int kAtlasCellsPerPage = kAtlasCellsPerRow * kAtlasCellsPerRow;
+    constexpr int kAtlasMipLevels = 4; // 256 -> 32 px per cell; the gutter is still 1 px at the last level.
+
+    // Atlas pages are stored as DXT5 when the driver exposes S3TC, otherwise as plain RGBA8.
+    using CompressedTexSubImage2DProc = void(APIENTRY*)(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei, const void*);
+    bool g_textureCompressionProbed = false;
+    CompressedTexSubImage2DProc g_glCompressedTexSubImage2D = nullptr;
+    bool g_glSupportsBgra = false;
+    bool g_preferBgraUpload = true; // Content Browser toggle: keep GDI+'s BGRA and skip the swizzle.
+
+    bool AtlasUsesCompression()
+    {
+        if (!g_textureCompressionProbed && wglGetCurrentContext())
         {
-            const unsigned char* srcRow = static_cast<const unsigned char*>(data.Scan0) + y * data.Stride;
-            for (UINT x = 0; x < width; ++x)
+            g_textureCompressionProbed = true;
+            const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+            if (extensions && std::strstr(extensions, "GL_EXT_texture_compression_s3tc"))
             {
-                const size_t dstIndex = (static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)) * 4u;
-                const unsigned char b = srcRow[x * 4 + 0];
-                const unsigned char g = srcRow[x * 4 + 1];
-                const unsigned char r = srcRow[x * 4 + 2];
-                const unsigned char a = srcRow[x * 4 + 3];
-                outPixels[dstIndex + 0] = r;
-                outPixels[dstIndex + 1] = g;
-                outPixels[dstIndex + 2] = b;
-                outPixels[dstIndex + 3] = a;
+                g_glCompressedTexSubImage2D = reinterpret_cast<CompressedTexSubImage2DProc>(wglGetProcAddress("glCompressedTexSubImage2D"));
             }
+            g_glSupportsBgra = extensions && std::strstr(extensions, "GL_EXT_bgra");
         }
+        return g_glCompressedTexSubImage2D != nullptr;
+    }
 
-        bitmap.UnlockBits(&data);
+    // Channel order atlas cells are built and uploaded in. The box filter and mip builder are
+    // channel-agnostic and the BC3 encoder reads either order, so with BGRA the decoded pixels
+    // reach the GPU without a swizzle pass.
+    vengine::PixelOrder AtlasPixelOrder()
+    {
+        const bool compressed = AtlasUsesCompression();
+        return g_preferBgraUpload && (compressed || g_glSupportsBgra) ? vengine::PixelOrder::Bgra : vengine::PixelOrder::Rgba;
+    }
+
+    struct AtlasPage
+    {
+        GLuint id = 0;
+        std::vector<int> freeCells;
+    };
+
+    struct AtlasRegion
+    {
+        int page = -1;
+        int cell = -1;
+        float u0 = 0.0f;
+        float v0 = 0.0f;
+        float u1 = 1.0f;
+        float v1 = 1.0f;
+    };
+
+    std::vector<AtlasPage> g_atlasPages;
+
+    bool CreateAtlasPageTexture(AtlasPage& page)
+    {
+        glGenTextures(1, &page.id);
+        if (page.id == 0)
+        {
+            return false;
+        }
+
+        const GLint internalFormat = AtlasUsesCompression() ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_RGBA8;
+        glBindTexture(GL_TEXTURE_2D, page.id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, kAtlasMipLevels - 1);
+        for (int level = 0; level < kAtlasMipLevels; ++level)
+        {
+            const int size = kAtlasPageSize >> level;
+            glTexImage2D(GL_TEXTURE_2D, level, internalFormat, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        // Stored in reverse so pop_back hands out cells in row order.
+        page.freeCells.clear();
+        page.freeCells.reserve(kAtlasCellsPerPage);
+        for (int cell = kAtlasCellsPerPage - 1; cell >= 0; --cell)
+        {
+            page.freeCells.push_back(cell);
+        }
+        return true;
+    }
+
+    bool AllocateAtlasRegion(AtlasRegion& regionOut)
+    {
+        // Prefer a live page with room, then revive a released page slot, then grow.
+        size_t pageIndex = 0;
+        while (pageIndex < g_atlasPages.size() && (g_atlasPages[pageIndex].id == 0 || g_atlasPages[pageIndex].freeCells.empty()))
+        {
+            ++pageIndex;
+        }
+        if (pageIndex == g_atlasPages.size())
+        {
+            pageIndex = 0;
+            while (pageIndex < g_atlasPages.size() && g_atlasPages[pageIndex].id != 0)
+            {
+                ++pageIndex;
+            }
+            if (pageIndex == g_atlasPages.size())
+            {
+                g_atlasPages.emplace_back();
+            }
+            if (!CreateAtlasPageTexture(g_atlasPages[pageIndex]))
+            {
+                return false;
+            }
+        }
+
+        AtlasPage& page = g_atlasPages[pageIndex];
+        const int cell = page.freeCells.back();
+        page.freeCells.pop_back();
+
+        const float invSize = 1.0f / static_cast<float>(kAtlasPageSize);
+        const int originX = (cell % kAtlasCellsPerRow) * kAtlasCellStride + kAtlasCellGutter;
+        const int originY = (cell / kAtlasCellsPerRow) * kAtlasCellStride + kAtlasCellGutter;
+        regionOut.page = static_cast<int>(pageIndex);
+        regionOut.cell = cell;
+        regionOut.u0 = static_cast<float>(originX) * invSize;
+        regionOut.v0 = static_cast<float>(originY) * invSize;
+        regionOut.u1 = static_cast<float>(originX + kAtlasCellContent) * invSize;
+        regionOut.v1 = static_cast<float>(originY + kAtlasCellContent) * invSize;
+        return true;
+    }
+
+    // The image's aspect ratio fitted inside the cell's content square, so a wide image keeps the
+    // full content width and gets a proportionally shorter height (and a tall one the reverse).
+    void AtlasCellContentSize(int width, int height, int& contentWidth, int& contentHeight)
+    {
+        contentWidth = kAtlasCellContent;
+        contentHeight = kAtlasCellContent;
+        if (width <= 0 || height <= 0)
+        {
+            return;
+        }
+        if (width > height)
+        {
+            contentHeight = std::max(1, static_cast<int>((static_cast<int64_t>(kAtlasCellContent) * height + width / 2) / width));
+        }
+        else if (height > width)
+        {
+            contentWidth = std::max(1, static_cast<int>((static_cast<int64_t>(kAtlasCellContent) * width + height / 2) / height));
+        }
+    }
+
+    // Narrows a region's UV rect to the part of its cell an image of this size fills.
+    void FitAtlasRegionToImage(AtlasRegion& region, int width, int height)
+    {
+        int contentWidth = 0;
+        int contentHeight = 0;
+        AtlasCellContentSize(width, height, contentWidth, contentHeight);
+        const float invSize = 1.0f / static_cast<float>(kAtlasPageSize);
+        region.u1 = region.u0 + static_cast<float>(contentWidth) * invSize;
+        region.v1 = region.v0 + static_cast<float>(contentHeight) * invSize;
+    }
+
+    // Returns the cell to its page and frees the page's VRAM once nothing lives on it any more.
+    void ReleaseAtlasRegion(const AtlasRegion& region)
+    {
+        if (region.page < 0 || static_cast<size_t>(region.page) >= g_atlasPages.size())
+        {
+            return;
+        }
+        AtlasPage& page = g_atlasPages[static_cast<size_t>(region.page)];
+        page.freeCells.push_back(region.cell);
+        if (page.freeCells.size() == static_cast<size_t>(kAtlasCellsPerPage) && page.id != 0)
+        {
+            glDeleteTextures(1, &page.id);
+            page.id = 0;
+            page.freeCells.clear();
+        }
+    }
+
+    // Box-filters (or nearest-samples when upscaling) an arbitrary 32-bit image into the
+    // aspect-correct content rect of one atlas cell, replicating its border pixels over the rest of
+    // the cell and the gutter.
+    void ResampleIntoAtlasCell(const unsigned char* src, int width, int height, std::vector<unsigned char>& cellPixels)
+    {
+        int contentWidth = 0;
+        int contentHeight = 0;
+        AtlasCellContentSize(width, height, contentWidth, contentHeight);
+        cellPixels.resize(static_cast<size_t>(kAtlasCellStride) * static_cast<size_t>(kAtlasCellStride) * 4u);
+        for (int y = 0; y < kAtlasCellStride; ++y)
+        {
+            const int cy = std::clamp(y - kAtlasCellGutter, 0, contentHeight - 1);
+            const int srcY0 = cy * height / contentHeight;
+            const int srcY1 = std::max(srcY0 + 1, (cy + 1) * height / contentHeight);
+            for (int x = 0; x < kAtlasCellStride; ++x)
+            {
+                const int cx = std::clamp(x - kAtlasCellGutter, 0, contentWidth - 1);
+                const int srcX0 = cx * width / contentWidth;
+                const int srcX1 = std::max(srcX0 + 1, (cx + 1) * width / contentWidth);
+
+                unsigned int sum[4] = {0, 0, 0, 0};
+                for (int sy = srcY0; sy < srcY1; ++sy)
+                {
+                    const unsigned char* row = src + static_cast<size_t>(sy) * static_cast<size_t>(width) * 4u;
+                    for (int sx = srcX0; sx < srcX1; ++sx)
+                    {
+                        sum[0] += row[sx * 4 + 0];
+                        sum[1] += row[sx * 4 + 1];
+                        sum[2] += row[sx * 4 + 2];
+                        sum[3] += row[sx * 4 + 3];
+                    }
+                }
+                const unsigned int count = static_cast<unsigned int>((srcY1 - srcY0) * (srcX1 - srcX0));
+                unsigned char* dst = &cellPixels[(static_cast<size_t>(y) * kAtlasCellStride + static_cast<size_t>(x)) * 4u];
+                for (int c = 0; c < 4; ++c)
+                {
+                    dst[c] = static_cast<unsigned char>(sum[c] / count);
+                }
+            }
+        }
+    }
+
+    // Box-filters level 0 of a cell down into the remaining mip levels.
+    void BuildAtlasCellMips(std::array<std::vector<unsigned char>, kAtlasMipLevels>& levels)
+    {
+        for (int level = 1; level < kAtlasMipLevels; ++level)
+        {
+            const int srcSize = kAtlasCellStride >> (level - 1);
+            const int dstSize = kAtlasCellStride >> level;
+            const std::vector<unsigned char>& src = levels[static_cast<size_t>(level - 1)];
+            std::vector<unsigned char>& dst = levels[static_cast<size_t>(level)];
+            dst.resize(static_cast<size_t>(dstSize) * static_cast<size_t>(dstSize) * 4u);
+            for (int y = 0; y < dstSize; ++y)
+            {
+                const unsigned char* row0 = &src[static_cast<size_t>(y * 2) * static_cast<size_t>(srcSize) * 4u];
+                const unsigned char* row1 = row0 + static_cast<size_t>(srcSize) * 4u;
+                for (int x = 0; x < dstSize; ++x)
+                {
+                    unsigned char* out = &dst[(static_cast<size_t>(y) * static_cast<size_t>(dstSize) + static_cast<size_t>(x)) * 4u];
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        const int sum = row0[x * 8 + c] + row0[x * 8 + 4 + c] + row1[x * 8 + c] + row1[x * 8 + 4 + c];
+                        out[c] = static_cast<unsigned char>((sum + 2) / 4);
+                    }
+                }
+            }
+        }
+    }
+
+    size_t AtlasCellLevelBytes(int level, bool compressed)
+    {
+        const size_t size = static_cast<size_t>(kAtlasCellStride >> level);
+        return compressed ? (size / 4u) * (size / 4u) * 16u : size * size * 4u;
+    }
+
+    // One atlas cell's mip chain. The pointers reference either freshly encoded data or a mapped cache file.
+    struct AtlasCellLevels
+    {
+        bool compressed = false;
+        vengine::PixelOrder order = vengine::PixelOrder::Rgba; // Only meaningful when uncompressed.
+        std::array<const unsigned char*, kAtlasMipLevels> data{};
+    };
+
+    void UploadAtlasCell(const AtlasRegion& region, const AtlasCellLevels& levels)
+    {
+        const AtlasPage& page = g_atlasPages[static_cast<size_t>(region.page)];
+        const int cellX = (region.cell % kAtlasCellsPerRow) * kAtlasCellStride;
+        const int cellY = (region.cell / kAtlasCellsPerRow) * kAtlasCellStride;
+        glBindTexture(GL_TEXTURE_2D, page.id);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        for (int level = 0; level < kAtlasMipLevels; ++level)
+        {
+            const int size = kAtlasCellStride >> level;
+            if (levels.compressed)
+            {
+                g_glCompressedTexSubImage2D(GL_TEXTURE_2D, level, cellX >> level, cellY >> level, size, size,
+                                            GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+                                            static_cast<GLsizei>(AtlasCellLevelBytes(level, true)),
+                                            levels.data[static_cast<size_t>(level)]);
+            }
+            else
+            {
+                const GLenum format = levels.order == vengine::PixelOrder::Bgra ? GL_BGRA_EXT : GL_RGBA;
+                glTexSubImage2D(GL_TEXTURE_2D, level, cellX >> level, cellY >> level, size, size, format, GL_UNSIGNED_BYTE, levels.data[static_cast<size_t>(level)]);
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // Mipmapped (and, with S3TC, pre-compressed) atlas cells are cached under texture_cache/ next to the
+    // exe, keyed by source path. A launch maps the blob directly instead of decoding the PNG again;
+    // the source is only re-decoded when its size/mtime stamp and content hash both changed.
+    constexpr uint32_t kTextureCacheMagic = 0x43544756u; // "VGTC"
+    constexpr uint32_t kTextureCacheVersion = 3;
+    std::string g_textureCacheDirectory;
+
+    struct TextureCacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t format; // TextureCacheFormat
+        uint32_t cellSize;
+        uint32_t levelCount;
+        uint32_t sourceWidth;
+        uint32_t sourceHeight;
+        uint32_t pathLength;
+        uint64_t sourceSize;
+        uint64_t sourceWriteTime;
+        uint64_t sourceHash;
+    };
+
+    enum TextureCacheFormat : uint32_t
+    {
+        kTextureCacheRgba8 = 0,
+        kTextureCacheDxt5 = 1,
+        kTextureCacheBgra8 = 2,
+    };
+
+    uint32_t TextureCacheFormatFor(bool compressed, vengine::PixelOrder order)
+    {
+        if (compressed)
+        {
+            return kTextureCacheDxt5;
+        }
+        return order == vengine::PixelOrder::Bgra ? kTextureCacheBgra8 : kTextureCacheRgba8;
+    }
+
+    bool StatTextureSource(const std::string& path, uint64_t& sizeOut, uint64_t& writeTimeOut)
+    {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        const fs::path source = fs::u8path(path);
+        const uintmax_t size = fs::file_size(source, ec);
+        if (ec)
+        {
+            return false;
+        }
+        const fs::file_time_type writeTime = fs::last_write_time(source, ec);
+        if (ec)
+        {
+            return false;
+        }
+        sizeOut = static_cast<uint64_t>(size);
+        writeTimeOut = static_cast<uint64_t>(writeTime.time_since_epoch().count());
+        return true;
+    }
+
+    bool HashTextureSource(const std::string& path, uint64_t& hashOut)
+    {
+        std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+        uint64_t hash = vengine::HashBytes(nullptr, 0);
+        char buffer[64 * 1024];
+        while (file)
+        {
+            file.read(buffer, sizeof(buffer));
+            hash = vengine::HashBytes(buffer, static_cast<size_t>(file.gcount()), hash);
+        }
+        hashOut = hash;
+        return true;
+    }
+
+    std::string BuildTextureCachePath(const std::string& sourcePath)
+    {
+        std::ostringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << vengine::HashBytes(sourcePath.data(), sourcePath.size()) << ".vtc";
+        return g_textureCacheDirectory + name.str();
+    }
+
+    size_t TextureCacheDataOffset(uint32_t pathLength)
+    {
+        return (sizeof(TextureCacheHeader) + pathLength + 15u) & ~static_cast<size_t>(15u);
+    }
+
+    // Read-only view of a cache blob; level pointers handed to GL point straight into the mapping.
+    struct MappedFile
+    {
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile()
+        {
+            Close();
+        }
+
+        bool Open(const std::string& path)
+        {
+            Close();
+            const std::wstring widePath = Utf8ToWide(path);
+            file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+            {
+                return false;
+            }
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+            {
+                Close();
+                return false;
+            }
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping)
+            {
+                Close();
+                return false;
+            }
+            data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (!data)
+            {
+                Close();
+                return false;
+            }
+            size = static_cast<size_t>(fileSize.QuadPart);
+            return true;
+        }
+
+        void Close()
+        {
+            if (data)
+            {
+                UnmapViewOfFile(data);
+                data = nullptr;
+            }
+            if (mapping)
+            {
+                CloseHandle(mapping);
+                mapping = nullptr;
+            }
+            if (file != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(file);
+                file = INVALID_HANDLE_VALUE;
+            }
+            size = 0;
+        }
+    };
+
+    // Maps a valid cache entry for sourcePath. staleStampOut is set when the blob is reusable but the
+    // source was touched without changing, so the caller can refresh the stored stamp.
+    bool LoadTextureCacheEntry(const std::string& sourcePath,
+                               MappedFile& mapping,
+                               AtlasCellLevels& levelsOut,
+                               int& widthOut,
+                               int& heightOut,
+                               bool& staleStampOut)
+    {
+        staleStampOut = false;
+        if (g_textureCacheDirectory.empty() || !mapping.Open(BuildTextureCachePath(sourcePath)))
+        {
+            return false;
+        }
+
+        TextureCacheHeader header;
+        if (mapping.size < sizeof(header))
+        {
+            return false;
+        }
+        std::memcpy(&header, mapping.data, sizeof(header));
+        const bool compressed = AtlasUsesCompression();
+        const vengine::PixelOrder order = AtlasPixelOrder();
+        if (header.magic != kTextureCacheMagic || header.version != kTextureCacheVersion ||
+            header.cellSize != static_cast<uint32_t>(kAtlasCellStride) || header.levelCount != static_cast<uint32_t>(kAtlasMipLevels) ||
+            header.format != TextureCacheFormatFor(compressed, order))
+        {
+            return false;
+        }
+
+        size_t offset = TextureCacheDataOffset(header.pathLength);
+        size_t expectedSize = offset;
+        for (int level = 0; level < kAtlasMipLevels; ++level)
+        {
+            expectedSize += AtlasCellLevelBytes(level, compressed);
+        }
+        if (mapping.size != expectedSize ||
+            header.pathLength != sourcePath.size() ||
+            std::memcmp(mapping.data + sizeof(header), sourcePath.data(), sourcePath.size()) != 0)
+        {
+            return false;
+        }
+
+        uint64_t sourceSize = 0;
+        uint64_t sourceWriteTime = 0;
+        if (!StatTextureSource(sourcePath, sourceSize, sourceWriteTime))
+        {
+            return false;
+        }
+        if (sourceSize != header.sourceSize || sourceWriteTime != header.sourceWriteTime)
+        {
+            uint64_t sourceHash = 0;
+            if (sourceSize != header.sourceSize || !HashTextureSource(sourcePath, sourceHash) || sourceHash != header.sourceHash)
+            {
+                return false;
+            }
+            staleStampOut = true;
+        }
+
+        levelsOut.compressed = compressed;
+        levelsOut.order = order;
+        for (int level = 0; level < kAtlasMipLevels; ++level)
+        {
+            levelsOut.data[static_cast<size_t>(level)] = mapping.data + offset;
+            offset += AtlasCellLevelBytes(level, compressed);
+        }
+        widthOut = static_cast<int>(header.sourceWidth);
+        heightOut = static_cast<int>(header.sourceHeight);
         return true;
     }
 
+    void StoreTextureCacheEntry(const std::string& sourcePath, const AtlasCellLevels& levels, int width, int height)
+    {
+        if (g_textureCacheDirectory.empty())
+        {
+            return;
+        }
+
+        TextureCacheHeader header{};
+        header.magic = kTextureCacheMagic;
+        header.version = kTextureCacheVersion;
+        header.format = TextureCacheFormatFor(levels.compressed, levels.order);
+        header.cellSize = static_cast<uint32_t>(kAtlasCellStride);
+        header.levelCount = static_cast<uint32_t>(kAtlasMipLevels);
+        header.sourceWidth = static_cast<uint32_t>(width);
+        header.sourceHeight = static_cast<uint32_t>(height);
+        header.pathLength = static_cast<uint32_t>(sourcePath.size());
+        if (!StatTextureSource(sourcePath, header.sourceSize, header.sourceWriteTime) ||
+            !HashTextureSource(sourcePath, header.sourceHash))
+        {
+            return;
+        }
+
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        fs::create_directories(fs::u8path(g_textureCacheDirectory), ec);
+
+        // Written to a temp file first so an interrupted write never leaves a truncated blob behind.
+        const std::string cachePath = BuildTextureCachePath(sourcePath);
+        const std::string tempPath = cachePath + ".tmp";
+        {
+            std::ofstream file(fs::u8path(tempPath), std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                return;
+            }
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(sourcePath.data(), static_cast<std::streamsize>(sourcePath.size()));
+            const size_t padding = TextureCacheDataOffset(header.pathLength) - sizeof(header) - sourcePath.size();
+            const char zeros[16] = {};
+            file.write(zeros, static_cast<std::streamsize>(padding));
+            for (int level = 0; level < kAtlasMipLevels; ++level)
+            {
+                file.write(reinterpret_cast<const char*>(levels.data[static_cast<size_t>(level)]),
+                           static_cast<std::streamsize>(AtlasCellLevelBytes(level, levels.compressed)));
+            }
+            if (!file)
+            {
+                return;
+            }
+        }
+        fs::rename(fs::u8path(tempPath), fs::u8path(cachePath), ec);
+        if (ec)
+        {
+            fs::remove(fs::u8path(tempPath), ec);
+        }
+    }
+
+    void RefreshTextureCacheStamp(const std::string& sourcePath)
+    {
+        TextureCacheHeader header{};
+        std::fstream file(std::filesystem::u8path(BuildTextureCachePath(sourcePath)), std::ios::binary | std::ios::in | std::ios::out);
+        if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        {
+            return;
+        }
+        if (!StatTextureSource(sourcePath, header.sourceSize, header.sourceWriteTime))
+        {
+            return;
+        }
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    GLuint GetAtlasPageTexture(int page)
+    {
+        if (page < 0 || static_cast<size_t>(page) >= g_atlasPages.size())
+        {
+            return 0;
+        }
+        return g_atlasPages[static_cast<size_t>(page)].id;
+    }
+
+    // Texture registry. Handles index stable slots; each placed cube's handle and the preset slots
+    // each hold one reference. Unreferenced textures stay resident for reuse until the budget
+    // forces least-recently-used ones out of the atlas.
+    constexpr size_t kTextureMemoryBudgetBytes = 64u * 1024u * 1024u;
+
     struct LoadedTexture
     {
-        GLuint id = 0;
+        AtlasRegion region;
         int width = 0;
         int height = 0;
         std::string path;
+        int refCount = 0;
+        uint64_t lastUse = 0;
+        size_t gpuBytes = 0;
+        bool live = false;
     };
 
     std::vector<LoadedTexture> g_loadedTextures;
+    std::vector<int> g_freeTextureHandles;
+    std::unordered_map<std::string, int> g_textureHandlesByPath;
+    size_t g_textureResidentBytes = 0;
+    uint64_t g_textureUseClock = 0;
+    uint64_t g_atlasLayoutVersion = 0; // Moves whenever a texture gains, loses or refits its atlas cell.
 
-    const LoadedTexture* GetTextureInfo(int handle)
+    LoadedTexture* GetTextureSlot(int handle)
     {
-        if (handle < 0 || static_cast<size_t>(handle) >= g_loadedTextures.size())
+        if (handle < 0 || static_cast<size_t>(handle) >= g_loadedTextures.size() || !g_loadedTextures[static_cast<size_t>(handle)].live)
         {
             return nullptr;
         }
         return &g_loadedTextures[static_cast<size_t>(handle)];
     }
 
+    const LoadedTexture* GetTextureInfo(int handle)
+    {
+        return GetTextureSlot(handle);
+    }
+
     int FindTextureHandleByPath(const std::string& path)
     {
-        for (size_t i = 0; i < g_loadedTextures.size(); ++i)
+        const auto it = g_textureHandlesByPath.find(path);
+        return it != g_textureHandlesByPath.end() ? it->second : kInvalidTextureHandle;
+    }
+
+    void EvictTexture(int handle)
+    {
+        LoadedTexture& texture = g_loadedTextures[static_cast<size_t>(handle)];
+        ReleaseAtlasRegion(texture.region);
+        ++g_atlasLayoutVersion;
+        g_textureResidentBytes -= texture.gpuBytes;
+        g_textureHandlesByPath.erase(texture.path);
+        texture = LoadedTexture{};
+        g_freeTextureHandles.push_back(handle);
+    }
+
+    // Evicts unreferenced textures, oldest first, until incomingBytes more fit in the budget.
+    // Referenced textures are never evicted, so the budget can be exceeded while they are in use.
+    void EnforceTextureBudget(size_t incomingBytes)
+    {
+        while (g_textureResidentBytes + incomingBytes > kTextureMemoryBudgetBytes)
         {
-            if (g_loadedTextures[i].path == path)
+            int victim = kInvalidTextureHandle;
+            for (size_t i = 0; i < g_loadedTextures.size(); ++i)
+            {
+                const LoadedTexture& texture = g_loadedTextures[i];
+                if (texture.live && texture.refCount == 0 &&
+                    (victim < 0 || texture.lastUse < g_loadedTextures[static_cast<size_t>(victim)].lastUse))
+                {
+                    victim = static_cast<int>(i);
+                }
+            }
+            if (victim < 0)
             {
-                return static_cast<int>(i);
+                return;
             }
+            EvictTexture(victim);
+        }
+    }
+
+    void AcquireTexture(int handle)
+    {
+        if (LoadedTexture* texture = GetTextureSlot(handle))
+        {
+            ++texture->refCount;
+            texture->lastUse = ++g_textureUseClock;
+        }
+    }
+
+    void ReleaseTexture(int handle)
+    {
+        LoadedTexture* texture = GetTextureSlot(handle);
+        if (!texture || texture->refCount <= 0)
+        {
+            return;
+        }
+        --texture->refCount;
+        texture->lastUse = ++g_textureUseClock;
+        if (texture->refCount == 0)
+        {
+            EnforceTextureBudget(0);
+        }
+    }
+
+    // Pixels for one atlas cell, either mapped from the disk cache or decoded from the source.
+    // levels points into cacheMapping or the scratch vectors, so this must outlive the upload.
+    struct PreparedAtlasCell
+    {
+        MappedFile cacheMapping;
+        AtlasCellLevels levels;
+        int width = 0;
+        int height = 0;
+        bool staleStamp = false;
+        std::array<std::vector<unsigned char>, kAtlasMipLevels> decodedLevels;
+        std::array<std::vector<unsigned char>, kAtlasMipLevels> encodedLevels;
+
+        size_t GpuBytes() const
+        {
+            size_t bytes = 0;
+            for (int level = 0; level < kAtlasMipLevels; ++level)
+            {
+                bytes += AtlasCellLevelBytes(level, levels.compressed);
+            }
+            return bytes;
+        }
+    };
+
+    bool PrepareAtlasCell(const std::string& path, PreparedAtlasCell& cell, std::string& messageOut)
+    {
+        if (LoadTextureCacheEntry(path, cell.cacheMapping, cell.levels, cell.width, cell.height, cell.staleStamp))
+        {
+            return true;
+        }
+
+        vengine::DecodedImage image;
+        if (!LoadImagePixelsGdiplus(path, image, messageOut))
+        {
+            return false;
+        }
+        cell.width = image.width;
+        cell.height = image.height;
+
+        AtlasCellLevels& levels = cell.levels;
+        levels.compressed = AtlasUsesCompression();
+        levels.order = AtlasPixelOrder();
+        vengine::ConvertPixelOrder(image, levels.order);
+        ResampleIntoAtlasCell(image.pixels.data(), cell.width, cell.height, cell.decodedLevels[0]);
+        BuildAtlasCellMips(cell.decodedLevels);
+        for (int level = 0; level < kAtlasMipLevels; ++level)
+        {
+            const size_t index = static_cast<size_t>(level);
+            if (levels.compressed)
+            {
+                vengine::EncodeBc3Image(cell.decodedLevels[index], kAtlasCellStride >> level, levels.order, cell.encodedLevels[index]);
+                levels.data[index] = cell.encodedLevels[index].data();
+            }
+            else
+            {
+                levels.data[index] = cell.decodedLevels[index].data();
+            }
+        }
+        StoreTextureCacheEntry(path, levels, cell.width, cell.height);
+        return true;
+    }
+
+    void FinishAtlasCellUpload(const std::string& path, PreparedAtlasCell& cell)
+    {
+        cell.cacheMapping.Close();
+        if (cell.staleStamp)
+        {
+            RefreshTextureCacheStamp(path);
         }
-        return kInvalidTextureHandle;
     }
 
+    int InstallPreparedTexture(const std::string& path, PreparedAtlasCell& cell, std::string& messageOut);
+
     int LoadTextureFromFile(const std::string& path, std::string& messageOut)
     {
         if (path.empty())
@@ -180,86 +967,151 @@ namespace
             return existing;
         }
 
-        std::vector<unsigned char> pixels;
-        UINT width = 0;
-        UINT height = 0;
-        if (!LoadImagePixelsGdiplus(path, pixels, width, height, messageOut))
+        PreparedAtlasCell cell;
+        if (!PrepareAtlasCell(path, cell, messageOut))
         {
             return kInvalidTextureHandle;
         }
+        return InstallPreparedTexture(path, cell, messageOut);
+    }
 
-        GLuint texId = 0;
-        glGenTextures(1, &texId);
-        if (texId == 0)
+    // The GL half of LoadTextureFromFile, for a cell prepared ahead of time (possibly on another thread).
+    int InstallPreparedTexture(const std::string& path, PreparedAtlasCell& cell, std::string& messageOut)
+    {
+        const size_t gpuBytes = cell.GpuBytes();
+        EnforceTextureBudget(gpuBytes);
+
+        AtlasRegion region;
+        if (!AllocateAtlasRegion(region))
         {
             messageOut = "glGenTextures failed";
             return kInvalidTextureHandle;
         }
+        FitAtlasRegionToImage(region, cell.width, cell.height);
+        UploadAtlasCell(region, cell.levels);
+        FinishAtlasCellUpload(path, cell);
 
-        glBindTexture(GL_TEXTURE_2D, texId);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexImage2D(GL_TEXTURE_2D,
-                     0,
-                     GL_RGBA8,
-                     static_cast<GLsizei>(width),
-                     static_cast<GLsizei>(height),
-                     0,
-                     GL_RGBA,
-                     GL_UNSIGNED_BYTE,
-                     pixels.data());
-        glBindTexture(GL_TEXTURE_2D, 0);
+        int handle = kInvalidTextureHandle;
+        if (!g_freeTextureHandles.empty())
+        {
+            handle = g_freeTextureHandles.back();
+            g_freeTextureHandles.pop_back();
+        }
+        else
+        {
+            handle = static_cast<int>(g_loadedTextures.size());
+            g_loadedTextures.emplace_back();
+        }
 
-        LoadedTexture info;
-        info.id = texId;
-        info.width = static_cast<int>(width);
-        info.height = static_cast<int>(height);
+        LoadedTexture& info = g_loadedTextures[static_cast<size_t>(handle)];
+        info.region = region;
+        info.width = cell.width;
+        info.height = cell.height;
         info.path = path;
-        g_loadedTextures.push_back(info);
+        info.refCount = 0;
+        info.lastUse = ++g_textureUseClock;
+        info.gpuBytes = gpuBytes;
+        info.live = true;
+        g_textureHandlesByPath[path] = handle;
+        g_textureResidentBytes += gpuBytes;
+        ++g_atlasLayoutVersion;
 
         messageOut = "Loaded";
-        return static_cast<int>(g_loadedTextures.size() - 1);
+        return handle;
+    }
+
+    // Re-reads a resident texture's source into its existing atlas cell, so every cube and preset
+    // holding the handle picks up the new pixels. On failure (e.g. a half-written file) the old
+    // pixels stay and the next change event retries.
+    bool ReloadTextureFromFile(int handle, std::string& messageOut)
+    {
+        LoadedTexture* texture = GetTextureSlot(handle);
+        if (!texture)
+        {
+            messageOut = "Texture not resident";
+            return false;
+        }
+
+        PreparedAtlasCell cell;
+        if (!PrepareAtlasCell(texture->path, cell, messageOut))
+        {
+            return false;
+        }
+        FitAtlasRegionToImage(texture->region, cell.width, cell.height);
+        UploadAtlasCell(texture->region, cell.levels);
+        FinishAtlasCellUpload(texture->path, cell);
+
+        const size_t gpuBytes = cell.GpuBytes();
+        g_textureResidentBytes = g_textureResidentBytes - texture->gpuBytes + gpuBytes;
+        texture->gpuBytes = gpuBytes;
+        texture->width = cell.width;
+        texture->height = cell.height;
+        ++g_atlasLayoutVersion;
+        messageOut = "Reloaded";
+        return true;
     }
 
     void CleanupLoadedTextures()
     {
-        for (LoadedTexture& tex : g_loadedTextures)
+        for (AtlasPage& page : g_atlasPages)
         {
-            if (tex.id != 0)
+            if (page.id != 0)
             {
-                glDeleteTextures(1, &tex.id);
-                tex.id = 0;
+                glDeleteTextures(1, &page.id);
+                page.id = 0;
             }
         }
+        g_atlasPages.clear();
         g_loadedTextures.clear();
+        g_freeTextureHandles.clear();
+        g_textureHandlesByPath.clear();
+        g_textureResidentBytes = 0;
+        ++g_atlasLayoutVersion;
     }
 
-    // CPU-side copy of the cube mesh. Each vertex stores position, normal, UV for retro GL.
-    struct Mesh
+    // Where one attribute sits in an interleaved vertex; components == 0 means the format lacks it.
+    struct VertexAttribute
     {
-        std::vector<float> vertices; // xyz triplets
-        std::vector<float> normals;  // xyz triplets
-        std::vector<float> texcoords; // uv pairs
+        GLint components = 0;
+        size_t offset = 0; // Bytes from the start of the vertex.
     };
 
-    // Runtime state for a block dropped into the world. Each cube remembers its texture handle.
-    struct PlacedCube
+    // Layout of an interleaved float vertex. BindMesh sets the client array pointers from it, so
+    // any mesh that describes itself this way draws through the same path.
+    struct VertexFormat
     {
-        int gridX;
-        int gridY;
-        int gridZ;
-        float r;
-        float g;
-        float b;
-        bool glowing = false;
-        bool transparent = false;
-        int textureHandle = kInvalidTextureHandle;
-        int presetIndex = -1;
-        std::string texturePath;
+        GLsizei stride = 0;
+        VertexAttribute position;
+        VertexAttribute normal;
+        VertexAttribute texcoord;
+        VertexAttribute color;
+    };
+
+    // vengine::MeshVertex: position, normal, UV.
+    const VertexFormat kMeshVertexFormat{static_cast<GLsizei>(sizeof(vengine::MeshVertex)),
+                                         {3, offsetof(vengine::MeshVertex, position)},
+                                         {3, offsetof(vengine::MeshVertex, normal)},
+                                         {2, offsetof(vengine::MeshVertex, uv)},
+                                         {}};
+
+    // Interleaved, indexed triangle mesh. UploadMesh copies it into buffer objects once when the
+    // driver has them; otherwise it is drawn from these arrays.
+    struct Mesh
+    {
+        VertexFormat format;
+        std::vector<float> vertexData; // format.stride bytes per vertex.
+        std::vector<uint32_t> indices; // Triangle list.
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+
+        size_t TriangleCount() const { return indices.size() / 3; }
+        bool Empty() const { return indices.empty(); }
     };
 
+    // A block dropped into the world, in one piece while it is built, dragged or staged. Placed
+    // cubes live split into g_placedCubes' arrays. Each cube remembers its texture handle.
+    using PlacedCube = vengine::CubeRecord;
+
     struct GameState
     {
         float cubeY = 0.0f;
@@ -274,9 +1126,15 @@ namespace
 
     bool g_running = true;
     bool g_jumpRequested = false;
+    // Per-frame scratch, reset at the top of the frame loop. g_frameHeapAllocations is how many
+    // heap allocations the main thread made during the previous frame; steady state should be 0.
+    vengine::FrameArena g_frameArena;
+    uint64_t g_frameHeapAllocationMark = 0;
+    int g_frameHeapAllocations = 0;
     int g_windowWidth = 800;
     int g_windowHeight = 600;
     Mesh g_cubeMesh;
+    Mesh g_playerMesh; // Empty unless --player-model loaded; the player is then drawn as the cube.
     GameState g_game;
     constexpr float kPi = 3.1415926535f;
     constexpr int kTargetPixelWidth = 320;
@@ -325,13 +1183,22 @@ namespace
     std::string g_notesFilePath;
     std::string g_sceneFilePath;
     bool g_sceneSuppressSave = false;
+    bool g_sceneLoading = false; // The scene loader is running; the world is empty and not editable until it finishes.
     std::string g_notesContent;
+    vengine::LuaHighlightCache g_notesHighlight; // Token cache for the code overlay, updated as g_notesContent changes.
     bool g_notesDirty = false;
+    bool g_notesChangedOnDisk = false; // notes.txt changed underneath unsaved edits.
     bool g_showDocs = false;
     std::string g_docsContent =
         "GYGE - Gerasin Yaroslav Game Engine\n"
         "Version 0.001\n"
-        "Last update: 10.11.2025\n";
+        "Last update: 10.11.2025\n"
+        "\n"
+        "Scripting (Lua, runs on Save):\n"
+        "  function tick(dt) ... end   -- called every frame\n"
+        "  world.place(x, y, z [, preset]), world.remove(x, y, z)\n"
+        "  world.get(x, y, z) -> preset or nil, world.count()\n"
+        "  player.position() -> x, y, z, player.move(dx, dy, dz), player.teleport(x, y, z)\n";
 
     float g_cameraYawDegrees = 0.0f;
     float g_cameraYawTarget = 0.0f;
@@ -345,15 +1212,26 @@ namespace
     float g_cameraFocusZ = 0.0f;
     float g_cameraDistance = 8.0f;
     constexpr float kCameraMinDistance = 4.0f;
-    constexpr float kCameraMaxDistance = 18.0f;
+    // Far enough to take in a 512x512 level; distant chunks switch to LOD meshes.
+    constexpr float kCameraMaxDistance = 200.0f;
     constexpr float kCameraMoveSpeed = 6.0f;
     constexpr float kCameraZoomStep = 0.6f;
+    constexpr float kCameraZoomFraction = 0.075f; // Wheel steps grow with distance so far zooms stay quick.
     constexpr float kCameraPitchMinDegrees = 25.0f;
     constexpr float kCameraPitchMaxDegrees = 85.0f;
     constexpr float kCameraPitchStepDegrees = 6.0f;
     constexpr float kCameraPitchSpeed = 180.0f;
     constexpr float kCameraRotationSpeed = 240.0f;
-    std::vector<PlacedCube> g_placedCubes;
+    vengine::CubeStore g_placedCubes;
+    // Bumped whenever cubes are added, removed or reordered; the culling chunks rebuild lazily.
+    uint64_t g_cubeLayoutVersion = 0;
+    // g_placedCubes bucketed by chunk, for culling and for every spatial query (collision, picking,
+    // surface heights). Rebuilt by RefreshCubeChunks when g_cubeLayoutVersion moves.
+    vengine::CubeChunkIndex g_cubeChunks;
+    uint64_t g_cubeChunksVersion = std::numeric_limits<uint64_t>::max();
+    // Active with --world <dir>: g_placedCubes then holds only the chunks streamed in around the
+    // player, and edits are saved chunk by chunk instead of to scene.txt.
+    vengine::WorldStreamer g_worldStreamer;
     bool g_showContentPanel = false;
     float g_contentPanelPosY = 0.0f;
     constexpr float kContentPanelHeight = 180.0f;
@@ -429,7 +1307,9 @@ namespace
         bool transparent;
     };
 
-    float ComputeLightAtPoint(const Vec3& point, const PlacedCube* receiver);
+    // receiver is the index of the cube being lit, which never shadows itself; -1 for none.
+    float ComputeLightAtPoint(const Vec3& point, int receiver);
+    void RefreshCubeChunks();
 
     constexpr SpawnPreset kSpawnPresets[] = {
         {"Blue Cube", 0.3f, 0.45f, 0.85f, false, false},
@@ -453,32 +1333,48 @@ namespace
     std::array<std::string, kSpawnPresetCount> g_presetTexturePaths;
     std::array<std::string, kSpawnPresetCount> g_presetTextureStatus;
 
+    // Cell lookups go through the chunk index while it is current. Right after an edit they scan
+    // instead of rebuilding it: a script applies a batch of placements, each looking its cell up,
+    // and one scan per placement is far cheaper than one rebuild per placement.
     int FindCubeIndex(int x, int y, int z)
     {
-        for (size_t i = 0; i < g_placedCubes.size(); ++i)
+        if (g_cubeChunksVersion != g_cubeLayoutVersion || !vengine::CubeCellInRange(x, y, z))
         {
-            const PlacedCube& cube = g_placedCubes[i];
-            if (cube.gridX == x && cube.gridY == y && cube.gridZ == z)
+            return g_placedCubes.Find(x, y, z);
+        }
+        int found = -1;
+        const uint64_t cell = vengine::PackCubeCell(x, y, z);
+        g_cubeChunks.ForEachInCellBox(x, y, z, x, y, z, [&](uint32_t index) {
+            if (g_placedCubes.Cells()[index] == cell)
             {
-                return static_cast<int>(i);
+                found = static_cast<int>(index);
             }
-        }
-        return -1;
+        });
+        return found;
     }
 
     int FindHighestCubeIndex(int x, int z)
     {
         int bestIndex = -1;
         int bestHeight = std::numeric_limits<int>::min();
-        for (size_t i = 0; i < g_placedCubes.size(); ++i)
+        const auto consider = [&](size_t index) {
+            int cubeX, cubeY, cubeZ;
+            g_placedCubes.Cell(index, cubeX, cubeY, cubeZ);
+            if (cubeX == x && cubeZ == z && cubeY > bestHeight)
+            {
+                bestHeight = cubeY;
+                bestIndex = static_cast<int>(index);
+            }
+        };
+        if (g_cubeChunksVersion != g_cubeLayoutVersion)
         {
-            const PlacedCube& cube = g_placedCubes[i];
-            if (cube.gridX == x && cube.gridZ == z && cube.gridY > bestHeight)
+            for (size_t i = 0; i < g_placedCubes.Size(); ++i)
             {
-                bestHeight = cube.gridY;
-                bestIndex = static_cast<int>(i);
+                consider(i);
             }
+            return bestIndex;
         }
+        g_cubeChunks.ForEachInCellBox(x, std::numeric_limits<int>::min(), z, x, std::numeric_limits<int>::max(), z, consider);
         return bestIndex;
     }
 
@@ -490,9 +1386,30 @@ namespace
         }
     }
 
+    // How far from the origin, in cells along x and z, a world that isn't streamed extends. The
+    // ground can be picked and cubes placed anywhere inside it.
+    constexpr int kWorldHalfExtent = 256;
+
+    // Whether the ground at column (x, z) is part of the world.
+    bool IsGroundColumn(int x, int z)
+    {
+        return g_worldStreamer.Active() ? g_worldStreamer.IsResident(x, z) : std::abs(x) <= kWorldHalfExtent && std::abs(z) <= kWorldHalfExtent;
+    }
+
+    // Whether the editor may put a cube on cell (x, y, z). A streamed world has no edge, but a cube
+    // can only go into a chunk that is loaded, and only on a cell the cube store can pack.
+    bool IsPlaceableCell(int x, int y, int z)
+    {
+        return vengine::CubeCellInRange(x, y, z) && IsGroundColumn(x, z);
+    }
+
     void PlaceCube(int x, int y, int z, const SpawnPreset& preset, int presetIndex, int textureHandle, const std::string& texturePath)
     {
-        if (std::abs(x) > 100 || std::abs(z) > 100)
+        if (g_sceneLoading)
+        {
+            return;
+        }
+        if (!IsPlaceableCell(x, y, z))
         {
             return;
         }
@@ -501,8 +1418,11 @@ namespace
             return;
         }
         PlacedCube cube{x, y, z, preset.r, preset.g, preset.b, preset.glowing, preset.transparent, textureHandle, presetIndex, texturePath};
-        g_placedCubes.push_back(std::move(cube));
+        AcquireTexture(textureHandle);
+        g_placedCubes.Append(std::move(cube));
+        ++g_cubeLayoutVersion;
         MarkSceneDirty();
+        g_worldStreamer.MarkDirty(x, z);
     }
 
     void RemoveCube(int x, int y, int z)
@@ -510,8 +1430,11 @@ namespace
         int index = FindCubeIndex(x, y, z);
         if (index >= 0)
         {
-            g_placedCubes.erase(g_placedCubes.begin() + index);
+            ReleaseTexture(g_placedCubes.TextureHandle(static_cast<size_t>(index)));
+            g_placedCubes.Erase(static_cast<size_t>(index));
+            ++g_cubeLayoutVersion;
             MarkSceneDirty();
+            g_worldStreamer.MarkDirty(x, z);
         }
     }
 
@@ -606,7 +1529,7 @@ namespace
                 Vec3 hitPoint = origin + dir * t;
                 int gx = static_cast<int>(std::round(hitPoint.x));
                 int gz = static_cast<int>(std::round(hitPoint.z));
-                if (std::fabs(hitPoint.x) <= 200.0f && std::fabs(hitPoint.z) <= 200.0f)
+                if (IsGroundColumn(gx, gz))
                 {
                     result.hit = true;
                     result.hitGround = true;
@@ -619,24 +1542,34 @@ namespace
             }
         }
 
-        for (const PlacedCube& cube : g_placedCubes)
-        {
-            Vec3 minB{static_cast<float>(cube.gridX) - 0.5f, static_cast<float>(cube.gridY), static_cast<float>(cube.gridZ) - 0.5f};
-            Vec3 maxB{static_cast<float>(cube.gridX) + 0.5f, static_cast<float>(cube.gridY) + 1.0f, static_cast<float>(cube.gridZ) + 0.5f};
-            float t = 0.0f;
-            Vec3 normal;
-            if (RayIntersectsAABB(origin, dir, minB, maxB, t, normal) && t > 0.0f && t < result.t)
+        // Chunks are walked front to back, up to the ground hit; the first chunk holding a hit
+        // holds the nearest one.
+        RefreshCubeChunks();
+        const float rayOrigin[3] = {origin.x, origin.y, origin.z};
+        const float rayDir[3] = {dir.x, dir.y, dir.z};
+        g_cubeChunks.ForEachChunkAlongRay(rayOrigin, rayDir, result.t, [&](const std::vector<uint32_t>& items, float tExit) {
+            for (uint32_t index : items)
             {
-                result.hit = true;
-                result.hitCube = true;
-                result.hitGround = false;
-                result.t = t;
-                result.cubeX = cube.gridX;
-                result.cubeY = cube.gridY;
-                result.cubeZ = cube.gridZ;
-                result.normal = normal;
+                int cubeX, cubeY, cubeZ;
+                g_placedCubes.Cell(index, cubeX, cubeY, cubeZ);
+                Vec3 minB{static_cast<float>(cubeX) - 0.5f, static_cast<float>(cubeY), static_cast<float>(cubeZ) - 0.5f};
+                Vec3 maxB{static_cast<float>(cubeX) + 0.5f, static_cast<float>(cubeY) + 1.0f, static_cast<float>(cubeZ) + 0.5f};
+                float t = 0.0f;
+                Vec3 normal;
+                if (RayIntersectsAABB(origin, dir, minB, maxB, t, normal) && t > 0.0f && t < result.t)
+                {
+                    result.hit = true;
+                    result.hitCube = true;
+                    result.hitGround = false;
+                    result.t = t;
+                    result.cubeX = cubeX;
+                    result.cubeY = cubeY;
+                    result.cubeZ = cubeZ;
+                    result.normal = normal;
+                }
             }
-        }
+            return !(result.hitCube && result.t <= tExit);
+        });
 
         return result;
     }
@@ -666,7 +1599,9 @@ namespace
             int topIndex = FindHighestCubeIndex(outX, outZ);
             if (topIndex >= 0)
             {
-                outY = g_placedCubes[topIndex].gridY + 1;
+                int topX, topY, topZ;
+                g_placedCubes.Cell(static_cast<size_t>(topIndex), topX, topY, topZ);
+                outY = topY + 1;
             }
             else
             {
@@ -734,7 +1669,7 @@ namespace
         g_dragPreviewZ = targetZ;
         g_dragPreviewHasPosition = true;
 
-        if (std::abs(targetX) > 100 || std::abs(targetZ) > 100)
+        if (!IsPlaceableCell(targetX, targetY, targetZ))
         {
             g_dragPreviewValid = false;
             return;
@@ -756,14 +1691,15 @@ namespace
 
     void BeginCubeDrag(int cubeIndex, int mouseX, int mouseY)
     {
-        if (cubeIndex < 0 || cubeIndex >= static_cast<int>(g_placedCubes.size()))
+        if (cubeIndex < 0 || cubeIndex >= static_cast<int>(g_placedCubes.Size()))
         {
             CancelPendingCubeDrag();
             return;
         }
         g_draggingCube = true;
-        g_draggedCube = g_placedCubes[cubeIndex];
-        g_placedCubes.erase(g_placedCubes.begin() + cubeIndex);
+        g_draggedCube = g_placedCubes.Record(static_cast<size_t>(cubeIndex));
+        g_placedCubes.Erase(static_cast<size_t>(cubeIndex));
+        ++g_cubeLayoutVersion;
         g_dragPreviewHasPosition = false;
         g_dragPreviewValid = false;
         UpdateDraggingCubePreview(mouseX, mouseY);
@@ -779,12 +1715,15 @@ namespace
         bool appliedNewPosition = false;
         if (commit && g_dragPreviewValid && g_dragPreviewHasPosition)
         {
+            g_worldStreamer.MarkDirty(g_draggedCube.gridX, g_draggedCube.gridZ);
+            g_worldStreamer.MarkDirty(g_dragPreviewX, g_dragPreviewZ);
             g_draggedCube.gridX = g_dragPreviewX;
             g_draggedCube.gridY = g_dragPreviewY;
             g_draggedCube.gridZ = g_dragPreviewZ;
             appliedNewPosition = true;
         }
-        g_placedCubes.push_back(g_draggedCube);
+        g_placedCubes.Append(std::move(g_draggedCube));
+        ++g_cubeLayoutVersion;
         if (appliedNewPosition)
         {
             MarkSceneDirty();
@@ -797,138 +1736,62 @@ namespace
         g_pendingPlacementPresetIndex = -1;
     }
 
-    const std::unordered_set<std::string> kLuaKeywords = {
-        "and", "break", "do",   "else", "elseif", "end", "false", "for",   "function",
-        "goto", "if",    "in",  "local", "nil",  "not", "or",   "repeat", "return",
-        "then", "true",  "until", "while"
-    };
-
-    bool IsIdentifierChar(char c)
-    {
-        return static_cast<bool>(std::isalnum(static_cast<unsigned char>(c)) || c == '_');
-    }
-
-    void RenderLuaToken(ImDrawList* drawList, const char* begin, const char* end, ImVec2& cursor, ImU32 color)
-    {
-        if (begin >= end)
-        {
-            return;
-        }
-        drawList->AddText(cursor, color, begin, end);
-        const ImVec2 size = ImGui::CalcTextSize(begin, end, false);
-        cursor.x += size.x;
-    }
-
-    void RenderLuaLineTokens(ImDrawList* drawList,
-                             const char* lineStart,
-                             const char* lineEnd,
-                             ImVec2& cursor,
-                             ImU32 defaultColor,
-                             ImU32 keywordColor,
-                             ImU32 stringColor,
-                             ImU32 commentColor,
-                             ImU32 numberColor)
+    // Draws the cached tokens of the lines inside the clip rect. Token offsets are measured once per
+    // line after it changes, so steady-state cost is one AddText per visible token.
+    void RenderLuaHighlightedText(vengine::LuaHighlightCache& cache, const std::string& text, const ImVec2& origin, const ImVec2& size)
     {
-        const char* ptr = lineStart;
-        while (ptr < lineEnd)
-        {
-            if (*ptr == '\r')
-            {
-                ++ptr;
-                continue;
-            }
-
-            if (*ptr == '-' && (ptr + 1) < lineEnd && *(ptr + 1) == '-')
-            {
-                RenderLuaToken(drawList, ptr, lineEnd, cursor, commentColor);
-                break;
-            }
+        cache.Update(text);
+        cache.SetLayoutKey(ImGui::GetFont(), ImGui::GetFontSize());
 
-            if (*ptr == '"' || *ptr == '\'')
-            {
-                const char quote = *ptr;
-                const char* tokenStart = ptr++;
-                while (ptr < lineEnd)
-                {
-                    if (*ptr == '\\' && (ptr + 1) < lineEnd)
-                    {
-                        ptr += 2;
-                        continue;
-                    }
-                    if (*ptr == quote)
-                    {
-                        ++ptr;
-                        break;
-                    }
-                    ++ptr;
-                }
-                RenderLuaToken(drawList, tokenStart, ptr, cursor, stringColor);
-                continue;
-            }
-
-            if (std::isdigit(static_cast<unsigned char>(*ptr)))
-            {
-                const char* tokenStart = ptr++;
-                while (ptr < lineEnd && (std::isdigit(static_cast<unsigned char>(*ptr)) || *ptr == '.' || *ptr == 'x' || *ptr == 'X'))
-                {
-                    ++ptr;
-                }
-                RenderLuaToken(drawList, tokenStart, ptr, cursor, numberColor);
-                continue;
-            }
-
-            if (IsIdentifierChar(*ptr))
-            {
-                const char* tokenStart = ptr++;
-                while (ptr < lineEnd && IsIdentifierChar(*ptr))
-                {
-                    ++ptr;
-                }
-                const std::string identifier(tokenStart, ptr);
-                const bool isKeyword = kLuaKeywords.find(identifier) != kLuaKeywords.end();
-                RenderLuaToken(drawList, tokenStart, ptr, cursor, isKeyword ? keywordColor : defaultColor);
-                continue;
-            }
-
-            RenderLuaToken(drawList, ptr, ptr + 1, cursor, defaultColor);
-            ++ptr;
-        }
-    }
-
-    void RenderLuaHighlightedText(const std::string& text, const ImVec2& origin, const ImVec2& size)
-    {
         ImDrawList* drawList = ImGui::GetWindowDrawList();
         ImGuiStyle& style = ImGui::GetStyle();
-        ImVec2 cursor = ImVec2(origin.x + style.FramePadding.x, origin.y + style.FramePadding.y);
+        const ImVec2 cursor = ImVec2(origin.x + style.FramePadding.x, origin.y + style.FramePadding.y);
         const float lineHeight = ImGui::GetTextLineHeight();
-        const ImU32 defaultColor = ImGui::GetColorU32(ImGui::GetStyleColorVec4(ImGuiCol_Text));
-        const ImU32 keywordColor = ImGui::GetColorU32(ImVec4(0.70f, 0.55f, 1.0f, 1.0f));
-        const ImU32 stringColor = ImGui::GetColorU32(ImVec4(0.90f, 0.80f, 0.45f, 1.0f));
-        const ImU32 commentColor = ImGui::GetColorU32(ImVec4(0.45f, 0.80f, 0.45f, 1.0f));
-        const ImU32 numberColor = ImGui::GetColorU32(ImVec4(0.90f, 0.60f, 0.45f, 1.0f));
+        const ImU32 colors[] = {
+            ImGui::GetColorU32(ImGui::GetStyleColorVec4(ImGuiCol_Text)), // Default
+            ImGui::GetColorU32(ImVec4(0.70f, 0.55f, 1.0f, 1.0f)),      // Keyword
+            ImGui::GetColorU32(ImVec4(0.90f, 0.80f, 0.45f, 1.0f)),     // String
+            ImGui::GetColorU32(ImVec4(0.45f, 0.80f, 0.45f, 1.0f)),     // Comment
+            ImGui::GetColorU32(ImVec4(0.90f, 0.60f, 0.45f, 1.0f)),     // Number
+        };
 
         const ImVec2 clipMax = ImVec2(origin.x + size.x, origin.y + size.y);
         drawList->PushClipRect(origin, clipMax, true);
+        const ImVec2 visibleMin = drawList->GetClipRectMin();
+        const ImVec2 visibleMax = drawList->GetClipRectMax();
 
-        const char* ptr = text.c_str();
-        while (*ptr)
+        std::vector<vengine::LuaLine>& lines = cache.Lines();
+        const int firstLine = std::max(0, static_cast<int>(std::floor((visibleMin.y - cursor.y) / lineHeight)));
+        const int endLine = std::min(static_cast<int>(lines.size()), static_cast<int>(std::ceil((visibleMax.y - cursor.y) / lineHeight)));
+        for (int lineIndex = firstLine; lineIndex < endLine; ++lineIndex)
         {
-            const char* lineStart = ptr;
-            while (*ptr && *ptr != '\n')
+            vengine::LuaLine& line = lines[static_cast<size_t>(lineIndex)];
+            const char* lineText = text.data() + line.offset;
+            if (!line.measured)
             {
-                ++ptr;
-            }
-            const char* lineEnd = ptr;
-            ImVec2 lineCursor = cursor;
-            RenderLuaLineTokens(drawList, lineStart, lineEnd, lineCursor, defaultColor, keywordColor, stringColor, commentColor, numberColor);
-            cursor.y += lineHeight;
-            if (*ptr == '\n')
-            {
-                ++ptr;
+                float x = 0.0f;
+                const char* measuredEnd = lineText;
+                for (vengine::LuaToken& token : line.tokens)
+                {
+                    const char* tokenBegin = lineText + token.begin;
+                    x += ImGui::CalcTextSize(measuredEnd, tokenBegin, false).x;
+                    token.x = x;
+                    measuredEnd = tokenBegin + token.length;
+                    x += ImGui::CalcTextSize(tokenBegin, measuredEnd, false).x;
+                }
+                line.measured = true;
             }
-            else
+
+            const float y = cursor.y + static_cast<float>(lineIndex) * lineHeight;
+            for (const vengine::LuaToken& token : line.tokens)
             {
-                break;
+                const float x = cursor.x + token.x;
+                if (x > visibleMax.x)
+                {
+                    break;
+                }
+                const char* tokenBegin = lineText + token.begin;
+                drawList->AddText(ImVec2(x, y), colors[static_cast<size_t>(token.kind)], tokenBegin, tokenBegin + token.length);
             }
         }
 
@@ -961,9 +1824,10 @@ namespace
         {
             return g_exeDirectory;
         }
-        char pathBuffer[MAX_PATH] = {};
-        const DWORD length = GetModuleFileNameA(nullptr, pathBuffer, static_cast<DWORD>(std::size(pathBuffer)));
-        std::string path(pathBuffer, length);
+        // UTF-8 like every other path in the editor; the ANSI code page cannot name every folder.
+        wchar_t pathBuffer[MAX_PATH] = {};
+        const DWORD length = GetModuleFileNameW(nullptr, pathBuffer, static_cast<DWORD>(std::size(pathBuffer)));
+        std::string path = std::filesystem::path(std::wstring(pathBuffer, length)).u8string();
         const size_t separator = path.find_last_of("\\/");
         if (separator != std::string::npos)
         {
@@ -991,6 +1855,13 @@ namespace
         return path;
     }
 
+    std::string BuildTextureCacheDirectory()
+    {
+        std::string path = GetExecutableDirectory();
+        path.append("texture_cache\\");
+        return path;
+    }
+
     std::string MakeAbsoluteTexturePath(const std::string& storedPath)
     {
         if (storedPath.empty())
@@ -998,10 +1869,10 @@ namespace
             return {};
         }
         namespace fs = std::filesystem;
-        fs::path base(GetExecutableDirectory());
-        fs::path rel(storedPath);
+        fs::path base = fs::u8path(GetExecutableDirectory());
+        fs::path rel = fs::u8path(storedPath);
         fs::path combined = rel.is_absolute() ? rel : (base / rel);
-        return combined.string();
+        return combined.u8string();
     }
 
     bool NormalizeTextureInputPath(const std::string& inputPath, std::string& relativeOut, std::string& statusOut)
@@ -1014,7 +1885,7 @@ namespace
 
         namespace fs = std::filesystem;
         std::error_code ec;
-        fs::path base(GetExecutableDirectory());
+        fs::path base = fs::u8path(GetExecutableDirectory());
         fs::path canonicalBase = fs::weakly_canonical(base, ec);
         if (ec)
         {
@@ -1022,7 +1893,7 @@ namespace
             return false;
         }
 
-        fs::path candidate(inputPath);
+        fs::path candidate = fs::u8path(inputPath);
         if (!candidate.is_absolute())
         {
             candidate = canonicalBase / candidate;
@@ -1040,7 +1911,7 @@ namespace
             statusOut = "Texture must be inside exe directory";
             return false;
         }
-        std::string rel = relative.generic_string();
+        std::string rel = relative.generic_u8string();
         if (rel.empty() || rel.rfind("..", 0) == 0)
         {
             statusOut = "Texture must stay inside exe directory";
@@ -1059,7 +1930,7 @@ namespace
             return;
         }
 
-        std::ifstream file(g_notesFilePath, std::ios::binary);
+        std::ifstream file(std::filesystem::u8path(g_notesFilePath), std::ios::binary);
         if (!file)
         {
             g_notesContent.clear();
@@ -1070,6 +1941,7 @@ namespace
         std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
         g_notesContent = std::move(contents);
         g_notesDirty = false;
+        g_notesChangedOnDisk = false;
     }
 
     void SaveNotesToFile()
@@ -1079,122 +1951,84 @@ namespace
             return;
         }
 
-        std::ofstream file(g_notesFilePath, std::ios::binary);
+        std::ofstream file(std::filesystem::u8path(g_notesFilePath), std::ios::binary);
         if (!file)
         {
             return;
         }
         file.write(g_notesContent.data(), static_cast<std::streamsize>(g_notesContent.size()));
         g_notesDirty = false;
+        g_notesChangedOnDisk = false;
     }
 
-    bool SaveSceneToFile()
+    vengine::SceneCube ToSceneCube(size_t index)
     {
-        if (g_sceneFilePath.empty() || g_sceneSuppressSave)
-        {
-            return false;
-        }
+        vengine::SceneCube record;
+        g_placedCubes.Cell(index, record.gridX, record.gridY, record.gridZ);
+        const vengine::CubeColor& color = g_placedCubes.Color(index);
+        record.r = color.r;
+        record.g = color.g;
+        record.b = color.b;
+        record.glowing = g_placedCubes.Glowing(index);
+        record.transparent = g_placedCubes.Transparent(index);
+        record.presetIndex = g_placedCubes.PresetIndex(index);
+        record.texturePath = g_placedCubes.TexturePath(index);
+        return record;
+    }
 
-        std::ofstream file(g_sceneFilePath, std::ios::binary);
-        if (!file)
-        {
-            return false;
-        }
+    // Takes a reference on textureHandle for the new cube.
+    PlacedCube ToPlacedCube(vengine::SceneCube& record, int textureHandle)
+    {
+        PlacedCube cube;
+        cube.gridX = record.gridX;
+        cube.gridY = record.gridY;
+        cube.gridZ = record.gridZ;
+        cube.r = record.r;
+        cube.g = record.g;
+        cube.b = record.b;
+        cube.glowing = record.glowing;
+        cube.transparent = record.transparent;
+        cube.presetIndex = record.presetIndex;
+        cube.texturePath = std::move(record.texturePath);
+        cube.textureHandle = textureHandle >= 0 ? textureHandle : kInvalidTextureHandle;
+        AcquireTexture(cube.textureHandle);
+        return cube;
+    }
 
-        file << "VENGINE_SCENE 1\n";
-        file << g_placedCubes.size() << '\n';
-        for (const PlacedCube& cube : g_placedCubes)
+    // Resolves the record's texture path and takes a reference on the texture.
+    PlacedCube MakePlacedCube(vengine::SceneCube& record)
+    {
+        int handle = kInvalidTextureHandle;
+        if (!record.texturePath.empty())
         {
-            file << cube.gridX << ' '
-                 << cube.gridY << ' '
-                 << cube.gridZ << ' '
-                 << cube.r << ' '
-                 << cube.g << ' '
-                 << cube.b << ' '
-                 << (cube.glowing ? 1 : 0) << ' '
-                 << (cube.transparent ? 1 : 0) << ' '
-                 << cube.presetIndex << ' '
-                 << std::quoted(cube.texturePath) << '\n';
+            std::string loadStatus;
+            handle = LoadTextureFromFile(MakeAbsoluteTexturePath(record.texturePath), loadStatus);
         }
-        g_sceneDirty = false;
-        return true;
+        return ToPlacedCube(record, handle);
     }
 
-    void LoadSceneFromFile()
+    bool SaveSceneToFile()
     {
-        if (g_sceneFilePath.empty())
+        if (g_sceneFilePath.empty() || g_sceneSuppressSave || g_worldStreamer.Active())
         {
-            return;
+            return false;
         }
 
-        g_sceneSuppressSave = true;
-        g_placedCubes.clear();
-
-        std::ifstream file(g_sceneFilePath, std::ios::binary);
+        std::ofstream file(std::filesystem::u8path(g_sceneFilePath), std::ios::binary);
         if (!file)
         {
-            g_sceneSuppressSave = false;
-            g_sceneDirty = false;
-            return;
-        }
-
-        std::string header;
-        int version = 0;
-        file >> header >> version;
-        if (header != "VENGINE_SCENE" || version != 1)
-        {
-            g_sceneSuppressSave = false;
-            g_sceneDirty = false;
-            return;
+            return false;
         }
 
-        size_t cubeCount = 0;
-        file >> cubeCount;
-        file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-
-        for (size_t i = 0; i < cubeCount; ++i)
+        std::vector<vengine::SceneCube> records;
+        records.reserve(g_placedCubes.Size());
+        for (size_t i = 0; i < g_placedCubes.Size(); ++i)
         {
-            std::string line;
-            if (!std::getline(file, line))
-            {
-                break;
-            }
-            if (line.empty())
-            {
-                continue;
-            }
-
-            std::istringstream iss(line);
-            PlacedCube cube;
-            int glowing = 0;
-            int transparent = 0;
-            iss >> cube.gridX >> cube.gridY >> cube.gridZ >> cube.r >> cube.g >> cube.b >> glowing >> transparent >> cube.presetIndex;
-            if (!iss)
-            {
-                continue;
-            }
-            cube.glowing = glowing != 0;
-            cube.transparent = transparent != 0;
-            if (!(iss >> std::quoted(cube.texturePath)))
-            {
-                cube.texturePath.clear();
-            }
-            if (!cube.texturePath.empty())
-            {
-                const std::string absolute = MakeAbsoluteTexturePath(cube.texturePath);
-                std::string loadStatus;
-                const int handle = LoadTextureFromFile(absolute, loadStatus);
-                cube.textureHandle = handle >= 0 ? handle : kInvalidTextureHandle;
-            }
-            else
-            {
-                cube.textureHandle = kInvalidTextureHandle;
-            }
-            g_placedCubes.push_back(std::move(cube));
+            records.push_back(ToSceneCube(i));
         }
-
-        g_sceneSuppressSave = false;
+        file << vengine::SerializeScene(records);
         g_sceneDirty = false;
+        return true;
     }
 
     void EnsureSnowflakes(int renderWidth, int renderHeight)
@@ -1269,7 +2103,132 @@ namespace
         }
     }
 
-    double GetSeconds()
+    // --record <file> logs every input message to a file; --replay <file> plays one back on the
+    // frames it arrived in, with a fixed time step (--replay-dt <seconds>, or the recorded mean),
+    // then writes <file>.timings.csv and exits. Live input is ignored while a replay runs.
+    // --generate <seed> [--world-size <cells>] replaces the scene with a generated world at startup.
+    // --world <dir> [--world-budget <MB>] streams an endless world from <dir> around the player
+    // instead of loading scene.txt; with --generate, chunks never saved there are generated.
+    vengine::InputRecorder g_inputRecorder;
+    vengine::InputReplayer g_inputReplayer;
+    std::string g_inputRecordPath;
+    std::string g_inputReplayPath;
+    bool g_dispatchingReplayedInput = false;
+    // Last client-area cursor position the replay delivered; ImGui gets this instead of the OS cursor.
+    bool g_replayMouseKnown = false;
+    int g_replayMouseX = 0;
+    int g_replayMouseY = 0;
+
+    vengine::WorldGenerator g_worldGenerator;
+    int g_worldGenSeed = 1;
+    int g_worldGenSize = 96;
+    bool g_worldGenRequested = false;
+    constexpr size_t kWorldGenChunksPerFrame = 8;
+
+    std::string g_worldStreamPath;
+    int g_worldStreamBudgetMB = 256;
+
+    std::string g_playerModelPath;
+
+    bool IsRecordedInputMessage(UINT message)
+    {
+        switch (message)
+        {
+        case WM_KEYDOWN:
+        case WM_KEYUP:
+        case WM_SYSKEYDOWN:
+        case WM_SYSKEYUP:
+        case WM_CHAR:
+        case WM_MOUSEMOVE:
+        case WM_LBUTTONDOWN:
+        case WM_LBUTTONUP:
+        case WM_RBUTTONDOWN:
+        case WM_RBUTTONUP:
+        case WM_MBUTTONDOWN:
+        case WM_MBUTTONUP:
+        case WM_MOUSEWHEEL:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Split by the shell's own rules (quoted paths keep their backslashes) and converted to UTF-8,
+    // the encoding every path is opened with.
+    void ParseCommandLine()
+    {
+        std::vector<std::string> arguments;
+        int argumentCount = 0;
+        if (LPWSTR* wideArguments = CommandLineToArgvW(GetCommandLineW(), &argumentCount))
+        {
+            for (int i = 1; i < argumentCount; ++i)
+            {
+                arguments.push_back(WideToUtf8(wideArguments[i]));
+            }
+            LocalFree(wideArguments);
+        }
+
+        float replayDeltaTime = 0.0f;
+        for (size_t i = 0; i < arguments.size(); ++i)
+        {
+            const std::string& argument = arguments[i];
+            std::string value;
+            if (argument == "--record" || argument == "--replay" || argument == "--replay-dt" || argument == "--generate" || argument == "--world-size" ||
+                argument == "--world" || argument == "--world-budget" || argument == "--player-model")
+            {
+                if (i + 1 == arguments.size())
+                {
+                    break;
+                }
+                value = arguments[++i];
+            }
+            if (argument == "--record")
+            {
+                g_inputRecordPath = value;
+            }
+            else if (argument == "--replay")
+            {
+                g_inputReplayPath = value;
+            }
+            else if (argument == "--replay-dt")
+            {
+                replayDeltaTime = std::strtof(value.c_str(), nullptr);
+            }
+            else if (argument == "--generate")
+            {
+                g_worldGenSeed = std::atoi(value.c_str());
+                g_worldGenRequested = true;
+            }
+            else if (argument == "--world-size")
+            {
+                g_worldGenSize = std::clamp(std::atoi(value.c_str()), 16, 512);
+            }
+            else if (argument == "--world")
+            {
+                g_worldStreamPath = value;
+            }
+            else if (argument == "--world-budget")
+            {
+                g_worldStreamBudgetMB = std::clamp(std::atoi(value.c_str()), 16, 4096);
+            }
+            else if (argument == "--player-model")
+            {
+                g_playerModelPath = value;
+            }
+        }
+
+        if (!g_inputReplayPath.empty())
+        {
+            std::string error;
+            if (!g_inputReplayer.Start(g_inputReplayPath, vengine::InputSource::Win32, replayDeltaTime, error))
+            {
+                MessageBox(nullptr, error.c_str(), "Input replay", MB_OK | MB_ICONWARNING);
+                g_inputReplayPath.clear();
+            }
+        }
+    }
+
+    double GetWallSeconds()
     {
         static LARGE_INTEGER frequency = [] {
             LARGE_INTEGER value;
@@ -1283,6 +2242,170 @@ namespace
                static_cast<double>(frequency.QuadPart);
     }
 
+    // Clears the scene and starts generating a world from the Content Browser's seed and size.
+    // Chunks are streamed into g_placedCubes by StreamGeneratedWorld as the workers finish them.
+    void StartWorldGeneration()
+    {
+        if (g_sceneLoading)
+        {
+            return;
+        }
+        for (int textureHandle : g_placedCubes.TextureHandles())
+        {
+            ReleaseTexture(textureHandle);
+        }
+        g_placedCubes.Clear();
+        ++g_cubeLayoutVersion;
+        MarkSceneDirty();
+
+        vengine::WorldGenSettings settings;
+        settings.seed = static_cast<uint32_t>(g_worldGenSeed);
+        // PlaceCube keeps the editor inside kWorldHalfExtent cells; generated worlds stay there too.
+        settings.sizeX = settings.sizeZ = std::clamp(g_worldGenSize, 16, 2 * kWorldHalfExtent);
+        g_worldGenerator.Start(settings);
+    }
+
+    void StreamGeneratedWorld(bool drainAll)
+    {
+        // A replay waits for each chunk so the world fills in on the same frames every run.
+        const size_t budget = drainAll ? std::numeric_limits<size_t>::max() : kWorldGenChunksPerFrame;
+        const bool wait = drainAll || g_inputReplayer.Active();
+        const size_t delivered = g_worldGenerator.Drain(
+            [](vengine::WorldChunk& chunk) {
+                for (const vengine::SceneCube& record : chunk.cubes)
+                {
+                    g_placedCubes.Append(PlacedCube{record.gridX, record.gridY, record.gridZ, record.r, record.g, record.b, record.glowing,
+                                                    record.transparent, kInvalidTextureHandle, record.presetIndex, {}});
+                }
+            },
+            budget, wait);
+        if (delivered > 0)
+        {
+            ++g_cubeLayoutVersion;
+            MarkSceneDirty();
+        }
+    }
+
+    void StartWorldStreaming()
+    {
+        vengine::WorldStreamSettings settings;
+        settings.budgetBytes = static_cast<size_t>(g_worldStreamBudgetMB) << 20;
+        // The cube itself plus roughly its share of the culling chunks' and LOD meshes' data.
+        settings.bytesPerCube = vengine::CubeStore::BytesPerCube() + 48;
+        settings.generateMissing = g_worldGenRequested;
+        // A replay repeats the recorded session's edits; like scene.txt, the world isn't written back.
+        settings.readOnly = !g_inputReplayPath.empty();
+        settings.generation.seed = static_cast<uint32_t>(g_worldGenSeed);
+        g_worldStreamer.Start(std::make_unique<vengine::RegionChunkStore>(g_worldStreamPath), settings);
+    }
+
+    // Keeps the chunks around the player resident: hands the ones that fell out of range back to
+    // the streamer (which saves them if edited) and installs the ones that have finished loading.
+    void UpdateWorldStreaming(float deltaTime)
+    {
+        // A dragged cube is out of g_placedCubes until it is dropped; don't page its chunk out meanwhile.
+        if (!g_worldStreamer.Active() || g_draggingCube)
+        {
+            return;
+        }
+
+        // The world has no centre to look at, so the camera follows the player.
+        g_cameraFocusX = g_game.cubeX;
+        g_cameraFocusZ = g_game.cubeZ;
+        const float radius = std::max(48.0f, g_cameraDistance * 1.5f + 16.0f);
+        const std::vector<vengine::ChunkCoord> leaving = g_worldStreamer.Update(g_cameraFocusX, g_cameraFocusZ, radius, deltaTime);
+        bool changed = false;
+        if (!leaving.empty())
+        {
+            const auto key = [](int chunkX, int chunkZ) {
+                return (static_cast<uint64_t>(static_cast<uint32_t>(chunkX)) << 32) | static_cast<uint32_t>(chunkZ);
+            };
+            std::unordered_map<uint64_t, std::vector<vengine::SceneCube>> unloaded;
+            for (const vengine::ChunkCoord& coord : leaving)
+            {
+                unloaded[key(coord.x, coord.z)];
+            }
+            g_placedCubes.RemoveIf([&](size_t index) {
+                int cubeX, cubeY, cubeZ;
+                g_placedCubes.Cell(index, cubeX, cubeY, cubeZ);
+                const auto found = unloaded.find(key(vengine::StreamChunkOf(cubeX), vengine::StreamChunkOf(cubeZ)));
+                if (found == unloaded.end())
+                {
+                    return false;
+                }
+                found->second.push_back(ToSceneCube(index));
+                ReleaseTexture(g_placedCubes.TextureHandle(index));
+                return true;
+            });
+            for (const vengine::ChunkCoord& coord : leaving)
+            {
+                g_worldStreamer.Unload(coord, std::move(unloaded[key(coord.x, coord.z)]));
+            }
+            changed = true;
+        }
+
+        const auto install = [](const vengine::ChunkCoord&, std::vector<vengine::SceneCube>& cubes) {
+            for (vengine::SceneCube& record : cubes)
+            {
+                g_placedCubes.Append(MakePlacedCube(record));
+            }
+        };
+        if (g_inputReplayer.Active())
+        {
+            // A replay waits for every requested chunk so the world fills in on the same frames every run.
+            while (g_worldStreamer.Stats().requestedChunks > 0)
+            {
+                if (g_worldStreamer.DrainLoaded(install) > 0)
+                {
+                    changed = true;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        else if (g_worldStreamer.DrainLoaded(install) > 0)
+        {
+            changed = true;
+        }
+        if (changed)
+        {
+            ++g_cubeLayoutVersion;
+        }
+    }
+
+    // Queues every edited chunk still resident, then waits for the saves to land.
+    void StopWorldStreaming()
+    {
+        if (!g_worldStreamer.Active())
+        {
+            return;
+        }
+        g_worldStreamer.SaveDirty([](const vengine::ChunkCoord& coord) {
+            std::vector<vengine::SceneCube> cubes;
+            const std::vector<uint64_t>& cells = g_placedCubes.Cells();
+            for (size_t i = 0; i < cells.size(); ++i)
+            {
+                int cubeX, cubeY, cubeZ;
+                vengine::UnpackCubeCell(cells[i], cubeX, cubeY, cubeZ);
+                if (vengine::StreamChunkOf(cubeX) == coord.x && vengine::StreamChunkOf(cubeZ) == coord.z)
+                {
+                    cubes.push_back(ToSceneCube(i));
+                }
+            }
+            return cubes;
+        });
+        g_worldStreamer.Stop();
+    }
+
+    // Simulation time. A replay runs on its own clock so timed gestures (drag delays and the
+    // like) resolve on the same frames they did when recorded.
+    double GetSeconds()
+    {
+        return g_inputReplayer.Active() ? g_inputReplayer.VirtualSeconds() : GetWallSeconds();
+    }
+
     void UpdateProjection(int width, int height)
     {
         if (height == 0)
@@ -1294,7 +2417,7 @@ namespace
 
         const float aspect = static_cast<float>(width) / static_cast<float>(height);
         const float zNear = 0.1f;
-        const float zFar = 100.0f;
+        const float zFar = 600.0f;
         const float fovDegrees = 60.0f;
         const float fovRadians = fovDegrees * kPi / 180.0f;
         const float top = zNear * std::tan(fovRadians * 0.5f);
@@ -1308,94 +2431,269 @@ namespace
         glMatrixMode(GL_MODELVIEW);
     }
 
-    Mesh CreateCubeMesh()
+    // GL_ARB_vertex_buffer_object (core since GL 1.5), resolved once the context exists. Without it
+    // meshes are drawn from client arrays, which GL 1.1 already has.
+    using GenBuffersProc = void(APIENTRY*)(GLsizei, GLuint*);
+    using DeleteBuffersProc = void(APIENTRY*)(GLsizei, const GLuint*);
+    using BindBufferProc = void(APIENTRY*)(GLenum, GLuint);
+    using BufferDataProc = void(APIENTRY*)(GLenum, std::ptrdiff_t, const void*, GLenum);
+    constexpr GLenum kGlArrayBuffer = 0x8892;
+    constexpr GLenum kGlElementArrayBuffer = 0x8893;
+    constexpr GLenum kGlStaticDraw = 0x88E4;
+    GenBuffersProc g_glGenBuffers = nullptr;
+    DeleteBuffersProc g_glDeleteBuffers = nullptr;
+    BindBufferProc g_glBindBuffer = nullptr;
+    BufferDataProc g_glBufferData = nullptr;
+
+    // GL 1.4 / GL_EXT_multi_draw_arrays. Without it the opaque page batches draw range by range.
+    using MultiDrawElementsProc = void(APIENTRY*)(GLenum, const GLsizei*, GLenum, const void* const*, GLsizei);
+    MultiDrawElementsProc g_glMultiDrawElements = nullptr;
+
+    void LoadBufferObjectProcs()
+    {
+        const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+        const char* suffix = extensions && std::strstr(extensions, "GL_ARB_vertex_buffer_object") ? "ARB" : "";
+        auto resolve = [suffix](const char* name) {
+            const std::string full = std::string(name) + suffix;
+            return wglGetProcAddress(full.c_str());
+        };
+        g_glGenBuffers = reinterpret_cast<GenBuffersProc>(resolve("glGenBuffers"));
+        g_glDeleteBuffers = reinterpret_cast<DeleteBuffersProc>(resolve("glDeleteBuffers"));
+        g_glBindBuffer = reinterpret_cast<BindBufferProc>(resolve("glBindBuffer"));
+        g_glBufferData = reinterpret_cast<BufferDataProc>(resolve("glBufferData"));
+        if (!g_glGenBuffers || !g_glDeleteBuffers || !g_glBindBuffer || !g_glBufferData)
+        {
+            g_glGenBuffers = nullptr;
+        }
+        g_glMultiDrawElements = reinterpret_cast<MultiDrawElementsProc>(wglGetProcAddress("glMultiDrawElements"));
+        if (!g_glMultiDrawElements)
+        {
+            g_glMultiDrawElements = reinterpret_cast<MultiDrawElementsProc>(wglGetProcAddress("glMultiDrawElementsEXT"));
+        }
+    }
+
+    void UploadMesh(Mesh& mesh)
+    {
+        if (!g_glGenBuffers || mesh.Empty())
+        {
+            return;
+        }
+        GLuint buffers[2] = {};
+        g_glGenBuffers(2, buffers);
+        mesh.vertexBuffer = buffers[0];
+        mesh.indexBuffer = buffers[1];
+        g_glBindBuffer(kGlArrayBuffer, mesh.vertexBuffer);
+        g_glBufferData(kGlArrayBuffer, static_cast<std::ptrdiff_t>(mesh.vertexData.size() * sizeof(float)), mesh.vertexData.data(), kGlStaticDraw);
+        g_glBindBuffer(kGlElementArrayBuffer, mesh.indexBuffer);
+        g_glBufferData(kGlElementArrayBuffer, static_cast<std::ptrdiff_t>(mesh.indices.size() * sizeof(uint32_t)), mesh.indices.data(), kGlStaticDraw);
+        g_glBindBuffer(kGlArrayBuffer, 0);
+        g_glBindBuffer(kGlElementArrayBuffer, 0);
+    }
+
+    void ReleaseMesh(Mesh& mesh)
+    {
+        if (g_glDeleteBuffers && mesh.vertexBuffer != 0)
+        {
+            const GLuint buffers[2] = {mesh.vertexBuffer, mesh.indexBuffer};
+            g_glDeleteBuffers(2, buffers);
+        }
+        mesh.vertexBuffer = 0;
+        mesh.indexBuffer = 0;
+    }
+
+    // Points the fixed-function arrays at the mesh. Pair with UnbindMesh before anything else
+    // (LOD meshes, ImGui) sets client arrays of its own.
+    void BindMesh(const Mesh& mesh)
     {
-        struct VertexData
+        const char* base = reinterpret_cast<const char*>(mesh.vertexData.data());
+        if (mesh.vertexBuffer != 0)
         {
-            float px;
-            float py;
-            float pz;
-            float nx;
-            float ny;
-            float nz;
-            float u;
-            float v;
+            g_glBindBuffer(kGlArrayBuffer, mesh.vertexBuffer);
+            g_glBindBuffer(kGlElementArrayBuffer, mesh.indexBuffer);
+            base = nullptr;
+        }
+        const VertexFormat& format = mesh.format;
+        const auto at = [base](const VertexAttribute& attribute) {
+            return base ? static_cast<const void*>(base + attribute.offset) : reinterpret_cast<const void*>(attribute.offset);
         };
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(format.position.components, GL_FLOAT, format.stride, at(format.position));
+        if (format.normal.components > 0)
+        {
+            glEnableClientState(GL_NORMAL_ARRAY);
+            glNormalPointer(GL_FLOAT, format.stride, at(format.normal));
+        }
+        if (format.texcoord.components > 0)
+        {
+            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+            glTexCoordPointer(format.texcoord.components, GL_FLOAT, format.stride, at(format.texcoord));
+        }
+        if (format.color.components > 0)
+        {
+            glEnableClientState(GL_COLOR_ARRAY);
+            glColorPointer(format.color.components, GL_FLOAT, format.stride, at(format.color));
+        }
+    }
 
-        constexpr float s = 0.5f;
+    void DrawBoundMesh(const Mesh& mesh)
+    {
+        const void* indices = mesh.indexBuffer != 0 ? nullptr : mesh.indices.data();
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(mesh.indices.size()), GL_UNSIGNED_INT, indices);
+    }
+
+    void UnbindMesh(const Mesh& mesh)
+    {
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        if (mesh.vertexBuffer != 0)
+        {
+            g_glBindBuffer(kGlArrayBuffer, 0);
+            g_glBindBuffer(kGlElementArrayBuffer, 0);
+        }
+    }
+
+    // Maps the mesh's 0..1 UVs into an atlas cell through the texture matrix, so one vertex
+    // buffer serves every texture; a null region restores the identity.
+    void SetAtlasRegionTransform(const AtlasRegion* region)
+    {
+        glMatrixMode(GL_TEXTURE);
+        glLoadIdentity();
+        if (region)
+        {
+            glTranslatef(region->u0, region->v0, 0.0f);
+            glScalef(region->u1 - region->u0, region->v1 - region->v0, 1.0f);
+        }
+        glMatrixMode(GL_MODELVIEW);
+    }
 
-        constexpr VertexData vertices[] = {
+    vengine::MeshData CreateCubeMeshData()
+    {
+        constexpr float s = 0.5f;
+        // Four corners per face, counter-clockwise seen from outside.
+        constexpr vengine::MeshVertex vertices[] = {
             // Front
-            {-s, -s, s, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f},
-            {s, -s, s, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f},
-            {s, s, s, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f},
-            {-s, -s, s, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f},
-            {s, s, s, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f},
-            {-s, s, s, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f},
+            {{-s, -s, s}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},
+            {{s, -s, s}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}},
+            {{s, s, s}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
+            {{-s, s, s}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
 
             // Right
-            {s, -s, s, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f},
-            {s, -s, -s, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f},
-            {s, s, -s, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f},
-            {s, -s, s, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f},
-            {s, s, -s, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f},
-            {s, s, s, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f},
+            {{s, -s, s}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
+            {{s, -s, -s}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
+            {{s, s, -s}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f}},
+            {{s, s, s}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
 
             // Back
-            {s, -s, -s, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f},
-            {-s, -s, -s, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f},
-            {-s, s, -s, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f},
-            {s, -s, -s, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f},
-            {-s, s, -s, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f},
-            {s, s, -s, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f},
+            {{s, -s, -s}, {0.0f, 0.0f, -1.0f}, {1.0f, 0.0f}},
+            {{-s, -s, -s}, {0.0f, 0.0f, -1.0f}, {0.0f, 0.0f}},
+            {{-s, s, -s}, {0.0f, 0.0f, -1.0f}, {0.0f, 1.0f}},
+            {{s, s, -s}, {0.0f, 0.0f, -1.0f}, {1.0f, 1.0f}},
 
             // Left
-            {-s, -s, -s, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f},
-            {-s, -s, s, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f},
-            {-s, s, s, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f},
-            {-s, -s, -s, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f},
-            {-s, s, s, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f},
-            {-s, s, -s, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f},
+            {{-s, -s, -s}, {-1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
+            {{-s, -s, s}, {-1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
+            {{-s, s, s}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f}},
+            {{-s, s, -s}, {-1.0f, 0.0f, 0.0f}, {1.0f, 1.0f}},
 
             // Top
-            {-s, s, s, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f},
-            {s, s, s, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f},
-            {s, s, -s, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f},
-            {-s, s, s, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f},
-            {s, s, -s, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f},
-            {-s, s, -s, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f},
+            {{-s, s, s}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
+            {{s, s, s}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
+            {{s, s, -s}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f}},
+            {{-s, s, -s}, {0.0f, 1.0f, 0.0f}, {0.0f, 1.0f}},
 
             // Bottom
-            {-s, -s, -s, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f},
-            {s, -s, -s, 0.0f, -1.0f, 0.0f, 1.0f, 1.0f},
-            {s, -s, s, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f},
-            {-s, -s, -s, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f},
-            {s, -s, s, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f},
-            {-s, -s, s, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f},
+            {{-s, -s, -s}, {0.0f, -1.0f, 0.0f}, {0.0f, 1.0f}},
+            {{s, -s, -s}, {0.0f, -1.0f, 0.0f}, {1.0f, 1.0f}},
+            {{s, -s, s}, {0.0f, -1.0f, 0.0f}, {1.0f, 0.0f}},
+            {{-s, -s, s}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f}},
         };
 
-        Mesh mesh;
-        const size_t vertexCount = sizeof(vertices) / sizeof(vertices[0]);
-        mesh.vertices.reserve(vertexCount * 3);
-        mesh.normals.reserve(vertexCount * 3);
-        mesh.texcoords.reserve(vertexCount * 2);
+        vengine::MeshData mesh;
+        mesh.vertices.assign(std::begin(vertices), std::end(vertices));
+        for (uint32_t face = 0; face < 6; ++face)
+        {
+            const uint32_t base = face * 4;
+            mesh.indices.insert(mesh.indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+        }
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            mesh.boundsMin[axis] = -s;
+            mesh.boundsMax[axis] = s;
+        }
+        return mesh;
+    }
 
-        for (size_t i = 0; i < vertexCount; ++i)
+    // Copies imported vertices into a Mesh. fitToCell scales and centres it into the unit cell a
+    // cube occupies, so any model can stand in for one.
+    Mesh BuildMesh(const vengine::MeshData& data, bool fitToCell)
+    {
+        float scale = 1.0f;
+        float center[3] = {0.0f, 0.0f, 0.0f};
+        if (fitToCell)
         {
-            const VertexData& v = vertices[i];
-            mesh.vertices.push_back(v.px);
-            mesh.vertices.push_back(v.py);
-            mesh.vertices.push_back(v.pz);
-            mesh.normals.push_back(v.nx);
-            mesh.normals.push_back(v.ny);
-            mesh.normals.push_back(v.nz);
-            mesh.texcoords.push_back(v.u);
-            mesh.texcoords.push_back(v.v);
+            float extent = 0.0f;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                center[axis] = 0.5f * (data.boundsMin[axis] + data.boundsMax[axis]);
+                extent = std::max(extent, data.boundsMax[axis] - data.boundsMin[axis]);
+            }
+            scale = extent > 0.0f ? 1.0f / extent : 1.0f;
         }
 
+        std::vector<vengine::MeshVertex> vertices = data.vertices;
+        for (vengine::MeshVertex& vertex : vertices)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                vertex.position[axis] = (vertex.position[axis] - center[axis]) * scale;
+            }
+        }
+        Mesh mesh;
+        mesh.format = kMeshVertexFormat;
+        mesh.vertexData.resize(vertices.size() * (sizeof(vengine::MeshVertex) / sizeof(float)));
+        std::memcpy(mesh.vertexData.data(), vertices.data(), vertices.size() * sizeof(vengine::MeshVertex));
+        mesh.indices = data.indices;
         return mesh;
     }
 
+    // The cube comes from assets/cube.obj beside the exe (or beside build/), through the mesh
+    // cache; the built-in cube covers a missing or broken asset. Needs the GL context for upload.
+    void LoadModelMeshes()
+    {
+        LoadBufferObjectProcs();
+        const std::string exeDirectory = GetExecutableDirectory();
+        const std::string cacheDirectory = exeDirectory + "mesh_cache\\";
+        vengine::MeshData data = CreateCubeMeshData();
+        std::string error;
+        for (const char* candidate : {"assets\\cube.obj", "..\\assets\\cube.obj"})
+        {
+            const std::string path = exeDirectory + candidate;
+            vengine::MeshData loaded;
+            if (std::filesystem::exists(std::filesystem::u8path(path)) && vengine::LoadMesh(path, cacheDirectory, loaded, error))
+            {
+                data = std::move(loaded);
+                break;
+            }
+        }
+        g_cubeMesh = BuildMesh(data, false);
+        UploadMesh(g_cubeMesh);
+
+        if (!g_playerModelPath.empty())
+        {
+            if (vengine::LoadMesh(g_playerModelPath, cacheDirectory, data, error))
+            {
+                g_playerMesh = BuildMesh(data, true);
+                UploadMesh(g_playerMesh);
+            }
+            else
+            {
+                MessageBox(nullptr, error.c_str(), "Player model", MB_OK | MB_ICONWARNING);
+            }
+        }
+    }
+
     void RenderGround()
     {
         glDisable(GL_LIGHTING);
@@ -1417,7 +2715,7 @@ namespace
                 const float sampleZ = cellMinZ + cellSize * 0.5f;
 
                 Vec3 samplePoint{sampleX, 0.05f, sampleZ};
-                const float light = ComputeLightAtPoint(samplePoint, nullptr);
+                const float light = ComputeLightAtPoint(samplePoint, -1);
                 const float r = shadowBase[0] + (litBase[0] - shadowBase[0]) * light;
                 const float g = shadowBase[1] + (litBase[1] - shadowBase[1]) * light;
                 const float b = shadowBase[2] + (litBase[2] - shadowBase[2]) * light;
@@ -1455,38 +2753,30 @@ namespace
     void RenderMesh(const Mesh& mesh, float r = 0.6f, float g = 0.7f, float b = 1.0f, float a = 1.0f, int textureHandle = kInvalidTextureHandle)
     {
         const LoadedTexture* texture = GetTextureInfo(textureHandle);
-        const bool textureEnabled = texture && texture->id != 0;
+        const GLuint atlasTexture = texture ? GetAtlasPageTexture(texture->region.page) : 0;
+        const bool textureEnabled = atlasTexture != 0;
         if (textureEnabled)
         {
             glEnable(GL_TEXTURE_2D);
-            glBindTexture(GL_TEXTURE_2D, texture->id);
+            glBindTexture(GL_TEXTURE_2D, atlasTexture);
             glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+            SetAtlasRegionTransform(&texture->region);
         }
 
-        glColor4f(r, g, b, a);
-        glBegin(GL_TRIANGLES);
-        const size_t count = mesh.vertices.size();
-        const bool hasTexcoords = mesh.texcoords.size() >= (count / 3) * 2;
-        for (size_t i = 0; i < count; i += 3)
-        {
-            const size_t texIndex = (i / 3) * 2;
-            if (textureEnabled && hasTexcoords && texIndex + 1 < mesh.texcoords.size())
-            {
-                glTexCoord2f(mesh.texcoords[texIndex], mesh.texcoords[texIndex + 1]);
-            }
-            glNormal3f(mesh.normals[i], mesh.normals[i + 1], mesh.normals[i + 2]);
-            glVertex3f(mesh.vertices[i], mesh.vertices[i + 1], mesh.vertices[i + 2]);
-        }
-        glEnd();
-
+        glColor4f(r, g, b, a);
+        BindMesh(mesh);
+        DrawBoundMesh(mesh);
+        UnbindMesh(mesh);
+
         if (textureEnabled)
         {
+            SetAtlasRegionTransform(nullptr);
             glBindTexture(GL_TEXTURE_2D, 0);
             glDisable(GL_TEXTURE_2D);
         }
     }
 
-    void RenderGlowAura(const PlacedCube& cube)
+    void RenderGlowAura(int gridX, int gridY, int gridZ, const vengine::CubeColor& color)
     {
         glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glDisable(GL_LIGHTING);
@@ -1495,7 +2785,7 @@ namespace
         glDepthMask(GL_FALSE);
 
         glPushMatrix();
-        glTranslatef(static_cast<float>(cube.gridX), static_cast<float>(cube.gridY) + 0.5f, static_cast<float>(cube.gridZ));
+        glTranslatef(static_cast<float>(gridX), static_cast<float>(gridY) + 0.5f, static_cast<float>(gridZ));
 
         constexpr int kSegments = 32;
         const float radius = 1.8f;
@@ -1506,9 +2796,9 @@ namespace
                 glRotatef(angle, axisX, axisY, axisZ);
             }
             glBegin(GL_TRIANGLE_FAN);
-            glColor4f(cube.r, cube.g, cube.b, 0.45f);
+            glColor4f(color.r, color.g, color.b, 0.45f);
             glVertex3f(0.0f, 0.0f, 0.0f);
-            glColor4f(cube.r, cube.g, cube.b, 0.0f);
+            glColor4f(color.r, color.g, color.b, 0.0f);
             for (int i = 0; i <= kSegments; ++i)
             {
                 const float theta = (static_cast<float>(i) / static_cast<float>(kSegments)) * 2.0f * kPi;
@@ -1531,9 +2821,16 @@ namespace
         glPopAttrib();
     }
 
-    void RenderTransparentCubes(const Mesh& mesh, const std::vector<const PlacedCube*>& cubes)
+    void RenderGlowAura(size_t index)
+    {
+        int gridX, gridY, gridZ;
+        g_placedCubes.Cell(index, gridX, gridY, gridZ);
+        RenderGlowAura(gridX, gridY, gridZ, g_placedCubes.Color(index));
+    }
+
+    void RenderTransparentCubes(const Mesh& mesh, const vengine::FrameVector<uint32_t>& cubes, const vengine::FrameVector<uint32_t>& auras)
     {
-        if (cubes.empty())
+        if (cubes.empty() && auras.empty())
         {
             return;
         }
@@ -1546,23 +2843,27 @@ namespace
         constexpr float kAlpha = 0.45f;
         const GLfloat kNoEmission[] = {0.0f, 0.0f, 0.0f, 1.0f};
 
-        for (const PlacedCube* cube : cubes)
+        for (uint32_t index : cubes)
         {
+            int gridX, gridY, gridZ;
+            g_placedCubes.Cell(index, gridX, gridY, gridZ);
+            const vengine::CubeColor& color = g_placedCubes.Color(index);
+            const bool glowing = g_placedCubes.Glowing(index);
             glPushMatrix();
-            glTranslatef(static_cast<float>(cube->gridX), static_cast<float>(cube->gridY) + 0.5f, static_cast<float>(cube->gridZ));
-            Vec3 samplePos{static_cast<float>(cube->gridX), static_cast<float>(cube->gridY) + 0.5f, static_cast<float>(cube->gridZ)};
-            const float lightAmount = cube->glowing ? 1.0f : ComputeLightAtPoint(samplePos, cube);
+            glTranslatef(static_cast<float>(gridX), static_cast<float>(gridY) + 0.5f, static_cast<float>(gridZ));
+            Vec3 samplePos{static_cast<float>(gridX), static_cast<float>(gridY) + 0.5f, static_cast<float>(gridZ)};
+            const float lightAmount = glowing ? 1.0f : ComputeLightAtPoint(samplePos, static_cast<int>(index));
             const float shading = std::clamp(0.5f + 0.5f * lightAmount, 0.2f, 1.2f);
-            const float tintedR = std::clamp(cube->r * shading, 0.0f, 1.0f);
-            const float tintedG = std::clamp(cube->g * shading, 0.0f, 1.0f);
-            const float tintedB = std::clamp(cube->b * shading, 0.0f, 1.0f);
-            if (cube->glowing)
+            const float tintedR = std::clamp(color.r * shading, 0.0f, 1.0f);
+            const float tintedG = std::clamp(color.g * shading, 0.0f, 1.0f);
+            const float tintedB = std::clamp(color.b * shading, 0.0f, 1.0f);
+            if (glowing)
             {
-                const GLfloat emission[] = {cube->r * 0.4f, cube->g * 0.4f, cube->b * 0.4f, 1.0f};
+                const GLfloat emission[] = {color.r * 0.4f, color.g * 0.4f, color.b * 0.4f, 1.0f};
                 glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, emission);
             }
-            RenderMesh(mesh, tintedR, tintedG, tintedB, kAlpha, cube->textureHandle);
-            if (cube->glowing)
+            RenderMesh(mesh, tintedR, tintedG, tintedB, kAlpha, g_placedCubes.TextureHandle(index));
+            if (glowing)
             {
                 glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, kNoEmission);
             }
@@ -1573,12 +2874,9 @@ namespace
         glDisable(GL_BLEND);
         glPopAttrib();
 
-        for (const PlacedCube* cube : cubes)
+        for (uint32_t index : auras)
         {
-            if (cube->glowing)
-            {
-                RenderGlowAura(*cube);
-            }
+            RenderGlowAura(index);
         }
     }
 
@@ -1594,7 +2892,7 @@ namespace
         int drawZ = g_dragPreviewHasPosition ? g_dragPreviewZ : g_draggedCube.gridZ;
 
         Vec3 samplePos{static_cast<float>(drawX), static_cast<float>(drawY) + 0.5f, static_cast<float>(drawZ)};
-        const float lightAmount = g_draggedCube.glowing ? 1.0f : ComputeLightAtPoint(samplePos, &g_draggedCube);
+        const float lightAmount = g_draggedCube.glowing ? 1.0f : ComputeLightAtPoint(samplePos, -1);
         const float shading = std::clamp(0.4f + 0.6f * lightAmount, 0.2f, 1.0f);
         const float shadedR = std::clamp(g_draggedCube.r * shading, 0.0f, 1.0f);
         const float shadedG = std::clamp(g_draggedCube.g * shading, 0.0f, 1.0f);
@@ -1643,137 +2941,913 @@ namespace
 
         if (g_draggedCube.glowing && g_dragPreviewHasPosition)
         {
-            PlacedCube previewGlow = g_draggedCube;
-            previewGlow.gridX = drawX;
-            previewGlow.gridY = drawY;
-            previewGlow.gridZ = drawZ;
-            RenderGlowAura(previewGlow);
+            RenderGlowAura(drawX, drawY, drawZ, vengine::CubeColor{g_draggedCube.r, g_draggedCube.g, g_draggedCube.b});
+        }
+    }
+
+    // One light field per layout version. The editor lights cubes with it on the main thread, and
+    // every LOD job queued while it is current shares it on the worker.
+    std::shared_ptr<const vengine::CubeLightField> g_cubeLighting;
+    uint64_t g_cubeLightingVersion = 0;
+
+    std::shared_ptr<const vengine::CubeLightField> AcquireCubeLighting()
+    {
+        if (!g_cubeLighting || g_cubeLightingVersion != g_cubeLayoutVersion)
+        {
+            auto lighting = std::make_shared<vengine::CubeLightField>();
+            lighting->Build(g_placedCubes);
+            g_cubeLighting = std::move(lighting);
+            g_cubeLightingVersion = g_cubeLayoutVersion;
         }
+        return g_cubeLighting;
     }
 
-    bool IsLightOccluded(const Vec3& origin, const Vec3& target, const PlacedCube* lightCube, const PlacedCube* receiver)
+    float ComputeLightAtPoint(const Vec3& point, int receiver)
     {
-        Vec3 dir = target - origin;
-        const float dirLengthSq = dir.x * dir.x + dir.y * dir.y + dir.z * dir.z;
-        if (dirLengthSq < 1e-6f)
+        const vengine::CubeLightField& lighting = *AcquireCubeLighting();
+        if (receiver >= 0)
         {
-            return false;
+            int cubeX, cubeY, cubeZ;
+            g_placedCubes.Cell(static_cast<size_t>(receiver), cubeX, cubeY, cubeZ);
+            return lighting.LightAtCube(cubeX, cubeY, cubeZ);
+        }
+        return lighting.LightAt(point.x, point.y, point.z);
+    }
+
+    // Draws opaque glowing cubes that share an atlas page (or have no texture at all) with the mesh
+    // bound once: per cube only the colour, emission, transform and atlas cell change. The rest of
+    // the opaque cubes go through the baked page buffers below.
+    void RenderOpaqueCubeBatch(const Mesh& mesh, const vengine::FrameVector<uint32_t>& cubes, GLuint atlasTexture)
+    {
+        const GLfloat kNoEmission[] = {0.0f, 0.0f, 0.0f, 1.0f};
+        if (atlasTexture != 0)
+        {
+            glEnable(GL_TEXTURE_2D);
+            glBindTexture(GL_TEXTURE_2D, atlasTexture);
+            glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+        }
+
+        BindMesh(mesh);
+        for (uint32_t index : cubes)
+        {
+            int gridX, gridY, gridZ;
+            g_placedCubes.Cell(index, gridX, gridY, gridZ);
+            const vengine::CubeColor& color = g_placedCubes.Color(index);
+            const bool glowing = g_placedCubes.Glowing(index);
+            Vec3 samplePos{static_cast<float>(gridX), static_cast<float>(gridY) + 0.5f, static_cast<float>(gridZ)};
+            const float lightAmount = glowing ? 1.0f : ComputeLightAtPoint(samplePos, static_cast<int>(index));
+            const float shading = std::clamp(0.4f + 0.6f * lightAmount, 0.2f, 1.0f);
+            const float shadedR = std::clamp(color.r * shading, 0.0f, 1.0f);
+            const float shadedG = std::clamp(color.g * shading, 0.0f, 1.0f);
+            const float shadedB = std::clamp(color.b * shading, 0.0f, 1.0f);
+            if (glowing)
+            {
+                const GLfloat emission[] = {color.r * 0.6f, color.g * 0.6f, color.b * 0.6f, 1.0f};
+                glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, emission);
+            }
+            glColor4f(shadedR, shadedG, shadedB, 1.0f);
+            if (atlasTexture != 0)
+            {
+                const LoadedTexture* texture = GetTextureInfo(g_placedCubes.TextureHandle(index));
+                SetAtlasRegionTransform(texture ? &texture->region : nullptr);
+            }
+            glPushMatrix();
+            glTranslatef(samplePos.x, samplePos.y, samplePos.z);
+            DrawBoundMesh(mesh);
+            glPopMatrix();
+            if (glowing)
+            {
+                glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, kNoEmission);
+            }
+        }
+        UnbindMesh(mesh);
+
+        if (atlasTexture != 0)
+        {
+            SetAtlasRegionTransform(nullptr);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glDisable(GL_TEXTURE_2D);
+        }
+    }
+
+    // Opaque, non-glowing cubes drawn at full detail are pre-transformed into one buffer per atlas
+    // page (plus one for untextured cubes): world position, normal, atlas UV and baked shading per
+    // vertex, laid out chunk by chunk. Each page then costs one glMultiDrawElements over the index
+    // ranges of its visible chunks, with no per-cube state changes. A chunk's geometry is built the
+    // first frame it is drawn at full detail and kept until it goes unused for a while; the page
+    // buffers are reassembled from it only when that set of chunks changes or when any edit or
+    // atlas change invalidates the baked vertices.
+    constexpr uint64_t kOpaqueChunkKeepFrames = 300;
+    constexpr int kBakedVertexFloats = 11;
+    const VertexFormat kBakedCubeVertexFormat{static_cast<GLsizei>(kBakedVertexFloats * sizeof(float)),
+                                              {3, 0},
+                                              {3, 3 * sizeof(float)},
+                                              {2, 6 * sizeof(float)},
+                                              {3, 8 * sizeof(float)}};
+
+    struct OpaqueChunkGeometry
+    {
+        std::vector<std::vector<float>> batches; // Indexed like opaqueBatches: 0 untextured, N + 1 atlas page N.
+        uint64_t lastUsedFrame = 0;
+    };
+
+    struct OpaquePageBuffer
+    {
+        Mesh mesh; // kBakedCubeVertexFormat; the arrays are dropped once uploaded to buffer objects.
+        std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>> chunkRanges; // Chunk key -> first index, index count.
+    };
+
+    std::unordered_map<uint64_t, OpaqueChunkGeometry> g_opaqueChunkGeometry;
+    std::vector<OpaquePageBuffer> g_opaquePageBuffers;
+    bool g_opaquePageBuffersDirty = true;
+    uint64_t g_opaqueGeometryLayoutVersion = std::numeric_limits<uint64_t>::max();
+    uint64_t g_opaqueGeometryAtlasVersion = std::numeric_limits<uint64_t>::max();
+    uint64_t g_opaqueGeometryFrame = 0;
+
+    void ReleaseOpaquePageBuffers()
+    {
+        for (OpaquePageBuffer& page : g_opaquePageBuffers)
+        {
+            ReleaseMesh(page.mesh);
+        }
+        g_opaquePageBuffers.clear();
+        g_opaquePageBuffersDirty = true;
+    }
+
+    // Called once per frame before any chunk is drawn: drops everything baked against an older
+    // layout or atlas, and chunks nobody has drawn for kOpaqueChunkKeepFrames.
+    void BeginOpaqueChunkFrame()
+    {
+        ++g_opaqueGeometryFrame;
+        if (g_opaqueGeometryLayoutVersion != g_cubeLayoutVersion || g_opaqueGeometryAtlasVersion != g_atlasLayoutVersion)
+        {
+            g_opaqueChunkGeometry.clear();
+            g_opaquePageBuffersDirty = true;
+            g_opaqueGeometryLayoutVersion = g_cubeLayoutVersion;
+            g_opaqueGeometryAtlasVersion = g_atlasLayoutVersion;
+        }
+        for (auto it = g_opaqueChunkGeometry.begin(); it != g_opaqueChunkGeometry.end();)
+        {
+            if (g_opaqueGeometryFrame - it->second.lastUsedFrame < kOpaqueChunkKeepFrames)
+            {
+                ++it;
+                continue;
+            }
+            it = g_opaqueChunkGeometry.erase(it);
+            g_opaquePageBuffersDirty = true;
+        }
+    }
+
+    // Marks the chunk as drawn this frame, baking its geometry first if it has none.
+    void UseOpaqueChunk(const Mesh& mesh, uint64_t key, const std::vector<uint32_t>& items)
+    {
+        const auto inserted = g_opaqueChunkGeometry.try_emplace(key);
+        OpaqueChunkGeometry& geometry = inserted.first->second;
+        geometry.lastUsedFrame = g_opaqueGeometryFrame;
+        if (!inserted.second)
+        {
+            return;
+        }
+        g_opaquePageBuffersDirty = true;
+        geometry.batches.resize(g_atlasPages.size() + 1);
+
+        const VertexFormat& format = mesh.format;
+        const size_t stride = static_cast<size_t>(format.stride) / sizeof(float);
+        const size_t vertexCount = stride > 0 ? mesh.vertexData.size() / stride : 0;
+        for (uint32_t index : items)
+        {
+            if (g_placedCubes.Transparent(index) || g_placedCubes.Glowing(index))
+            {
+                continue;
+            }
+            int gridX, gridY, gridZ;
+            g_placedCubes.Cell(index, gridX, gridY, gridZ);
+            const vengine::CubeColor& color = g_placedCubes.Color(index);
+            const Vec3 samplePos{static_cast<float>(gridX), static_cast<float>(gridY) + 0.5f, static_cast<float>(gridZ)};
+            const float shading = std::clamp(0.4f + 0.6f * ComputeLightAtPoint(samplePos, static_cast<int>(index)), 0.2f, 1.0f);
+            const float shaded[3] = {std::clamp(color.r * shading, 0.0f, 1.0f), std::clamp(color.g * shading, 0.0f, 1.0f),
+                                     std::clamp(color.b * shading, 0.0f, 1.0f)};
+            const LoadedTexture* texture = GetTextureInfo(g_placedCubes.TextureHandle(index));
+            const bool textured = texture && GetAtlasPageTexture(texture->region.page) != 0;
+            const size_t batch = textured ? static_cast<size_t>(texture->region.page) + 1 : 0;
+
+            std::vector<float>& out = geometry.batches[batch];
+            for (size_t vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex)
+            {
+                const float* vertex = &mesh.vertexData[vertexIndex * stride];
+                const float* position = vertex + format.position.offset / sizeof(float);
+                out.insert(out.end(), {position[0] + samplePos.x, position[1] + samplePos.y, position[2] + samplePos.z});
+                if (format.normal.components > 0)
+                {
+                    const float* normal = vertex + format.normal.offset / sizeof(float);
+                    out.insert(out.end(), {normal[0], normal[1], normal[2]});
+                }
+                else
+                {
+                    out.insert(out.end(), {0.0f, 1.0f, 0.0f});
+                }
+                // The atlas cell mapping SetAtlasRegionTransform applies through the texture matrix.
+                float u = 0.0f;
+                float v = 0.0f;
+                if (format.texcoord.components > 0)
+                {
+                    const float* texcoord = vertex + format.texcoord.offset / sizeof(float);
+                    u = texcoord[0];
+                    v = texcoord[1];
+                }
+                if (textured)
+                {
+                    u = texture->region.u0 + u * (texture->region.u1 - texture->region.u0);
+                    v = texture->region.v0 + v * (texture->region.v1 - texture->region.v0);
+                }
+                out.insert(out.end(), {u, v, shaded[0], shaded[1], shaded[2]});
+            }
+        }
+    }
+
+    // Concatenates every resident chunk's geometry into the page buffers, chunk by chunk.
+    void RebuildOpaquePageBuffers(const Mesh& mesh)
+    {
+        ReleaseOpaquePageBuffers();
+        g_opaquePageBuffersDirty = false;
+        g_opaquePageBuffers.resize(g_atlasPages.size() + 1);
+        const uint32_t meshVertexCount = mesh.format.stride > 0
+                                             ? static_cast<uint32_t>(mesh.vertexData.size() * sizeof(float) / static_cast<size_t>(mesh.format.stride))
+                                             : 0;
+        for (size_t batch = 0; batch < g_opaquePageBuffers.size(); ++batch)
+        {
+            OpaquePageBuffer& page = g_opaquePageBuffers[batch];
+            page.mesh.format = kBakedCubeVertexFormat;
+            for (const auto& entry : g_opaqueChunkGeometry)
+            {
+                if (batch >= entry.second.batches.size() || entry.second.batches[batch].empty() || meshVertexCount == 0)
+                {
+                    continue;
+                }
+                const std::vector<float>& vertices = entry.second.batches[batch];
+                const uint32_t firstIndex = static_cast<uint32_t>(page.mesh.indices.size());
+                const uint32_t firstVertex = static_cast<uint32_t>(page.mesh.vertexData.size() / kBakedVertexFloats);
+                const uint32_t cubes = static_cast<uint32_t>(vertices.size() / kBakedVertexFloats) / meshVertexCount;
+                page.mesh.vertexData.insert(page.mesh.vertexData.end(), vertices.begin(), vertices.end());
+                for (uint32_t cube = 0; cube < cubes; ++cube)
+                {
+                    const uint32_t base = firstVertex + cube * meshVertexCount;
+                    for (uint32_t index : mesh.indices)
+                    {
+                        page.mesh.indices.push_back(base + index);
+                    }
+                }
+                page.chunkRanges[entry.first] = {firstIndex, static_cast<uint32_t>(page.mesh.indices.size()) - firstIndex};
+            }
+            UploadMesh(page.mesh);
+            if (page.mesh.vertexBuffer != 0)
+            {
+                std::vector<float>().swap(page.mesh.vertexData);
+                std::vector<uint32_t>().swap(page.mesh.indices);
+            }
         }
+    }
 
-        for (const PlacedCube& cube : g_placedCubes)
+    // One draw per page over the given chunks' ranges; returns the triangles drawn.
+    size_t RenderOpaquePageBuffers(const Mesh& mesh, const vengine::FrameVector<uint64_t>& chunks)
+    {
+        if (g_opaquePageBuffersDirty)
+        {
+            RebuildOpaquePageBuffers(mesh);
+        }
+        const vengine::ArenaAllocator<GLsizei> countAllocator(g_frameArena);
+        const vengine::ArenaAllocator<const void*> offsetAllocator(g_frameArena);
+        vengine::FrameVector<GLsizei> counts(countAllocator);
+        vengine::FrameVector<const void*> offsets(offsetAllocator);
+        size_t triangles = 0;
+        for (size_t batch = 0; batch < g_opaquePageBuffers.size(); ++batch)
         {
-            if (&cube == lightCube || &cube == receiver)
+            const OpaquePageBuffer& page = g_opaquePageBuffers[batch];
+            const GLuint atlasTexture = batch == 0 ? 0 : GetAtlasPageTexture(static_cast<int>(batch) - 1);
+            if (page.chunkRanges.empty() || (batch != 0 && atlasTexture == 0))
             {
                 continue;
             }
-            if (cube.transparent)
+            const char* indexBase = page.mesh.indexBuffer != 0 ? nullptr : reinterpret_cast<const char*>(page.mesh.indices.data());
+            counts.clear();
+            offsets.clear();
+            uint32_t runFirst = 0;
+            uint32_t runEnd = 0;
+            for (uint64_t key : chunks)
+            {
+                const auto found = page.chunkRanges.find(key);
+                if (found == page.chunkRanges.end())
+                {
+                    continue;
+                }
+                const uint32_t first = found->second.first;
+                const uint32_t count = found->second.second;
+                if (!counts.empty() && first == runEnd)
+                {
+                    // Chunks adjacent in the buffer merge into one range.
+                    runEnd += count;
+                    counts.back() = static_cast<GLsizei>(runEnd - runFirst);
+                    continue;
+                }
+                runFirst = first;
+                runEnd = first + count;
+                counts.push_back(static_cast<GLsizei>(count));
+                offsets.push_back(indexBase + static_cast<size_t>(first) * sizeof(uint32_t));
+            }
+            if (counts.empty())
             {
                 continue;
             }
 
-            Vec3 minB{static_cast<float>(cube.gridX) - 0.5f, static_cast<float>(cube.gridY), static_cast<float>(cube.gridZ) - 0.5f};
-            Vec3 maxB{static_cast<float>(cube.gridX) + 0.5f, static_cast<float>(cube.gridY) + 1.0f, static_cast<float>(cube.gridZ) + 0.5f};
-            float t = 0.0f;
-            Vec3 normal;
-            if (RayIntersectsAABB(origin, dir, minB, maxB, t, normal))
+            if (atlasTexture != 0)
+            {
+                glEnable(GL_TEXTURE_2D);
+                glBindTexture(GL_TEXTURE_2D, atlasTexture);
+                glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+            }
+            BindMesh(page.mesh);
+            if (g_glMultiDrawElements)
             {
-                if (t > 1e-4f && t < 1.0f)
+                g_glMultiDrawElements(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(), static_cast<GLsizei>(counts.size()));
+            }
+            else
+            {
+                for (size_t range = 0; range < counts.size(); ++range)
                 {
-                    return true;
+                    glDrawElements(GL_TRIANGLES, counts[range], GL_UNSIGNED_INT, offsets[range]);
                 }
             }
+            UnbindMesh(page.mesh);
+            if (atlasTexture != 0)
+            {
+                glBindTexture(GL_TEXTURE_2D, 0);
+                glDisable(GL_TEXTURE_2D);
+            }
+            for (GLsizei count : counts)
+            {
+                triangles += static_cast<size_t>(count) / 3;
+            }
         }
+        return triangles;
+    }
 
-        return false;
+    // Culling state. The frustum is captured right after gluLookAt each frame. Culled cubes also
+    // skip ComputeLightAtPoint, which is the expensive part of drawing one.
+    constexpr float kGlowAuraRadius = 1.8f;
+    vengine::Frustum g_viewFrustum;
+    int g_lastVisibleCubeCount = 0;
+    Vec3 g_viewEye{0.0f, 0.0f, 0.0f};
+
+    // Chunks whose centre is at least kLodDistances[L - 1] from the eye draw LOD level L. Each
+    // level quarters the faces of a surface while each band doubles in radius (four times the
+    // area), so the triangle count stays roughly flat as the camera pulls back. LOD meshes bake
+    // the glow lighting of their cells; a chunk rebuilds when its own cubes or any glowing cube
+    // changes, so shadows cast into it by other edits refresh only once it is next rebuilt.
+    constexpr float kLodDistances[vengine::kLodLevelCount - 1] = {48.0f, 96.0f};
+    vengine::ChunkLodCache g_chunkLods;
+    std::unordered_map<uint64_t, uint64_t> g_chunkContentHashes; // Chunk key -> sum of its cube hashes.
+    uint64_t g_glowLayoutHash = 0;
+    bool g_lodEnabled = true; // Content Browser toggle.
+    int g_lastTriangleCount = 0;
+
+    // GL_ARB_occlusion_query (core since GL 1.5), resolved once the context exists. Without it
+    // chunks are only frustum culled.
+    using GenQueriesProc = void(APIENTRY*)(GLsizei, GLuint*);
+    using DeleteQueriesProc = void(APIENTRY*)(GLsizei, const GLuint*);
+    using BeginQueryProc = void(APIENTRY*)(GLenum, GLuint);
+    using EndQueryProc = void(APIENTRY*)(GLenum);
+    using GetQueryObjectuivProc = void(APIENTRY*)(GLuint, GLenum, GLuint*);
+    constexpr GLenum kGlSamplesPassed = 0x8914;
+    constexpr GLenum kGlQueryResult = 0x8866;
+    constexpr GLenum kGlQueryResultAvailable = 0x8867;
+
+    class LegacyOcclusionQueries : public vengine::OcclusionQueryBackend
+    {
+    public:
+        bool Load()
+        {
+            const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+            const char* suffix = extensions && std::strstr(extensions, "GL_ARB_occlusion_query") ? "ARB" : "";
+            auto resolve = [suffix](const char* name) {
+                const std::string full = std::string(name) + suffix;
+                return wglGetProcAddress(full.c_str());
+            };
+            m_genQueries = reinterpret_cast<GenQueriesProc>(resolve("glGenQueries"));
+            m_deleteQueries = reinterpret_cast<DeleteQueriesProc>(resolve("glDeleteQueries"));
+            m_beginQuery = reinterpret_cast<BeginQueryProc>(resolve("glBeginQuery"));
+            m_endQuery = reinterpret_cast<EndQueryProc>(resolve("glEndQuery"));
+            m_getQueryObjectuiv = reinterpret_cast<GetQueryObjectuivProc>(resolve("glGetQueryObjectuiv"));
+            return Available();
+        }
+
+        bool Available() const
+        {
+            return m_genQueries && m_deleteQueries && m_beginQuery && m_endQuery && m_getQueryObjectuiv;
+        }
+
+        uint32_t CreateQuery() override
+        {
+            GLuint query = 0;
+            m_genQueries(1, &query);
+            return query;
+        }
+
+        void DestroyQuery(uint32_t query) override
+        {
+            const GLuint id = query;
+            m_deleteQueries(1, &id);
+        }
+
+        bool QueryResultReady(uint32_t query) override
+        {
+            GLuint available = 0;
+            m_getQueryObjectuiv(query, kGlQueryResultAvailable, &available);
+            return available != 0;
+        }
+
+        bool QueryAnySamplesPassed(uint32_t query) override
+        {
+            GLuint samples = 0;
+            m_getQueryObjectuiv(query, kGlQueryResult, &samples);
+            return samples != 0;
+        }
+
+        void BeginBoxPass() override
+        {
+            glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glDisable(GL_LIGHTING);
+            glDisable(GL_TEXTURE_2D);
+            glDisable(GL_BLEND);
+            glDisable(GL_CULL_FACE);
+            glEnable(GL_DEPTH_TEST);
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            glDepthMask(GL_FALSE);
+        }
+
+        void DrawQueryBox(uint32_t query, const vengine::Aabb& box) override
+        {
+            const float xs[2] = {box.minX, box.maxX};
+            const float ys[2] = {box.minY, box.maxY};
+            const float zs[2] = {box.minZ, box.maxZ};
+            // Corner i has x = bit 0, y = bit 1, z = bit 2.
+            static const int kFaces[6][4] = {
+                {0, 2, 6, 4}, {1, 5, 7, 3}, // -x, +x
+                {0, 4, 5, 1}, {2, 3, 7, 6}, // -y, +y
+                {0, 1, 3, 2}, {4, 6, 7, 5}, // -z, +z
+            };
+            m_beginQuery(kGlSamplesPassed, query);
+            glBegin(GL_QUADS);
+            for (const auto& face : kFaces)
+            {
+                for (int corner : face)
+                {
+                    glVertex3f(xs[corner & 1], ys[(corner >> 1) & 1], zs[(corner >> 2) & 1]);
+                }
+            }
+            glEnd();
+            m_endQuery(kGlSamplesPassed);
+        }
+
+        void EndBoxPass() override
+        {
+            glPopAttrib();
+        }
+
+    private:
+        GenQueriesProc m_genQueries = nullptr;
+        DeleteQueriesProc m_deleteQueries = nullptr;
+        BeginQueryProc m_beginQuery = nullptr;
+        EndQueryProc m_endQuery = nullptr;
+        GetQueryObjectuivProc m_getQueryObjectuiv = nullptr;
+    };
+
+    LegacyOcclusionQueries g_occlusionQueries;
+    vengine::ChunkOcclusionCuller g_chunkOcclusion;
+    bool g_occlusionCullingEnabled = true; // Content Browser toggle.
+
+    void InitializeOcclusionCulling()
+    {
+        g_chunkOcclusion.SetEnabled(g_occlusionQueries.Load() && g_occlusionCullingEnabled);
+    }
+
+    void ShutdownOcclusionCulling()
+    {
+        if (g_occlusionQueries.Available())
+        {
+            g_chunkOcclusion.Reset(g_occlusionQueries);
+        }
+    }
+
+    void CaptureViewFrustum(const Vec3& eye)
+    {
+        GLfloat projection[16];
+        GLfloat modelview[16];
+        GLfloat clip[16];
+        glGetFloatv(GL_PROJECTION_MATRIX, projection);
+        glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+        vengine::MultiplyColumnMajor(projection, modelview, clip);
+        g_viewFrustum.Extract(clip);
+        g_viewEye = eye;
+    }
+
+    // Everything about a cube that shows up in its LOD mesh or in the light it casts. Takes the
+    // fields rather than a cube, so the scene loader can hash SceneCubes on its index thread.
+    uint64_t HashCubeForLod(int x, int y, int z, const vengine::CubeColor& cubeColor, uint8_t flags)
+    {
+        const int cell[3] = {x, y, z};
+        const float color[3] = {cubeColor.r, cubeColor.g, cubeColor.b};
+        uint64_t hash = vengine::HashBytes(cell, sizeof(cell));
+        hash = vengine::HashBytes(color, sizeof(color), hash);
+        return vengine::HashBytes(&flags, sizeof(flags), hash);
+    }
+
+    void RefreshCubeChunks()
+    {
+        if (g_cubeChunksVersion == g_cubeLayoutVersion)
+        {
+            return;
+        }
+        g_cubeChunks.Clear();
+        g_chunkContentHashes.clear();
+        g_glowLayoutHash = 0;
+        for (size_t i = 0; i < g_placedCubes.Size(); ++i)
+        {
+            int gridX, gridY, gridZ;
+            g_placedCubes.Cell(i, gridX, gridY, gridZ);
+            g_cubeChunks.Insert(static_cast<uint32_t>(i), gridX, gridY, gridZ);
+            // Summed rather than chained so the hash ignores the order cubes sit in the store.
+            const uint64_t cubeHash = HashCubeForLod(gridX, gridY, gridZ, g_placedCubes.Color(i), g_placedCubes.Flags()[i]);
+            g_chunkContentHashes[vengine::CubeChunkIndex::KeyForCell(gridX, gridY, gridZ)] += cubeHash;
+            if (g_placedCubes.Glowing(i))
+            {
+                g_glowLayoutHash += cubeHash;
+            }
+        }
+        g_cubeChunksVersion = g_cubeLayoutVersion;
+    }
+
+    // scene.txt is read by vengine::SceneLoader: its parse workers, texture stage and index stage
+    // run in the background while the window keeps drawing a progress bar. The texture stage
+    // decodes each distinct texture once (PrepareAtlasCell touches no GL), and the index stage
+    // builds the culling chunks and LOD hashes RefreshCubeChunks would otherwise rebuild on the
+    // first frame. The main thread only uploads the prepared textures and copies cubes over; the
+    // finished scene replaces the empty one in a single swap.
+    class SceneLoadStages : public vengine::SceneLoadSink
+    {
+    public:
+        void PrepareTexture(const std::string& path) override
+        {
+            auto cell = std::make_unique<PreparedAtlasCell>();
+            std::string message;
+            if (!PrepareAtlasCell(MakeAbsoluteTexturePath(path), *cell, message))
+            {
+                cell.reset();
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_textures[path] = std::move(cell);
+        }
+
+        void IndexBatch(size_t firstItem, const std::vector<vengine::SceneCube>& cubes) override
+        {
+            for (size_t i = 0; i < cubes.size(); ++i)
+            {
+                const vengine::SceneCube& cube = cubes[i];
+                index.Insert(static_cast<uint32_t>(firstItem + i), cube.gridX, cube.gridY, cube.gridZ);
+                const uint8_t flags = static_cast<uint8_t>((cube.glowing ? vengine::kCubeGlowing : 0) | (cube.transparent ? vengine::kCubeTransparent : 0));
+                const uint64_t cubeHash = HashCubeForLod(cube.gridX, cube.gridY, cube.gridZ, vengine::CubeColor{cube.r, cube.g, cube.b}, flags);
+                contentHashes[vengine::CubeChunkIndex::KeyForCell(cube.gridX, cube.gridY, cube.gridZ)] += cubeHash;
+                if (cube.glowing)
+                {
+                    glowHash += cubeHash;
+                }
+            }
+        }
+
+        // Main thread: the prepared cell for a stored texture path, or null if it failed to load.
+        std::unique_ptr<PreparedAtlasCell> TakeTexture(const std::string& path)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const auto found = m_textures.find(path);
+            if (found == m_textures.end())
+            {
+                return nullptr;
+            }
+            std::unique_ptr<PreparedAtlasCell> cell = std::move(found->second);
+            m_textures.erase(found);
+            return cell;
+        }
+
+        // Written by the index stage; read once the load has finished.
+        vengine::CubeChunkIndex index;
+        std::unordered_map<uint64_t, uint64_t> contentHashes;
+        uint64_t glowHash = 0;
+
+    private:
+        std::mutex m_mutex;
+        std::unordered_map<std::string, std::unique_ptr<PreparedAtlasCell>> m_textures;
+    };
+
+    vengine::SceneLoader g_sceneLoader;
+    std::unique_ptr<SceneLoadStages> g_sceneLoadStages;
+    vengine::CubeStore g_sceneLoadCubes;
+    std::unordered_map<std::string, int> g_sceneLoadTextureHandles; // Stored path -> handle, for this load.
+    double g_sceneLoadStartSeconds = 0.0;
+    constexpr double kSceneLoadFrameBudgetSeconds = 0.008;
+
+    void StartSceneLoad()
+    {
+        if (g_sceneFilePath.empty())
+        {
+            return;
+        }
+        // Probe the GL extensions here: the texture stage picks the atlas format without a context.
+        // GDI+ is started here too, so the loader thread never races EnsureGdiplusInitialized.
+        AtlasUsesCompression();
+        EnsureGdiplusInitialized();
+        g_sceneLoading = true;
+        g_sceneSuppressSave = true;
+        g_sceneLoadCubes.Clear();
+        g_sceneLoadTextureHandles.clear();
+        g_sceneLoadStages = std::make_unique<SceneLoadStages>();
+        g_sceneLoadStartSeconds = GetWallSeconds();
+        g_sceneLoader.Start(g_sceneFilePath, *g_sceneLoadStages);
+    }
+
+    int ResolveSceneLoadTexture(const std::string& storedPath)
+    {
+        const auto known = g_sceneLoadTextureHandles.find(storedPath);
+        if (known != g_sceneLoadTextureHandles.end())
+        {
+            return known->second;
+        }
+        const std::string absolute = MakeAbsoluteTexturePath(storedPath);
+        int handle = FindTextureHandleByPath(absolute);
+        std::unique_ptr<PreparedAtlasCell> cell = g_sceneLoadStages->TakeTexture(storedPath);
+        if (handle < 0 && cell)
+        {
+            std::string message;
+            handle = InstallPreparedTexture(absolute, *cell, message);
+        }
+        g_sceneLoadTextureHandles.emplace(storedPath, handle);
+        return handle;
+    }
+
+    // Takes finished blocks over into g_sceneLoadCubes for up to a few milliseconds (or, with wait
+    // set, until the whole scene is in), then swaps the scene in once everything has arrived.
+    void PumpSceneLoad(bool wait)
+    {
+        if (!g_sceneLoading)
+        {
+            return;
+        }
+        const double deadline = GetWallSeconds() + kSceneLoadFrameBudgetSeconds;
+        bool overBudget = false;
+        while (!overBudget)
+        {
+            const size_t delivered = g_sceneLoader.Drain(
+                [](vengine::SceneLoadBatch& batch) {
+                    for (vengine::SceneCube& record : batch.cubes)
+                    {
+                        const int handle = record.texturePath.empty() ? kInvalidTextureHandle : ResolveSceneLoadTexture(record.texturePath);
+                        g_sceneLoadCubes.Append(ToPlacedCube(record, handle));
+                    }
+                },
+                1, wait);
+            overBudget = !wait && GetWallSeconds() > deadline;
+            if (delivered == 0)
+            {
+                break;
+            }
+        }
+
+        const vengine::SceneLoadProgress progress = g_sceneLoader.Progress();
+        if (!progress.finished)
+        {
+            return;
+        }
+        g_sceneLoader.Cancel();
+        if (!progress.failed)
+        {
+            for (int textureHandle : g_placedCubes.TextureHandles())
+            {
+                ReleaseTexture(textureHandle);
+            }
+            g_placedCubes.Swap(g_sceneLoadCubes);
+            ++g_cubeLayoutVersion;
+            g_cubeChunks = std::move(g_sceneLoadStages->index);
+            g_chunkContentHashes = std::move(g_sceneLoadStages->contentHashes);
+            g_glowLayoutHash = g_sceneLoadStages->glowHash;
+            g_cubeChunksVersion = g_cubeLayoutVersion;
+        }
+        for (int textureHandle : g_sceneLoadCubes.TextureHandles())
+        {
+            ReleaseTexture(textureHandle);
+        }
+        g_sceneLoadCubes = vengine::CubeStore();
+        g_sceneLoadTextureHandles.clear();
+        g_sceneLoadStages.reset();
+        g_sceneLoading = false;
+        g_sceneSuppressSave = false;
+        g_sceneDirty = false;
+    }
+
+    void RenderSceneLoadProgress()
+    {
+        if (!g_sceneLoading)
+        {
+            return;
+        }
+        const vengine::SceneLoadProgress progress = g_sceneLoader.Progress();
+        const float fraction = progress.totalBytes > 0 ? static_cast<float>(progress.deliveredBytes) / static_cast<float>(progress.totalBytes) : 0.0f;
+        ImGui::SetNextWindowPos(ImVec2(static_cast<float>(g_windowWidth) * 0.5f, static_cast<float>(g_windowHeight) * 0.5f), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+        ImGui::SetNextWindowSize(ImVec2(320.0f, 0.0f), ImGuiCond_Always);
+        ImGui::Begin("Loading scene", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoSavedSettings);
+        char label[64];
+        std::snprintf(label, sizeof(label), "%zu cubes", progress.deliveredCubes);
+        ImGui::ProgressBar(fraction, ImVec2(-1.0f, 0.0f), label);
+        ImGui::TextDisabled("%zu textures, %.1f s", progress.textures, GetWallSeconds() - g_sceneLoadStartSeconds);
+        ImGui::End();
+    }
+
+    vengine::SceneExporter g_sceneExporter;
+    std::string g_sceneExportStatus; // Refilled each frame; kept so its buffer is reused.
+
+    // Exports a snapshot of the scene next to the executable; with a streamed world that is
+    // whatever is resident.
+    void StartSceneExport(const char* fileName)
+    {
+        std::vector<vengine::SceneCube> cubes;
+        cubes.reserve(g_placedCubes.Size());
+        for (size_t i = 0; i < g_placedCubes.Size(); ++i)
+        {
+            cubes.push_back(ToSceneCube(i));
+        }
+        g_sceneExporter.Start(std::move(cubes), GetExecutableDirectory() + fileName);
     }
 
-    float ComputeLightAtPoint(const Vec3& point, const PlacedCube* receiver)
+    int SelectLodLevel(const vengine::Aabb& bounds)
     {
-        float total = 0.2f;
-        bool hasGlow = false;
-
-        for (const PlacedCube& glow : g_placedCubes)
+        if (!g_lodEnabled)
         {
-            if (!glow.glowing)
-            {
-                continue;
-            }
-
-            hasGlow = true;
-            Vec3 lightPos{
-                static_cast<float>(glow.gridX),
-                static_cast<float>(glow.gridY) + 0.5f,
-                static_cast<float>(glow.gridZ)};
-
-            if (IsLightOccluded(lightPos, point, &glow, receiver))
-            {
-                continue;
-            }
+            return 0;
+        }
+        const float dx = (bounds.minX + bounds.maxX) * 0.5f - g_viewEye.x;
+        const float dy = (bounds.minY + bounds.maxY) * 0.5f - g_viewEye.y;
+        const float dz = (bounds.minZ + bounds.maxZ) * 0.5f - g_viewEye.z;
+        const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+        int level = 0;
+        while (level < vengine::kLodLevelCount - 1 && distance >= kLodDistances[level])
+        {
+            ++level;
+        }
+        return level;
+    }
 
-            Vec3 delta = point - lightPos;
-            const float distSq = delta.x * delta.x + delta.y * delta.y + delta.z * delta.z;
-            if (distSq < 1e-4f)
+    // The opaque cubes of a chunk, unlit: the LOD worker shades them with the light field from
+    // AcquireCubeLighting. Transparent cubes stay on the per-cube path at every distance.
+    std::vector<vengine::LodCell> SnapshotLodCells(const std::vector<uint32_t>& items)
+    {
+        std::vector<vengine::LodCell> cells;
+        cells.reserve(items.size());
+        for (uint32_t index : items)
+        {
+            if (g_placedCubes.Transparent(index))
             {
-                total += 1.0f;
                 continue;
             }
-
-            constexpr float kIntensity = 2.6f;
-            constexpr float kFalloff = 0.45f;
-            const float contribution = kIntensity / (1.0f + distSq * kFalloff);
-            total += contribution;
-        }
-
-        if (!hasGlow)
-        {
-            return 0.35f;
+            int gridX, gridY, gridZ;
+            g_placedCubes.Cell(index, gridX, gridY, gridZ);
+            const vengine::CubeColor& color = g_placedCubes.Color(index);
+            cells.push_back(vengine::LodCell{gridX, gridY, gridZ, color.r, color.g, color.b, g_placedCubes.Glowing(index)});
         }
+        return cells;
+    }
 
-        return std::clamp(total, 0.0f, 1.0f);
+    // Untextured and lit through GL_COLOR_MATERIAL, like the rest of the opaque pass.
+    void RenderLodMeshes(const vengine::FrameVector<const vengine::LodMesh*>& meshes)
+    {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        for (const vengine::LodMesh* lodMesh : meshes)
+        {
+            glVertexPointer(3, GL_FLOAT, 0, lodMesh->positions.data());
+            glNormalPointer(GL_FLOAT, 0, lodMesh->normals.data());
+            glColorPointer(3, GL_FLOAT, 0, lodMesh->colors.data());
+            glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(lodMesh->VertexCount()));
+        }
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
     }
 
     void RenderPlacedCubes(const Mesh& mesh)
     {
-        const GLfloat kNoEmission[] = {0.0f, 0.0f, 0.0f, 1.0f};
-        std::vector<const PlacedCube*> transparentCubes;
-        for (const PlacedCube& cube : g_placedCubes)
-        {
-            if (cube.transparent)
+        // Every list here lives for this call only, so it all comes from the frame arena.
+        const vengine::ArenaAllocator<uint32_t> cubeAllocator(g_frameArena);
+        vengine::FrameVector<uint32_t> transparentCubes(cubeAllocator);
+        vengine::FrameVector<uint32_t> glowingCubes(cubeAllocator);
+        vengine::FrameVector<uint32_t> transparentAuras(cubeAllocator);
+        // Opaque glowing cubes, per cube for their emission. Batch 0 holds untextured cubes, batch
+        // N + 1 the cubes sampling atlas page N; every other opaque cube is in opaqueChunks' baked
+        // page buffers.
+        vengine::FrameVector<vengine::FrameVector<uint32_t>> opaqueBatches(
+            g_atlasPages.size() + 1, vengine::FrameVector<uint32_t>(cubeAllocator), cubeAllocator);
+        const vengine::ArenaAllocator<uint64_t> chunkAllocator(g_frameArena);
+        vengine::FrameVector<uint64_t> opaqueChunks(chunkAllocator);
+        vengine::FrameVector<const vengine::LodMesh*> lodMeshes(cubeAllocator);
+        int visibleCount = 0;
+        RefreshCubeChunks();
+        BeginOpaqueChunkFrame();
+        g_chunkOcclusion.BeginFrame(g_viewEye.x, g_viewEye.y, g_viewEye.z);
+        g_chunkLods.BeginFrame();
+        // Chunks are tested with the aura radius so a glow reaching into view is kept even when
+        // its cube is just off screen. Auras are only frustum culled: they spill past the chunk's
+        // box, so an occluded box does not mean a hidden aura.
+        g_cubeChunks.ForEachChunkInFrustum(g_viewFrustum, kGlowAuraRadius, [&](uint64_t key, const vengine::Aabb& bounds, const std::vector<uint32_t>& items) {
+            const bool drawCubes = g_viewFrustum.Intersects(bounds) && g_chunkOcclusion.IsVisible(g_occlusionQueries, key, bounds);
+            // Until a chunk's first LOD mesh lands it keeps drawing at full detail.
+            const vengine::LodMesh* lodMesh = nullptr;
+            const int lodLevel = drawCubes ? SelectLodLevel(bounds) : 0;
+            if (lodLevel > 0)
             {
-                transparentCubes.push_back(&cube);
-                continue;
+                const uint64_t contentHash = g_chunkContentHashes[key] ^ (g_glowLayoutHash * 0x9E3779B97F4A7C15ull);
+                lodMesh = g_chunkLods.Acquire(key, lodLevel, contentHash, [&items] { return SnapshotLodCells(items); }, AcquireCubeLighting());
+                if (lodMesh)
+                {
+                    lodMeshes.push_back(lodMesh);
+                }
             }
-            glPushMatrix();
-            glTranslatef(static_cast<float>(cube.gridX), static_cast<float>(cube.gridY) + 0.5f, static_cast<float>(cube.gridZ));
-            Vec3 samplePos{static_cast<float>(cube.gridX), static_cast<float>(cube.gridY) + 0.5f, static_cast<float>(cube.gridZ)};
-            const float lightAmount = cube.glowing ? 1.0f : ComputeLightAtPoint(samplePos, &cube);
-            const float shading = std::clamp(0.4f + 0.6f * lightAmount, 0.2f, 1.0f);
-            const float shadedR = std::clamp(cube.r * shading, 0.0f, 1.0f);
-            const float shadedG = std::clamp(cube.g * shading, 0.0f, 1.0f);
-            const float shadedB = std::clamp(cube.b * shading, 0.0f, 1.0f);
-            if (cube.glowing)
+            if (drawCubes && !lodMesh)
             {
-                const GLfloat emission[] = {cube.r * 0.6f, cube.g * 0.6f, cube.b * 0.6f, 1.0f};
-                glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, emission);
+                UseOpaqueChunk(mesh, key, items);
+                opaqueChunks.push_back(key);
             }
-            RenderMesh(mesh, shadedR, shadedG, shadedB, 1.0f, cube.textureHandle);
-            if (cube.glowing)
+            for (uint32_t index : items)
             {
-                glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, kNoEmission);
+                int gridX, gridY, gridZ;
+                g_placedCubes.Cell(index, gridX, gridY, gridZ);
+                const bool transparent = g_placedCubes.Transparent(index);
+                if (g_placedCubes.Glowing(index) && g_viewFrustum.Intersects(vengine::CubeCellBounds(gridX, gridY, gridZ, kGlowAuraRadius)))
+                {
+                    (transparent ? transparentAuras : glowingCubes).push_back(index);
+                }
+                if (!drawCubes)
+                {
+                    continue;
+                }
+                // Chunks drawn whole, from a LOD mesh or the baked page buffers.
+                if (!transparent && (lodMesh || !g_placedCubes.Glowing(index)))
+                {
+                    ++visibleCount;
+                    continue;
+                }
+                if (!g_viewFrustum.Intersects(vengine::CubeCellBounds(gridX, gridY, gridZ)))
+                {
+                    continue;
+                }
+                ++visibleCount;
+                if (transparent)
+                {
+                    transparentCubes.push_back(index);
+                    continue;
+                }
+                const LoadedTexture* texture = GetTextureInfo(g_placedCubes.TextureHandle(index));
+                const size_t batch = (texture && GetAtlasPageTexture(texture->region.page) != 0) ? static_cast<size_t>(texture->region.page) + 1 : 0;
+                opaqueBatches[batch].push_back(index);
             }
-            glPopMatrix();
+        });
+        g_lastVisibleCubeCount = visibleCount;
 
-            if (cube.glowing)
+        const size_t cubeTriangles = mesh.TriangleCount();
+        size_t triangleCount = transparentCubes.size() * cubeTriangles;
+        triangleCount += RenderOpaquePageBuffers(mesh, opaqueChunks);
+        for (size_t batch = 0; batch < opaqueBatches.size(); ++batch)
+        {
+            if (!opaqueBatches[batch].empty())
             {
-                RenderGlowAura(cube);
+                RenderOpaqueCubeBatch(mesh, opaqueBatches[batch], batch == 0 ? 0 : g_atlasPages[batch - 1].id);
+                triangleCount += opaqueBatches[batch].size() * cubeTriangles;
             }
         }
+        RenderLodMeshes(lodMeshes);
+        for (const vengine::LodMesh* lodMesh : lodMeshes)
+        {
+            triangleCount += lodMesh->QuadCount() * 2;
+        }
+        g_lastTriangleCount = static_cast<int>(triangleCount);
+        g_chunkLods.EndFrame();
+        // The depth buffer now holds every visible occluder; test this frame's chunks against it.
+        g_chunkOcclusion.IssueQueries(g_occlusionQueries);
+        g_chunkOcclusion.EndFrame(g_occlusionQueries);
 
-        if (!transparentCubes.empty())
+        for (uint32_t index : glowingCubes)
         {
-            RenderTransparentCubes(mesh, transparentCubes);
+            RenderGlowAura(index);
         }
 
+        RenderTransparentCubes(mesh, transparentCubes, transparentAuras);
+
         RenderDraggingCubePreview(mesh);
     }
 
@@ -1782,6 +3856,18 @@ namespace
         return maxA > minB && minA < maxB;
     }
 
+    // The cell holding coordinate v on x or z, where cubes are centred on integers, and on y, where
+    // they stand on them. A box touching a cell's face counts it too; the exact test comes after.
+    int CellOfCentred(float v)
+    {
+        return static_cast<int>(std::floor(v + 0.5f));
+    }
+
+    int CellOfFloor(float v)
+    {
+        return static_cast<int>(std::floor(v));
+    }
+
     bool CollidesAtPosition(const Vec3& pos)
     {
         const float minX = pos.x - kPlayerRadius;
@@ -1791,24 +3877,28 @@ namespace
         const float minZ = pos.z - kPlayerRadius;
         const float maxZ = pos.z + kPlayerRadius;
 
-        for (const PlacedCube& cube : g_placedCubes)
-        {
-            const float cubeMinX = static_cast<float>(cube.gridX) - 0.5f;
-            const float cubeMaxX = static_cast<float>(cube.gridX) + 0.5f;
-            const float cubeMinY = static_cast<float>(cube.gridY);
-            const float cubeMaxY = static_cast<float>(cube.gridY) + 1.0f;
-            const float cubeMinZ = static_cast<float>(cube.gridZ) - 0.5f;
-            const float cubeMaxZ = static_cast<float>(cube.gridZ) + 0.5f;
+        RefreshCubeChunks();
+        bool collides = false;
+        g_cubeChunks.ForEachInCellBox(CellOfCentred(minX), CellOfFloor(minY), CellOfCentred(minZ), CellOfCentred(maxX), CellOfFloor(maxY),
+                                      CellOfCentred(maxZ), [&](uint32_t index) {
+            int cubeX, cubeY, cubeZ;
+            g_placedCubes.Cell(index, cubeX, cubeY, cubeZ);
+            const float cubeMinX = static_cast<float>(cubeX) - 0.5f;
+            const float cubeMaxX = static_cast<float>(cubeX) + 0.5f;
+            const float cubeMinY = static_cast<float>(cubeY);
+            const float cubeMaxY = static_cast<float>(cubeY) + 1.0f;
+            const float cubeMinZ = static_cast<float>(cubeZ) - 0.5f;
+            const float cubeMaxZ = static_cast<float>(cubeZ) + 0.5f;
 
             if (OverlapsRange(minX, maxX, cubeMinX, cubeMaxX) &&
                 OverlapsRange(minY, maxY, cubeMinY, cubeMaxY) &&
                 OverlapsRange(minZ, maxZ, cubeMinZ, cubeMaxZ))
             {
-                return true;
+                collides = true;
             }
-        }
+        });
 
-        return false;
+        return collides;
     }
 
     float HighestSurfaceAt(const Vec3& pos)
@@ -1819,18 +3909,21 @@ namespace
         const float minZ = pos.z - kPlayerRadius;
         const float maxZ = pos.z + kPlayerRadius;
 
-        for (const PlacedCube& cube : g_placedCubes)
-        {
-            const float cubeMinX = static_cast<float>(cube.gridX) - 0.5f;
-            const float cubeMaxX = static_cast<float>(cube.gridX) + 0.5f;
-            const float cubeMinZ = static_cast<float>(cube.gridZ) - 0.5f;
-            const float cubeMaxZ = static_cast<float>(cube.gridZ) + 0.5f;
+        RefreshCubeChunks();
+        g_cubeChunks.ForEachInCellBox(CellOfCentred(minX), std::numeric_limits<int>::min(), CellOfCentred(minZ), CellOfCentred(maxX),
+                                      std::numeric_limits<int>::max(), CellOfCentred(maxZ), [&](uint32_t index) {
+            int cubeX, cubeY, cubeZ;
+            g_placedCubes.Cell(index, cubeX, cubeY, cubeZ);
+            const float cubeMinX = static_cast<float>(cubeX) - 0.5f;
+            const float cubeMaxX = static_cast<float>(cubeX) + 0.5f;
+            const float cubeMinZ = static_cast<float>(cubeZ) - 0.5f;
+            const float cubeMaxZ = static_cast<float>(cubeZ) + 0.5f;
             if (OverlapsRange(minX, maxX, cubeMinX, cubeMaxX) &&
                 OverlapsRange(minZ, maxZ, cubeMinZ, cubeMaxZ))
             {
-                height = std::max(height, static_cast<float>(cube.gridY) + 1.0f);
+                height = std::max(height, static_cast<float>(cubeY) + 1.0f);
             }
-        }
+        });
 
         return height;
     }
@@ -1977,6 +4070,181 @@ namespace
         g_game.cubeZ = position.z;
     }
 
+    // notes.txt doubles as the scene script. Lua reads the world through SceneScriptWorld and its
+    // edits come back as one batch of commands per tick, applied here between frames.
+    class SceneScriptWorld : public vengine::ScriptWorldView
+    {
+    public:
+        int CubePresetAt(int x, int y, int z) const override
+        {
+            const int index = FindCubeIndex(x, y, z);
+            return index >= 0 ? g_placedCubes.PresetIndex(static_cast<size_t>(index)) : -1;
+        }
+
+        int CubeCount() const override
+        {
+            return static_cast<int>(g_placedCubes.Size());
+        }
+
+        void PlayerPosition(float& x, float& y, float& z) const override
+        {
+            x = g_game.cubeX;
+            y = g_game.cubeY;
+            z = g_game.cubeZ;
+        }
+    };
+
+    vengine::ScriptRuntime g_scriptRuntime;
+    SceneScriptWorld g_scriptWorld;
+    bool g_scriptEnabled = true;
+
+    void ApplyScriptCommands()
+    {
+        for (const vengine::ScriptCommand& command : g_scriptRuntime.Commands())
+        {
+            switch (command.type)
+            {
+            case vengine::ScriptCommandType::PlaceCube:
+                if (command.preset >= 0 && command.preset < static_cast<int>(kSpawnPresetCount))
+                {
+                    const int textureHandle = g_presetTextureHandles[static_cast<size_t>(command.preset)];
+                    const std::string& texturePath = textureHandle >= 0 ? g_presetTexturePaths[static_cast<size_t>(command.preset)] : std::string();
+                    PlaceCube(command.x, command.y, command.z, kSpawnPresets[command.preset], command.preset, textureHandle, texturePath);
+                }
+                break;
+            case vengine::ScriptCommandType::RemoveCube:
+                RemoveCube(command.x, command.y, command.z);
+                break;
+            case vengine::ScriptCommandType::MovePlayer:
+            {
+                const Vec3 attempt{g_game.cubeX + command.px, std::max(0.0f, g_game.cubeY + command.py), g_game.cubeZ + command.pz};
+                if (!CollidesAtPosition(attempt))
+                {
+                    g_game.cubeX = attempt.x;
+                    g_game.cubeY = attempt.y;
+                    g_game.cubeZ = attempt.z;
+                }
+                break;
+            }
+            case vengine::ScriptCommandType::TeleportPlayer:
+                g_game.cubeX = command.px;
+                g_game.cubeY = std::max(0.0f, command.py);
+                g_game.cubeZ = command.pz;
+                g_game.cubeVelocity = 0.0f;
+                break;
+            }
+        }
+        g_scriptRuntime.ClearCommands();
+    }
+
+    void ReloadScript()
+    {
+        if (g_scriptRuntime.Load(g_notesContent, "notes.txt", g_scriptWorld))
+        {
+            ApplyScriptCommands();
+        }
+    }
+
+    // A script that errors or blows its frame budget is stopped rather than retried every frame;
+    // saving or re-enabling it in the Code panel starts a fresh VM.
+    void TickScript(float deltaTime)
+    {
+        // Scripts would see an empty world until the scene has loaded.
+        if (!g_scriptEnabled || !g_scriptRuntime.Loaded() || g_sceneLoading)
+        {
+            return;
+        }
+        if (g_scriptRuntime.Tick(deltaTime, g_scriptWorld))
+        {
+            ApplyScriptCommands();
+        }
+        else
+        {
+            g_scriptRuntime.Unload();
+        }
+    }
+
+    // Hot reload. The watcher covers the exe directory on a background thread; settled changes are
+    // applied here, once per frame, on the GL thread.
+    vengine::FileWatcher g_fileWatcher;
+    std::vector<std::string> g_fileChanges;
+    std::vector<std::string> g_deferredTextureReloads; // Changed while the scene loader was preparing textures.
+    std::string g_hotReloadStatus;
+
+    void StartFileWatcher()
+    {
+        std::string root = GetExecutableDirectory();
+        while (root.size() > 1 && (root.back() == '\\' || root.back() == '/'))
+        {
+            root.pop_back();
+        }
+        g_hotReloadStatus = g_fileWatcher.Start(root) ? "Watching for changes" : g_fileWatcher.LastError();
+    }
+
+    // Unsaved edits in the Code panel win over the file on disk; the panel flags the conflict
+    // instead. Our own saves come back as no-op changes and are skipped.
+    void HotReloadNotes()
+    {
+        if (g_notesDirty)
+        {
+            g_notesChangedOnDisk = true;
+            return;
+        }
+        std::ifstream file(std::filesystem::u8path(g_notesFilePath), std::ios::binary);
+        if (!file)
+        {
+            return;
+        }
+        std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (contents == g_notesContent)
+        {
+            return;
+        }
+        g_notesContent = std::move(contents);
+        ReloadScript();
+        g_hotReloadStatus = "notes.txt reloaded";
+    }
+
+    void ProcessFileChanges()
+    {
+        g_fileWatcher.TakeChanges(g_fileChanges);
+        if (!g_sceneLoading && !g_deferredTextureReloads.empty())
+        {
+            g_fileChanges.insert(g_fileChanges.end(), g_deferredTextureReloads.begin(), g_deferredTextureReloads.end());
+            g_deferredTextureReloads.clear();
+        }
+        for (const std::string& relative : g_fileChanges)
+        {
+            if (relative == "notes.txt")
+            {
+                HotReloadNotes();
+                continue;
+            }
+            if (relative.rfind("texture_cache/", 0) == 0)
+            {
+                continue;
+            }
+            // The loader thread decodes PNGs and writes the texture cache until the load ends, so a
+            // reload (which does both) waits for it.
+            if (g_sceneLoading)
+            {
+                if (std::find(g_deferredTextureReloads.begin(), g_deferredTextureReloads.end(), relative) == g_deferredTextureReloads.end())
+                {
+                    g_deferredTextureReloads.push_back(relative);
+                }
+                continue;
+            }
+            const int handle = FindTextureHandleByPath(MakeAbsoluteTexturePath(relative));
+            if (handle == kInvalidTextureHandle)
+            {
+                continue;
+            }
+            std::string status;
+            ReloadTextureFromFile(handle, status);
+            g_hotReloadStatus = relative + ": " + status;
+        }
+    }
+
     void RenderGradientBackground()
     {
         glDisable(GL_DEPTH_TEST);
@@ -2023,6 +4291,7 @@ namespace
         gluLookAt(eyeX, eyeY, eyeZ,
                   g_cameraFocusX, 0.0f, g_cameraFocusZ,
                   0.0f, 1.0f, 0.0f);
+        CaptureViewFrustum(Vec3{eyeX, eyeY, eyeZ});
 
         const GLfloat lightPos[] = {2.0f, 4.0f, 2.0f, 0.0f};
         glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
@@ -2036,9 +4305,10 @@ namespace
         glTranslatef(g_game.cubeX, g_game.cubeY + 0.5f, g_game.cubeZ);
         glRotatef(g_game.rotation, 0.0f, 1.0f, 0.0f);
         glRotatef(g_game.rotation * 0.5f, 1.0f, 0.0f, 0.0f);
-        const float playerLight = ComputeLightAtPoint(Vec3{g_game.cubeX, g_game.cubeY + 0.5f, g_game.cubeZ}, nullptr);
+        const float playerLight = ComputeLightAtPoint(Vec3{g_game.cubeX, g_game.cubeY + 0.5f, g_game.cubeZ}, -1);
         const float playerShade = std::clamp(0.5f + 0.5f * playerLight, 0.3f, 1.0f);
-        RenderMesh(mesh, 0.6f * playerShade, 0.7f * playerShade, 1.0f * playerShade, 1.0f, kInvalidTextureHandle);
+        RenderMesh(g_playerMesh.Empty() ? mesh : g_playerMesh, 0.6f * playerShade, 0.7f * playerShade, 1.0f * playerShade, 1.0f,
+                   kInvalidTextureHandle);
         glPopMatrix();
     }
 
@@ -2120,6 +4390,22 @@ namespace
 
     LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     {
+        if (IsRecordedInputMessage(uMsg))
+        {
+            if (g_inputReplayer.Active() && !g_dispatchingReplayedInput)
+            {
+                return 0;
+            }
+            // WM_MOUSEWHEEL carries screen coordinates; every other recorded mouse message client ones.
+            if (g_dispatchingReplayedInput && uMsg >= WM_MOUSEMOVE && uMsg <= WM_MBUTTONUP)
+            {
+                g_replayMouseKnown = true;
+                g_replayMouseX = GET_X_LPARAM(lParam);
+                g_replayMouseY = GET_Y_LPARAM(lParam);
+            }
+            g_inputRecorder.Record(uMsg, static_cast<int64_t>(wParam), static_cast<int64_t>(lParam));
+        }
+
         if (ImGui::GetCurrentContext() && ::ImGui_ImplWin32_WndProcHandler(hwnd, uMsg, wParam, lParam))
         {
             return true;
@@ -2216,7 +4502,8 @@ namespace
         case WM_MOUSEWHEEL:
         {
             const SHORT delta = GET_WHEEL_DELTA_WPARAM(wParam);
-            g_cameraDistance -= static_cast<float>(delta) / 120.0f * kCameraZoomStep;
+            const float zoomStep = std::max(kCameraZoomStep, g_cameraDistance * kCameraZoomFraction);
+            g_cameraDistance -= static_cast<float>(delta) / 120.0f * zoomStep;
             g_cameraDistance = std::clamp(g_cameraDistance, kCameraMinDistance, kCameraMaxDistance);
             return 0;
         }
@@ -2395,8 +4682,9 @@ namespace
                 int topIndex = FindHighestCubeIndex(hit.groundX, hit.groundZ);
                 if (topIndex >= 0)
                 {
-                    const PlacedCube& cube = g_placedCubes[topIndex];
-                    RemoveCube(cube.gridX, cube.gridY, cube.gridZ);
+                    int topX, topY, topZ;
+                    g_placedCubes.Cell(static_cast<size_t>(topIndex), topX, topY, topZ);
+                    RemoveCube(topX, topY, topZ);
                 }
             }
             return 0;
@@ -2411,6 +4699,14 @@ namespace
 
 int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
 {
+    ParseCommandLine();
+    if (g_inputReplayer.Active())
+    {
+        // Mouse coordinates and picking only line up at the recorded client size.
+        g_windowWidth = std::max(1, static_cast<int>(g_inputReplayer.Recording().viewportWidth));
+        g_windowHeight = std::max(1, static_cast<int>(g_inputReplayer.Recording().viewportHeight));
+    }
+
     const char kWindowClass[] = "SimpleOpenGLWindow";
 
     WNDCLASS wc = {};
@@ -2454,7 +4750,7 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
     g_notesFilePath = BuildNotesFilePath();
     LoadNotesFromFile();
     g_sceneFilePath = BuildSceneFilePath();
-    LoadSceneFromFile();
+    g_textureCacheDirectory = BuildTextureCacheDirectory();
     g_notesPanelTargetVisible = true;
     g_notesPanelPosX = kNotesPanelMargin;
     g_contentPanelPosY = static_cast<float>(g_windowHeight) + kContentPanelHeight;
@@ -2485,11 +4781,41 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
         return -1;
     }
 
-    g_cubeMesh = CreateCubeMesh();
+    LoadModelMeshes();
 
     InitializeOpenGLState();
+    InitializeOcclusionCulling();
     UpdateProjection(std::max(1, g_windowWidth), std::max(1, g_windowHeight));
 
+    // Scene textures are uploaded into the atlas, so the scene loads once the GL context exists.
+    if (!g_worldStreamPath.empty())
+    {
+        StartWorldStreaming();
+    }
+    else if (!g_worldGenRequested)
+    {
+        StartSceneLoad();
+        if (g_inputReplayer.Active())
+        {
+            // Recorded input expects the scene to be there from the first frame.
+            PumpSceneLoad(true);
+        }
+    }
+    if (g_worldGenRequested && !g_worldStreamer.Active())
+    {
+        // A generated stress world is an input, not an edit: don't save it over scene.txt on exit.
+        g_sceneSuppressSave = true;
+        StartWorldGeneration();
+        StreamGeneratedWorld(true);
+        g_sceneSuppressSave = false;
+    }
+    ReloadScript();
+    // Hot reloads would land on whatever frame the disk happened to change; keep replays fixed.
+    if (!g_inputReplayer.Active())
+    {
+        StartFileWatcher();
+    }
+
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
@@ -2504,9 +4830,20 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
 
     MSG msg = {};
 
+    if (!g_inputRecordPath.empty() && !g_inputReplayer.Active())
+    {
+        g_inputRecorder.Start(vengine::InputSource::Win32, g_windowWidth, g_windowHeight);
+    }
+
     double previousTime = GetSeconds();
     while (g_running)
     {
+        const double frameStart = GetWallSeconds();
+        const uint64_t heapAllocations = vengine::ThreadHeapAllocationCount();
+        g_frameHeapAllocations = static_cast<int>(heapAllocations - g_frameHeapAllocationMark);
+        g_frameHeapAllocationMark = heapAllocations;
+        g_frameArena.Reset();
+        g_inputRecorder.BeginFrame();
         while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
         {
             if (msg.message == WM_QUIT)
@@ -2517,9 +4854,28 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
             DispatchMessage(&msg);
         }
 
-        const double now = GetSeconds();
-        float deltaTime = static_cast<float>(now - previousTime);
-        previousTime = now;
+        float deltaTime = 0.0f;
+        if (g_inputReplayer.Active())
+        {
+            if (!g_inputReplayer.BeginFrame())
+            {
+                break;
+            }
+            // Sent straight to WindowProc: TranslateMessage already produced the recorded WM_CHARs.
+            g_dispatchingReplayedInput = true;
+            for (const vengine::InputEvent* event = g_inputReplayer.FrameEventsBegin(); event != g_inputReplayer.FrameEventsEnd(); ++event)
+            {
+                WindowProc(hwnd, event->kind, static_cast<WPARAM>(event->payload[0]), static_cast<LPARAM>(event->payload[1]));
+            }
+            g_dispatchingReplayedInput = false;
+            deltaTime = g_inputReplayer.FixedDeltaTime();
+        }
+        else
+        {
+            const double now = GetSeconds();
+            deltaTime = static_cast<float>(now - previousTime);
+            previousTime = now;
+        }
 
         if (deltaTime > 0.05f)
         {
@@ -2528,6 +4884,15 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
 
         ImGui_ImplOpenGL2_NewFrame();
         ImGui_ImplWin32_NewFrame();
+        if (g_inputReplayer.Active())
+        {
+            ImGui::GetIO().DeltaTime = deltaTime;
+            // The backend polls the live cursor in NewFrame; queue the recorded one after it.
+            if (g_replayMouseKnown)
+            {
+                ImGui::GetIO().AddMousePosEvent(static_cast<float>(g_replayMouseX), static_cast<float>(g_replayMouseY));
+            }
+        }
         ImGui::NewFrame();
 
         ImGuiWindowFlags overlayFlags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoSavedSettings;
@@ -2609,9 +4974,23 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
                 if (ImGui::Button("Save##CodePanel"))
                 {
                     SaveNotesToFile();
+                    ReloadScript();
                 }
                 ImGui::SameLine();
-                ImGui::TextUnformatted(g_notesDirty ? "Modified" : "Saved");
+                ImGui::TextUnformatted(g_notesDirty ? (g_notesChangedOnDisk ? "Modified (changed on disk)" : "Modified") : "Saved");
+                ImGui::SameLine();
+                if (ImGui::Checkbox("Run##CodePanel", &g_scriptEnabled) && g_scriptEnabled)
+                {
+                    ReloadScript();
+                }
+                if (!g_scriptRuntime.LastError().empty())
+                {
+                    ImGui::TextColored(ImVec4(0.95f, 0.45f, 0.45f, 1.0f), "%s", g_scriptRuntime.LastError().c_str());
+                }
+                else if (g_scriptEnabled && g_scriptRuntime.Loaded())
+                {
+                    ImGui::TextDisabled("tick: %u instructions, %.2f ms", g_scriptRuntime.LastInstructionCount(), g_scriptRuntime.LastMilliseconds());
+                }
                 ImGui::Spacing();
 
                 ImVec2 textSize = ImGui::GetContentRegionAvail();
@@ -2698,7 +5077,7 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
                 {
                     g_notesDirty = true;
                 }
-                RenderLuaHighlightedText(g_notesContent, editorPos, textSize);
+                RenderLuaHighlightedText(g_notesHighlight, g_notesContent, editorPos, textSize);
             }
 
             ImGui::End();
@@ -2753,7 +5132,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
                 ImGui::InputTextWithHint("##TexturePath", "texture.png", &g_presetTexturePaths[i]);
                 ImGui::PopItemWidth();
                 ImGui::SameLine();
-                if (ImGui::Button("Load PNG"))
+                // Loading decodes the PNG and writes the texture cache, as the scene loader's thread does.
+                if (g_sceneLoading)
+                {
+                    ImGui::TextDisabled("Load PNG");
+                }
+                else if (ImGui::Button("Load PNG"))
                 {
                     std::string relative;
                     std::string normalizeStatus;
@@ -2764,6 +5148,8 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
                         const int handle = LoadTextureFromFile(absolute, loadStatus);
                         if (handle >= 0)
                         {
+                            AcquireTexture(handle);
+                            ReleaseTexture(g_presetTextureHandles[i]);
                             g_presetTextureHandles[i] = handle;
                             g_presetTexturePaths[i] = relative;
                         }
@@ -2777,6 +5163,7 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
                 ImGui::SameLine();
                 if (g_presetTextureHandles[i] >= 0 && ImGui::Button("Clear"))
                 {
+                    ReleaseTexture(g_presetTextureHandles[i]);
                     g_presetTextureHandles[i] = kInvalidTextureHandle;
                     g_presetTexturePaths[i].clear();
                     g_presetTextureStatus[i].clear();
@@ -2800,10 +5187,116 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
                 ImGui::PopID();
             }
 
+            // The scene loader's texture stage reads the atlas order off the main thread.
+            if (!g_sceneLoading)
+            {
+                ImGui::Checkbox("Upload BGRA (skip swizzle)", &g_preferBgraUpload);
+            }
+            ImGui::TextDisabled("Texture memory: %.1f / %.0f MB",
+                static_cast<double>(g_textureResidentBytes) / (1024.0 * 1024.0),
+                static_cast<double>(kTextureMemoryBudgetBytes) / (1024.0 * 1024.0));
+            ImGui::TextDisabled("Hot reload: %s", g_hotReloadStatus.c_str());
+            ImGui::TextDisabled("Visible cubes: %d / %d (%d chunks)", g_lastVisibleCubeCount,
+                static_cast<int>(g_placedCubes.Size()), static_cast<int>(g_cubeChunks.ChunkCount()));
+            ImGui::Checkbox("Distant chunk LOD", &g_lodEnabled);
+            ImGui::SameLine();
+            ImGui::TextDisabled("%d triangles, %d LOD builds queued", g_lastTriangleCount,
+                static_cast<int>(g_chunkLods.PendingBuildCount()));
+            ImGui::TextDisabled("Frame: %d heap allocations, %.0f KB scratch", g_frameHeapAllocations,
+                static_cast<double>(g_frameArena.LastFrameBytes()) / 1024.0);
+            if (g_occlusionQueries.Available())
+            {
+                if (ImGui::Checkbox("Occlusion culling", &g_occlusionCullingEnabled))
+                {
+                    g_chunkOcclusion.SetEnabled(g_occlusionCullingEnabled);
+                }
+                ImGui::SameLine();
+                ImGui::TextDisabled("%d of %d chunks hidden", static_cast<int>(g_chunkOcclusion.LastOccludedChunkCount()),
+                    static_cast<int>(g_chunkOcclusion.LastTestedChunkCount()));
+            }
+
+            ImGui::Separator();
+            if (g_worldStreamer.Active())
+            {
+                const vengine::WorldStreamStats stats = g_worldStreamer.Stats();
+                ImGui::TextUnformatted("Streaming world");
+                ImGui::SameLine();
+                ImGui::PushItemWidth(160.0f);
+                if (ImGui::SliderInt("Budget (MB)", &g_worldStreamBudgetMB, 16, 4096))
+                {
+                    g_worldStreamer.SetBudgetBytes(static_cast<size_t>(g_worldStreamBudgetMB) << 20);
+                }
+                ImGui::PopItemWidth();
+                ImGui::TextDisabled("%d chunks, %.1f MB resident%s; %d loading, %d saving", static_cast<int>(stats.residentChunks),
+                    static_cast<double>(stats.residentBytes) / (1024.0 * 1024.0), stats.budgetLimited ? " (budget limited)" : "",
+                    static_cast<int>(stats.requestedChunks), static_cast<int>(stats.queuedSaves));
+                if (stats.ioErrors > 0)
+                {
+                    ImGui::TextDisabled("%d I/O errors, last: %s", static_cast<int>(stats.ioErrors), stats.lastError.c_str());
+                }
+            }
+            else
+            {
+                ImGui::TextUnformatted("World generator");
+                ImGui::PushItemWidth(110.0f);
+                ImGui::InputInt("Seed", &g_worldGenSeed);
+                ImGui::SameLine();
+                ImGui::SliderInt("Size", &g_worldGenSize, 16, 512);
+                ImGui::PopItemWidth();
+                // A scene load in flight would swap its own cubes in over the generated world.
+                if (!g_sceneLoading)
+                {
+                    ImGui::SameLine();
+                    if (ImGui::Button("Generate"))
+                    {
+                        StartWorldGeneration();
+                    }
+                }
+                if (g_worldGenerator.Running())
+                {
+                    ImGui::SameLine();
+                    if (ImGui::Button("Stop"))
+                    {
+                        g_worldGenerator.Cancel();
+                    }
+                    ImGui::SameLine();
+                    ImGui::TextDisabled("%d / %d chunks", static_cast<int>(g_worldGenerator.DeliveredChunkCount()),
+                        static_cast<int>(g_worldGenerator.ChunkCount()));
+                }
+            }
+
+            ImGui::TextUnformatted("Export");
+            ImGui::SameLine();
+            if (ImGui::Button("OBJ"))
+            {
+                StartSceneExport("scene_export.obj");
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("GLB"))
+            {
+                StartSceneExport("scene_export.glb");
+            }
+            ImGui::SameLine();
+            if (g_sceneExporter.Running())
+            {
+                ImGui::TextDisabled("%d / %d chunks", static_cast<int>(g_sceneExporter.ChunksDone()), static_cast<int>(g_sceneExporter.ChunkCount()));
+            }
+            else
+            {
+                g_sceneExporter.Status(g_sceneExportStatus);
+                ImGui::TextDisabled("%s", g_sceneExportStatus.c_str());
+            }
+
             ImGui::End();
         }
 
+        StreamGeneratedWorld(false);
+        PumpSceneLoad(false);
+        RenderSceneLoadProgress();
+        ProcessFileChanges();
+        TickScript(deltaTime);
         UpdatePlayerMovement(deltaTime);
+        UpdateWorldStreaming(deltaTime);
 
         const int scaleX = std::max(1, g_windowWidth / kTargetPixelWidth);
         const int scaleY = std::max(1, g_windowHeight / kTargetPixelHeight);
@@ -2833,6 +5326,27 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
         ImGui::Render();
         ImGui_ImplOpenGL2_RenderDrawData(ImGui::GetDrawData());
         SwapBuffers(hdc);
+        if (g_inputReplayer.Active())
+        {
+            g_inputReplayer.AddFrameTime((GetWallSeconds() - frameStart) * 1000.0);
+        }
+    }
+
+    std::string inputError;
+    if (g_inputRecorder.Active() && !g_inputRecorder.Stop(g_inputRecordPath, inputError))
+    {
+        MessageBox(nullptr, inputError.c_str(), "Input recording", MB_OK | MB_ICONWARNING);
+    }
+    if (!g_inputReplayPath.empty())
+    {
+        // A replay repeats the recorded session's edits; don't write them back on exit.
+        g_notesDirty = false;
+        g_sceneDirty = false;
+        const std::string reportPath = g_inputReplayPath + ".timings.csv";
+        if (g_inputReplayer.WriteTimingReport(reportPath, inputError))
+        {
+            OutputDebugStringA(("Input replay: " + g_inputReplayer.TimingSummary() + "\n").c_str());
+        }
     }
 
     if (g_notesDirty)
@@ -2844,6 +5358,16 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
         SaveSceneToFile();
     }
 
+    g_worldGenerator.Cancel();
+    g_sceneLoader.Cancel();
+    g_sceneExporter.Cancel();
+    StopWorldStreaming();
+    g_fileWatcher.Stop();
+    g_chunkLods.Stop();
+    ShutdownOcclusionCulling();
+    ReleaseMesh(g_playerMesh);
+    ReleaseOpaquePageBuffers();
+    ReleaseMesh(g_cubeMesh);
     CleanupLoadedTextures();
     ShutdownGdiplus();
 
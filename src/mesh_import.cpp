@@ -0,0 +1,1351 @@
+#include "mesh_import.h"
+#include "byte_codec.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+namespace vengine
+{
+    namespace
+    {
+        constexpr uint32_t kMeshCacheMagic = 0x48534D56u; // "VMSH"
+        constexpr uint32_t kMeshCacheVersion = 1;
+        constexpr size_t kMeshCacheOptimizeSize = 32;
+        constexpr int kMaxJsonDepth = 64;
+        constexpr int kMaxNodeDepth = 64;
+
+        bool ReadWholeFile(const std::string& path, std::string& bytes)
+        {
+            std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+            if (!file)
+            {
+                return false;
+            }
+            std::ostringstream stream;
+            stream << file.rdbuf();
+            bytes = stream.str();
+            return true;
+        }
+
+        void Cross(const float a[3], const float b[3], float out[3])
+        {
+            out[0] = a[1] * b[2] - a[2] * b[1];
+            out[1] = a[2] * b[0] - a[0] * b[2];
+            out[2] = a[0] * b[1] - a[1] * b[0];
+        }
+
+        void Normalize(float v[3])
+        {
+            const float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            if (length > 0.0f)
+            {
+                v[0] /= length;
+                v[1] /= length;
+                v[2] /= length;
+            }
+        }
+
+        // Merges bit-identical corners into one vertex.
+        class VertexWelder
+        {
+        public:
+            explicit VertexWelder(MeshData& mesh) : m_mesh(mesh) {}
+
+            void Add(MeshVertex vertex)
+            {
+                // -0 and +0 would otherwise hash apart.
+                float* fields = &vertex.position[0];
+                for (size_t i = 0; i < sizeof(MeshVertex) / sizeof(float); ++i)
+                {
+                    fields[i] += 0.0f;
+                }
+                const auto inserted = m_lookup.emplace(Key{vertex}, static_cast<uint32_t>(m_mesh.vertices.size()));
+                if (inserted.second)
+                {
+                    m_mesh.vertices.push_back(vertex);
+                }
+                m_mesh.indices.push_back(inserted.first->second);
+            }
+
+        private:
+            struct Key
+            {
+                MeshVertex vertex;
+
+                bool operator==(const Key& other) const { return std::memcmp(&vertex, &other.vertex, sizeof(MeshVertex)) == 0; }
+            };
+
+            struct KeyHash
+            {
+                size_t operator()(const Key& key) const { return static_cast<size_t>(HashBytes(&key.vertex, sizeof(MeshVertex))); }
+            };
+
+            MeshData& m_mesh;
+            std::unordered_map<Key, uint32_t, KeyHash> m_lookup;
+        };
+
+        void ComputeBounds(MeshData& mesh)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                mesh.boundsMin[axis] = mesh.vertices.empty() ? 0.0f : mesh.vertices[0].position[axis];
+                mesh.boundsMax[axis] = mesh.boundsMin[axis];
+            }
+            for (const MeshVertex& vertex : mesh.vertices)
+            {
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    mesh.boundsMin[axis] = std::min(mesh.boundsMin[axis], vertex.position[axis]);
+                    mesh.boundsMax[axis] = std::max(mesh.boundsMax[axis], vertex.position[axis]);
+                }
+            }
+        }
+
+        // --- OBJ ---------------------------------------------------------------------------------
+
+        const char* SkipSpaces(const char* p, const char* end)
+        {
+            while (p < end && (*p == ' ' || *p == '\t'))
+            {
+                ++p;
+            }
+            return p;
+        }
+
+        // Reads up to count floats; missing trailing values stay 0.
+        const char* ReadFloats(const char* p, const char* end, float* out, int count)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                p = SkipSpaces(p, end);
+                char* next = nullptr;
+                const float value = std::strtof(p, &next);
+                if (next == p || next > end)
+                {
+                    break;
+                }
+                out[i] = value;
+                p = next;
+            }
+            return p;
+        }
+
+        // Resolves a 1-based or negative (relative) v/vt/vn reference to a 0-based index.
+        bool ResolveObjIndex(long value, size_t count, long& out)
+        {
+            if (value > 0 && static_cast<size_t>(value) <= count)
+            {
+                out = value - 1;
+                return true;
+            }
+            // Compare in long rather than negating value, which overflows for LONG_MIN.
+            if (value < 0 && value >= -static_cast<long>(count))
+            {
+                out = static_cast<long>(count) + value;
+                return true;
+            }
+            return false;
+        }
+
+        struct ObjCorner
+        {
+            long position = -1;
+            long uv = -1;
+            long normal = -1;
+        };
+    }
+
+    bool ParseObjMesh(const std::string& text, MeshData& mesh, std::string& error)
+    {
+        mesh = MeshData{};
+        std::vector<float> positions;
+        std::vector<float> uvs;
+        std::vector<float> normals;
+        std::vector<ObjCorner> corners;
+        VertexWelder welder(mesh);
+
+        const char* p = text.data();
+        const char* const textEnd = p + text.size();
+        size_t lineNumber = 0;
+        while (p < textEnd)
+        {
+            const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(textEnd - p)));
+            lineEnd = lineEnd ? lineEnd : textEnd;
+            ++lineNumber;
+            const char* cursor = SkipSpaces(p, lineEnd);
+            const char* const line = cursor;
+            p = lineEnd + 1;
+            if (lineEnd - line >= 2 && line[0] == 'v' && line[1] == ' ')
+            {
+                float value[3] = {0.0f, 0.0f, 0.0f};
+                ReadFloats(line + 2, lineEnd, value, 3);
+                positions.insert(positions.end(), value, value + 3);
+            }
+            else if (lineEnd - line >= 3 && line[0] == 'v' && line[1] == 't' && line[2] == ' ')
+            {
+                float value[2] = {0.0f, 0.0f};
+                ReadFloats(line + 3, lineEnd, value, 2);
+                uvs.insert(uvs.end(), value, value + 2);
+            }
+            else if (lineEnd - line >= 3 && line[0] == 'v' && line[1] == 'n' && line[2] == ' ')
+            {
+                float value[3] = {0.0f, 0.0f, 0.0f};
+                ReadFloats(line + 3, lineEnd, value, 3);
+                normals.insert(normals.end(), value, value + 3);
+            }
+            else if (lineEnd - line >= 2 && line[0] == 'f' && line[1] == ' ')
+            {
+                corners.clear();
+                cursor = line + 2;
+                while ((cursor = SkipSpaces(cursor, lineEnd)) < lineEnd && *cursor != '\r' && *cursor != '#')
+                {
+                    ObjCorner corner;
+                    long* slots[3] = {&corner.position, &corner.uv, &corner.normal};
+                    const size_t counts[3] = {positions.size() / 3, uvs.size() / 2, normals.size() / 3};
+                    for (int slot = 0; slot < 3 && cursor < lineEnd; ++slot)
+                    {
+                        if (*cursor != '/')
+                        {
+                            char* next = nullptr;
+                            errno = 0;
+                            const long value = std::strtol(cursor, &next, 10);
+                            if (next == cursor || errno == ERANGE || !ResolveObjIndex(value, counts[slot], *slots[slot]))
+                            {
+                                error = "Bad face reference on line " + std::to_string(lineNumber);
+                                return false;
+                            }
+                            cursor = next;
+                        }
+                        if (cursor >= lineEnd || *cursor != '/')
+                        {
+                            break;
+                        }
+                        ++cursor;
+                    }
+                    if (corner.position < 0)
+                    {
+                        error = "Face without a position on line " + std::to_string(lineNumber);
+                        return false;
+                    }
+                    corners.push_back(corner);
+                }
+                if (corners.size() < 3)
+                {
+                    continue;
+                }
+
+                // Newell's method: a flat normal that holds up for non-planar polygons too.
+                float faceNormal[3] = {0.0f, 0.0f, 0.0f};
+                for (size_t i = 0; i < corners.size(); ++i)
+                {
+                    const float* a = &positions[static_cast<size_t>(corners[i].position) * 3];
+                    const float* b = &positions[static_cast<size_t>(corners[(i + 1) % corners.size()].position) * 3];
+                    faceNormal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+                    faceNormal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+                    faceNormal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+                }
+                Normalize(faceNormal);
+
+                const auto makeVertex = [&](const ObjCorner& corner) {
+                    MeshVertex vertex{};
+                    std::memcpy(vertex.position, &positions[static_cast<size_t>(corner.position) * 3], sizeof(vertex.position));
+                    std::memcpy(vertex.normal, corner.normal >= 0 ? &normals[static_cast<size_t>(corner.normal) * 3] : faceNormal, sizeof(vertex.normal));
+                    if (corner.uv >= 0)
+                    {
+                        std::memcpy(vertex.uv, &uvs[static_cast<size_t>(corner.uv) * 2], sizeof(vertex.uv));
+                    }
+                    return vertex;
+                };
+                for (size_t i = 1; i + 1 < corners.size(); ++i)
+                {
+                    welder.Add(makeVertex(corners[0]));
+                    welder.Add(makeVertex(corners[i]));
+                    welder.Add(makeVertex(corners[i + 1]));
+                }
+            }
+        }
+
+        if (mesh.indices.empty())
+        {
+            error = "No faces";
+            return false;
+        }
+        ComputeBounds(mesh);
+        return true;
+    }
+
+    namespace
+    {
+        // --- glTF --------------------------------------------------------------------------------
+
+        struct Json
+        {
+            enum class Type
+            {
+                Null,
+                Bool,
+                Number,
+                String,
+                Array,
+                Object,
+            };
+
+            Type type = Type::Null;
+            double number = 0.0;
+            std::string text;
+            std::vector<Json> items;
+            std::vector<std::pair<std::string, Json>> members;
+
+            const Json* Get(const char* key) const
+            {
+                for (const auto& member : members)
+                {
+                    if (member.first == key)
+                    {
+                        return &member.second;
+                    }
+                }
+                return nullptr;
+            }
+
+            const Json* At(double index) const
+            {
+                if (type != Type::Array || index < 0.0 || index >= static_cast<double>(items.size()) || index != std::floor(index))
+                {
+                    return nullptr;
+                }
+                return &items[static_cast<size_t>(index)];
+            }
+
+            double Number(const char* key, double fallback) const
+            {
+                const Json* value = Get(key);
+                return value && value->type == Type::Number ? value->number : fallback;
+            }
+        };
+
+        class JsonParser
+        {
+        public:
+            JsonParser(const char* begin, const char* end) : m_p(begin), m_end(end) {}
+
+            bool Parse(Json& root)
+            {
+                return ParseValue(root, 0) && (SkipWhitespace(), m_p == m_end);
+            }
+
+        private:
+            void SkipWhitespace()
+            {
+                while (m_p < m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r'))
+                {
+                    ++m_p;
+                }
+            }
+
+            bool Literal(const char* word)
+            {
+                const size_t length = std::strlen(word);
+                if (static_cast<size_t>(m_end - m_p) < length || std::memcmp(m_p, word, length) != 0)
+                {
+                    return false;
+                }
+                m_p += length;
+                return true;
+            }
+
+            bool ParseString(std::string& out)
+            {
+                if (m_p >= m_end || *m_p != '"')
+                {
+                    return false;
+                }
+                ++m_p;
+                while (m_p < m_end && *m_p != '"')
+                {
+                    char c = *m_p++;
+                    if (c != '\\')
+                    {
+                        out.push_back(c);
+                        continue;
+                    }
+                    if (m_p >= m_end)
+                    {
+                        return false;
+                    }
+                    c = *m_p++;
+                    switch (c)
+                    {
+                    case 'b': out.push_back('\b'); break;
+                    case 'f': out.push_back('\f'); break;
+                    case 'n': out.push_back('\n'); break;
+                    case 'r': out.push_back('\r'); break;
+                    case 't': out.push_back('\t'); break;
+                    case 'u':
+                    {
+                        if (m_end - m_p < 4)
+                        {
+                            return false;
+                        }
+                        const unsigned code = static_cast<unsigned>(std::strtoul(std::string(m_p, 4).c_str(), nullptr, 16));
+                        m_p += 4;
+                        // Surrogate pairs are kept as two code units; glTF names and URIs rarely need more.
+                        if (code < 0x80)
+                        {
+                            out.push_back(static_cast<char>(code));
+                        }
+                        else if (code < 0x800)
+                        {
+                            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                        }
+                        else
+                        {
+                            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                        }
+                        break;
+                    }
+                    default: out.push_back(c); break;
+                    }
+                }
+                if (m_p >= m_end)
+                {
+                    return false;
+                }
+                ++m_p;
+                return true;
+            }
+
+            bool ParseValue(Json& value, int depth)
+            {
+                SkipWhitespace();
+                if (m_p >= m_end || depth > kMaxJsonDepth)
+                {
+                    return false;
+                }
+                const char c = *m_p;
+                if (c == '{')
+                {
+                    value.type = Json::Type::Object;
+                    ++m_p;
+                    SkipWhitespace();
+                    if (m_p < m_end && *m_p == '}')
+                    {
+                        ++m_p;
+                        return true;
+                    }
+                    while (true)
+                    {
+                        SkipWhitespace();
+                        std::pair<std::string, Json> member;
+                        if (!ParseString(member.first))
+                        {
+                            return false;
+                        }
+                        SkipWhitespace();
+                        if (m_p >= m_end || *m_p++ != ':' || !ParseValue(member.second, depth + 1))
+                        {
+                            return false;
+                        }
+                        value.members.push_back(std::move(member));
+                        SkipWhitespace();
+                        if (m_p < m_end && *m_p == ',')
+                        {
+                            ++m_p;
+                            continue;
+                        }
+                        return m_p < m_end && *m_p++ == '}';
+                    }
+                }
+                if (c == '[')
+                {
+                    value.type = Json::Type::Array;
+                    ++m_p;
+                    SkipWhitespace();
+                    if (m_p < m_end && *m_p == ']')
+                    {
+                        ++m_p;
+                        return true;
+                    }
+                    while (true)
+                    {
+                        value.items.emplace_back();
+                        if (!ParseValue(value.items.back(), depth + 1))
+                        {
+                            return false;
+                        }
+                        SkipWhitespace();
+                        if (m_p < m_end && *m_p == ',')
+                        {
+                            ++m_p;
+                            continue;
+                        }
+                        return m_p < m_end && *m_p++ == ']';
+                    }
+                }
+                if (c == '"')
+                {
+                    value.type = Json::Type::String;
+                    return ParseString(value.text);
+                }
+                if (Literal("true") || Literal("false"))
+                {
+                    value.type = Json::Type::Bool;
+                    value.number = c == 't' ? 1.0 : 0.0;
+                    return true;
+                }
+                if (Literal("null"))
+                {
+                    return true;
+                }
+                // strtod needs a terminator; numbers are short, so copy one out.
+                const char* start = m_p;
+                while (m_p < m_end && (std::isdigit(static_cast<unsigned char>(*m_p)) || *m_p == '-' || *m_p == '+' || *m_p == '.' || *m_p == 'e' || *m_p == 'E'))
+                {
+                    ++m_p;
+                }
+                const std::string digits(start, m_p);
+                char* parsedEnd = nullptr;
+                value.type = Json::Type::Number;
+                value.number = std::strtod(digits.c_str(), &parsedEnd);
+                return !digits.empty() && parsedEnd == digits.c_str() + digits.size();
+            }
+
+            const char* m_p;
+            const char* m_end;
+        };
+
+        bool DecodeBase64(const std::string& text, size_t begin, std::string& out)
+        {
+            int bits = 0;
+            uint32_t accumulator = 0;
+            for (size_t i = begin; i < text.size() && text[i] != '='; ++i)
+            {
+                const char c = text[i];
+                int value = -1;
+                if (c >= 'A' && c <= 'Z')
+                {
+                    value = c - 'A';
+                }
+                else if (c >= 'a' && c <= 'z')
+                {
+                    value = c - 'a' + 26;
+                }
+                else if (c >= '0' && c <= '9')
+                {
+                    value = c - '0' + 52;
+                }
+                else if (c == '+')
+                {
+                    value = 62;
+                }
+                else if (c == '/')
+                {
+                    value = 63;
+                }
+                else
+                {
+                    return false;
+                }
+                accumulator = (accumulator << 6) | static_cast<uint32_t>(value);
+                bits += 6;
+                if (bits >= 8)
+                {
+                    bits -= 8;
+                    out.push_back(static_cast<char>((accumulator >> bits) & 0xFF));
+                }
+            }
+            return true;
+        }
+
+        uint32_t ReadU32(const char* bytes)
+        {
+            const unsigned char* b = reinterpret_cast<const unsigned char*>(bytes);
+            return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) | (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+        }
+
+        // Column-major 4x4, as glTF stores it.
+        struct Matrix4
+        {
+            float m[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+            Matrix4 operator*(const Matrix4& other) const
+            {
+                Matrix4 result;
+                for (int column = 0; column < 4; ++column)
+                {
+                    for (int row = 0; row < 4; ++row)
+                    {
+                        float sum = 0.0f;
+                        for (int k = 0; k < 4; ++k)
+                        {
+                            sum += m[k * 4 + row] * other.m[column * 4 + k];
+                        }
+                        result.m[column * 4 + row] = sum;
+                    }
+                }
+                return result;
+            }
+
+            void TransformPoint(const float in[3], float out[3]) const
+            {
+                for (int row = 0; row < 3; ++row)
+                {
+                    out[row] = m[row] * in[0] + m[4 + row] * in[1] + m[8 + row] * in[2] + m[12 + row];
+                }
+            }
+
+            float Determinant3() const
+            {
+                return m[0] * (m[5] * m[10] - m[9] * m[6]) - m[4] * (m[1] * m[10] - m[9] * m[2]) + m[8] * (m[1] * m[6] - m[5] * m[2]);
+            }
+
+            // Normals go through the inverse transpose; the cofactor matrix is that times the
+            // determinant, which normalisation (and the sign fix) takes care of.
+            void TransformNormal(const float in[3], float out[3]) const
+            {
+                const float cofactor[9] = {
+                    m[5] * m[10] - m[9] * m[6], m[8] * m[6] - m[4] * m[10], m[4] * m[9] - m[8] * m[5],
+                    m[9] * m[2] - m[1] * m[10], m[0] * m[10] - m[8] * m[2], m[8] * m[1] - m[0] * m[9],
+                    m[1] * m[6] - m[5] * m[2],  m[4] * m[2] - m[0] * m[6],  m[0] * m[5] - m[4] * m[1],
+                };
+                const float sign = Determinant3() < 0.0f ? -1.0f : 1.0f;
+                for (int row = 0; row < 3; ++row)
+                {
+                    out[row] = sign * (cofactor[row * 3] * in[0] + cofactor[row * 3 + 1] * in[1] + cofactor[row * 3 + 2] * in[2]);
+                }
+                Normalize(out);
+            }
+        };
+
+        Matrix4 NodeMatrix(const Json& node)
+        {
+            Matrix4 result;
+            if (const Json* matrix = node.Get("matrix"); matrix && matrix->items.size() == 16)
+            {
+                for (size_t i = 0; i < 16; ++i)
+                {
+                    result.m[i] = static_cast<float>(matrix->items[i].number);
+                }
+                return result;
+            }
+            float t[3] = {0, 0, 0};
+            float q[4] = {0, 0, 0, 1};
+            float s[3] = {1, 1, 1};
+            const auto read = [&](const char* key, float* out, size_t count) {
+                const Json* value = node.Get(key);
+                if (value && value->items.size() == count)
+                {
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        out[i] = static_cast<float>(value->items[i].number);
+                    }
+                }
+            };
+            read("translation", t, 3);
+            read("rotation", q, 4);
+            read("scale", s, 3);
+            const float x = q[0];
+            const float y = q[1];
+            const float z = q[2];
+            const float w = q[3];
+            const float rotation[9] = {
+                1 - 2 * (y * y + z * z), 2 * (x * y + z * w),     2 * (x * z - y * w),
+                2 * (x * y - z * w),     1 - 2 * (x * x + z * z), 2 * (y * z + x * w),
+                2 * (x * z + y * w),     2 * (y * z - x * w),     1 - 2 * (x * x + y * y),
+            };
+            for (int column = 0; column < 3; ++column)
+            {
+                for (int row = 0; row < 3; ++row)
+                {
+                    result.m[column * 4 + row] = rotation[column * 3 + row] * s[column];
+                }
+            }
+            result.m[12] = t[0];
+            result.m[13] = t[1];
+            result.m[14] = t[2];
+            return result;
+        }
+
+        class GltfReader
+        {
+        public:
+            GltfReader(MeshData& mesh, std::string& error) : m_welder(mesh), m_error(error) {}
+
+            bool Load(const std::string& bytes, const std::string& path)
+            {
+                std::string jsonText;
+                std::string binChunk;
+                if (bytes.size() >= 12 && ReadU32(bytes.data()) == 0x46546C67u)
+                {
+                    // GLB: a JSON chunk, then an optional BIN chunk that backs the first buffer.
+                    size_t offset = 12;
+                    while (offset + 8 <= bytes.size())
+                    {
+                        const uint32_t length = ReadU32(bytes.data() + offset);
+                        const uint32_t type = ReadU32(bytes.data() + offset + 4);
+                        if (length > bytes.size() - offset - 8)
+                        {
+                            return Fail("Truncated GLB chunk");
+                        }
+                        if (type == 0x4E4F534Au && jsonText.empty())
+                        {
+                            jsonText.assign(bytes, offset + 8, length);
+                        }
+                        else if (type == 0x004E4942u && binChunk.empty())
+                        {
+                            binChunk.assign(bytes, offset + 8, length);
+                        }
+                        offset += 8 + length;
+                    }
+                }
+                else
+                {
+                    jsonText = bytes;
+                }
+
+                JsonParser parser(jsonText.data(), jsonText.data() + jsonText.size());
+                if (!parser.Parse(m_root) || m_root.type != Json::Type::Object)
+                {
+                    return Fail("Malformed glTF JSON");
+                }
+                if (const Json* buffers = m_root.Get("buffers"))
+                {
+                    for (size_t i = 0; i < buffers->items.size(); ++i)
+                    {
+                        const Json* uri = buffers->items[i].Get("uri");
+                        std::string data;
+                        if (!uri)
+                        {
+                            data = i == 0 ? binChunk : std::string();
+                        }
+                        else if (uri->text.rfind("data:", 0) == 0)
+                        {
+                            const size_t comma = uri->text.find(";base64,");
+                            if (comma == std::string::npos || !DecodeBase64(uri->text, comma + 8, data))
+                            {
+                                return Fail("Unsupported data URI in buffer " + std::to_string(i));
+                            }
+                        }
+                        else if (!ReadWholeFile((std::filesystem::u8path(path).parent_path() / std::filesystem::u8path(uri->text)).u8string(), data))
+                        {
+                            return Fail("Unable to read buffer " + uri->text);
+                        }
+                        m_buffers.push_back(std::move(data));
+                    }
+                }
+
+                const Json* nodes = m_root.Get("nodes");
+                const Json* scenes = m_root.Get("scenes");
+                const Json* scene = scenes ? scenes->At(m_root.Number("scene", 0.0)) : nullptr;
+                if (scene && nodes)
+                {
+                    if (const Json* roots = scene->Get("nodes"))
+                    {
+                        for (const Json& root : roots->items)
+                        {
+                            if (!VisitNode(root.number, Matrix4{}, 0))
+                            {
+                                return false;
+                            }
+                        }
+                    }
+                }
+                else if (const Json* meshes = m_root.Get("meshes"))
+                {
+                    // No scene graph: every mesh, untransformed.
+                    for (size_t i = 0; i < meshes->items.size(); ++i)
+                    {
+                        if (!AddMesh(meshes->items[i], Matrix4{}))
+                        {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+            }
+
+        private:
+            bool Fail(const std::string& error)
+            {
+                m_error = error;
+                return false;
+            }
+
+            bool VisitNode(double index, const Matrix4& parent, int depth)
+            {
+                const Json* node = m_root.Get("nodes")->At(index);
+                if (!node || depth > kMaxNodeDepth)
+                {
+                    return Fail("Bad node reference");
+                }
+                const Matrix4 world = parent * NodeMatrix(*node);
+                if (const Json* meshIndex = node->Get("mesh"))
+                {
+                    const Json* meshes = m_root.Get("meshes");
+                    const Json* mesh = meshes ? meshes->At(meshIndex->number) : nullptr;
+                    if (!mesh || !AddMesh(*mesh, world))
+                    {
+                        return mesh ? false : Fail("Bad mesh reference");
+                    }
+                }
+                if (const Json* children = node->Get("children"))
+                {
+                    for (const Json& child : children->items)
+                    {
+                        if (!VisitNode(child.number, world, depth + 1))
+                        {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+            }
+
+            // Reads an accessor as floats, components per element; integer types must be normalized
+            // (or, for indices, are read as-is).
+            bool ReadAccessor(double index, int components, std::vector<float>* floats, std::vector<uint32_t>* integers)
+            {
+                const Json* accessors = m_root.Get("accessors");
+                const Json* accessor = accessors ? accessors->At(index) : nullptr;
+                const Json* views = m_root.Get("bufferViews");
+                const Json* view = accessor && views ? views->At(accessor->Number("bufferView", -1.0)) : nullptr;
+                if (!accessor || !view || accessor->Get("sparse"))
+                {
+                    return Fail("Unsupported or missing accessor " + std::to_string(static_cast<long long>(index)));
+                }
+                const Json* type = accessor->Get("type");
+                const int expected = !type ? 0 : type->text == "SCALAR" ? 1 : type->text == "VEC2" ? 2 : type->text == "VEC3" ? 3 : type->text == "VEC4" ? 4 : 0;
+                const int componentType = static_cast<int>(accessor->Number("componentType", 0.0));
+                const size_t componentSize = componentType == 5126 || componentType == 5125 ? 4 : componentType == 5123 ? 2 : componentType == 5121 ? 1 : 0;
+                const bool normalized = accessor->Get("normalized") && accessor->Get("normalized")->number != 0.0;
+                if (expected != components || componentSize == 0 || (floats && componentType != 5126 && !normalized))
+                {
+                    return Fail("Unsupported accessor layout");
+                }
+                const double bufferIndex = view->Number("buffer", -1.0);
+                if (bufferIndex < 0.0 || bufferIndex >= static_cast<double>(m_buffers.size()))
+                {
+                    return Fail("Bad buffer reference");
+                }
+                const std::string& buffer = m_buffers[static_cast<size_t>(bufferIndex)];
+                const size_t count = static_cast<size_t>(accessor->Number("count", 0.0));
+                const size_t elementSize = componentSize * static_cast<size_t>(components);
+                const size_t stride = std::max(elementSize, static_cast<size_t>(view->Number("byteStride", 0.0)));
+                const size_t viewOffset = static_cast<size_t>(view->Number("byteOffset", 0.0));
+                const size_t viewLength = static_cast<size_t>(view->Number("byteLength", 0.0));
+                const size_t start = static_cast<size_t>(accessor->Number("byteOffset", 0.0));
+                const bool viewFits = viewOffset <= buffer.size() && viewLength <= buffer.size() - viewOffset;
+                const bool elementsFit = count == 0 || (start <= viewLength && viewLength - start >= elementSize &&
+                                                        count - 1 <= (viewLength - start - elementSize) / stride);
+                if (!viewFits || !elementsFit)
+                {
+                    return Fail("Accessor runs past its buffer");
+                }
+                const char* base = buffer.data() + viewOffset + start;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const char* element = base + i * stride;
+                    for (int c = 0; c < components; ++c)
+                    {
+                        const char* at = element + static_cast<size_t>(c) * componentSize;
+                        uint32_t integer = 0;
+                        float value = 0.0f;
+                        if (componentType == 5126)
+                        {
+                            std::memcpy(&value, at, 4);
+                        }
+                        else
+                        {
+                            integer = componentType == 5125 ? ReadU32(at)
+                                      : componentType == 5123
+                                          ? static_cast<uint32_t>(static_cast<unsigned char>(at[0]) | (static_cast<unsigned char>(at[1]) << 8))
+                                          : static_cast<uint32_t>(static_cast<unsigned char>(at[0]));
+                            value = static_cast<float>(integer) / (componentType == 5123 ? 65535.0f : 255.0f);
+                        }
+                        if (floats)
+                        {
+                            floats->push_back(value);
+                        }
+                        else
+                        {
+                            integers->push_back(integer);
+                        }
+                    }
+                }
+                return true;
+            }
+
+            bool AddMesh(const Json& mesh, const Matrix4& transform)
+            {
+                const Json* primitives = mesh.Get("primitives");
+                if (!primitives)
+                {
+                    return true;
+                }
+                const bool mirrored = transform.Determinant3() < 0.0f;
+                for (const Json& primitive : primitives->items)
+                {
+                    const Json* attributes = primitive.Get("attributes");
+                    if (primitive.Number("mode", 4.0) != 4.0 || !attributes || !attributes->Get("POSITION"))
+                    {
+                        continue; // Points, lines and strips have nothing to offer a cube renderer.
+                    }
+                    std::vector<float> positions;
+                    std::vector<float> normals;
+                    std::vector<float> uvs;
+                    std::vector<uint32_t> indices;
+                    if (!ReadAccessor(attributes->Get("POSITION")->number, 3, &positions, nullptr) ||
+                        (attributes->Get("NORMAL") && !ReadAccessor(attributes->Get("NORMAL")->number, 3, &normals, nullptr)) ||
+                        (attributes->Get("TEXCOORD_0") && !ReadAccessor(attributes->Get("TEXCOORD_0")->number, 2, &uvs, nullptr)) ||
+                        (primitive.Get("indices") && !ReadAccessor(primitive.Get("indices")->number, 1, nullptr, &indices)))
+                    {
+                        return false;
+                    }
+                    const size_t vertexCount = positions.size() / 3;
+                    if (!primitive.Get("indices"))
+                    {
+                        for (uint32_t i = 0; i < vertexCount; ++i)
+                        {
+                            indices.push_back(i);
+                        }
+                    }
+                    const bool hasNormals = normals.size() == positions.size();
+                    const bool hasUvs = uvs.size() / 2 == vertexCount;
+                    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+                    {
+                        MeshVertex corners[3] = {};
+                        for (size_t c = 0; c < 3; ++c)
+                        {
+                            const uint32_t index = indices[t + c];
+                            if (index >= vertexCount)
+                            {
+                                return Fail("Index out of range");
+                            }
+                            transform.TransformPoint(&positions[index * 3], corners[c].position);
+                            if (hasNormals)
+                            {
+                                transform.TransformNormal(&normals[index * 3], corners[c].normal);
+                            }
+                            if (hasUvs)
+                            {
+                                corners[c].uv[0] = uvs[index * 2];
+                                corners[c].uv[1] = 1.0f - uvs[index * 2 + 1];
+                            }
+                        }
+                        if (mirrored)
+                        {
+                            std::swap(corners[1], corners[2]);
+                        }
+                        if (!hasNormals)
+                        {
+                            const float e1[3] = {corners[1].position[0] - corners[0].position[0], corners[1].position[1] - corners[0].position[1],
+                                                 corners[1].position[2] - corners[0].position[2]};
+                            const float e2[3] = {corners[2].position[0] - corners[0].position[0], corners[2].position[1] - corners[0].position[1],
+                                                 corners[2].position[2] - corners[0].position[2]};
+                            float faceNormal[3];
+                            Cross(e1, e2, faceNormal);
+                            Normalize(faceNormal);
+                            for (MeshVertex& corner : corners)
+                            {
+                                std::memcpy(corner.normal, faceNormal, sizeof(faceNormal));
+                            }
+                        }
+                        for (const MeshVertex& corner : corners)
+                        {
+                            m_welder.Add(corner);
+                        }
+                    }
+                }
+                return true;
+            }
+
+            VertexWelder m_welder;
+            std::string& m_error;
+            Json m_root;
+            std::vector<std::string> m_buffers;
+        };
+    }
+
+    bool ParseGltfMesh(const std::string& bytes, const std::string& path, MeshData& mesh, std::string& error)
+    {
+        mesh = MeshData{};
+        GltfReader reader(mesh, error);
+        if (!reader.Load(bytes, path))
+        {
+            return false;
+        }
+        if (mesh.indices.empty())
+        {
+            error = "No triangles";
+            return false;
+        }
+        ComputeBounds(mesh);
+        return true;
+    }
+
+    namespace
+    {
+        // --- Vertex cache optimisation -----------------------------------------------------------
+
+        // Forsyth's scoring: recently used vertices score high (the last triangle's three a little
+        // less, so strips don't run away), and vertices with few triangles left get a boost so
+        // they are finished off rather than stranded.
+        float VertexScore(int cachePosition, uint32_t remaining, size_t cacheSize)
+        {
+            if (remaining == 0)
+            {
+                return -1.0f;
+            }
+            float score = 0.0f;
+            if (cachePosition >= 0)
+            {
+                score = cachePosition < 3 ? 0.75f
+                                          : std::pow(1.0f - static_cast<float>(cachePosition - 3) / static_cast<float>(cacheSize - 3), 1.5f);
+            }
+            return score + 2.0f / std::sqrt(static_cast<float>(remaining));
+        }
+
+        void OptimizeTriangleOrder(std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize)
+        {
+            const size_t triangleCount = indices.size() / 3;
+            cacheSize = std::max<size_t>(cacheSize, 4);
+
+            // Each vertex's live triangles sit in adjacency[offsets[v], offsets[v] + remaining[v]).
+            std::vector<uint32_t> remaining(vertexCount, 0);
+            for (const uint32_t index : indices)
+            {
+                ++remaining[index];
+            }
+            std::vector<uint32_t> offsets(vertexCount + 1, 0);
+            for (size_t v = 0; v < vertexCount; ++v)
+            {
+                offsets[v + 1] = offsets[v] + remaining[v];
+            }
+            std::vector<uint32_t> adjacency(indices.size());
+            {
+                std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0; i < indices.size(); ++i)
+                {
+                    adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+
+            std::vector<int> cachePosition(vertexCount, -1);
+            std::vector<float> vertexScore(vertexCount);
+            for (size_t v = 0; v < vertexCount; ++v)
+            {
+                vertexScore[v] = VertexScore(-1, remaining[v], cacheSize);
+            }
+            std::vector<char> emitted(triangleCount, 0);
+            std::vector<uint32_t> cache;
+            std::vector<uint32_t> nextCache;
+            std::vector<uint32_t> ordered;
+            ordered.reserve(indices.size());
+
+            size_t restartCursor = 0;
+            size_t best = triangleCount;
+            while (ordered.size() < indices.size())
+            {
+                if (best == triangleCount)
+                {
+                    // Nothing in the cache has work left: start on the next untouched triangle.
+                    while (emitted[restartCursor])
+                    {
+                        ++restartCursor;
+                    }
+                    best = restartCursor;
+                }
+                const uint32_t* corners = &indices[best * 3];
+                emitted[best] = 1;
+                ordered.insert(ordered.end(), corners, corners + 3);
+                for (int c = 0; c < 3; ++c)
+                {
+                    const uint32_t v = corners[c];
+                    uint32_t* live = &adjacency[offsets[v]];
+                    uint32_t* found = std::find(live, live + remaining[v], static_cast<uint32_t>(best));
+                    std::swap(*found, live[remaining[v] - 1]);
+                    --remaining[v];
+                }
+
+                nextCache.assign(corners, corners + 3);
+                for (const uint32_t v : cache)
+                {
+                    if (v != corners[0] && v != corners[1] && v != corners[2])
+                    {
+                        nextCache.push_back(v);
+                    }
+                }
+                // Entries past cacheSize were just evicted; they are rescored once more, as misses.
+                for (size_t i = 0; i < nextCache.size(); ++i)
+                {
+                    const uint32_t v = nextCache[i];
+                    cachePosition[v] = i < cacheSize ? static_cast<int>(i) : -1;
+                    vertexScore[v] = VertexScore(cachePosition[v], remaining[v], cacheSize);
+                }
+                best = triangleCount;
+                float bestScore = -1.0f;
+                for (const uint32_t v : nextCache)
+                {
+                    for (uint32_t k = 0; k < remaining[v]; ++k)
+                    {
+                        const uint32_t t = adjacency[offsets[v] + k];
+                        const float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                        if (score > bestScore)
+                        {
+                            bestScore = score;
+                            best = t;
+                        }
+                    }
+                }
+                nextCache.resize(std::min(nextCache.size(), cacheSize));
+                cache.swap(nextCache);
+            }
+            indices.swap(ordered);
+        }
+    }
+
+    void OptimizeMesh(MeshData& mesh, size_t cacheSize)
+    {
+        OptimizeTriangleOrder(mesh.indices, mesh.vertices.size(), cacheSize);
+
+        // Renumber vertices in the order the triangles first use them; unused ones drop out.
+        constexpr uint32_t kUnmapped = UINT32_MAX;
+        std::vector<uint32_t> remap(mesh.vertices.size(), kUnmapped);
+        std::vector<MeshVertex> vertices;
+        vertices.reserve(mesh.vertices.size());
+        for (uint32_t& index : mesh.indices)
+        {
+            if (remap[index] == kUnmapped)
+            {
+                remap[index] = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(mesh.vertices[index]);
+            }
+            index = remap[index];
+        }
+        mesh.vertices.swap(vertices);
+    }
+
+    double AverageCacheMissRatio(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize)
+    {
+        if (indices.size() < 3)
+        {
+            return 0.0;
+        }
+        // A FIFO cache: a vertex is resident while fewer than cacheSize misses followed its own.
+        std::vector<size_t> missStamp(vertexCount, 0);
+        std::vector<char> seen(vertexCount, 0);
+        size_t misses = 0;
+        for (const uint32_t index : indices)
+        {
+            if (index >= vertexCount)
+            {
+                continue;
+            }
+            if (!seen[index] || misses - missStamp[index] >= cacheSize)
+            {
+                seen[index] = 1;
+                missStamp[index] = misses;
+                ++misses;
+            }
+        }
+        return static_cast<double>(misses) / static_cast<double>(indices.size() / 3);
+    }
+
+    namespace
+    {
+        // --- Mesh cache --------------------------------------------------------------------------
+
+        struct MeshCacheHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t vertexCount;
+            uint32_t indexCount;
+            uint32_t pathLength;
+            uint32_t optimizeCacheSize;
+            uint64_t sourceSize;
+            uint64_t sourceWriteTime;
+            uint64_t sourceHash;
+            float boundsMin[3];
+            float boundsMax[3];
+        };
+
+        std::string MeshCachePath(const std::string& cacheDirectory, const std::string& sourcePath)
+        {
+            std::ostringstream name;
+            name << std::hex << std::setw(16) << std::setfill('0') << HashBytes(sourcePath.data(), sourcePath.size()) << ".vmc";
+            return (std::filesystem::u8path(cacheDirectory) / name.str()).u8string();
+        }
+
+        bool StatSource(const std::string& path, uint64_t& size, uint64_t& writeTime)
+        {
+            std::error_code ec;
+            const uintmax_t bytes = std::filesystem::file_size(std::filesystem::u8path(path), ec);
+            if (ec)
+            {
+                return false;
+            }
+            const std::filesystem::file_time_type time = std::filesystem::last_write_time(std::filesystem::u8path(path), ec);
+            if (ec)
+            {
+                return false;
+            }
+            size = static_cast<uint64_t>(bytes);
+            writeTime = static_cast<uint64_t>(time.time_since_epoch().count());
+            return true;
+        }
+
+        // Trusts the blob when the stamp matches; when only the stamp moved, the source hash decides.
+        bool LoadMeshCache(const std::string& cachePath, const std::string& sourcePath, MeshData& mesh, bool& staleStamp)
+        {
+            staleStamp = false;
+            std::ifstream file(std::filesystem::u8path(cachePath), std::ios::binary);
+            MeshCacheHeader header{};
+            if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != kMeshCacheMagic ||
+                header.version != kMeshCacheVersion || header.optimizeCacheSize != kMeshCacheOptimizeSize || header.pathLength != sourcePath.size())
+            {
+                return false;
+            }
+            std::string storedPath(header.pathLength, '\0');
+            file.read(storedPath.data(), static_cast<std::streamsize>(storedPath.size()));
+            uint64_t sourceSize = 0;
+            uint64_t sourceWriteTime = 0;
+            if (!file || storedPath != sourcePath || !StatSource(sourcePath, sourceSize, sourceWriteTime) || sourceSize != header.sourceSize)
+            {
+                return false;
+            }
+            // Only reported once the payload below has read and validated, so a bad blob always
+            // falls back to a full parse.
+            const bool touched = sourceWriteTime != header.sourceWriteTime;
+            if (touched)
+            {
+                std::string bytes;
+                if (!ReadWholeFile(sourcePath, bytes) || HashBytes(bytes.data(), bytes.size()) != header.sourceHash)
+                {
+                    return false;
+                }
+            }
+            mesh = MeshData{};
+            mesh.vertices.resize(header.vertexCount);
+            mesh.indices.resize(header.indexCount);
+            file.read(reinterpret_cast<char*>(mesh.vertices.data()), static_cast<std::streamsize>(mesh.vertices.size() * sizeof(MeshVertex)));
+            file.read(reinterpret_cast<char*>(mesh.indices.data()), static_cast<std::streamsize>(mesh.indices.size() * sizeof(uint32_t)));
+            if (!file || file.peek() != std::char_traits<char>::eof() || mesh.indices.empty())
+            {
+                return false;
+            }
+            for (const uint32_t index : mesh.indices)
+            {
+                if (index >= header.vertexCount)
+                {
+                    return false;
+                }
+            }
+            std::memcpy(mesh.boundsMin, header.boundsMin, sizeof(mesh.boundsMin));
+            std::memcpy(mesh.boundsMax, header.boundsMax, sizeof(mesh.boundsMax));
+            staleStamp = touched;
+            return true;
+        }
+
+        void StoreMeshCache(const std::string& cachePath, const std::string& sourcePath, const std::string& sourceBytes, const MeshData& mesh)
+        {
+            MeshCacheHeader header{};
+            header.magic = kMeshCacheMagic;
+            header.version = kMeshCacheVersion;
+            header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+            header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+            header.pathLength = static_cast<uint32_t>(sourcePath.size());
+            header.optimizeCacheSize = static_cast<uint32_t>(kMeshCacheOptimizeSize);
+            header.sourceHash = HashBytes(sourceBytes.data(), sourceBytes.size());
+            std::memcpy(header.boundsMin, mesh.boundsMin, sizeof(header.boundsMin));
+            std::memcpy(header.boundsMax, mesh.boundsMax, sizeof(header.boundsMax));
+            if (!StatSource(sourcePath, header.sourceSize, header.sourceWriteTime))
+            {
+                return;
+            }
+
+            std::error_code ec;
+            std::filesystem::create_directories(std::filesystem::u8path(cachePath).parent_path(), ec);
+            // Written to a temp file first so an interrupted write never leaves a truncated blob behind.
+            const std::string tempPath = cachePath + ".tmp";
+            {
+                std::ofstream file(std::filesystem::u8path(tempPath), std::ios::binary | std::ios::trunc);
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                file.write(sourcePath.data(), static_cast<std::streamsize>(sourcePath.size()));
+                file.write(reinterpret_cast<const char*>(mesh.vertices.data()), static_cast<std::streamsize>(mesh.vertices.size() * sizeof(MeshVertex)));
+                file.write(reinterpret_cast<const char*>(mesh.indices.data()), static_cast<std::streamsize>(mesh.indices.size() * sizeof(uint32_t)));
+                if (!file)
+                {
+                    file.close();
+                    std::filesystem::remove(std::filesystem::u8path(tempPath), ec);
+                    return;
+                }
+            }
+            std::filesystem::rename(std::filesystem::u8path(tempPath), std::filesystem::u8path(cachePath), ec);
+            if (ec)
+            {
+                std::filesystem::remove(std::filesystem::u8path(tempPath), ec);
+            }
+        }
+    }
+
+    bool LoadMesh(const std::string& path, const std::string& cacheDirectory, MeshData& mesh, std::string& error, bool* fromCache)
+    {
+        if (fromCache)
+        {
+            *fromCache = false;
+        }
+        const std::string cachePath = cacheDirectory.empty() ? std::string() : MeshCachePath(cacheDirectory, path);
+        bool staleStamp = false;
+        if (!cachePath.empty() && LoadMeshCache(cachePath, path, mesh, staleStamp))
+        {
+            if (fromCache)
+            {
+                *fromCache = true;
+            }
+            if (!staleStamp)
+            {
+                return true;
+            }
+        }
+
+        std::string bytes;
+        if (!ReadWholeFile(path, bytes))
+        {
+            error = "Unable to read " + path;
+            return false;
+        }
+        if (!staleStamp)
+        {
+            std::string extension = std::filesystem::path(path).extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            const bool parsed = extension == ".gltf" || extension == ".glb" ? ParseGltfMesh(bytes, path, mesh, error) : ParseObjMesh(bytes, mesh, error);
+            if (!parsed)
+            {
+                error = path + ": " + error;
+                return false;
+            }
+            OptimizeMesh(mesh, kMeshCacheOptimizeSize);
+        }
+        if (!cachePath.empty())
+        {
+            // Also refreshes the stamp of a blob whose source was touched without changing.
+            StoreMeshCache(cachePath, path, bytes, mesh);
+        }
+        return true;
+    }
+}
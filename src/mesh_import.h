@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Imports triangle meshes from Wavefront OBJ and glTF 2.0 (.gltf or .glb) into one interleaved,
+// indexed layout the renderers can draw without per-vertex fix-ups:
+//
+//   - polygons are fan-triangulated and identical corners are welded, so a cube is 24 vertices
+//     and 36 indices rather than 36 loose vertices;
+//   - faces without normals get flat face normals, corners without UVs get (0, 0);
+//   - glTF node transforms are applied and every primitive is merged into one mesh; UVs are
+//     flipped to OBJ's bottom-left origin so both formats map textures the same way;
+//   - triangles are reordered for the post-transform vertex cache (Forsyth's linear-speed
+//     algorithm) and vertices renumbered in first-use order for fetch locality.
+//
+// LoadMesh keeps the optimised result as a binary blob in a cache directory, keyed by source path
+// and validated by the source's size/mtime stamp and content hash, the same way the texture cache
+// is, so later launches skip parsing and optimisation.
+namespace vengine
+{
+    struct MeshVertex
+    {
+        float position[3];
+        float normal[3];
+        float uv[2];
+    };
+
+    struct MeshData
+    {
+        std::vector<MeshVertex> vertices;
+        std::vector<uint32_t> indices; // Triangle list.
+        float boundsMin[3] = {0.0f, 0.0f, 0.0f};
+        float boundsMax[3] = {0.0f, 0.0f, 0.0f};
+    };
+
+    // Parse without optimising; vertices come out in the order corners were first seen.
+    bool ParseObjMesh(const std::string& text, MeshData& mesh, std::string& error);
+    // path is needed to resolve external buffers of a .gltf; .glb is detected by its header.
+    bool ParseGltfMesh(const std::string& bytes, const std::string& path, MeshData& mesh, std::string& error);
+
+    // Reorders triangles for a vertex cache of the given size, then vertices for fetch order.
+    void OptimizeMesh(MeshData& mesh, size_t cacheSize = 32);
+
+    // Vertex shader runs per triangle when drawn through a FIFO cache of cacheSize entries: 3.0
+    // is no reuse, 0.5 is the ideal for a large regular grid.
+    double AverageCacheMissRatio(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize = 16);
+
+    // Reads path (by extension: .obj, .gltf, .glb), parses and optimises it. With a non-empty
+    // cacheDirectory the result is reused from, or stored to, the mesh cache there; fromCache
+    // reports which happened.
+    bool LoadMesh(const std::string& path, const std::string& cacheDirectory, MeshData& mesh, std::string& error, bool* fromCache = nullptr);
+}
@@ -0,0 +1,168 @@
+#include "occlusion.h"
+
+namespace vengine
+{
+    namespace
+    {
+        // Query boxes are pushed out slightly so a cube face lying on the box boundary cannot
+        // depth-fail against itself.
+        constexpr float kQueryBoxPadding = 0.05f;
+
+        // A box that reaches the near plane gets clipped and can miss samples it should have;
+        // chunks this close to the eye are always drawn instead of queried.
+        constexpr float kEyeMargin = 0.5f;
+
+        // Chunks unseen for this many frames give their query back.
+        constexpr uint64_t kEvictAfterFrames = 120;
+
+        bool SameBounds(const Aabb& a, const Aabb& b)
+        {
+            return a.minX == b.minX && a.minY == b.minY && a.minZ == b.minZ &&
+                   a.maxX == b.maxX && a.maxY == b.maxY && a.maxZ == b.maxZ;
+        }
+    }
+
+    void ChunkOcclusionCuller::SetEnabled(bool enabled)
+    {
+        if (!enabled)
+        {
+            for (auto& entry : m_chunks)
+            {
+                entry.second.occluded = false;
+            }
+        }
+        m_enabled = enabled;
+    }
+
+    void ChunkOcclusionCuller::BeginFrame(float eyeX, float eyeY, float eyeZ)
+    {
+        ++m_frame;
+        m_eye[0] = eyeX;
+        m_eye[1] = eyeY;
+        m_eye[2] = eyeZ;
+        m_seenThisFrame.clear();
+        m_tested = 0;
+        m_occluded = 0;
+    }
+
+    bool ChunkOcclusionCuller::EyeNear(const Aabb& bounds) const
+    {
+        return m_eye[0] > bounds.minX - kEyeMargin && m_eye[0] < bounds.maxX + kEyeMargin &&
+               m_eye[1] > bounds.minY - kEyeMargin && m_eye[1] < bounds.maxY + kEyeMargin &&
+               m_eye[2] > bounds.minZ - kEyeMargin && m_eye[2] < bounds.maxZ + kEyeMargin;
+    }
+
+    bool ChunkOcclusionCuller::IsVisible(OcclusionQueryBackend& backend, uint64_t key, const Aabb& bounds)
+    {
+        if (!m_enabled)
+        {
+            return true;
+        }
+
+        ChunkState& state = m_chunks[key];
+        if (state.lastSeenFrame == m_frame)
+        {
+            return !state.occluded;
+        }
+        state.lastSeenFrame = m_frame;
+        m_seenThisFrame.push_back(key);
+        ++m_tested;
+
+        if (!SameBounds(state.bounds, bounds))
+        {
+            // Cubes were added or removed: earlier results describe a different box.
+            state.bounds = bounds;
+            state.occluded = false;
+            state.pendingStale = state.pending;
+        }
+        if (state.pending && backend.QueryResultReady(state.query))
+        {
+            if (!state.pendingStale)
+            {
+                state.occluded = !backend.QueryAnySamplesPassed(state.query);
+            }
+            state.pending = false;
+            state.pendingStale = false;
+        }
+        if (EyeNear(bounds))
+        {
+            state.occluded = false;
+        }
+        if (state.occluded)
+        {
+            ++m_occluded;
+        }
+        return !state.occluded;
+    }
+
+    void ChunkOcclusionCuller::IssueQueries(OcclusionQueryBackend& backend)
+    {
+        if (!m_enabled)
+        {
+            return;
+        }
+
+        bool passOpen = false;
+        for (uint64_t key : m_seenThisFrame)
+        {
+            ChunkState& state = m_chunks[key];
+            if (state.pending || EyeNear(state.bounds))
+            {
+                continue;
+            }
+            if (state.query == 0)
+            {
+                state.query = backend.CreateQuery();
+                if (state.query == 0)
+                {
+                    continue;
+                }
+            }
+            if (!passOpen)
+            {
+                backend.BeginBoxPass();
+                passOpen = true;
+            }
+            const Aabb& b = state.bounds;
+            backend.DrawQueryBox(state.query, Aabb{b.minX - kQueryBoxPadding, b.minY - kQueryBoxPadding, b.minZ - kQueryBoxPadding,
+                                                   b.maxX + kQueryBoxPadding, b.maxY + kQueryBoxPadding, b.maxZ + kQueryBoxPadding});
+            state.pending = true;
+        }
+        if (passOpen)
+        {
+            backend.EndBoxPass();
+        }
+    }
+
+    void ChunkOcclusionCuller::EndFrame(OcclusionQueryBackend& backend)
+    {
+        m_lastTested = m_tested;
+        m_lastOccluded = m_occluded;
+        for (auto it = m_chunks.begin(); it != m_chunks.end();)
+        {
+            if (m_frame - it->second.lastSeenFrame < kEvictAfterFrames)
+            {
+                ++it;
+                continue;
+            }
+            if (it->second.query != 0)
+            {
+                backend.DestroyQuery(it->second.query);
+            }
+            it = m_chunks.erase(it);
+        }
+    }
+
+    void ChunkOcclusionCuller::Reset(OcclusionQueryBackend& backend)
+    {
+        for (auto& entry : m_chunks)
+        {
+            if (entry.second.query != 0)
+            {
+                backend.DestroyQuery(entry.second.query);
+            }
+        }
+        m_chunks.clear();
+        m_seenThisFrame.clear();
+    }
+}
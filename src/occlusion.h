@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "frustum.h"
+
+// Chunk-level occlusion culling from GPU occlusion queries. After the opaque pass each chunk that
+// passed the frustum test has its bounding box rasterised (no colour or depth writes) inside a
+// query; the next frame reads back whatever results have landed and skips chunks whose box
+// produced no samples. Results are a frame late, so the GPU is never waited on; a chunk that
+// comes into view draws one frame after it is revealed.
+namespace vengine
+{
+    // The GL-flavour-specific half, implemented by each frontend (ARB queries on the GL 1.1
+    // renderer, core queries on GLES3).
+    class OcclusionQueryBackend
+    {
+    public:
+        virtual ~OcclusionQueryBackend() = default;
+        virtual uint32_t CreateQuery() = 0; // 0 when no query could be created.
+        virtual void DestroyQuery(uint32_t query) = 0;
+        virtual bool QueryResultReady(uint32_t query) = 0;
+        virtual bool QueryAnySamplesPassed(uint32_t query) = 0;
+        virtual void BeginBoxPass() = 0; // Colour and depth writes off, depth test on.
+        virtual void DrawQueryBox(uint32_t query, const Aabb& box) = 0; // Draws box inside the query.
+        virtual void EndBoxPass() = 0;
+    };
+
+    class ChunkOcclusionCuller
+    {
+    public:
+        // Disabling forgets every occluded verdict, so re-enabling starts from "all visible".
+        void SetEnabled(bool enabled);
+        bool Enabled() const { return m_enabled; }
+
+        void BeginFrame(float eyeX, float eyeY, float eyeZ);
+
+        // False only when the chunk's latest completed query saw no samples. New chunks, chunks
+        // whose bounds changed and chunks around the eye always draw.
+        bool IsVisible(OcclusionQueryBackend& backend, uint64_t key, const Aabb& bounds);
+
+        // Call after the opaque pass, with its depth still bound. Queries every chunk passed to
+        // IsVisible this frame that has no query in flight.
+        void IssueQueries(OcclusionQueryBackend& backend);
+
+        // Releases the queries of chunks that have been off screen for a while.
+        void EndFrame(OcclusionQueryBackend& backend);
+
+        // Deletes every query; call before the GL context goes away.
+        void Reset(OcclusionQueryBackend& backend);
+
+        size_t LastTestedChunkCount() const { return m_lastTested; }
+        size_t LastOccludedChunkCount() const { return m_lastOccluded; }
+
+    private:
+        struct ChunkState
+        {
+            Aabb bounds;
+            uint32_t query = 0;
+            bool pending = false;
+            bool pendingStale = false; // The query in flight tested bounds that have since changed.
+            bool occluded = false;
+            uint64_t lastSeenFrame = 0;
+        };
+
+        bool EyeNear(const Aabb& bounds) const;
+
+        std::unordered_map<uint64_t, ChunkState> m_chunks;
+        std::vector<uint64_t> m_seenThisFrame;
+        uint64_t m_frame = 0;
+        float m_eye[3] = {0.0f, 0.0f, 0.0f};
+        bool m_enabled = true;
+        size_t m_tested = 0;
+        size_t m_occluded = 0;
+        size_t m_lastTested = 0;
+        size_t m_lastOccluded = 0;
+    };
+}
@@ -0,0 +1,421 @@
+#include "region_file.h"
+#include "byte_codec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <tuple>
+
+namespace vengine
+{
+    namespace
+    {
+        constexpr char kMagic[4] = {'V', 'R', 'E', 'G'};
+        constexpr uint32_t kVersion = 1;
+        constexpr uint8_t kCodecPaletteRuns = 1;
+        constexpr size_t kChunksPerRegion = static_cast<size_t>(kRegionSize) * kRegionSize;
+        constexpr size_t kTableOffset = sizeof(kMagic) + sizeof(uint32_t);
+        constexpr size_t kColumnsPerChunk = static_cast<size_t>(kStreamChunkSize) * kStreamChunkSize;
+        constexpr uint8_t kFlagGlowing = 1;
+        constexpr uint8_t kFlagTransparent = 2;
+
+        static_assert(kTableOffset + kChunksPerRegion * 8 <= kRegionHeaderSectors * kRegionSectorBytes, "Region table must fit its header sectors");
+
+        void WriteFloat(std::string& out, float value)
+        {
+            char bytes[sizeof(float)];
+            std::memcpy(bytes, &value, sizeof(float));
+            out.append(bytes, sizeof(float));
+        }
+
+
+        // Everything about a cube except where it is.
+        std::string MaterialKey(const SceneCube& cube)
+        {
+            std::string key;
+            WriteFloat(key, cube.r);
+            WriteFloat(key, cube.g);
+            WriteFloat(key, cube.b);
+            key.push_back(static_cast<char>((cube.glowing ? kFlagGlowing : 0) | (cube.transparent ? kFlagTransparent : 0)));
+            WriteSigned(key, cube.presetIndex);
+            WriteVarint(key, cube.texturePath.size());
+            key += cube.texturePath;
+            return key;
+        }
+
+        size_t ChunkIndexInRegion(const ChunkCoord& coord)
+        {
+            const int localX = coord.x - RegionOf(coord.x) * kRegionSize;
+            const int localZ = coord.z - RegionOf(coord.z) * kRegionSize;
+            return static_cast<size_t>(localZ) * kRegionSize + static_cast<size_t>(localX);
+        }
+
+        uint64_t RegionKey(int regionX, int regionZ)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(regionX)) << 32) | static_cast<uint32_t>(regionZ);
+        }
+    }
+
+    bool EncodeRegionChunk(const ChunkCoord& coord, const std::vector<SceneCube>& cubes, std::string& payload, std::string& error)
+    {
+        const int x0 = coord.x * kStreamChunkSize;
+        const int z0 = coord.z * kStreamChunkSize;
+        struct Cell
+        {
+            size_t column;
+            int y;
+            uint32_t material;
+        };
+        std::vector<Cell> cells;
+        cells.reserve(cubes.size());
+        std::unordered_map<std::string, uint32_t> materialIds;
+        std::vector<const SceneCube*> palette;
+        for (const SceneCube& cube : cubes)
+        {
+            const int localX = cube.gridX - x0;
+            const int localZ = cube.gridZ - z0;
+            if (localX < 0 || localX >= kStreamChunkSize || localZ < 0 || localZ >= kStreamChunkSize)
+            {
+                error = "Cube (" + std::to_string(cube.gridX) + ", " + std::to_string(cube.gridZ) + ") is outside chunk (" + std::to_string(coord.x) + ", " +
+                        std::to_string(coord.z) + ")";
+                return false;
+            }
+            const auto inserted = materialIds.emplace(MaterialKey(cube), static_cast<uint32_t>(palette.size()));
+            if (inserted.second)
+            {
+                palette.push_back(&cube);
+            }
+            cells.push_back(Cell{static_cast<size_t>(localZ) * kStreamChunkSize + static_cast<size_t>(localX), cube.gridY, inserted.first->second});
+        }
+        // Stable, so of two cubes in one cell the first one given is the one kept.
+        std::stable_sort(cells.begin(), cells.end(), [](const Cell& a, const Cell& b) { return std::tie(a.column, a.y) < std::tie(b.column, b.y); });
+        cells.erase(std::unique(cells.begin(), cells.end(), [](const Cell& a, const Cell& b) { return a.column == b.column && a.y == b.y; }), cells.end());
+
+        payload.clear();
+        payload.push_back(static_cast<char>(kCodecPaletteRuns));
+        WriteVarint(payload, cells.size());
+        WriteVarint(payload, palette.size());
+        for (const SceneCube* material : palette)
+        {
+            payload += MaterialKey(*material);
+        }
+        const int minY = cells.empty() ? 0 : std::min_element(cells.begin(), cells.end(), [](const Cell& a, const Cell& b) { return a.y < b.y; })->y;
+        WriteSigned(payload, minY);
+
+        // Each column: its run count, then per run the gap below it, its length and its material.
+        size_t next = 0;
+        for (size_t column = 0; column < kColumnsPerChunk; ++column)
+        {
+            const size_t begin = next;
+            while (next < cells.size() && cells[next].column == column)
+            {
+                ++next;
+            }
+            std::string runs;
+            size_t runCount = 0;
+            int64_t cursor = minY;
+            for (size_t i = begin; i < next;)
+            {
+                size_t end = i + 1;
+                while (end < next && cells[end].y == cells[end - 1].y + 1 && cells[end].material == cells[i].material)
+                {
+                    ++end;
+                }
+                WriteVarint(runs, static_cast<uint64_t>(cells[i].y - cursor));
+                WriteVarint(runs, end - i);
+                WriteVarint(runs, cells[i].material);
+                cursor = static_cast<int64_t>(cells[i].y) + static_cast<int64_t>(end - i);
+                ++runCount;
+                i = end;
+            }
+            WriteVarint(payload, runCount);
+            payload += runs;
+        }
+        return true;
+    }
+
+    bool DecodeRegionChunk(const ChunkCoord& coord, const std::string& payload, std::vector<SceneCube>& cubes, std::string& error)
+    {
+        cubes.clear();
+        ByteReader reader(payload.data(), payload.size());
+        uint8_t codec = 0;
+        uint64_t cubeCount = 0;
+        uint64_t paletteSize = 0;
+        if (!reader.Byte(codec) || codec != kCodecPaletteRuns)
+        {
+            error = "Unknown chunk codec";
+            return false;
+        }
+        // Every cube and material takes at least one byte, so the counts can't outrun the payload.
+        if (!reader.Varint(cubeCount) || !reader.Varint(paletteSize) || cubeCount > payload.size() * 128 || paletteSize > reader.Remaining())
+        {
+            error = "Corrupt chunk header";
+            return false;
+        }
+
+        std::vector<SceneCube> palette(static_cast<size_t>(paletteSize));
+        for (SceneCube& material : palette)
+        {
+            uint8_t flags = 0;
+            int64_t presetIndex = 0;
+            uint64_t pathLength = 0;
+            if (!reader.Bytes(&material.r, sizeof(float)) || !reader.Bytes(&material.g, sizeof(float)) || !reader.Bytes(&material.b, sizeof(float)) ||
+                !reader.Byte(flags) || !reader.Signed(presetIndex) || !reader.Varint(pathLength) || pathLength > reader.Remaining())
+            {
+                error = "Corrupt chunk palette";
+                return false;
+            }
+            material.glowing = (flags & kFlagGlowing) != 0;
+            material.transparent = (flags & kFlagTransparent) != 0;
+            material.presetIndex = static_cast<int>(presetIndex);
+            material.texturePath.resize(static_cast<size_t>(pathLength));
+            reader.Bytes(material.texturePath.data(), material.texturePath.size());
+        }
+
+        int64_t minY = 0;
+        if (!reader.Signed(minY))
+        {
+            error = "Corrupt chunk header";
+            return false;
+        }
+        cubes.reserve(static_cast<size_t>(cubeCount));
+        for (size_t column = 0; column < kColumnsPerChunk; ++column)
+        {
+            const int x = coord.x * kStreamChunkSize + static_cast<int>(column % kStreamChunkSize);
+            const int z = coord.z * kStreamChunkSize + static_cast<int>(column / kStreamChunkSize);
+            uint64_t runCount = 0;
+            if (!reader.Varint(runCount))
+            {
+                error = "Truncated chunk";
+                return false;
+            }
+            int64_t cursor = minY;
+            for (uint64_t run = 0; run < runCount; ++run)
+            {
+                uint64_t gap = 0;
+                uint64_t length = 0;
+                uint64_t material = 0;
+                if (!reader.Varint(gap) || !reader.Varint(length) || !reader.Varint(material) || material >= palette.size() ||
+                    cubes.size() + length > cubeCount)
+                {
+                    error = "Corrupt chunk runs";
+                    return false;
+                }
+                cursor += static_cast<int64_t>(gap);
+                for (uint64_t i = 0; i < length; ++i)
+                {
+                    SceneCube cube = palette[static_cast<size_t>(material)];
+                    cube.gridX = x;
+                    cube.gridY = static_cast<int>(cursor++);
+                    cube.gridZ = z;
+                    cubes.push_back(std::move(cube));
+                }
+            }
+        }
+        if (cubes.size() != cubeCount)
+        {
+            error = "Chunk cube count mismatch";
+            return false;
+        }
+        return true;
+    }
+
+    RegionChunkStore::RegionChunkStore(std::string directory, size_t maxOpenRegions)
+        : m_directory(std::move(directory)), m_maxOpenRegions(std::max<size_t>(1, maxOpenRegions))
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::u8path(m_directory), ec);
+    }
+
+    std::string RegionChunkStore::PathFor(int regionX, int regionZ) const
+    {
+        return (std::filesystem::u8path(m_directory) / ("r." + std::to_string(regionX) + "." + std::to_string(regionZ) + ".vreg")).u8string();
+    }
+
+    RegionChunkStore::Region* RegionChunkStore::OpenRegion(int regionX, int regionZ, bool create, bool& found, std::string& error)
+    {
+        found = true;
+        const uint64_t key = RegionKey(regionX, regionZ);
+        const auto cached = m_regions.find(key);
+        if (cached != m_regions.end())
+        {
+            cached->second->lastUse = ++m_useCounter;
+            return cached->second.get();
+        }
+
+        auto region = std::make_unique<Region>();
+        region->path = PathFor(regionX, regionZ);
+        std::error_code ec;
+        if (!std::filesystem::exists(std::filesystem::u8path(region->path), ec))
+        {
+            if (!create)
+            {
+                found = false;
+                return nullptr;
+            }
+            std::ofstream created(std::filesystem::u8path(region->path), std::ios::binary | std::ios::trunc);
+            std::string header(kRegionHeaderSectors * kRegionSectorBytes, '\0');
+            std::memcpy(header.data(), kMagic, sizeof(kMagic));
+            PutU32(reinterpret_cast<unsigned char*>(header.data()) + sizeof(kMagic), kVersion);
+            if (!created.write(header.data(), static_cast<std::streamsize>(header.size())))
+            {
+                error = "Unable to create " + region->path;
+                return nullptr;
+            }
+        }
+
+        region->file.open(std::filesystem::u8path(region->path), std::ios::binary | std::ios::in | std::ios::out);
+        std::vector<unsigned char> header(kRegionHeaderSectors * kRegionSectorBytes);
+        if (!region->file || !region->file.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size())))
+        {
+            error = "Unable to read region header of " + region->path;
+            return nullptr;
+        }
+        if (std::memcmp(header.data(), kMagic, sizeof(kMagic)) != 0 || GetU32(header.data() + sizeof(kMagic)) != kVersion)
+        {
+            error = region->path + " is not a version " + std::to_string(kVersion) + " region file";
+            return nullptr;
+        }
+
+        const uint64_t fileSize = static_cast<uint64_t>(std::filesystem::file_size(std::filesystem::u8path(region->path), ec));
+        region->firstSector.resize(kChunksPerRegion);
+        region->byteLength.resize(kChunksPerRegion);
+        region->usedSectors.assign(kRegionHeaderSectors, true);
+        for (size_t i = 0; i < kChunksPerRegion; ++i)
+        {
+            const uint32_t first = GetU32(header.data() + kTableOffset + i * 8);
+            const uint32_t length = GetU32(header.data() + kTableOffset + i * 8 + 4);
+            const uint64_t sectors = (static_cast<uint64_t>(length) + kRegionSectorBytes - 1) / kRegionSectorBytes;
+            // An entry pointing into the header or past the end is treated as never saved.
+            if (first < kRegionHeaderSectors || length == 0 || (first + sectors) * kRegionSectorBytes > fileSize)
+            {
+                continue;
+            }
+            region->firstSector[i] = first;
+            region->byteLength[i] = length;
+            if (region->usedSectors.size() < first + sectors)
+            {
+                region->usedSectors.resize(static_cast<size_t>(first + sectors), false);
+            }
+            std::fill(region->usedSectors.begin() + first, region->usedSectors.begin() + static_cast<std::ptrdiff_t>(first + sectors), true);
+        }
+
+        if (m_regions.size() >= m_maxOpenRegions)
+        {
+            const auto oldest = std::min_element(m_regions.begin(), m_regions.end(),
+                                                 [](const auto& a, const auto& b) { return a.second->lastUse < b.second->lastUse; });
+            m_regions.erase(oldest);
+        }
+        region->lastUse = ++m_useCounter;
+        ++m_stats.regionsOpened;
+        return m_regions.emplace(key, std::move(region)).first->second.get();
+    }
+
+    uint32_t RegionChunkStore::AllocateSectors(Region& region, uint32_t count) const
+    {
+        // First fit; the tail of the file extends the last free run if it reaches the end.
+        size_t runStart = kRegionHeaderSectors;
+        for (size_t sector = kRegionHeaderSectors; sector < region.usedSectors.size(); ++sector)
+        {
+            if (region.usedSectors[sector])
+            {
+                runStart = sector + 1;
+            }
+            else if (sector + 1 - runStart == count)
+            {
+                return static_cast<uint32_t>(runStart);
+            }
+        }
+        return static_cast<uint32_t>(runStart);
+    }
+
+    bool RegionChunkStore::LoadChunk(const ChunkCoord& coord, std::vector<SceneCube>& cubes, bool& found, std::string& error)
+    {
+        cubes.clear();
+        Region* region = OpenRegion(RegionOf(coord.x), RegionOf(coord.z), false, found, error);
+        if (!region)
+        {
+            return !found;
+        }
+        const size_t index = ChunkIndexInRegion(coord);
+        found = region->firstSector[index] != 0;
+        if (!found)
+        {
+            return true;
+        }
+
+        std::string payload(region->byteLength[index], '\0');
+        region->file.clear();
+        region->file.seekg(static_cast<std::streamoff>(region->firstSector[index]) * static_cast<std::streamoff>(kRegionSectorBytes));
+        if (!region->file.read(payload.data(), static_cast<std::streamsize>(payload.size())))
+        {
+            error = "Unable to read chunk (" + std::to_string(coord.x) + ", " + std::to_string(coord.z) + ") from " + region->path;
+            return false;
+        }
+        ++m_stats.chunksRead;
+        m_stats.bytesRead += payload.size();
+        if (!DecodeRegionChunk(coord, payload, cubes, error))
+        {
+            error += " in chunk (" + std::to_string(coord.x) + ", " + std::to_string(coord.z) + ") of " + region->path;
+            return false;
+        }
+        return true;
+    }
+
+    bool RegionChunkStore::SaveChunk(const ChunkCoord& coord, const std::vector<SceneCube>& cubes, std::string& error)
+    {
+        std::string payload;
+        if (!EncodeRegionChunk(coord, cubes, payload, error))
+        {
+            return false;
+        }
+        bool found = false;
+        Region* region = OpenRegion(RegionOf(coord.x), RegionOf(coord.z), true, found, error);
+        if (!region)
+        {
+            return false;
+        }
+
+        // The new copy goes into sectors the old one doesn't use, and the table entry moves only
+        // once it is written.
+        const size_t index = ChunkIndexInRegion(coord);
+        const uint32_t sectors = static_cast<uint32_t>((payload.size() + kRegionSectorBytes - 1) / kRegionSectorBytes);
+        const uint32_t first = AllocateSectors(*region, sectors);
+        const uint32_t length = static_cast<uint32_t>(payload.size());
+        payload.resize(static_cast<size_t>(sectors) * kRegionSectorBytes, '\0');
+        region->file.clear();
+        region->file.seekp(static_cast<std::streamoff>(first) * static_cast<std::streamoff>(kRegionSectorBytes));
+        if (!region->file.write(payload.data(), static_cast<std::streamsize>(payload.size())) || !region->file.flush())
+        {
+            error = "Unable to write chunk (" + std::to_string(coord.x) + ", " + std::to_string(coord.z) + ") to " + region->path;
+            return false;
+        }
+
+        unsigned char entry[8];
+        PutU32(entry, first);
+        PutU32(entry + 4, length);
+        region->file.seekp(static_cast<std::streamoff>(kTableOffset + index * 8));
+        if (!region->file.write(reinterpret_cast<const char*>(entry), sizeof(entry)) || !region->file.flush())
+        {
+            error = "Unable to update the chunk table of " + region->path;
+            return false;
+        }
+
+        if (region->usedSectors.size() < static_cast<size_t>(first) + sectors)
+        {
+            region->usedSectors.resize(static_cast<size_t>(first) + sectors, false);
+        }
+        if (region->firstSector[index] != 0)
+        {
+            const size_t oldSectors = (region->byteLength[index] + kRegionSectorBytes - 1) / kRegionSectorBytes;
+            std::fill_n(region->usedSectors.begin() + region->firstSector[index], oldSectors, false);
+        }
+        std::fill_n(region->usedSectors.begin() + first, sectors, true);
+        region->firstSector[index] = first;
+        region->byteLength[index] = length;
+        ++m_stats.chunksWritten;
+        m_stats.bytesWritten += payload.size() + sizeof(entry);
+        return true;
+    }
+}
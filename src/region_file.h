@@ -0,0 +1,88 @@
+#pragma once
+
+#include "world_stream.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Region files for the streamed world: each file holds a kRegionSize x kRegionSize block of chunks
+// and is named r.<regionX>.<regionZ>.vreg. The layout is
+//
+//   "VREG" <u32 version> then one <u32 first sector, u32 byte length> entry per chunk (z-major),
+//   padded to kRegionHeaderSectors sectors of kRegionSectorBytes; chunk payloads follow, each on
+//   whole sectors. A zero first sector means the chunk was never saved.
+//
+// Every chunk is compressed on its own, so any chunk can be read with one seek and one read, in
+// any order. A save writes the new payload into free sectors and only then repoints the chunk's
+// 8-byte table entry, so a one-cube edit rewrites one chunk and a crash mid-save leaves the
+// previous copy readable. Sectors freed that way are reused by later saves.
+//
+// The payload is a codec byte, a palette of the distinct cube materials (colour, flags, preset,
+// texture path), then each of the chunk's 16x16 columns as runs of (gap, length, palette index)
+// going up from the chunk's lowest cube. A terrain column is a handful of runs; generated terrain
+// tints every column differently, so the palette is most of the payload, and a chunk still packs
+// about five times smaller than in the text format.
+namespace vengine
+{
+    constexpr int kRegionSize = 32;
+    constexpr size_t kRegionSectorBytes = 4096;
+    constexpr size_t kRegionHeaderSectors = 3;
+
+    inline int RegionOf(int chunk)
+    {
+        return chunk >= 0 ? chunk / kRegionSize : -((-chunk + kRegionSize - 1) / kRegionSize);
+    }
+
+    // Cubes outside the chunk's columns are rejected. Two cubes in one cell keep the first.
+    bool EncodeRegionChunk(const ChunkCoord& coord, const std::vector<SceneCube>& cubes, std::string& payload, std::string& error);
+    bool DecodeRegionChunk(const ChunkCoord& coord, const std::string& payload, std::vector<SceneCube>& cubes, std::string& error);
+
+    struct RegionStoreStats
+    {
+        size_t chunksRead = 0;
+        size_t chunksWritten = 0;
+        size_t bytesRead = 0;
+        size_t bytesWritten = 0; // Payload sectors plus table entries.
+        size_t regionsOpened = 0;
+    };
+
+    // A ChunkStore over a directory of region files. Keeps up to maxOpenRegions files open, closing
+    // the least recently used. Not thread-safe; WorldStreamer only calls it from its I/O thread.
+    class RegionChunkStore : public ChunkStore
+    {
+    public:
+        explicit RegionChunkStore(std::string directory, size_t maxOpenRegions = 16);
+
+        bool LoadChunk(const ChunkCoord& coord, std::vector<SceneCube>& cubes, bool& found, std::string& error) override;
+        bool SaveChunk(const ChunkCoord& coord, const std::vector<SceneCube>& cubes, std::string& error) override;
+
+        RegionStoreStats Stats() const { return m_stats; }
+
+    private:
+        struct Region
+        {
+            std::fstream file;
+            std::string path;
+            std::vector<uint32_t> firstSector; // Per chunk; 0 if absent.
+            std::vector<uint32_t> byteLength;
+            std::vector<bool> usedSectors;
+            uint64_t lastUse = 0;
+        };
+
+        std::string PathFor(int regionX, int regionZ) const;
+        // Returns null with found cleared when the file doesn't exist and create is false.
+        Region* OpenRegion(int regionX, int regionZ, bool create, bool& found, std::string& error);
+        uint32_t AllocateSectors(Region& region, uint32_t count) const;
+
+        std::string m_directory;
+        size_t m_maxOpenRegions;
+        std::unordered_map<uint64_t, std::unique_ptr<Region>> m_regions;
+        uint64_t m_useCounter = 0;
+        RegionStoreStats m_stats;
+    };
+}
@@ -0,0 +1,69 @@
+#include "render_queue.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace vengine
+{
+    void RenderQueue::Flush(RenderCommandBackend& backend)
+    {
+        if (m_commands.empty())
+        {
+            return;
+        }
+
+        // Sort indices rather than the commands themselves; a command carries a whole matrix.
+        m_order.resize(m_commands.size());
+        for (size_t i = 0; i < m_order.size(); ++i)
+        {
+            m_order[i] = static_cast<uint32_t>(i);
+        }
+        // Equal keys fall back to the index, which keeps submission order without stable_sort's
+        // per-call scratch buffer.
+        std::sort(m_order.begin(), m_order.end(), [this](uint32_t a, uint32_t b) {
+            const DrawCommand& ca = m_commands[a];
+            const DrawCommand& cb = m_commands[b];
+            return std::make_tuple(ca.blend, ca.program, ca.vertexArray, ca.texture, a) <
+                   std::make_tuple(cb.blend, cb.program, cb.vertexArray, cb.texture, b);
+        });
+
+        bool first = true;
+        BlendMode blend = BlendMode::Opaque;
+        uint32_t program = 0;
+        uint32_t vertexArray = 0;
+        uint32_t texture = 0;
+        for (uint32_t index : m_order)
+        {
+            const DrawCommand& command = m_commands[index];
+            if (first || command.blend != blend)
+            {
+                backend.SetBlendMode(command.blend);
+                blend = command.blend;
+                ++m_stats.blendChanges;
+            }
+            if (first || command.program != program)
+            {
+                backend.BindProgram(command.program);
+                program = command.program;
+                ++m_stats.programBinds;
+            }
+            if (first || command.vertexArray != vertexArray)
+            {
+                backend.BindVertexArray(command.vertexArray);
+                vertexArray = command.vertexArray;
+                ++m_stats.vertexArrayBinds;
+            }
+            if (first || command.texture != texture)
+            {
+                backend.BindTexture(command.texture);
+                texture = command.texture;
+                ++m_stats.textureBinds;
+            }
+            first = false;
+            backend.Draw(command);
+            ++m_stats.draws;
+        }
+        backend.Restore();
+        m_commands.clear();
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A thin draw-command layer. Callers submit DrawCommands during a pass; Flush sorts them by blend
+// mode, then program, vertex array and texture, and replays them through a backend while binding
+// only what actually changed since the previous command. Commands with equal keys keep their
+// submission order, so blended geometry draws in the order it was queued.
+namespace vengine
+{
+    // Also the first sort key: every opaque draw lands before any blended one.
+    enum class BlendMode : uint8_t
+    {
+        Opaque,
+        Alpha,    // Straight alpha, no depth writes.
+        Additive, // src * alpha + dst, no depth writes, no face culling.
+    };
+
+    struct DrawCommand
+    {
+        BlendMode blend = BlendMode::Opaque;
+        uint32_t program = 0;
+        uint32_t vertexArray = 0;
+        uint32_t texture = 0;
+        uint32_t primitive = 0; // GL primitive enum.
+        int32_t first = 0;      // First vertex, or byte offset into the bound index buffer.
+        int32_t count = 0;
+        bool indexed = false;   // 16-bit indices from the vertex array's element buffer.
+        float model[16] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+        float color[3] = {1.0f, 1.0f, 1.0f};
+        float alpha = 1.0f;
+    };
+
+    struct RenderQueueStats
+    {
+        size_t draws = 0;
+        size_t programBinds = 0;
+        size_t vertexArrayBinds = 0;
+        size_t textureBinds = 0;
+        size_t blendChanges = 0;
+
+        size_t StateChanges() const { return programBinds + vertexArrayBinds + textureBinds + blendChanges; }
+    };
+
+    // The GL-flavour-specific half; the GLES3 frontend implements it.
+    class RenderCommandBackend
+    {
+    public:
+        virtual ~RenderCommandBackend() = default;
+        virtual void SetBlendMode(BlendMode mode) = 0;
+        virtual void BindProgram(uint32_t program) = 0;
+        virtual void BindVertexArray(uint32_t vertexArray) = 0;
+        virtual void BindTexture(uint32_t texture) = 0;
+        // Uploads the command's per-draw uniforms to the bound program and issues the draw.
+        virtual void Draw(const DrawCommand& command) = 0;
+        // Puts blending, depth writes and bindings back to the defaults the rest of the frame expects.
+        virtual void Restore() = 0;
+    };
+
+    class RenderQueue
+    {
+    public:
+        // Clears the stats; call once per frame before the first Submit.
+        void BeginFrame() { m_stats = RenderQueueStats{}; }
+
+        void Submit(const DrawCommand& command) { m_commands.push_back(command); }
+
+        // Draws everything submitted since the last flush, then restores the backend's defaults.
+        // Nothing is assumed bound on entry, so GL calls made between flushes are safe.
+        void Flush(RenderCommandBackend& backend);
+
+        // Totals of every flush since BeginFrame.
+        const RenderQueueStats& FrameStats() const { return m_stats; }
+
+    private:
+        std::vector<DrawCommand> m_commands;
+        std::vector<uint32_t> m_order;
+        RenderQueueStats m_stats;
+    };
+}
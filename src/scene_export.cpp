@@ -0,0 +1,744 @@
+#include "scene_export.h"
+#include "byte_codec.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <system_error>
+#include <tuple>
+#include <unordered_map>
+
+namespace vengine
+{
+    namespace
+    {
+        constexpr int kPadded = kExportChunkSize + 2; // The chunk plus a one-cell border from its neighbours.
+        constexpr int kNoCube = -1;
+
+        int FloorDiv(int value, int divisor)
+        {
+            return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+        }
+
+        struct ChunkPos
+        {
+            int x = 0;
+            int y = 0;
+            int z = 0;
+        };
+
+        uint64_t ChunkKey(int x, int y, int z)
+        {
+            constexpr uint64_t kMask = (uint64_t{1} << 21) - 1;
+            return ((static_cast<uint64_t>(x) & kMask) << 42) | ((static_cast<uint64_t>(y) & kMask) << 21) | (static_cast<uint64_t>(z) & kMask);
+        }
+
+        // What splits a material; colour rides on the vertices.
+        struct MaterialClass
+        {
+            bool glowing = false;
+            bool transparent = false;
+            std::string texturePath;
+        };
+
+        // One material's share of a chunk.
+        struct MeshPart
+        {
+            uint32_t material = 0;
+            std::vector<float> positions;
+            std::vector<float> normals;
+            std::vector<float> colors;
+            std::vector<float> uvs;
+            std::vector<uint32_t> indices;
+            std::array<float, 3> min{};
+            std::array<float, 3> max{};
+
+            size_t VertexCount() const { return positions.size() / 3; }
+        };
+
+        // Normals in the order face directions are numbered: +x, -x, +y, -y, +z, -z.
+        constexpr float kNormals[6][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+
+        class MeshWriter
+        {
+        public:
+            virtual ~MeshWriter() = default;
+            virtual bool WriteChunk(const ChunkPos& chunk, const std::vector<MeshPart>& parts, std::string& error) = 0;
+            virtual bool Finish(const std::vector<MaterialClass>& materials, std::string& error) = 0;
+            virtual uint64_t BytesWritten() const = 0;
+        };
+
+        std::string FormatFloat(float value)
+        {
+            char text[32];
+            std::snprintf(text, sizeof(text), "%.6g", static_cast<double>(value));
+            return text;
+        }
+
+        std::string JsonEscape(const std::string& text)
+        {
+            std::string escaped;
+            for (const char c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    escaped.push_back('\\');
+                    escaped.push_back(c);
+                }
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char code[8];
+                    std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(static_cast<unsigned char>(c)));
+                    escaped += code;
+                }
+                else
+                {
+                    // glTF URIs use forward slashes; the editor may have stored Windows separators.
+                    escaped.push_back(c == '\\' ? '/' : c);
+                }
+            }
+            return escaped;
+        }
+
+        class ObjWriter : public MeshWriter
+        {
+        public:
+            bool Open(const std::string& path, std::string& error)
+            {
+                const std::filesystem::path objPath = std::filesystem::u8path(path);
+                m_mtlPath = std::filesystem::path(objPath).replace_extension(".mtl").u8string();
+                m_file.open(objPath, std::ios::binary | std::ios::trunc);
+                if (!m_file)
+                {
+                    error = "Unable to write " + path;
+                    return false;
+                }
+                m_buffer = "# Exported by VEngine: merged cube faces, vertex colours after each position\n";
+                m_buffer += "mtllib " + std::filesystem::u8path(m_mtlPath).filename().u8string() + "\n";
+                for (const auto& normal : kNormals)
+                {
+                    m_buffer += "vn " + FormatFloat(normal[0]) + " " + FormatFloat(normal[1]) + " " + FormatFloat(normal[2]) + "\n";
+                }
+                return Flush(error);
+            }
+
+            bool WriteChunk(const ChunkPos& chunk, const std::vector<MeshPart>& parts, std::string& error) override
+            {
+                m_buffer += "o chunk_" + std::to_string(chunk.x) + "_" + std::to_string(chunk.y) + "_" + std::to_string(chunk.z) + "\n";
+                char line[160];
+                for (const MeshPart& part : parts)
+                {
+                    m_buffer += "usemtl m" + std::to_string(part.material) + "\n";
+                    for (size_t v = 0; v < part.VertexCount(); ++v)
+                    {
+                        const float* p = &part.positions[v * 3];
+                        const float* c = &part.colors[v * 3];
+                        std::snprintf(line, sizeof(line), "v %g %g %g %.4g %.4g %.4g\nvt %g %g\n", static_cast<double>(p[0]), static_cast<double>(p[1]),
+                                      static_cast<double>(p[2]), static_cast<double>(c[0]), static_cast<double>(c[1]), static_cast<double>(c[2]),
+                                      static_cast<double>(part.uvs[v * 2]), static_cast<double>(part.uvs[v * 2 + 1]));
+                        m_buffer += line;
+                    }
+                    for (size_t i = 0; i + 2 < part.indices.size(); i += 3)
+                    {
+                        const size_t a = m_vertexBase + part.indices[i] + 1;
+                        const size_t b = m_vertexBase + part.indices[i + 1] + 1;
+                        const size_t c = m_vertexBase + part.indices[i + 2] + 1;
+                        // Every vertex of a face shares its normal; recover the direction from the first.
+                        const size_t n = NormalIndex(&part.normals[part.indices[i] * 3]) + 1;
+                        std::snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, n, b, b, n, c, c, n);
+                        m_buffer += line;
+                    }
+                    m_vertexBase += part.VertexCount();
+                }
+                return Flush(error);
+            }
+
+            bool Finish(const std::vector<MaterialClass>& materials, std::string& error) override
+            {
+                m_file.close();
+                std::ofstream mtl(std::filesystem::u8path(m_mtlPath), std::ios::binary | std::ios::trunc);
+                std::string text = "# Colours are per vertex in the .obj; these only carry what a vertex colour can't.\n";
+                for (size_t i = 0; i < materials.size(); ++i)
+                {
+                    const MaterialClass& material = materials[i];
+                    text += "\nnewmtl m" + std::to_string(i) + "\nKd 1 1 1\n";
+                    if (material.glowing)
+                    {
+                        const std::string glow = FormatFloat(kExportGlowEmission);
+                        text += "Ke " + glow + " " + glow + " " + glow + "\n";
+                    }
+                    if (material.transparent)
+                    {
+                        text += "d 0.5\n";
+                    }
+                    if (!material.texturePath.empty())
+                    {
+                        text += "map_Kd " + material.texturePath + "\n";
+                    }
+                }
+                if (!mtl.write(text.data(), static_cast<std::streamsize>(text.size())))
+                {
+                    error = "Unable to write " + m_mtlPath;
+                    return false;
+                }
+                m_bytesWritten += text.size();
+                return true;
+            }
+
+            uint64_t BytesWritten() const override { return m_bytesWritten; }
+
+        private:
+            static size_t NormalIndex(const float* normal)
+            {
+                for (size_t i = 0; i < 6; ++i)
+                {
+                    if (normal[0] == kNormals[i][0] && normal[1] == kNormals[i][1] && normal[2] == kNormals[i][2])
+                    {
+                        return i;
+                    }
+                }
+                return 0;
+            }
+
+            bool Flush(std::string& error)
+            {
+                if (!m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size())))
+                {
+                    error = "Write failed";
+                    return false;
+                }
+                m_bytesWritten += m_buffer.size();
+                m_buffer.clear();
+                return true;
+            }
+
+            std::ofstream m_file;
+            std::string m_mtlPath;
+            std::string m_buffer;
+            size_t m_vertexBase = 0;
+            uint64_t m_bytesWritten = 0;
+        };
+
+        class GlbWriter : public MeshWriter
+        {
+        public:
+            ~GlbWriter() override
+            {
+                if (m_spool.is_open())
+                {
+                    m_spool.close();
+                }
+                std::error_code ec;
+                std::filesystem::remove(std::filesystem::u8path(m_spoolPath), ec);
+            }
+
+            bool Open(const std::string& path, std::string& error)
+            {
+                m_path = path;
+                m_spoolPath = path + ".bin.tmp";
+                m_spool.open(std::filesystem::u8path(m_spoolPath), std::ios::binary | std::ios::trunc);
+                if (!m_spool)
+                {
+                    error = "Unable to write " + m_spoolPath;
+                    return false;
+                }
+                return true;
+            }
+
+            bool WriteChunk(const ChunkPos& chunk, const std::vector<MeshPart>& parts, std::string& error) override
+            {
+                std::string primitives;
+                for (const MeshPart& part : parts)
+                {
+                    const size_t vertexCount = part.VertexCount();
+                    const size_t position = AddAccessor(part.positions.data(), part.positions.size() * sizeof(float), vertexCount, "VEC3", 5126, 34962,
+                                                        ",\"min\":[" + FormatFloat(part.min[0]) + "," + FormatFloat(part.min[1]) + "," + FormatFloat(part.min[2]) +
+                                                            "],\"max\":[" + FormatFloat(part.max[0]) + "," + FormatFloat(part.max[1]) + "," +
+                                                            FormatFloat(part.max[2]) + "]");
+                    const size_t normal = AddAccessor(part.normals.data(), part.normals.size() * sizeof(float), vertexCount, "VEC3", 5126, 34962, "");
+                    const size_t color = AddAccessor(part.colors.data(), part.colors.size() * sizeof(float), vertexCount, "VEC3", 5126, 34962, "");
+                    const size_t uv = AddAccessor(part.uvs.data(), part.uvs.size() * sizeof(float), vertexCount, "VEC2", 5126, 34962, "");
+                    const size_t index = AddAccessor(part.indices.data(), part.indices.size() * sizeof(uint32_t), part.indices.size(), "SCALAR", 5125, 34963, "");
+                    if (!primitives.empty())
+                    {
+                        primitives += ",";
+                    }
+                    primitives += "{\"attributes\":{\"POSITION\":" + std::to_string(position) + ",\"NORMAL\":" + std::to_string(normal) +
+                                  ",\"COLOR_0\":" + std::to_string(color) + ",\"TEXCOORD_0\":" + std::to_string(uv) + "},\"indices\":" + std::to_string(index) +
+                                  ",\"material\":" + std::to_string(part.material) + "}";
+                }
+                if (!m_spool)
+                {
+                    error = "Unable to write " + m_spoolPath;
+                    return false;
+                }
+                Append(m_meshes, "{\"primitives\":[" + primitives + "]}");
+                Append(m_nodes, "{\"name\":\"chunk_" + std::to_string(chunk.x) + "_" + std::to_string(chunk.y) + "_" + std::to_string(chunk.z) +
+                                    "\",\"mesh\":" + std::to_string(m_meshCount++) + "}");
+                return true;
+            }
+
+            bool Finish(const std::vector<MaterialClass>& materials, std::string& error) override
+            {
+                m_spool.close();
+                std::string materialJson;
+                std::string textureJson;
+                std::string imageJson;
+                size_t textureCount = 0;
+                for (const MaterialClass& material : materials)
+                {
+                    std::string entry = "{\"pbrMetallicRoughness\":{\"baseColorFactor\":[1,1,1," + std::string(material.transparent ? "0.5" : "1") + "]";
+                    if (!material.texturePath.empty())
+                    {
+                        entry += ",\"baseColorTexture\":{\"index\":" + std::to_string(textureCount++) + "}";
+                        Append(imageJson, "{\"uri\":\"" + JsonEscape(material.texturePath) + "\"}");
+                        Append(textureJson, "{\"sampler\":0,\"source\":" + std::to_string(textureCount - 1) + "}");
+                    }
+                    entry += ",\"metallicFactor\":0,\"roughnessFactor\":1}";
+                    if (material.glowing)
+                    {
+                        const std::string glow = FormatFloat(kExportGlowEmission);
+                        entry += ",\"emissiveFactor\":[" + glow + "," + glow + "," + glow + "]";
+                    }
+                    if (material.transparent)
+                    {
+                        entry += ",\"alphaMode\":\"BLEND\"";
+                    }
+                    Append(materialJson, entry + "}");
+                }
+
+                std::string sceneNodes;
+                for (size_t i = 0; i < m_meshCount; ++i)
+                {
+                    Append(sceneNodes, std::to_string(i));
+                }
+                std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"VEngine scene export\"},\"scene\":0,\"scenes\":[{\"nodes\":[" + sceneNodes +
+                                   "]}],\"nodes\":[" + m_nodes + "],\"meshes\":[" + m_meshes + "],\"materials\":[" + materialJson + "]";
+                if (textureCount > 0)
+                {
+                    // Textures tile once per cell, so the sampler repeats.
+                    json += ",\"samplers\":[{\"magFilter\":9728,\"minFilter\":9987,\"wrapS\":10497,\"wrapT\":10497}],\"textures\":[" + textureJson +
+                            "],\"images\":[" + imageJson + "]";
+                }
+                json += ",\"accessors\":[" + m_accessors + "],\"bufferViews\":[" + m_bufferViews + "],\"buffers\":[{\"byteLength\":" +
+                        std::to_string(m_binBytes) + "}]}";
+                json.append((4 - json.size() % 4) % 4, ' ');
+                const uint64_t binPadded = (m_binBytes + 3) / 4 * 4;
+
+                // Checked before the output is opened, so a scene that doesn't fit leaves any earlier export intact.
+                const uint64_t total = 12 + 8 + json.size() + 8 + binPadded;
+                if (total > UINT32_MAX)
+                {
+                    error = "Scene is too large for a single GLB file";
+                    return false;
+                }
+                std::ofstream out(std::filesystem::u8path(m_path), std::ios::binary | std::ios::trunc);
+                unsigned char header[12];
+                PutU32(header, 0x46546C67u); // "glTF"
+                PutU32(header + 4, 2);
+                PutU32(header + 8, static_cast<uint32_t>(total));
+                unsigned char jsonHeader[8];
+                PutU32(jsonHeader, static_cast<uint32_t>(json.size()));
+                PutU32(jsonHeader + 4, 0x4E4F534Au); // "JSON"
+                unsigned char binHeader[8];
+                PutU32(binHeader, static_cast<uint32_t>(binPadded));
+                PutU32(binHeader + 4, 0x004E4942u); // "BIN\0"
+                out.write(reinterpret_cast<const char*>(header), sizeof(header));
+                out.write(reinterpret_cast<const char*>(jsonHeader), sizeof(jsonHeader));
+                out.write(json.data(), static_cast<std::streamsize>(json.size()));
+                out.write(reinterpret_cast<const char*>(binHeader), sizeof(binHeader));
+
+                std::ifstream spool(std::filesystem::u8path(m_spoolPath), std::ios::binary);
+                std::vector<char> block(size_t{1} << 20);
+                while (spool)
+                {
+                    spool.read(block.data(), static_cast<std::streamsize>(block.size()));
+                    out.write(block.data(), spool.gcount());
+                }
+                out.write("\0\0\0", static_cast<std::streamsize>(binPadded - m_binBytes));
+                if (!out)
+                {
+                    error = "Unable to write " + m_path;
+                    return false;
+                }
+                m_bytesWritten = total;
+                return true;
+            }
+
+            uint64_t BytesWritten() const override { return m_bytesWritten; }
+
+        private:
+            static void Append(std::string& list, const std::string& item)
+            {
+                if (!list.empty())
+                {
+                    list += ",";
+                }
+                list += item;
+            }
+
+            // Spools the data and adds a bufferView and accessor for it; returns the accessor index.
+            size_t AddAccessor(const void* data, size_t bytes, size_t count, const char* type, int componentType, int target, const std::string& extra)
+            {
+                m_spool.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+                Append(m_bufferViews, "{\"buffer\":0,\"byteOffset\":" + std::to_string(m_binBytes) + ",\"byteLength\":" + std::to_string(bytes) +
+                                          ",\"target\":" + std::to_string(target) + "}");
+                Append(m_accessors, "{\"bufferView\":" + std::to_string(m_accessorCount) + ",\"componentType\":" + std::to_string(componentType) +
+                                        ",\"count\":" + std::to_string(count) + ",\"type\":\"" + type + "\"" + extra + "}");
+                m_binBytes += bytes;
+                return m_accessorCount++;
+            }
+
+            std::string m_path;
+            std::string m_spoolPath;
+            std::ofstream m_spool;
+            uint64_t m_binBytes = 0;
+            size_t m_accessorCount = 0;
+            size_t m_meshCount = 0;
+            std::string m_accessors;
+            std::string m_bufferViews;
+            std::string m_meshes;
+            std::string m_nodes;
+            uint64_t m_bytesWritten = 0;
+        };
+
+        bool SameLook(const SceneCube& a, const SceneCube& b)
+        {
+            return a.r == b.r && a.g == b.g && a.b == b.b && a.glowing == b.glowing && a.transparent == b.transparent && a.texturePath == b.texturePath;
+        }
+
+        size_t PaddedIndex(int x, int y, int z)
+        {
+            return static_cast<size_t>((x + 1) + kPadded * ((y + 1) + kPadded * (z + 1)));
+        }
+
+        class ChunkMesher
+        {
+        public:
+            explicit ChunkMesher(const std::vector<SceneCube>& cubes) : m_cubes(cubes), m_grid(static_cast<size_t>(kPadded) * kPadded * kPadded, kNoCube) {}
+
+            std::vector<MaterialClass> materials;
+
+            // Fills the padded grid from the chunk's cubes and its six neighbours' touching layers.
+            void Fill(const ChunkPos& chunk, const std::unordered_map<uint64_t, std::vector<uint32_t>>& buckets)
+            {
+                std::fill(m_grid.begin(), m_grid.end(), kNoCube);
+                m_origin = {chunk.x * kExportChunkSize, chunk.y * kExportChunkSize, chunk.z * kExportChunkSize};
+                const int offsets[7][3] = {{0, 0, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+                for (const auto& offset : offsets)
+                {
+                    const auto found = buckets.find(ChunkKey(chunk.x + offset[0], chunk.y + offset[1], chunk.z + offset[2]));
+                    if (found == buckets.end())
+                    {
+                        continue;
+                    }
+                    for (const uint32_t index : found->second)
+                    {
+                        const SceneCube& cube = m_cubes[index];
+                        const int x = cube.gridX - m_origin[0];
+                        const int y = cube.gridY - m_origin[1];
+                        const int z = cube.gridZ - m_origin[2];
+                        if (x < -1 || x > kExportChunkSize || y < -1 || y > kExportChunkSize || z < -1 || z > kExportChunkSize)
+                        {
+                            continue;
+                        }
+                        int& slot = m_grid[PaddedIndex(x, y, z)];
+                        // Two cubes in one cell: the first one in the scene wins.
+                        slot = slot == kNoCube ? static_cast<int>(index) : std::min(slot, static_cast<int>(index));
+                    }
+                }
+            }
+
+            // Greedy-meshes the chunk into parts, one per material; returns the unit faces kept.
+            size_t Mesh(std::vector<MeshPart>& parts)
+            {
+                parts.clear();
+                size_t visibleFaces = 0;
+                std::array<int, kExportChunkSize * kExportChunkSize> mask{};
+                for (int direction = 0; direction < 6; ++direction)
+                {
+                    const int d = direction / 2;
+                    const int sign = direction % 2 == 0 ? 1 : -1;
+                    const int u = (d + 1) % 3;
+                    const int v = (d + 2) % 3;
+                    for (int slice = 0; slice < kExportChunkSize; ++slice)
+                    {
+                        for (int j = 0; j < kExportChunkSize; ++j)
+                        {
+                            for (int i = 0; i < kExportChunkSize; ++i)
+                            {
+                                int cell[3];
+                                cell[d] = slice;
+                                cell[u] = i;
+                                cell[v] = j;
+                                const int self = m_grid[PaddedIndex(cell[0], cell[1], cell[2])];
+                                int& entry = mask[static_cast<size_t>(j * kExportChunkSize + i)];
+                                entry = kNoCube;
+                                if (self == kNoCube)
+                                {
+                                    continue;
+                                }
+                                cell[d] += sign;
+                                const int other = m_grid[PaddedIndex(cell[0], cell[1], cell[2])];
+                                // A glass neighbour hides glass but not the solid faces behind it.
+                                if (other == kNoCube || (m_cubes[static_cast<size_t>(other)].transparent && !m_cubes[static_cast<size_t>(self)].transparent))
+                                {
+                                    entry = self;
+                                    ++visibleFaces;
+                                }
+                            }
+                        }
+                        EmitSlice(mask, direction, slice, parts);
+                    }
+                }
+                return visibleFaces;
+            }
+
+        private:
+            void EmitSlice(std::array<int, kExportChunkSize * kExportChunkSize>& mask, int direction, int slice, std::vector<MeshPart>& parts)
+            {
+                for (int j = 0; j < kExportChunkSize; ++j)
+                {
+                    for (int i = 0; i < kExportChunkSize;)
+                    {
+                        const int first = mask[static_cast<size_t>(j * kExportChunkSize + i)];
+                        if (first == kNoCube)
+                        {
+                            ++i;
+                            continue;
+                        }
+                        const SceneCube& look = m_cubes[static_cast<size_t>(first)];
+                        const auto matches = [&](int at) {
+                            const int other = mask[static_cast<size_t>(at)];
+                            return other != kNoCube && (other == first || SameLook(m_cubes[static_cast<size_t>(other)], look));
+                        };
+                        int width = 1;
+                        while (i + width < kExportChunkSize && matches(j * kExportChunkSize + i + width))
+                        {
+                            ++width;
+                        }
+                        int height = 1;
+                        for (bool grow = true; grow && j + height < kExportChunkSize; height += grow ? 1 : 0)
+                        {
+                            for (int k = 0; k < width && grow; ++k)
+                            {
+                                grow = matches((j + height) * kExportChunkSize + i + k);
+                            }
+                        }
+                        for (int h = 0; h < height; ++h)
+                        {
+                            std::fill_n(mask.begin() + (j + h) * kExportChunkSize + i, width, kNoCube);
+                        }
+                        AddQuad(look, direction, slice, i, j, width, height, parts);
+                        i += width;
+                    }
+                }
+            }
+
+            MeshPart& PartFor(const SceneCube& cube, std::vector<MeshPart>& parts)
+            {
+                uint32_t material = 0;
+                while (material < materials.size() && !(materials[material].glowing == cube.glowing && materials[material].transparent == cube.transparent &&
+                                                         materials[material].texturePath == cube.texturePath))
+                {
+                    ++material;
+                }
+                if (material == materials.size())
+                {
+                    materials.push_back(MaterialClass{cube.glowing, cube.transparent, cube.texturePath});
+                }
+                for (MeshPart& part : parts)
+                {
+                    if (part.material == material)
+                    {
+                        return part;
+                    }
+                }
+                parts.emplace_back();
+                parts.back().material = material;
+                parts.back().min = {1e30f, 1e30f, 1e30f};
+                parts.back().max = {-1e30f, -1e30f, -1e30f};
+                return parts.back();
+            }
+
+            void AddQuad(const SceneCube& cube, int direction, int slice, int i, int j, int width, int height, std::vector<MeshPart>& parts)
+            {
+                MeshPart& part = PartFor(cube, parts);
+                const int d = direction / 2;
+                const bool positive = direction % 2 == 0;
+                const int u = (d + 1) % 3;
+                const int v = (d + 2) % 3;
+                // Cubes are centred on their grid coordinates, so a cell spans +-0.5 around it.
+                const float plane = static_cast<float>(m_origin[d] + slice) + (positive ? 0.5f : -0.5f);
+                const float u0 = static_cast<float>(m_origin[u] + i) - 0.5f;
+                const float v0 = static_cast<float>(m_origin[v] + j) - 0.5f;
+                const float w = static_cast<float>(width);
+                const float h = static_cast<float>(height);
+                // Counter-clockwise seen from the side the normal points to.
+                const float corners[4][2] = {{0, 0}, {w, 0}, {w, h}, {0, h}};
+                const int order[2][4] = {{0, 1, 2, 3}, {0, 3, 2, 1}};
+                const uint32_t base = static_cast<uint32_t>(part.VertexCount());
+                for (const int corner : order[positive ? 0 : 1])
+                {
+                    float position[3];
+                    position[d] = plane;
+                    position[u] = u0 + corners[corner][0];
+                    position[v] = v0 + corners[corner][1];
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                        part.positions.push_back(position[axis]);
+                        part.normals.push_back(kNormals[direction][axis]);
+                        part.min[static_cast<size_t>(axis)] = std::min(part.min[static_cast<size_t>(axis)], position[axis]);
+                        part.max[static_cast<size_t>(axis)] = std::max(part.max[static_cast<size_t>(axis)], position[axis]);
+                    }
+                    part.colors.insert(part.colors.end(), {cube.r, cube.g, cube.b});
+                    part.uvs.insert(part.uvs.end(), {corners[corner][0], corners[corner][1]});
+                }
+                part.indices.insert(part.indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+            }
+
+            const std::vector<SceneCube>& m_cubes;
+            std::vector<int> m_grid;
+            std::array<int, 3> m_origin{};
+        };
+    }
+
+    SceneExportFormat SceneExportFormatForPath(const std::string& path)
+    {
+        std::string extension = std::filesystem::path(path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return extension == ".glb" ? SceneExportFormat::Glb : SceneExportFormat::Obj;
+    }
+
+    bool ExportScene(const std::vector<SceneCube>& cubes, const std::string& path, SceneExportFormat format, SceneExportStats& stats,
+                     std::string& error, SceneExportProgress* progress)
+    {
+        stats = SceneExportStats{};
+        stats.cubes = cubes.size();
+
+        // Bucket the scene by chunk: four bytes per cube, and the only whole-scene structure.
+        std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+        std::vector<ChunkPos> chunks;
+        for (size_t i = 0; i < cubes.size(); ++i)
+        {
+            const SceneCube& cube = cubes[i];
+            const ChunkPos chunk{FloorDiv(cube.gridX, kExportChunkSize), FloorDiv(cube.gridY, kExportChunkSize), FloorDiv(cube.gridZ, kExportChunkSize)};
+            std::vector<uint32_t>& bucket = buckets[ChunkKey(chunk.x, chunk.y, chunk.z)];
+            if (bucket.empty())
+            {
+                chunks.push_back(chunk);
+            }
+            bucket.push_back(static_cast<uint32_t>(i));
+        }
+        std::sort(chunks.begin(), chunks.end(), [](const ChunkPos& a, const ChunkPos& b) { return std::tie(a.z, a.x, a.y) < std::tie(b.z, b.x, b.y); });
+        stats.chunks = chunks.size();
+        if (progress)
+        {
+            progress->chunkCount = chunks.size();
+            progress->chunksDone = 0;
+        }
+
+        std::unique_ptr<MeshWriter> writer;
+        if (format == SceneExportFormat::Glb)
+        {
+            auto glb = std::make_unique<GlbWriter>();
+            if (!glb->Open(path, error))
+            {
+                return false;
+            }
+            writer = std::move(glb);
+        }
+        else
+        {
+            auto obj = std::make_unique<ObjWriter>();
+            if (!obj->Open(path, error))
+            {
+                return false;
+            }
+            writer = std::move(obj);
+        }
+
+        ChunkMesher mesher(cubes);
+        std::vector<MeshPart> parts;
+        for (const ChunkPos& chunk : chunks)
+        {
+            if (progress && progress->cancel.load())
+            {
+                error = "Cancelled";
+                return false;
+            }
+            mesher.Fill(chunk, buckets);
+            stats.visibleFaces += mesher.Mesh(parts);
+            for (const MeshPart& part : parts)
+            {
+                stats.quads += part.indices.size() / 6;
+            }
+            if (!parts.empty() && !writer->WriteChunk(chunk, parts, error))
+            {
+                return false;
+            }
+            if (progress)
+            {
+                ++progress->chunksDone;
+            }
+        }
+        stats.materials = mesher.materials.size();
+        if (!writer->Finish(mesher.materials, error))
+        {
+            return false;
+        }
+        stats.bytesWritten = writer->BytesWritten();
+        return true;
+    }
+
+    SceneExporter::~SceneExporter()
+    {
+        Cancel();
+    }
+
+    void SceneExporter::Start(std::vector<SceneCube> cubes, const std::string& path)
+    {
+        Cancel();
+        m_progress.cancel = false;
+        m_progress.chunksDone = 0;
+        m_progress.chunkCount = 0;
+        m_done = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_status = "Exporting " + path;
+        }
+        m_thread = std::thread([this, cubes = std::move(cubes), path] {
+            SceneExportStats stats;
+            std::string error;
+            const bool ok = ExportScene(cubes, path, SceneExportFormatForPath(path), stats, error, &m_progress);
+            char summary[160];
+            std::snprintf(summary, sizeof(summary), ": %zu cubes -> %zu quads, %.1f MB", stats.cubes, stats.quads,
+                          static_cast<double>(stats.bytesWritten) / (1024.0 * 1024.0));
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_status = ok ? "Wrote " + path + summary : "Export failed: " + error;
+            }
+            m_done = true;
+        });
+    }
+
+    void SceneExporter::Cancel()
+    {
+        if (m_thread.joinable())
+        {
+            m_progress.cancel = true;
+            m_thread.join();
+        }
+    }
+
+    void SceneExporter::Status(std::string& status) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        status = m_status;
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "scene_file.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Exports a cube scene as merged meshes, to Wavefront OBJ (with a .mtl beside it) or binary glTF.
+// The scene is walked one 16x16x16 chunk at a time. Each chunk is greedy-meshed: faces hidden by a
+// neighbouring cube are dropped (a glass neighbour hides only other glass), then coplanar faces of
+// the same colour and material are merged into rectangles. Each chunk's geometry is written out
+// before the next chunk is meshed. Memory is the scene, a per-cube chunk index and one chunk's
+// mesh. The glTF binary chunk is spooled through a temporary file next to the output, because GLB
+// puts the JSON (which needs every accessor's size) first.
+//
+// Colours travel as vertex colours. Materials split only on what a vertex colour can't carry:
+// glowing (emissive), transparent (alpha blended) and the texture, which tiles once per cell.
+// glTF has no per-vertex emission, so glow materials emit white scaled by kExportGlowEmission.
+namespace vengine
+{
+    constexpr int kExportChunkSize = 16;
+    constexpr float kExportGlowEmission = 0.6f;
+
+    enum class SceneExportFormat
+    {
+        Obj,
+        Glb,
+    };
+
+    // .glb selects binary glTF; anything else is written as OBJ.
+    SceneExportFormat SceneExportFormatForPath(const std::string& path);
+
+    struct SceneExportStats
+    {
+        size_t cubes = 0;
+        size_t chunks = 0;
+        size_t visibleFaces = 0; // Unit faces that survived culling.
+        size_t quads = 0;        // After merging.
+        size_t materials = 0;
+        uint64_t bytesWritten = 0;
+    };
+
+    struct SceneExportProgress
+    {
+        std::atomic<size_t> chunksDone{0};
+        std::atomic<size_t> chunkCount{0};
+        std::atomic<bool> cancel{false};
+    };
+
+    // Writes the scene to path. progress, when given, is updated as chunks are written and is
+    // polled for cancellation. texturePaths are written as stored, relative to wherever the
+    // editor resolves them.
+    bool ExportScene(const std::vector<SceneCube>& cubes, const std::string& path, SceneExportFormat format, SceneExportStats& stats,
+                     std::string& error, SceneExportProgress* progress = nullptr);
+
+    // Runs ExportScene on a worker thread over a snapshot of the scene.
+    class SceneExporter
+    {
+    public:
+        SceneExporter() = default;
+        ~SceneExporter();
+        SceneExporter(const SceneExporter&) = delete;
+        SceneExporter& operator=(const SceneExporter&) = delete;
+
+        // Cancels any export in progress and starts a new one.
+        void Start(std::vector<SceneCube> cubes, const std::string& path);
+        void Cancel();
+
+        bool Running() const { return m_thread.joinable() && !m_done.load(); }
+        // Chunks written and the total, for a progress bar.
+        size_t ChunksDone() const { return m_progress.chunksDone.load(); }
+        size_t ChunkCount() const { return m_progress.chunkCount.load(); }
+        // The last finished export's outcome; a human-readable line for the editor. Copied into
+        // the caller's string so a UI polling it every frame reuses one buffer.
+        void Status(std::string& status) const;
+
+    private:
+        std::thread m_thread;
+        SceneExportProgress m_progress;
+        std::atomic<bool> m_done{false};
+        mutable std::mutex m_mutex;
+        std::string m_status;
+    };
+}
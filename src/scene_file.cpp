@@ -0,0 +1,145 @@
+#include "scene_file.h"
+#include "cube_store.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <sstream>
+
+namespace vengine
+{
+    namespace
+    {
+        constexpr size_t kCountFieldWidth = 20; // Fits any size_t.
+
+        void WriteCubeLine(std::ostream& file, const SceneCube& cube)
+        {
+            file << cube.gridX << ' '
+                 << cube.gridY << ' '
+                 << cube.gridZ << ' '
+                 << cube.r << ' '
+                 << cube.g << ' '
+                 << cube.b << ' '
+                 << (cube.glowing ? 1 : 0) << ' '
+                 << (cube.transparent ? 1 : 0) << ' '
+                 << cube.presetIndex << ' '
+                 << std::quoted(cube.texturePath) << '\n';
+        }
+    }
+
+    bool ParseScene(const std::string& text, std::vector<SceneCube>& cubes, std::string& errorMessage)
+    {
+        cubes.clear();
+        std::istringstream file(text);
+        std::string header;
+        int version = 0;
+        file >> header >> version;
+        if (header != "VENGINE_SCENE" || version != 1)
+        {
+            errorMessage = "Not a VENGINE_SCENE 1 file";
+            return false;
+        }
+
+        size_t cubeCount = 0;
+        file >> cubeCount;
+        file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        // The count comes from the file; do not let a corrupt one reserve gigabytes up front.
+        cubes.reserve(std::min<size_t>(cubeCount, text.size() / 16 + 1));
+
+        for (size_t i = 0; i < cubeCount; ++i)
+        {
+            std::string line;
+            if (!std::getline(file, line))
+            {
+                break;
+            }
+            if (line.empty())
+            {
+                continue;
+            }
+
+            std::istringstream iss(line);
+            SceneCube cube;
+            int glowing = 0;
+            int transparent = 0;
+            iss >> cube.gridX >> cube.gridY >> cube.gridZ >> cube.r >> cube.g >> cube.b >> glowing >> transparent >> cube.presetIndex;
+            // Cells the editor's cube store cannot hold are skipped like malformed lines.
+            if (!iss || !CubeCellInRange(cube.gridX, cube.gridY, cube.gridZ))
+            {
+                continue;
+            }
+            cube.glowing = glowing != 0;
+            cube.transparent = transparent != 0;
+            if (!(iss >> std::quoted(cube.texturePath)))
+            {
+                cube.texturePath.clear();
+            }
+            cubes.push_back(std::move(cube));
+        }
+        return true;
+    }
+
+    bool LoadSceneFile(const std::string& path, std::vector<SceneCube>& cubes, std::string& errorMessage)
+    {
+        std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+        if (!file)
+        {
+            cubes.clear();
+            errorMessage = "Unable to open " + path;
+            return false;
+        }
+        const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return ParseScene(text, cubes, errorMessage);
+    }
+
+    std::string SerializeScene(const std::vector<SceneCube>& cubes)
+    {
+        std::ostringstream file;
+        file << "VENGINE_SCENE 1\n";
+        file << cubes.size() << '\n';
+        for (const SceneCube& cube : cubes)
+        {
+            WriteCubeLine(file, cube);
+        }
+        return file.str();
+    }
+
+    bool SceneFileWriter::Open(const std::string& path, std::string& errorMessage)
+    {
+        m_file.open(std::filesystem::u8path(path), std::ios::binary | std::ios::trunc);
+        if (!m_file)
+        {
+            errorMessage = "Unable to write " + path;
+            return false;
+        }
+        m_count = 0;
+        m_file << "VENGINE_SCENE 1\n";
+        m_countPosition = m_file.tellp();
+        // ParseScene reads the count and skips the rest of the line, so trailing padding is fine.
+        m_file << std::string(kCountFieldWidth, ' ') << '\n';
+        return true;
+    }
+
+    void SceneFileWriter::Write(const SceneCube& cube)
+    {
+        WriteCubeLine(m_file, cube);
+        ++m_count;
+    }
+
+    bool SceneFileWriter::Close(std::string& errorMessage)
+    {
+        const std::string count = std::to_string(m_count);
+        m_file.seekp(m_countPosition);
+        m_file.write(count.data(), static_cast<std::streamsize>(count.size()));
+        m_file.close();
+        if (m_file.fail())
+        {
+            errorMessage = "Failed to finish the scene file";
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Reader and writer for the editor's text scene format:
+//
+//   VENGINE_SCENE 1
+//   <cube count>
+//   <x> <y> <z> <r> <g> <b> <glowing 0|1> <transparent 0|1> <preset index> "<texture path>"
+//
+// one cube per line. Texture paths are stored as written by the editor and are not resolved here;
+// the frontends turn them into texture handles.
+namespace vengine
+{
+    struct SceneCube
+    {
+        int gridX = 0;
+        int gridY = 0;
+        int gridZ = 0;
+        float r = 1.0f;
+        float g = 1.0f;
+        float b = 1.0f;
+        bool glowing = false;
+        bool transparent = false;
+        int presetIndex = -1;
+        std::string texturePath;
+    };
+
+    // Lines that fail to parse are skipped, as the editor always has. Fails only on a bad header.
+    bool ParseScene(const std::string& text, std::vector<SceneCube>& cubes, std::string& errorMessage);
+    bool LoadSceneFile(const std::string& path, std::vector<SceneCube>& cubes, std::string& errorMessage);
+
+    std::string SerializeScene(const std::vector<SceneCube>& cubes);
+
+    // Writes a scene one cube at a time, for scenes too large to hold in memory. The header's cube
+    // count is a fixed-width placeholder that Close fills in.
+    class SceneFileWriter
+    {
+    public:
+        bool Open(const std::string& path, std::string& errorMessage);
+        void Write(const SceneCube& cube);
+        bool Close(std::string& errorMessage);
+
+        size_t CubeCount() const { return m_count; }
+
+    private:
+        std::ofstream m_file;
+        std::streampos m_countPosition = 0;
+        size_t m_count = 0;
+    };
+}
@@ -0,0 +1,440 @@
+#include "scene_loader.h"
+#include "cube_store.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+namespace vengine
+{
+    namespace
+    {
+        // About 25k cubes; big enough to keep the stage hand-offs cheap, small enough that the
+        // first cubes reach the caller early and every core gets work on a large scene.
+        constexpr size_t kBlockBytes = size_t{1} << 20;
+        // Blocks each stage queue holds before the stage in front of it waits.
+        constexpr size_t kQueueDepth = 4;
+
+        bool IsLineSpace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+        }
+
+        // Field readers for one line: each skips blanks first and fails at the end of the line,
+        // which is what extraction from a line-sized stream does.
+        class LineReader
+        {
+        public:
+            LineReader(const char* begin, const char* end) : m_cursor(begin), m_end(end) {}
+
+            bool Int(int& value)
+            {
+                if (!SkipBlanks())
+                {
+                    return false;
+                }
+                char* parsed = nullptr;
+                errno = 0;
+                const long result = std::strtol(m_cursor, &parsed, 10);
+                if (parsed == m_cursor || parsed > m_end || errno == ERANGE || result < INT32_MIN || result > INT32_MAX)
+                {
+                    return false;
+                }
+                value = static_cast<int>(result);
+                m_cursor = parsed;
+                return true;
+            }
+
+            bool Float(float& value)
+            {
+                if (!SkipBlanks())
+                {
+                    return false;
+                }
+                char* parsed = nullptr;
+                const float result = std::strtof(m_cursor, &parsed);
+                if (parsed == m_cursor || parsed > m_end)
+                {
+                    return false;
+                }
+                value = result;
+                m_cursor = parsed;
+                return true;
+            }
+
+            // Like std::quoted: a quoted string with backslash escapes, or else one bare word.
+            bool Quoted(std::string& value)
+            {
+                value.clear();
+                if (!SkipBlanks())
+                {
+                    return false;
+                }
+                if (*m_cursor != '"')
+                {
+                    const char* start = m_cursor;
+                    while (m_cursor < m_end && !IsLineSpace(*m_cursor))
+                    {
+                        ++m_cursor;
+                    }
+                    value.assign(start, m_cursor);
+                    return true;
+                }
+                ++m_cursor;
+                while (m_cursor < m_end && *m_cursor != '"')
+                {
+                    if (*m_cursor == '\\' && m_cursor + 1 < m_end)
+                    {
+                        ++m_cursor;
+                    }
+                    value.push_back(*m_cursor++);
+                }
+                return true;
+            }
+
+        private:
+            bool SkipBlanks()
+            {
+                while (m_cursor < m_end && IsLineSpace(*m_cursor))
+                {
+                    ++m_cursor;
+                }
+                return m_cursor < m_end;
+            }
+
+            const char* m_cursor;
+            const char* m_end;
+        };
+
+        // Reads one whitespace-separated token from text at offset, as operator>> would.
+        std::string NextToken(const std::string& text, size_t& offset)
+        {
+            while (offset < text.size() && std::isspace(static_cast<unsigned char>(text[offset])))
+            {
+                ++offset;
+            }
+            const size_t start = offset;
+            while (offset < text.size() && !std::isspace(static_cast<unsigned char>(text[offset])))
+            {
+                ++offset;
+            }
+            return text.substr(start, offset - start);
+        }
+    }
+
+    void ParseSceneLines(const char* begin, const char* end, std::vector<SceneCube>& cubes)
+    {
+        const char* line = begin;
+        while (line < end)
+        {
+            const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+            if (!lineEnd)
+            {
+                lineEnd = end;
+            }
+            LineReader reader(line, lineEnd);
+            SceneCube cube;
+            int glowing = 0;
+            int transparent = 0;
+            // Cells the editor's cube store cannot hold are skipped like malformed lines.
+            if (reader.Int(cube.gridX) && reader.Int(cube.gridY) && reader.Int(cube.gridZ) && reader.Float(cube.r) && reader.Float(cube.g) &&
+                reader.Float(cube.b) && reader.Int(glowing) && reader.Int(transparent) && reader.Int(cube.presetIndex) &&
+                CubeCellInRange(cube.gridX, cube.gridY, cube.gridZ))
+            {
+                cube.glowing = glowing != 0;
+                cube.transparent = transparent != 0;
+                reader.Quoted(cube.texturePath);
+                cubes.push_back(std::move(cube));
+            }
+            line = lineEnd + 1;
+        }
+    }
+
+    SceneLoader::~SceneLoader()
+    {
+        Cancel();
+    }
+
+    void SceneLoader::Start(const std::string& path, SceneLoadSink& sink, unsigned threads)
+    {
+        Cancel();
+        m_path = path;
+        m_sink = &sink;
+        m_text.clear();
+        m_blocks.clear();
+        m_split = false;
+        m_nextClaim = 0;
+        m_parsed.clear();
+        m_nextTextured = 0;
+        m_toIndex.clear();
+        m_ready.clear();
+        m_readyBytes.clear();
+        m_indexedBlocks = 0;
+        m_deliveredBlocks = 0;
+        m_totalBytes = 0;
+        m_deliveredBytes = 0;
+        m_deliveredCubes = 0;
+        m_textureCount = 0;
+        m_failed = false;
+        m_error.clear();
+        m_stopRequested = false;
+
+        // The two stage threads are mostly waiting on the parsers, so they don't take a core.
+        const unsigned parsers = std::max(1u, threads != 0 ? threads : std::thread::hardware_concurrency());
+        m_window = parsers * 2;
+        m_threads.emplace_back(&SceneLoader::RunTextureStage, this);
+        m_threads.emplace_back(&SceneLoader::RunIndexStage, this);
+        for (unsigned i = 0; i < parsers; ++i)
+        {
+            m_threads.emplace_back(&SceneLoader::RunParser, this);
+        }
+    }
+
+    void SceneLoader::Cancel()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopRequested = true;
+        }
+        m_changed.notify_all();
+        for (std::thread& thread : m_threads)
+        {
+            thread.join();
+        }
+        m_threads.clear();
+        m_text.clear();
+        m_text.shrink_to_fit();
+        m_parsed.clear();
+        m_toIndex.clear();
+        m_ready.clear();
+        m_readyBytes.clear();
+    }
+
+    SceneLoadProgress SceneLoader::Progress() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        SceneLoadProgress progress;
+        progress.totalBytes = m_totalBytes;
+        progress.deliveredBytes = m_deliveredBytes;
+        progress.deliveredCubes = m_deliveredCubes;
+        progress.textures = m_textureCount;
+        progress.failed = m_failed;
+        progress.error = m_error;
+        progress.finished = m_failed || (m_split && m_deliveredBlocks == m_blocks.size());
+        return progress;
+    }
+
+    void SceneLoader::Fail(const std::string& error)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_failed = true;
+            m_error = error;
+        }
+        m_changed.notify_all();
+    }
+
+    bool SceneLoader::ReadAndSplit()
+    {
+        std::ifstream file(std::filesystem::u8path(m_path), std::ios::binary);
+        if (!file)
+        {
+            Fail("Unable to open " + m_path);
+            return false;
+        }
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        // The header is read the way ParseScene reads it: magic, version, then the cube count,
+        // with the rest of the count's line skipped.
+        size_t offset = 0;
+        const std::string magic = NextToken(text, offset);
+        const std::string version = NextToken(text, offset);
+        if (magic != "VENGINE_SCENE" || version != "1")
+        {
+            Fail("Not a VENGINE_SCENE 1 file");
+            return false;
+        }
+        const std::string countToken = NextToken(text, offset);
+        char* countEnd = nullptr;
+        const unsigned long long parsedCount = std::strtoull(countToken.c_str(), &countEnd, 10);
+        const size_t cubeCount = countEnd != countToken.c_str() && countToken[0] != '-' ? static_cast<size_t>(parsedCount) : 0;
+        const size_t newline = text.find('\n', offset);
+        offset = newline == std::string::npos ? text.size() : newline + 1;
+
+        // ParseScene reads exactly cubeCount lines after the header; blocks cover just those,
+        // cut at line ends roughly every kBlockBytes.
+        std::vector<Block> blocks;
+        size_t blockBegin = offset;
+        size_t cursor = offset;
+        for (size_t line = 0; line < cubeCount && cursor < text.size(); ++line)
+        {
+            const size_t lineEnd = text.find('\n', cursor);
+            cursor = lineEnd == std::string::npos ? text.size() : lineEnd + 1;
+            if (cursor - blockBegin >= kBlockBytes)
+            {
+                blocks.push_back(Block{blockBegin, cursor});
+                blockBegin = cursor;
+            }
+        }
+        if (cursor > blockBegin)
+        {
+            blocks.push_back(Block{blockBegin, cursor});
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_text = std::move(text);
+            m_blocks = std::move(blocks);
+            m_totalBytes = cursor - offset;
+            m_split = true;
+        }
+        m_changed.notify_all();
+        return true;
+    }
+
+    void SceneLoader::RunParser()
+    {
+        for (;;)
+        {
+            size_t index = 0;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_changed.wait(lock, [&] {
+                    return m_stopRequested || m_failed || (m_split && (m_nextClaim >= m_blocks.size() || m_nextClaim < m_nextTextured + m_window));
+                });
+                if (m_stopRequested || m_failed || m_nextClaim >= m_blocks.size())
+                {
+                    return;
+                }
+                index = m_nextClaim++;
+            }
+
+            // m_text and m_blocks don't change once split, so parsing needs no lock.
+            const Block block = m_blocks[index];
+            Parsed parsed;
+            parsed.bytes = block.end - block.begin;
+            parsed.cubes.reserve(parsed.bytes / 40 + 1);
+            ParseSceneLines(m_text.data() + block.begin, m_text.data() + block.end, parsed.cubes);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_parsed.emplace(index, std::move(parsed));
+            }
+            m_changed.notify_all();
+        }
+    }
+
+    void SceneLoader::RunTextureStage()
+    {
+        if (!ReadAndSplit())
+        {
+            return;
+        }
+        std::unordered_set<std::string> seen;
+        for (;;)
+        {
+            Parsed parsed;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_changed.wait(lock, [&] {
+                    return m_stopRequested || m_nextTextured >= m_blocks.size() || m_parsed.count(m_nextTextured) != 0;
+                });
+                if (m_stopRequested || m_nextTextured >= m_blocks.size())
+                {
+                    return;
+                }
+                const auto found = m_parsed.find(m_nextTextured);
+                parsed = std::move(found->second);
+                m_parsed.erase(found);
+            }
+
+            for (const SceneCube& cube : parsed.cubes)
+            {
+                if (!cube.texturePath.empty() && seen.insert(cube.texturePath).second)
+                {
+                    m_sink->PrepareTexture(cube.texturePath);
+                }
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_changed.wait(lock, [&] { return m_stopRequested || m_toIndex.size() < kQueueDepth; });
+                if (m_stopRequested)
+                {
+                    return;
+                }
+                m_textureCount = seen.size();
+                m_toIndex.push_back(std::move(parsed));
+                ++m_nextTextured;
+            }
+            m_changed.notify_all();
+        }
+    }
+
+    void SceneLoader::RunIndexStage()
+    {
+        size_t firstItem = 0;
+        for (;;)
+        {
+            Parsed parsed;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_changed.wait(lock, [&] { return m_stopRequested || m_failed || !m_toIndex.empty() || (m_split && m_indexedBlocks >= m_blocks.size()); });
+                if (m_stopRequested || m_toIndex.empty())
+                {
+                    return;
+                }
+                parsed = std::move(m_toIndex.front());
+                m_toIndex.pop_front();
+            }
+            m_changed.notify_all();
+
+            m_sink->IndexBatch(firstItem, parsed.cubes);
+            SceneLoadBatch batch;
+            batch.firstItem = firstItem;
+            firstItem += parsed.cubes.size();
+            batch.cubes = std::move(parsed.cubes);
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_changed.wait(lock, [&] { return m_stopRequested || m_ready.size() < kQueueDepth; });
+                if (m_stopRequested)
+                {
+                    return;
+                }
+                m_ready.push_back(std::move(batch));
+                m_readyBytes.push_back(parsed.bytes);
+                ++m_indexedBlocks;
+            }
+            m_changed.notify_all();
+        }
+    }
+
+    bool SceneLoader::PopReady(SceneLoadBatch& batch, bool wait)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (wait)
+            {
+                m_changed.wait(lock, [&] { return !m_ready.empty() || m_failed || m_stopRequested || m_threads.empty() || (m_split && m_deliveredBlocks == m_blocks.size()); });
+            }
+            if (m_ready.empty())
+            {
+                return false;
+            }
+            batch = std::move(m_ready.front());
+            m_ready.pop_front();
+            m_deliveredBytes += m_readyBytes.front();
+            m_readyBytes.pop_front();
+            m_deliveredCubes += batch.cubes.size();
+            ++m_deliveredBlocks;
+        }
+        m_changed.notify_all();
+        return true;
+    }
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "scene_file.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads a text scene (scene_file.h) on background threads, in three pipelined stages joined by
+// bounded queues:
+//
+//   parse    the file is cut into blocks of whole lines that worker threads parse in parallel;
+//   texture  a stage thread takes the blocks in file order and hands each texture path the first
+//            time it appears to SceneLoadSink::PrepareTexture, so every texture is decoded once;
+//   index    a second stage thread passes each block, with the scene index of its first cube, to
+//            SceneLoadSink::IndexBatch so the spatial index is built while parsing continues.
+//
+// The caller then takes the finished blocks from Drain, still in file order, so the cube order
+// and which lines count match ParseScene exactly. A block reaches Drain only after its textures
+// were prepared and its cubes indexed.
+namespace vengine
+{
+    // The frontend's side of the texture and index stages. Each method is called from one stage
+    // thread at a time.
+    class SceneLoadSink
+    {
+    public:
+        virtual ~SceneLoadSink() = default;
+        // Once per distinct non-empty texture path, as stored in the file.
+        virtual void PrepareTexture(const std::string& path) = 0;
+        // Every block in file order; firstItem is the position of cubes[0] in the whole scene.
+        virtual void IndexBatch(size_t firstItem, const std::vector<SceneCube>& cubes) = 0;
+    };
+
+    struct SceneLoadBatch
+    {
+        size_t firstItem = 0;
+        std::vector<SceneCube> cubes;
+    };
+
+    struct SceneLoadProgress
+    {
+        size_t totalBytes = 0;     // The cube lines' share of the file; 0 until it has been read.
+        size_t deliveredBytes = 0; // Of those, the bytes whose cubes Drain has handed out.
+        size_t deliveredCubes = 0;
+        size_t textures = 0;
+        bool finished = false; // Everything delivered, or the load failed.
+        bool failed = false;
+        std::string error;
+    };
+
+    class SceneLoader
+    {
+    public:
+        SceneLoader() = default;
+        ~SceneLoader();
+        SceneLoader(const SceneLoader&) = delete;
+        SceneLoader& operator=(const SceneLoader&) = delete;
+
+        // Cancels any load in progress and starts reading path. The sink must outlive the load.
+        void Start(const std::string& path, SceneLoadSink& sink, unsigned threads = 0);
+
+        // Passes finished blocks, in order, to sink(SceneLoadBatch&), up to maxBatches. With wait
+        // set it blocks for each block until the whole scene has been delivered.
+        template <typename Sink>
+        size_t Drain(Sink&& sink, size_t maxBatches = std::numeric_limits<size_t>::max(), bool wait = false)
+        {
+            size_t delivered = 0;
+            SceneLoadBatch batch;
+            while (delivered < maxBatches && PopReady(batch, wait))
+            {
+                sink(batch);
+                ++delivered;
+            }
+            return delivered;
+        }
+
+        // Drops whatever is in flight and joins every thread.
+        void Cancel();
+
+        bool Active() const { return !m_threads.empty(); }
+        SceneLoadProgress Progress() const;
+
+    private:
+        struct Block
+        {
+            size_t begin = 0;
+            size_t end = 0;
+        };
+
+        struct Parsed
+        {
+            size_t bytes = 0;
+            std::vector<SceneCube> cubes;
+        };
+
+        bool PopReady(SceneLoadBatch& batch, bool wait);
+        bool ReadAndSplit();
+        void RunParser();
+        void RunTextureStage();
+        void RunIndexStage();
+        void Fail(const std::string& error);
+
+        std::string m_path;
+        SceneLoadSink* m_sink = nullptr;
+        std::string m_text;
+        std::vector<Block> m_blocks;
+        std::vector<std::thread> m_threads;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_changed;
+        bool m_split = false; // m_text and m_blocks are ready for the parsers.
+        size_t m_nextClaim = 0;
+        size_t m_window = 0; // Blocks a parser may run ahead of the texture stage.
+        std::map<size_t, Parsed> m_parsed;
+        size_t m_nextTextured = 0;
+        std::deque<Parsed> m_toIndex;
+        std::deque<SceneLoadBatch> m_ready;
+        std::deque<size_t> m_readyBytes;
+        size_t m_indexedBlocks = 0;
+        size_t m_deliveredBlocks = 0;
+        size_t m_totalBytes = 0;
+        size_t m_deliveredBytes = 0;
+        size_t m_deliveredCubes = 0;
+        size_t m_textureCount = 0;
+        bool m_failed = false;
+        std::string m_error;
+        bool m_stopRequested = false;
+    };
+
+    // Parses the cube lines in text[begin, end) the way ParseScene does, appending to cubes.
+    void ParseSceneLines(const char* begin, const char* end, std::vector<SceneCube>& cubes);
+}
@@ -0,0 +1,329 @@
+#include "script_runtime.h"
+
+#include <chrono>
+
+#if defined(VENGINE_ENABLE_LUA)
+#include <lua.hpp>
+#endif
+
+namespace vengine
+{
+#if defined(VENGINE_ENABLE_LUA)
+
+    namespace
+    {
+        double NowSeconds()
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // The budget hook fires every kHookInterval VM instructions, which keeps its overhead
+        // negligible while still stopping a runaway loop within a fraction of a millisecond.
+        constexpr int kHookInterval = 1000;
+    }
+
+    // Lua entry points. The owning runtime lives in the state's extra space, so the bindings need
+    // no registry lookups or upvalues and never allocate on the C++ side.
+    struct ScriptBindings
+    {
+        static ScriptRuntime& Runtime(lua_State* state)
+        {
+            return **static_cast<ScriptRuntime**>(lua_getextraspace(state));
+        }
+
+        static ScriptCommand& PushCommand(lua_State* state, ScriptCommandType type)
+        {
+            ScriptRuntime& runtime = Runtime(state);
+            if (runtime.m_commands.size() >= kMaxScriptCommandsPerTick)
+            {
+                luaL_error(state, "more than %d world commands in one tick", static_cast<int>(kMaxScriptCommandsPerTick));
+            }
+            runtime.m_commands.emplace_back();
+            ScriptCommand& command = runtime.m_commands.back();
+            command.type = type;
+            return command;
+        }
+
+        static int CheckInt(lua_State* state, int index)
+        {
+            return static_cast<int>(luaL_checkinteger(state, index));
+        }
+
+        static float CheckFloat(lua_State* state, int index)
+        {
+            return static_cast<float>(luaL_checknumber(state, index));
+        }
+
+        // world.place(x, y, z [, preset])
+        static int WorldPlace(lua_State* state)
+        {
+            ScriptCommand& command = PushCommand(state, ScriptCommandType::PlaceCube);
+            command.x = CheckInt(state, 1);
+            command.y = CheckInt(state, 2);
+            command.z = CheckInt(state, 3);
+            command.preset = static_cast<int>(luaL_optinteger(state, 4, 0));
+            return 0;
+        }
+
+        // world.remove(x, y, z)
+        static int WorldRemove(lua_State* state)
+        {
+            ScriptCommand& command = PushCommand(state, ScriptCommandType::RemoveCube);
+            command.x = CheckInt(state, 1);
+            command.y = CheckInt(state, 2);
+            command.z = CheckInt(state, 3);
+            return 0;
+        }
+
+        // world.get(x, y, z) -> preset index, or nil for an empty cell
+        static int WorldGet(lua_State* state)
+        {
+            const int x = CheckInt(state, 1);
+            const int y = CheckInt(state, 2);
+            const int z = CheckInt(state, 3);
+            const ScriptWorldView* world = Runtime(state).m_world;
+            const int preset = world ? world->CubePresetAt(x, y, z) : -1;
+            if (preset < 0)
+            {
+                lua_pushnil(state);
+            }
+            else
+            {
+                lua_pushinteger(state, preset);
+            }
+            return 1;
+        }
+
+        // world.count() -> number of placed cubes
+        static int WorldCount(lua_State* state)
+        {
+            const ScriptWorldView* world = Runtime(state).m_world;
+            lua_pushinteger(state, world ? world->CubeCount() : 0);
+            return 1;
+        }
+
+        // player.position() -> x, y, z
+        static int PlayerPosition(lua_State* state)
+        {
+            float x = 0.0f;
+            float y = 0.0f;
+            float z = 0.0f;
+            if (const ScriptWorldView* world = Runtime(state).m_world)
+            {
+                world->PlayerPosition(x, y, z);
+            }
+            lua_pushnumber(state, x);
+            lua_pushnumber(state, y);
+            lua_pushnumber(state, z);
+            return 3;
+        }
+
+        // player.move(dx, dy, dz) -- collision-checked by the frontend
+        static int PlayerMove(lua_State* state)
+        {
+            ScriptCommand& command = PushCommand(state, ScriptCommandType::MovePlayer);
+            command.px = CheckFloat(state, 1);
+            command.py = CheckFloat(state, 2);
+            command.pz = CheckFloat(state, 3);
+            return 0;
+        }
+
+        // player.teleport(x, y, z)
+        static int PlayerTeleport(lua_State* state)
+        {
+            ScriptCommand& command = PushCommand(state, ScriptCommandType::TeleportPlayer);
+            command.px = CheckFloat(state, 1);
+            command.py = CheckFloat(state, 2);
+            command.pz = CheckFloat(state, 3);
+            return 0;
+        }
+
+        static void BudgetHook(lua_State* state, lua_Debug*)
+        {
+            ScriptRuntime& runtime = Runtime(state);
+            const double elapsedMs = (NowSeconds() - runtime.m_startSeconds) * 1000.0;
+            if (!runtime.m_budgetExceeded)
+            {
+                runtime.m_instructions += kHookInterval;
+                if (runtime.m_instructions <= runtime.m_budget.maxInstructions && elapsedMs <= runtime.m_budget.maxMilliseconds)
+                {
+                    return;
+                }
+                // A script can catch one error with pcall and keep looping, so from here on every
+                // instruction fails until the stack has unwound out of the protected call.
+                runtime.m_budgetExceeded = true;
+                lua_sethook(state, BudgetHook, LUA_MASKCOUNT, 1);
+            }
+            luaL_error(state, "script exceeded its frame budget (%d instructions, %.1f ms)", static_cast<int>(runtime.m_instructions), elapsedMs);
+        }
+
+        static void Register(lua_State* state)
+        {
+            // Only the pure libraries: scripts get no file, OS or module-loading access.
+            luaL_requiref(state, "_G", luaopen_base, 1);
+            luaL_requiref(state, LUA_TABLIBNAME, luaopen_table, 1);
+            luaL_requiref(state, LUA_STRLIBNAME, luaopen_string, 1);
+            luaL_requiref(state, LUA_MATHLIBNAME, luaopen_math, 1);
+            lua_pop(state, 4);
+            for (const char* unsafe : {"dofile", "loadfile", "load", "collectgarbage"})
+            {
+                lua_pushnil(state);
+                lua_setglobal(state, unsafe);
+            }
+
+            static const luaL_Reg kWorld[] = {
+                {"place", WorldPlace},
+                {"remove", WorldRemove},
+                {"get", WorldGet},
+                {"count", WorldCount},
+                {nullptr, nullptr},
+            };
+            static const luaL_Reg kPlayer[] = {
+                {"position", PlayerPosition},
+                {"move", PlayerMove},
+                {"teleport", PlayerTeleport},
+                {nullptr, nullptr},
+            };
+            luaL_newlib(state, kWorld);
+            lua_setglobal(state, "world");
+            luaL_newlib(state, kPlayer);
+            lua_setglobal(state, "player");
+        }
+    };
+
+    ScriptRuntime::ScriptRuntime()
+    {
+        m_commands.reserve(kMaxScriptCommandsPerTick);
+    }
+
+    ScriptRuntime::~ScriptRuntime()
+    {
+        Unload();
+    }
+
+    bool ScriptRuntime::Available()
+    {
+        return true;
+    }
+
+    void ScriptRuntime::Unload()
+    {
+        if (m_state)
+        {
+            // lua_close runs any pending __gc metamethods, which are script code like any other,
+            // so the budget hook stays installed until the state is gone.
+            m_instructions = 0;
+            m_budgetExceeded = false;
+            m_startSeconds = NowSeconds();
+            lua_sethook(m_state, ScriptBindings::BudgetHook, LUA_MASKCOUNT, kHookInterval);
+            lua_close(m_state);
+            m_state = nullptr;
+            m_commands.clear();
+        }
+    }
+
+    bool ScriptRuntime::RunProtected(int argumentCount, const ScriptWorldView& world)
+    {
+        m_world = &world;
+        m_instructions = 0;
+        m_budgetExceeded = false;
+        m_startSeconds = NowSeconds();
+        lua_sethook(m_state, ScriptBindings::BudgetHook, LUA_MASKCOUNT, kHookInterval);
+        const int status = lua_pcall(m_state, argumentCount, 0, 0);
+        lua_sethook(m_state, nullptr, 0, 0);
+        m_lastMilliseconds = (NowSeconds() - m_startSeconds) * 1000.0;
+        m_lastInstructions = m_instructions;
+        m_world = nullptr;
+
+        if (status != LUA_OK)
+        {
+            const char* message = lua_tostring(m_state, -1);
+            m_lastError = message ? message : "script error";
+            lua_pop(m_state, 1);
+            m_commands.clear();
+            return false;
+        }
+        m_lastError.clear();
+        return true;
+    }
+
+    bool ScriptRuntime::Load(const std::string& source, const std::string& chunkName, const ScriptWorldView& world)
+    {
+        Unload();
+        m_commands.clear();
+        m_state = luaL_newstate();
+        if (!m_state)
+        {
+            m_lastError = "Unable to create Lua state";
+            return false;
+        }
+        *static_cast<ScriptRuntime**>(lua_getextraspace(m_state)) = this;
+        ScriptBindings::Register(m_state);
+
+        const std::string name = "=" + chunkName;
+        if (luaL_loadbuffer(m_state, source.data(), source.size(), name.c_str()) != LUA_OK)
+        {
+            const char* message = lua_tostring(m_state, -1);
+            m_lastError = message ? message : "syntax error";
+            Unload();
+            return false;
+        }
+        if (!RunProtected(0, world))
+        {
+            Unload();
+            return false;
+        }
+        return true;
+    }
+
+    bool ScriptRuntime::Tick(float deltaTime, const ScriptWorldView& world)
+    {
+        m_commands.clear();
+        if (!m_state)
+        {
+            return false;
+        }
+        if (lua_getglobal(m_state, "tick") != LUA_TFUNCTION)
+        {
+            lua_pop(m_state, 1);
+            m_lastInstructions = 0;
+            m_lastMilliseconds = 0.0;
+            return true;
+        }
+        lua_pushnumber(m_state, static_cast<lua_Number>(deltaTime));
+        return RunProtected(1, world);
+    }
+
+#else
+
+    ScriptRuntime::ScriptRuntime() = default;
+
+    ScriptRuntime::~ScriptRuntime() = default;
+
+    bool ScriptRuntime::Available()
+    {
+        return false;
+    }
+
+    void ScriptRuntime::Unload()
+    {
+    }
+
+    bool ScriptRuntime::RunProtected(int, const ScriptWorldView&)
+    {
+        return false;
+    }
+
+    bool ScriptRuntime::Load(const std::string&, const std::string&, const ScriptWorldView&)
+    {
+        m_lastError = "Lua scripting is disabled in this build (define VENGINE_ENABLE_LUA)";
+        return false;
+    }
+
+    bool ScriptRuntime::Tick(float, const ScriptWorldView&)
+    {
+        return false;
+    }
+
+#endif
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct lua_State;
+
+// Embedded Lua VM behind the Code panel. The frontends hand it their script text, call Tick once
+// per frame and then apply the queued world commands. Scripts only ever read the world through
+// ScriptWorldView, and every mutation lands in a preallocated command buffer, so a tick neither
+// allocates on the C++ side nor touches the cube store while Lua is running.
+//
+// Built only when VENGINE_ENABLE_LUA is defined (see the Makefile's LUA_DIR and the WebGL CMake
+// option); otherwise every call fails with a "scripting disabled" error and the editors still work.
+namespace vengine
+{
+    enum class ScriptCommandType : uint8_t
+    {
+        PlaceCube,       // x, y, z, preset
+        RemoveCube,      // x, y, z
+        MovePlayer,      // dx, dy, dz
+        TeleportPlayer,  // px, py, pz
+    };
+
+    struct ScriptCommand
+    {
+        ScriptCommandType type = ScriptCommandType::PlaceCube;
+        int x = 0;
+        int y = 0;
+        int z = 0;
+        int preset = 0;
+        float px = 0.0f;
+        float py = 0.0f;
+        float pz = 0.0f;
+    };
+
+    // Read-only world access for scripts; implemented by each frontend over its cube store.
+    class ScriptWorldView
+    {
+    public:
+        virtual ~ScriptWorldView() = default;
+        virtual int CubePresetAt(int x, int y, int z) const = 0; // -1 when the cell is empty.
+        virtual int CubeCount() const = 0;
+        virtual void PlayerPosition(float& x, float& y, float& z) const = 0;
+    };
+
+    struct ScriptBudget
+    {
+        uint32_t maxInstructions = 500000;
+        double maxMilliseconds = 4.0;
+    };
+
+    constexpr size_t kMaxScriptCommandsPerTick = 4096;
+
+    class ScriptRuntime
+    {
+    public:
+        ScriptRuntime();
+        ~ScriptRuntime();
+        ScriptRuntime(const ScriptRuntime&) = delete;
+        ScriptRuntime& operator=(const ScriptRuntime&) = delete;
+
+        static bool Available();
+
+        // Starts a fresh VM and runs the chunk's top level under the budget. Commands queued by the
+        // top level are left in Commands() for the caller to apply. On failure the previous VM is
+        // gone and LastError() explains why.
+        bool Load(const std::string& source, const std::string& chunkName, const ScriptWorldView& world);
+        void Unload();
+        bool Loaded() const { return m_state != nullptr; }
+
+        // Calls the global tick(dt) if the script defines one. Commands from a tick that errors or
+        // runs over budget are discarded so the world never sees half a frame of edits.
+        bool Tick(float deltaTime, const ScriptWorldView& world);
+
+        const std::vector<ScriptCommand>& Commands() const { return m_commands; }
+        void ClearCommands() { m_commands.clear(); }
+
+        void SetBudget(const ScriptBudget& budget) { m_budget = budget; }
+        const std::string& LastError() const { return m_lastError; }
+        uint32_t LastInstructionCount() const { return m_lastInstructions; }
+        double LastMilliseconds() const { return m_lastMilliseconds; }
+
+    private:
+        bool RunProtected(int argumentCount, const ScriptWorldView& world);
+
+        lua_State* m_state = nullptr;
+        const ScriptWorldView* m_world = nullptr;
+        std::vector<ScriptCommand> m_commands;
+        ScriptBudget m_budget;
+        std::string m_lastError;
+        uint32_t m_instructions = 0;
+        uint32_t m_lastInstructions = 0;
+        double m_lastMilliseconds = 0.0;
+        double m_startSeconds = 0.0;
+        bool m_budgetExceeded = false;
+
+        friend struct ScriptBindings;
+    };
+}
@@ -0,0 +1,579 @@
+#include "software_raytracer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace vengine
+{
+    namespace
+    {
+        // Must match the preview shader in webgl/src/main.cpp.
+        constexpr int kMaxBounces = 3;
+        constexpr int kMaxSegments = 8;
+        constexpr float kGlassPassProbability = 0.55f;
+        constexpr float kAmbient = 0.05f;
+        constexpr float kPathClamp = 4.0f;
+
+        struct Vec3
+        {
+            float x = 0.0f;
+            float y = 0.0f;
+            float z = 0.0f;
+        };
+
+        Vec3 operator+(const Vec3& a, const Vec3& b) { return Vec3{a.x + b.x, a.y + b.y, a.z + b.z}; }
+        Vec3 operator-(const Vec3& a, const Vec3& b) { return Vec3{a.x - b.x, a.y - b.y, a.z - b.z}; }
+        Vec3 operator*(const Vec3& a, const Vec3& b) { return Vec3{a.x * b.x, a.y * b.y, a.z * b.z}; }
+        Vec3 operator*(const Vec3& a, float s) { return Vec3{a.x * s, a.y * s, a.z * s}; }
+        float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+        Vec3 Cross(const Vec3& a, const Vec3& b) { return Vec3{a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+        Vec3 Normalize(const Vec3& v)
+        {
+            const float length = std::sqrt(Dot(v, v));
+            return length > 0.0f ? v * (1.0f / length) : v;
+        }
+        Vec3 Load(const float v[3]) { return Vec3{v[0], v[1], v[2]}; }
+        void Store(const Vec3& v, float out[3])
+        {
+            out[0] = v.x;
+            out[1] = v.y;
+            out[2] = v.z;
+        }
+        Vec3 Tint(const Voxel& voxel) { return Vec3{0.5f + 0.5f * voxel.r, 0.5f + 0.5f * voxel.g, 0.5f + 0.5f * voxel.b}; }
+        Vec3 Color(const Voxel& voxel) { return Vec3{voxel.r, voxel.g, voxel.b}; }
+
+        // PCG hash, as in the shader.
+        struct Rng
+        {
+            uint32_t state = 1;
+
+            float Next()
+            {
+                state = state * 747796405u + 2891336453u;
+                uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+                word = (word >> 22u) ^ word;
+                return static_cast<float>(word) / 4294967296.0f;
+            }
+        };
+
+        struct SurfaceHit
+        {
+            bool sky = true;
+            VoxelKind kind = VoxelKind::Empty; // Empty with !sky is the ground.
+            float t = 0.0f;
+            Vec3 normal{0.0f, 1.0f, 0.0f};
+            int cell = -1;
+        };
+
+        // One ray's DDA walk through the grid.
+        struct MarchState
+        {
+            int cell[3] = {0, 0, 0};
+            int step[3] = {0, 0, 0};
+            float tNext[3] = {0.0f, 0.0f, 0.0f};
+            float tDelta[3] = {0.0f, 0.0f, 0.0f};
+            float stepSign[3] = {0.0f, 0.0f, 0.0f};
+            float t = 0.0f;
+            int lastAxis = 1;
+            int stepsLeft = 0;
+            bool active = false;
+        };
+
+        float GuardDirection(float d)
+        {
+            return std::fabs(d) < 1e-6f ? 1e-6f : d;
+        }
+
+        // Clips the ray against the grid box and positions its walk at the entry cell; the walk is
+        // left inactive when the ray misses the box.
+        void BeginMarch(const RaytraceScene& scene, const Vec3& ro, const Vec3& rd, MarchState& s)
+        {
+            const float* origin = scene.Origin();
+            const int* size = scene.Size();
+            const float p[3] = {ro.x - origin[0], ro.y - origin[1], ro.z - origin[2]};
+            const float dir[3] = {GuardDirection(rd.x), GuardDirection(rd.y), GuardDirection(rd.z)};
+            float inv[3];
+            for (int a = 0; a < 3; ++a)
+            {
+                inv[a] = 1.0f / dir[a];
+            }
+            float tEnter = -1e30f;
+            float tExit = 1e30f;
+            int enterAxis = 0;
+            for (int a = 0; a < 3; ++a)
+            {
+                const float extent = static_cast<float>(size[a]);
+                const float t0 = -p[a] * inv[a];
+                const float t1 = (extent - p[a]) * inv[a];
+                const float lo = std::min(t0, t1);
+                const float hi = std::max(t0, t1);
+                enterAxis = lo > tEnter ? a : enterAxis;
+                tEnter = std::max(tEnter, lo);
+                tExit = std::min(tExit, hi);
+            }
+
+            s.active = !(tEnter > tExit || tExit < 0.0f);
+            if (!s.active)
+            {
+                return;
+            }
+            s.t = std::max(tEnter, 0.0f);
+            s.lastAxis = enterAxis;
+            s.stepsLeft = size[0] + size[1] + size[2];
+            for (int a = 0; a < 3; ++a)
+            {
+                const float sign = dir[a] > 0.0f ? 1.0f : -1.0f;
+                const int cell = static_cast<int>(std::floor(p[a] + dir[a] * (s.t + 1e-4f)));
+                s.cell[a] = std::clamp(cell, 0, size[a] - 1);
+                s.step[a] = dir[a] > 0.0f ? 1 : -1;
+                s.stepSign[a] = sign;
+                s.tDelta[a] = std::fabs(inv[a]);
+                s.tNext[a] = (static_cast<float>(s.cell[a]) + (sign > 0.0f ? 1.0f : 0.0f) - p[a]) * inv[a];
+            }
+        }
+
+        enum class MarchResult
+        {
+            Continue,
+            Hit,
+            Miss,
+        };
+
+        // Visits the walk's current cell, then advances it by one cell. With glassTint, glass is
+        // passed through and its tint multiplied into transmittance instead of counting as a hit.
+        MarchResult StepMarch(const RaytraceScene& scene, MarchState& s, float maxT, int skipCell, bool glassTint, Vec3& transmittance,
+                              SurfaceHit& hit)
+        {
+            if (s.t >= maxT || s.stepsLeft-- <= 0)
+            {
+                return MarchResult::Miss;
+            }
+            const int index = scene.CellIndex(s.cell[0], s.cell[1], s.cell[2]);
+            const Voxel& voxel = scene.At(index);
+            if (voxel.kind != VoxelKind::Empty && index != skipCell)
+            {
+                if (glassTint && voxel.kind == VoxelKind::Glass)
+                {
+                    transmittance = transmittance * Tint(voxel);
+                }
+                else
+                {
+                    hit.sky = false;
+                    hit.kind = voxel.kind;
+                    hit.t = s.t;
+                    hit.cell = index;
+                    float normal[3] = {0.0f, 0.0f, 0.0f};
+                    normal[s.lastAxis] = -s.stepSign[s.lastAxis];
+                    hit.normal = Load(normal);
+                    return MarchResult::Hit;
+                }
+            }
+            int axis = 2;
+            if (s.tNext[0] < s.tNext[1] && s.tNext[0] < s.tNext[2])
+            {
+                axis = 0;
+            }
+            else if (s.tNext[1] < s.tNext[2])
+            {
+                axis = 1;
+            }
+            s.t = s.tNext[axis];
+            s.tNext[axis] += s.tDelta[axis];
+            s.cell[axis] += s.step[axis];
+            s.lastAxis = axis;
+            if (s.cell[axis] < 0 || s.cell[axis] >= scene.Size()[axis])
+            {
+                return MarchResult::Miss;
+            }
+            return MarchResult::Continue;
+        }
+
+        float GroundDistance(const Vec3& ro, const Vec3& rd)
+        {
+            return (rd.y < -1e-4f && ro.y > 0.0f) ? -ro.y / rd.y : 1e9f;
+        }
+
+        void ResolveGround(float tGround, SurfaceHit& hit)
+        {
+            if (hit.sky && tGround < 1e9f)
+            {
+                hit.sky = false;
+                hit.kind = VoxelKind::Empty;
+                hit.t = tGround;
+                hit.normal = Vec3{0.0f, 1.0f, 0.0f};
+                hit.cell = -1;
+            }
+        }
+
+        SurfaceHit Trace(const RaytraceScene& scene, const Vec3& ro, const Vec3& rd, int skipCell)
+        {
+            const float tGround = GroundDistance(ro, rd);
+            MarchState state;
+            BeginMarch(scene, ro, rd, state);
+            SurfaceHit hit;
+            Vec3 unused{1.0f, 1.0f, 1.0f};
+            while (state.active && StepMarch(scene, state, tGround, skipCell, false, unused, hit) == MarchResult::Continue)
+            {
+            }
+            ResolveGround(tGround, hit);
+            return hit;
+        }
+
+        // Next-event estimate from one glow cube picked at random, aimed at a random point inside it.
+        Vec3 SampleGlowLight(const RaytraceScene& scene, const Vec3& pos, const Vec3& normal, int selfCell, Rng& rng)
+        {
+            const std::vector<int>& lights = scene.GlowCells();
+            if (lights.empty())
+            {
+                return Vec3{};
+            }
+            const int count = static_cast<int>(lights.size());
+            const int lightCell = lights[static_cast<size_t>(std::min(static_cast<int>(rng.Next() * static_cast<float>(count)), count - 1))];
+            if (lightCell == selfCell)
+            {
+                return Vec3{};
+            }
+            const int* size = scene.Size();
+            const int cx = lightCell % size[0];
+            const int cy = (lightCell / size[0]) % size[1];
+            const int cz = lightCell / (size[0] * size[1]);
+            const Vec3 center = Load(scene.Origin()) + Vec3{static_cast<float>(cx) + 0.5f, static_cast<float>(cy) + 0.5f, static_cast<float>(cz) + 0.5f};
+            const float jx = rng.Next();
+            const float jy = rng.Next();
+            const float jz = rng.Next();
+            const Vec3 target = center + Vec3{jx - 0.5f, jy - 0.5f, jz - 0.5f};
+            Vec3 L = target - pos;
+            const float dist = std::sqrt(Dot(L, L));
+            if (dist < 0.0001f)
+            {
+                return Vec3{};
+            }
+            L = L * (1.0f / dist);
+            const float diff = Dot(normal, L);
+            if (diff <= 0.0f)
+            {
+                return Vec3{};
+            }
+
+            const Vec3 start = pos + normal * 0.02f;
+            MarchState state;
+            BeginMarch(scene, start, L, state);
+            Vec3 visible{1.0f, 1.0f, 1.0f};
+            SurfaceHit blocker;
+            MarchResult result = MarchResult::Miss;
+            if (state.active)
+            {
+                do
+                {
+                    result = StepMarch(scene, state, dist - 0.02f, lightCell, true, visible, blocker);
+                } while (result == MarchResult::Continue);
+            }
+            if (result == MarchResult::Hit)
+            {
+                return Vec3{};
+            }
+            const float attenuation = 1.0f / (1.0f + dist * 0.6f + dist * dist * 0.15f);
+            return Color(scene.At(lightCell)) * visible * (diff * attenuation * 2.0f * static_cast<float>(count));
+        }
+
+        Vec3 CosineDirection(const Vec3& normal, Rng& rng)
+        {
+            const float u = rng.Next();
+            const float phi = 6.2831853f * rng.Next();
+            const float r = std::sqrt(u);
+            const Vec3 tangent = Normalize(std::fabs(normal.y) < 0.9f ? Cross(normal, Vec3{0.0f, 1.0f, 0.0f}) : Cross(normal, Vec3{1.0f, 0.0f, 0.0f}));
+            const Vec3 bitangent = Cross(normal, tangent);
+            return Normalize(tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + normal * std::sqrt(1.0f - u));
+        }
+
+        Vec3 Sky(const Vec3& rd)
+        {
+            const Vec3 top{0.18f, 0.13f, 0.25f};
+            const Vec3 bottom{0.03f, 0.05f, 0.12f};
+            const float f = std::clamp(rd.y * 0.5f + 0.5f, 0.0f, 1.0f);
+            return bottom + (top - bottom) * f;
+        }
+
+        Vec3 TracePath(const RaytraceScene& scene, Vec3 ro, Vec3 rd, Rng& rng)
+        {
+            Vec3 radiance;
+            Vec3 throughput{1.0f, 1.0f, 1.0f};
+            int bounces = 0;
+            SurfaceHit hit;
+            for (int segment = 0; segment < kMaxSegments; ++segment)
+            {
+                hit = Trace(scene, ro, rd, segment > 0 && hit.cell >= 0 && hit.kind == VoxelKind::Glass && !hit.sky ? hit.cell : -1);
+                if (hit.sky)
+                {
+                    radiance = radiance + throughput * Sky(rd);
+                    break;
+                }
+                const Vec3 pos = ro + rd * hit.t;
+                Vec3 albedo{0.22f, 0.22f, 0.25f};
+                if (hit.kind == VoxelKind::Glow)
+                {
+                    // Later bounces already counted this light through SampleGlowLight.
+                    if (bounces == 0)
+                    {
+                        radiance = radiance + throughput * Color(scene.At(hit.cell));
+                    }
+                    break;
+                }
+                if (hit.kind != VoxelKind::Empty)
+                {
+                    albedo = Color(scene.At(hit.cell));
+                }
+                if (hit.kind == VoxelKind::Glass)
+                {
+                    if (rng.Next() < kGlassPassProbability)
+                    {
+                        throughput = throughput * Tint(scene.At(hit.cell));
+                        ro = pos;
+                        continue; // hit still names the glass cell, so the next Trace skips it.
+                    }
+                    albedo = albedo + (Vec3{0.9f, 0.95f, 1.0f} - albedo) * 0.5f;
+                }
+                const Vec3 light = SampleGlowLight(scene, pos, hit.normal, hit.cell, rng);
+                radiance = radiance + throughput * albedo * (light + Vec3{kAmbient, kAmbient, kAmbient});
+                if (bounces == kMaxBounces)
+                {
+                    break;
+                }
+                ++bounces;
+                throughput = throughput * albedo;
+                ro = pos + hit.normal * 0.002f;
+                rd = CosineDirection(hit.normal, rng);
+                hit.kind = VoxelKind::Empty; // Nothing to skip after a bounce.
+            }
+            return radiance;
+        }
+
+        struct TileJob
+        {
+            const RaytraceScene* scene = nullptr;
+            const RaytraceCamera* camera = nullptr;
+            const RaytraceSettings* settings = nullptr;
+            RaytraceImage* image = nullptr;
+            int tilesX = 0;
+        };
+
+        struct PixelRay
+        {
+            Vec3 dir;
+            Rng rng;
+        };
+
+        // px/py follow gl_FragCoord: origin bottom-left, so seeds and rays line up with the preview.
+        PixelRay MakePixelRay(const RaytraceCamera& camera, int width, int height, int px, int py, int sample)
+        {
+            PixelRay ray;
+            ray.rng.state = (static_cast<uint32_t>(px) * 1973u + static_cast<uint32_t>(py) * 9277u + static_cast<uint32_t>(sample) * 26699u) | 1u;
+            const float jx = ray.rng.Next() - 0.5f;
+            const float jy = ray.rng.Next() - 0.5f;
+            float u = ((static_cast<float>(px) + 0.5f + jx) / static_cast<float>(width)) * 2.0f - 1.0f;
+            const float v = ((static_cast<float>(py) + 0.5f + jy) / static_cast<float>(height)) * 2.0f - 1.0f;
+            u *= static_cast<float>(width) / static_cast<float>(height);
+            ray.dir = Normalize(Load(camera.dir) + Load(camera.right) * (u * camera.tanHalfFov) + Load(camera.up) * (v * camera.tanHalfFov));
+            return ray;
+        }
+
+        void Accumulate(RaytraceImage& image, int px, int py, const Vec3& radiance)
+        {
+            const Vec3 clamped{std::min(radiance.x, kPathClamp), std::min(radiance.y, kPathClamp), std::min(radiance.z, kPathClamp)};
+            float* out = &image.rgb[(static_cast<size_t>(image.height - 1 - py) * static_cast<size_t>(image.width) + static_cast<size_t>(px)) * 3u];
+            out[0] += clamped.x;
+            out[1] += clamped.y;
+            out[2] += clamped.z;
+        }
+
+        void RenderTile(const TileJob& job, int tileIndex)
+        {
+            const RaytraceScene& scene = *job.scene;
+            const RaytraceCamera& camera = *job.camera;
+            const RaytraceSettings& settings = *job.settings;
+            RaytraceImage& image = *job.image;
+            const int x0 = (tileIndex % job.tilesX) * settings.tileSize;
+            const int y0 = (tileIndex / job.tilesX) * settings.tileSize;
+            const int x1 = std::min(x0 + settings.tileSize, image.width);
+            const int y1 = std::min(y0 + settings.tileSize, image.height);
+            const Vec3 eye = Load(camera.eye);
+
+            for (int sample = 0; sample < settings.samplesPerPixel; ++sample)
+            {
+                for (int py = y0; py < y1; ++py)
+                {
+                    for (int px = x0; px < x1; ++px)
+                    {
+                        PixelRay ray = MakePixelRay(camera, image.width, image.height, px, py, sample);
+                        Accumulate(image, px, py, TracePath(scene, eye, ray.dir, ray.rng));
+                    }
+                }
+            }
+
+            const float scale = 1.0f / static_cast<float>(settings.samplesPerPixel);
+            for (int py = y0; py < y1; ++py)
+            {
+                float* row = &image.rgb[(static_cast<size_t>(image.height - 1 - py) * static_cast<size_t>(image.width) + static_cast<size_t>(x0)) * 3u];
+                for (int i = 0; i < (x1 - x0) * 3; ++i)
+                {
+                    row[i] *= scale;
+                }
+            }
+        }
+    }
+
+    bool RaytraceScene::Build(const std::vector<SceneCube>& cubes, std::string& errorMessage, size_t maxCells)
+    {
+        m_voxels.clear();
+        m_glowCells.clear();
+        m_cubeCount = 0;
+        int minCell[3] = {0, 0, 0};
+        int maxCell[3] = {0, 0, 0};
+        for (size_t i = 0; i < cubes.size(); ++i)
+        {
+            const int cell[3] = {cubes[i].gridX, cubes[i].gridY, cubes[i].gridZ};
+            for (int a = 0; a < 3; ++a)
+            {
+                minCell[a] = i == 0 ? cell[a] : std::min(minCell[a], cell[a]);
+                maxCell[a] = i == 0 ? cell[a] : std::max(maxCell[a], cell[a]);
+            }
+        }
+        size_t cellCount = 1;
+        for (int a = 0; a < 3; ++a)
+        {
+            m_size[a] = maxCell[a] - minCell[a] + 1;
+            cellCount *= static_cast<size_t>(m_size[a]);
+        }
+        if (cellCount > maxCells)
+        {
+            errorMessage = "Scene bounds need " + std::to_string(cellCount) + " voxels; the limit is " + std::to_string(maxCells);
+            m_size[0] = m_size[1] = m_size[2] = 0;
+            return false;
+        }
+        m_origin[0] = static_cast<float>(minCell[0]) - 0.5f;
+        m_origin[1] = static_cast<float>(minCell[1]);
+        m_origin[2] = static_cast<float>(minCell[2]) - 0.5f;
+
+        m_voxels.assign(cellCount, Voxel{});
+        for (const SceneCube& cube : cubes)
+        {
+            const int index = CellIndex(cube.gridX - minCell[0], cube.gridY - minCell[1], cube.gridZ - minCell[2]);
+            Voxel& voxel = m_voxels[static_cast<size_t>(index)];
+            if (voxel.kind == VoxelKind::Empty)
+            {
+                ++m_cubeCount;
+            }
+            voxel.r = std::clamp(cube.r, 0.0f, 1.0f);
+            voxel.g = std::clamp(cube.g, 0.0f, 1.0f);
+            voxel.b = std::clamp(cube.b, 0.0f, 1.0f);
+            voxel.kind = cube.glowing ? VoxelKind::Glow : (cube.transparent ? VoxelKind::Glass : VoxelKind::Solid);
+        }
+        for (size_t i = 0; i < m_voxels.size(); ++i)
+        {
+            if (m_voxels[i].kind == VoxelKind::Glow)
+            {
+                m_glowCells.push_back(static_cast<int>(i));
+            }
+        }
+        return true;
+    }
+
+    void RaytraceScene::Bounds(float center[3], float& extent) const
+    {
+        extent = 0.0f;
+        for (int a = 0; a < 3; ++a)
+        {
+            center[a] = m_origin[a] + 0.5f * static_cast<float>(m_size[a]);
+            extent = std::max(extent, static_cast<float>(m_size[a]));
+        }
+    }
+
+    RaytraceCamera RaytraceCamera::LookAt(const float eye[3], const float target[3], float verticalFovDegrees)
+    {
+        RaytraceCamera camera;
+        const Vec3 dir = Normalize(Load(target) - Load(eye));
+        Vec3 right = Cross(dir, Vec3{0.0f, 1.0f, 0.0f});
+        right = Dot(right, right) > 1e-8f ? Normalize(right) : Vec3{1.0f, 0.0f, 0.0f};
+        Store(Load(eye), camera.eye);
+        Store(dir, camera.dir);
+        Store(right, camera.right);
+        Store(Cross(right, dir), camera.up);
+        camera.tanHalfFov = std::tan(verticalFovDegrees * (3.1415926535f / 180.0f) * 0.5f);
+        return camera;
+    }
+
+    std::vector<uint8_t> RaytraceImage::ToRgba8() const
+    {
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u);
+        for (size_t i = 0, count = static_cast<size_t>(width) * static_cast<size_t>(height); i < count; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                pixels[i * 4u + static_cast<size_t>(c)] = static_cast<uint8_t>(std::clamp(rgb[i * 3u + static_cast<size_t>(c)], 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+            pixels[i * 4u + 3u] = 255;
+        }
+        return pixels;
+    }
+
+    RaytraceImage RenderRaytrace(const RaytraceScene& scene, const RaytraceCamera& camera, const RaytraceSettings& settings, RaytraceStats* stats)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        RaytraceSettings resolved = settings;
+        resolved.width = std::max(1, resolved.width);
+        resolved.height = std::max(1, resolved.height);
+        resolved.samplesPerPixel = std::max(1, resolved.samplesPerPixel);
+        resolved.tileSize = std::max(1, resolved.tileSize);
+        if (resolved.threadCount <= 0)
+        {
+            resolved.threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        }
+
+        RaytraceImage image;
+        image.width = resolved.width;
+        image.height = resolved.height;
+        image.rgb.assign(static_cast<size_t>(image.width) * static_cast<size_t>(image.height) * 3u, 0.0f);
+
+        TileJob job;
+        job.scene = &scene;
+        job.camera = &camera;
+        job.settings = &resolved;
+        job.image = &image;
+        job.tilesX = (image.width + resolved.tileSize - 1) / resolved.tileSize;
+        const int tilesY = (image.height + resolved.tileSize - 1) / resolved.tileSize;
+        const int tileCount = job.tilesX * tilesY;
+        const int threadCount = std::min(resolved.threadCount, tileCount);
+
+        // Tiles write disjoint pixels, so workers share nothing but the claim counter.
+        std::atomic<int> nextTile{0};
+        const auto worker = [&] {
+            for (int tile = nextTile.fetch_add(1); tile < tileCount; tile = nextTile.fetch_add(1))
+            {
+                RenderTile(job, tile);
+            }
+        };
+        std::vector<std::thread> threads;
+        threads.reserve(static_cast<size_t>(threadCount - 1));
+        for (int i = 1; i < threadCount; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        if (stats)
+        {
+            stats->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            stats->tiles = static_cast<size_t>(tileCount);
+            stats->primaryRays = static_cast<size_t>(image.width) * static_cast<size_t>(image.height) * static_cast<size_t>(resolved.samplesPerPixel);
+            stats->threads = threadCount;
+        }
+        return image;
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "scene_file.h"
+
+// CPU path tracer for headless renders: level thumbnails, regression images and a reference for
+// the WebGL Compile Scene preview. It follows the preview shader's model exactly: the cubes form
+// a voxel grid walked with a DDA, the ground is the y = 0 plane, glow cubes are area lights
+// sampled at every diffuse hit, bounces are cosine-weighted, glass passes light tinted 55% of
+// the time, and a flat 0.05 ambient stands in for everything else.
+//
+// The image is split into square tiles that worker threads claim one at a time. Every pixel's
+// random stream is seeded from its coordinates, so the image doesn't depend on the tiling or the
+// thread count (raytrace_render --verify).
+namespace vengine
+{
+    enum class VoxelKind : uint8_t
+    {
+        Empty,
+        Solid,
+        Glow,
+        Glass,
+    };
+
+    struct Voxel
+    {
+        float r = 0.0f;
+        float g = 0.0f;
+        float b = 0.0f;
+        VoxelKind kind = VoxelKind::Empty;
+    };
+
+    // Dense grid over the cubes' bounding box. Cell (i, j, k) covers
+    // [origin + (i, j, k), origin + (i + 1, j + 1, k + 1)], matching the editor's cubes, which are
+    // centred on integer x/z and stand on integer y.
+    class RaytraceScene
+    {
+    public:
+        // Fails when the bounding box would need more than maxCells cells.
+        bool Build(const std::vector<SceneCube>& cubes, std::string& errorMessage, size_t maxCells = size_t{1} << 26);
+
+        const Voxel& At(int index) const { return m_voxels[static_cast<size_t>(index)]; }
+        int CellIndex(int x, int y, int z) const { return (z * m_size[1] + y) * m_size[0] + x; }
+        const float* Origin() const { return m_origin; }
+        const int* Size() const { return m_size; }
+        const std::vector<int>& GlowCells() const { return m_glowCells; }
+        size_t CubeCount() const { return m_cubeCount; }
+
+        // Centre of the bounding box and its largest extent, for framing a default camera.
+        void Bounds(float center[3], float& extent) const;
+
+    private:
+        std::vector<Voxel> m_voxels;
+        std::vector<int> m_glowCells;
+        float m_origin[3] = {0.0f, 0.0f, 0.0f};
+        int m_size[3] = {0, 0, 0};
+        size_t m_cubeCount = 0;
+    };
+
+    struct RaytraceCamera
+    {
+        float eye[3] = {0.0f, 8.0f, 8.0f};
+        float dir[3] = {0.0f, -0.7071f, -0.7071f};
+        float right[3] = {1.0f, 0.0f, 0.0f};
+        float up[3] = {0.0f, 0.7071f, -0.7071f};
+        float tanHalfFov = 0.57735f;
+
+        // World +y is up, as in both frontends.
+        static RaytraceCamera LookAt(const float eye[3], const float target[3], float verticalFovDegrees);
+    };
+
+    struct RaytraceSettings
+    {
+        int width = 512;
+        int height = 512;
+        int samplesPerPixel = 64;
+        int threadCount = 0; // 0 uses every hardware thread.
+        int tileSize = 32;
+    };
+
+    struct RaytraceStats
+    {
+        double milliseconds = 0.0;
+        size_t tiles = 0;
+        size_t primaryRays = 0;
+        int threads = 0;
+    };
+
+    // Mean radiance per pixel, rgb floats, top row first.
+    struct RaytraceImage
+    {
+        int width = 0;
+        int height = 0;
+        std::vector<float> rgb;
+
+        // Clamped to [0, 1] like the preview's blit, alpha 255.
+        std::vector<uint8_t> ToRgba8() const;
+    };
+
+    RaytraceImage RenderRaytrace(const RaytraceScene& scene, const RaytraceCamera& camera, const RaytraceSettings& settings,
+                                 RaytraceStats* stats = nullptr);
+}
@@ -0,0 +1,176 @@
+#include "texture_compress.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace vengine
+{
+    namespace
+    {
+        uint16_t PackRgb565(int r, int g, int b)
+        {
+            return static_cast<uint16_t>(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+        }
+
+        void UnpackRgb565(uint16_t packed, int rgb[3])
+        {
+            const int r = (packed >> 11) & 31;
+            const int g = (packed >> 5) & 63;
+            const int b = packed & 31;
+            rgb[0] = (r << 3) | (r >> 2);
+            rgb[1] = (g << 2) | (g >> 4);
+            rgb[2] = (b << 3) | (b >> 2);
+        }
+
+        // BC3 colour blocks always decode in four-colour mode, whatever the endpoint order.
+        void BuildColorPalette(uint16_t color0, uint16_t color1, int palette[4][3])
+        {
+            UnpackRgb565(color0, palette[0]);
+            UnpackRgb565(color1, palette[1]);
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+        }
+
+        // Eight-level mode when alpha0 > alpha1, otherwise six levels plus 0 and 255.
+        void BuildAlphaPalette(int alpha0, int alpha1, int palette[8])
+        {
+            palette[0] = alpha0;
+            palette[1] = alpha1;
+            if (alpha0 > alpha1)
+            {
+                for (int i = 1; i < 7; ++i)
+                {
+                    palette[i + 1] = ((7 - i) * alpha0 + i * alpha1 + 3) / 7;
+                }
+                return;
+            }
+            for (int i = 1; i < 5; ++i)
+            {
+                palette[i + 1] = ((5 - i) * alpha0 + i * alpha1 + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    void EncodeBc3Block(const uint8_t* image, int imageSize, int blockX, int blockY, PixelOrder order, uint8_t* out)
+    {
+        const int red = order == PixelOrder::Bgra ? 2 : 0;
+        uint8_t texels[16][4];
+        int minC[4] = {255, 255, 255, 255};
+        int maxC[4] = {0, 0, 0, 0};
+        for (int i = 0; i < 16; ++i)
+        {
+            const uint8_t* px = image + (static_cast<size_t>(blockY * 4 + i / 4) * static_cast<size_t>(imageSize) + static_cast<size_t>(blockX * 4 + i % 4)) * 4u;
+            for (int c = 0; c < 4; ++c)
+            {
+                // Endpoints come from the swizzled texel, so BGRA input gets RGB565 endpoints too.
+                texels[i][c] = px[(c == 0 || c == 2) ? (c ^ red) : c];
+                minC[c] = std::min(minC[c], static_cast<int>(texels[i][c]));
+                maxC[c] = std::max(maxC[c], static_cast<int>(texels[i][c]));
+            }
+        }
+
+        // Alpha: equal endpoints select the six-level mode, whose first entry is still alpha0.
+        int alphaPalette[8];
+        BuildAlphaPalette(maxC[3], minC[3], alphaPalette);
+        uint64_t alphaBits = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            int bestError = 256;
+            for (int p = 0; p < 8; ++p)
+            {
+                const int error = std::abs(alphaPalette[p] - texels[i][3]);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            alphaBits |= static_cast<uint64_t>(best) << (3 * i);
+        }
+        out[0] = static_cast<uint8_t>(maxC[3]);
+        out[1] = static_cast<uint8_t>(minC[3]);
+        for (int i = 0; i < 6; ++i)
+        {
+            out[2 + i] = static_cast<uint8_t>((alphaBits >> (8 * i)) & 0xFF);
+        }
+
+        const uint16_t color0 = PackRgb565(maxC[0], maxC[1], maxC[2]);
+        const uint16_t color1 = PackRgb565(minC[0], minC[1], minC[2]);
+        int palette[4][3];
+        BuildColorPalette(color0, color1, palette);
+        uint32_t colorBits = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            int bestError = std::numeric_limits<int>::max();
+            for (int p = 0; p < 4; ++p)
+            {
+                const int dr = palette[p][0] - texels[i][0];
+                const int dg = palette[p][1] - texels[i][1];
+                const int db = palette[p][2] - texels[i][2];
+                const int error = dr * dr + dg * dg + db * db;
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            colorBits |= static_cast<uint32_t>(best) << (2 * i);
+        }
+        out[8] = static_cast<uint8_t>(color0 & 0xFF);
+        out[9] = static_cast<uint8_t>(color0 >> 8);
+        out[10] = static_cast<uint8_t>(color1 & 0xFF);
+        out[11] = static_cast<uint8_t>(color1 >> 8);
+        for (int i = 0; i < 4; ++i)
+        {
+            out[12 + i] = static_cast<uint8_t>((colorBits >> (8 * i)) & 0xFF);
+        }
+    }
+
+    void EncodeBc3Image(const std::vector<uint8_t>& pixels, int size, PixelOrder order, std::vector<uint8_t>& out)
+    {
+        const int blocks = size / 4;
+        out.resize(static_cast<size_t>(blocks) * static_cast<size_t>(blocks) * 16u);
+        for (int by = 0; by < blocks; ++by)
+        {
+            for (int bx = 0; bx < blocks; ++bx)
+            {
+                EncodeBc3Block(pixels.data(), size, bx, by, order, &out[(static_cast<size_t>(by) * static_cast<size_t>(blocks) + static_cast<size_t>(bx)) * 16u]);
+            }
+        }
+    }
+
+    void DecodeBc3Block(const uint8_t* block, uint8_t out[16][4])
+    {
+        int alphaPalette[8];
+        BuildAlphaPalette(block[0], block[1], alphaPalette);
+        uint64_t alphaBits = 0;
+        for (int i = 0; i < 6; ++i)
+        {
+            alphaBits |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+        }
+
+        const uint16_t color0 = static_cast<uint16_t>(block[8] | (block[9] << 8));
+        const uint16_t color1 = static_cast<uint16_t>(block[10] | (block[11] << 8));
+        int palette[4][3];
+        BuildColorPalette(color0, color1, palette);
+        const uint32_t colorBits = static_cast<uint32_t>(block[12]) | (static_cast<uint32_t>(block[13]) << 8) | (static_cast<uint32_t>(block[14]) << 16) |
+                                   (static_cast<uint32_t>(block[15]) << 24);
+
+        for (int i = 0; i < 16; ++i)
+        {
+            const int* color = palette[(colorBits >> (2 * i)) & 3u];
+            out[i][0] = static_cast<uint8_t>(color[0]);
+            out[i][1] = static_cast<uint8_t>(color[1]);
+            out[i][2] = static_cast<uint8_t>(color[2]);
+            out[i][3] = static_cast<uint8_t>(alphaPalette[(alphaBits >> (3 * i)) & 7u]);
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "image_decode.h"
+
+// Block compression for the atlas texture cache. The encoder is a bounding-box DXT5 (BC3) one:
+// each 4x4 block takes the per-channel min and max of its texels as endpoints, which is quick
+// enough to run on every atlas cell at load and good enough for voxel textures viewed through
+// the retro buffer. Blocks are always standard RGB565 DXT5, whatever order the source was in.
+namespace vengine
+{
+    // Encodes the 4x4 block at (blockX, blockY) of a size x size image of 32-bit pixels in the
+    // given channel order into 16 bytes at out.
+    void EncodeBc3Block(const uint8_t* image, int imageSize, int blockX, int blockY, PixelOrder order, uint8_t* out);
+
+    // size must be a multiple of 4; out is resized to (size / 4)^2 blocks.
+    void EncodeBc3Image(const std::vector<uint8_t>& pixels, int size, PixelOrder order, std::vector<uint8_t>& out);
+
+    // Decodes one 16-byte block into 16 RGBA8 texels, row by row.
+    void DecodeBc3Block(const uint8_t* block, uint8_t out[16][4]);
+}
@@ -0,0 +1,424 @@
+#include "world_gen.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vengine
+{
+    namespace
+    {
+        // Salts keep the noise fields and per-cell decisions independent of each other.
+        constexpr uint32_t kSaltHeight = 1;
+        constexpr uint32_t kSaltCave = 2;
+        constexpr uint32_t kSaltGlow = 3;
+        constexpr uint32_t kSaltGlass = 4;
+        constexpr uint32_t kSaltTower = 5;
+        constexpr uint32_t kSaltTint = 6;
+
+        constexpr float kTerrainScale = 1.0f / 40.0f;
+        constexpr float kCaveScaleXZ = 1.0f / 9.0f;
+        constexpr float kCaveScaleY = 1.0f / 5.0f;
+        constexpr int kTowerRadius = 2; // 5x5 footprint.
+
+        uint32_t Hash(uint32_t seed, uint32_t salt, int x, int y, int z)
+        {
+            uint32_t h = seed * 0x9E3779B9u ^ salt * 0x7FEB352Du;
+            h ^= static_cast<uint32_t>(x) * 0x85EBCA6Bu;
+            h = (h << 13) | (h >> 19);
+            h ^= static_cast<uint32_t>(y) * 0xC2B2AE35u;
+            h = (h << 17) | (h >> 15);
+            h ^= static_cast<uint32_t>(z) * 0x27D4EB2Fu;
+            h ^= h >> 15;
+            h *= 0x2C1B3C6Du;
+            h ^= h >> 12;
+            h *= 0x297A2D39u;
+            h ^= h >> 15;
+            return h;
+        }
+
+        // [0, 1).
+        float Unit(uint32_t hash)
+        {
+            return static_cast<float>(hash >> 8) * (1.0f / 16777216.0f);
+        }
+
+        float Smooth(float t)
+        {
+            return t * t * (3.0f - 2.0f * t);
+        }
+
+        float Lerp(float a, float b, float t)
+        {
+            return a + (b - a) * t;
+        }
+
+        // Value noise in [0, 1).
+        float Noise2(uint32_t seed, uint32_t salt, float x, float z)
+        {
+            const float fx = std::floor(x);
+            const float fz = std::floor(z);
+            const int ix = static_cast<int>(fx);
+            const int iz = static_cast<int>(fz);
+            const float tx = Smooth(x - fx);
+            const float tz = Smooth(z - fz);
+            const float a = Unit(Hash(seed, salt, ix, 0, iz));
+            const float b = Unit(Hash(seed, salt, ix + 1, 0, iz));
+            const float c = Unit(Hash(seed, salt, ix, 0, iz + 1));
+            const float d = Unit(Hash(seed, salt, ix + 1, 0, iz + 1));
+            return Lerp(Lerp(a, b, tx), Lerp(c, d, tx), tz);
+        }
+
+        float Noise3(uint32_t seed, uint32_t salt, float x, float y, float z)
+        {
+            const float fx = std::floor(x);
+            const float fy = std::floor(y);
+            const float fz = std::floor(z);
+            const int ix = static_cast<int>(fx);
+            const int iy = static_cast<int>(fy);
+            const int iz = static_cast<int>(fz);
+            const float tx = Smooth(x - fx);
+            const float ty = Smooth(y - fy);
+            const float tz = Smooth(z - fz);
+            float layers[2];
+            for (int dy = 0; dy < 2; ++dy)
+            {
+                const float a = Unit(Hash(seed, salt, ix, iy + dy, iz));
+                const float b = Unit(Hash(seed, salt, ix + 1, iy + dy, iz));
+                const float c = Unit(Hash(seed, salt, ix, iy + dy, iz + 1));
+                const float d = Unit(Hash(seed, salt, ix + 1, iy + dy, iz + 1));
+                layers[dy] = Lerp(Lerp(a, b, tx), Lerp(c, d, tx), tz);
+            }
+            return Lerp(layers[0], layers[1], ty);
+        }
+
+        int SurfaceHeight(const WorldGenSettings& settings, int x, int z)
+        {
+            float sum = 0.0f;
+            float amplitude = 0.5f;
+            float frequency = kTerrainScale;
+            float norm = 0.0f;
+            for (int octave = 0; octave < 4; ++octave)
+            {
+                sum += amplitude * Noise2(settings.seed, kSaltHeight + static_cast<uint32_t>(octave) * 16u, static_cast<float>(x) * frequency,
+                                          static_cast<float>(z) * frequency);
+                norm += amplitude;
+                amplitude *= 0.5f;
+                frequency *= 2.0f;
+            }
+            // Value noise bunches around 0.5; stretch it so the full range actually shows up.
+            const float h = std::clamp((sum / norm - 0.5f) * 1.8f + 0.5f, 0.0f, 1.0f);
+            return settings.baseHeight + static_cast<int>(std::lround(h * static_cast<float>(settings.heightRange)));
+        }
+
+        bool IsCave(const WorldGenSettings& settings, int x, int y, int z)
+        {
+            if (settings.caveDensity <= 0.0f)
+            {
+                return false;
+            }
+            const float n = Noise3(settings.seed, kSaltCave, static_cast<float>(x) * kCaveScaleXZ, static_cast<float>(y) * kCaveScaleY,
+                                   static_cast<float>(z) * kCaveScaleXZ);
+            // Interpolated noise is roughly triangular around 0.5, so this threshold carves about
+            // caveDensity of the cells for small densities.
+            return n > 1.0f - std::sqrt(std::clamp(settings.caveDensity, 0.0f, 1.0f) * 0.5f);
+        }
+
+        struct Rgb
+        {
+            float r;
+            float g;
+            float b;
+        };
+
+        Rgb TerrainColor(const WorldGenSettings& settings, int height, int depth)
+        {
+            if (depth > 3)
+            {
+                return {0.42f, 0.42f, 0.45f}; // Stone.
+            }
+            if (depth > 0)
+            {
+                return {0.45f, 0.33f, 0.22f}; // Dirt.
+            }
+            const float t = settings.heightRange > 0 ? static_cast<float>(height - settings.baseHeight) / static_cast<float>(settings.heightRange) : 0.5f;
+            if (t < 0.2f)
+            {
+                return {0.82f, 0.76f, 0.52f}; // Sand.
+            }
+            if (t < 0.6f)
+            {
+                return {0.33f, 0.62f, 0.30f}; // Grass.
+            }
+            if (t < 0.85f)
+            {
+                return {0.55f, 0.53f, 0.50f}; // Rock.
+            }
+            return {0.92f, 0.94f, 0.97f}; // Snow.
+        }
+
+        SceneCube MakeCube(int x, int y, int z, Rgb color, float tint)
+        {
+            SceneCube cube;
+            cube.gridX = x;
+            cube.gridY = y;
+            cube.gridZ = z;
+            cube.r = std::clamp(color.r * tint, 0.0f, 1.0f);
+            cube.g = std::clamp(color.g * tint, 0.0f, 1.0f);
+            cube.b = std::clamp(color.b * tint, 0.0f, 1.0f);
+            return cube;
+        }
+
+        bool InTowerFootprint(bool hasTower, int towerX, int towerZ, int x, int z)
+        {
+            return hasTower && std::abs(x - towerX) <= kTowerRadius && std::abs(z - towerZ) <= kTowerRadius;
+        }
+    }
+
+    int WorldChunkCountX(const WorldGenSettings& settings)
+    {
+        const int chunk = std::max(1, settings.chunkSize);
+        return (std::max(0, settings.sizeX) + chunk - 1) / chunk;
+    }
+
+    int WorldChunkCountZ(const WorldGenSettings& settings)
+    {
+        const int chunk = std::max(1, settings.chunkSize);
+        return (std::max(0, settings.sizeZ) + chunk - 1) / chunk;
+    }
+
+    WorldChunk GenerateWorldChunk(const WorldGenSettings& settings, int chunkX, int chunkZ)
+    {
+        const int chunkSize = std::max(1, settings.chunkSize);
+        const int worldX0 = -settings.sizeX / 2;
+        const int worldZ0 = -settings.sizeZ / 2;
+        const int x0 = worldX0 + chunkX * chunkSize;
+        const int z0 = worldZ0 + chunkZ * chunkSize;
+        const int x1 = std::min(x0 + chunkSize, worldX0 + settings.sizeX);
+        const int z1 = std::min(z0 + chunkSize, worldZ0 + settings.sizeZ);
+        return GenerateWorldCells(settings, chunkX, chunkZ, x0, z0, x1, z1);
+    }
+
+    WorldChunk GenerateUnboundedChunk(const WorldGenSettings& settings, int chunkX, int chunkZ)
+    {
+        const int chunkSize = std::max(1, settings.chunkSize);
+        const int x0 = chunkX * chunkSize;
+        const int z0 = chunkZ * chunkSize;
+        return GenerateWorldCells(settings, chunkX, chunkZ, x0, z0, x0 + chunkSize, z0 + chunkSize);
+    }
+
+    WorldChunk GenerateWorldCells(const WorldGenSettings& settings, int chunkX, int chunkZ, int x0, int z0, int x1, int z1)
+    {
+        WorldChunk chunk;
+        chunk.chunkX = chunkX;
+        chunk.chunkZ = chunkZ;
+        if (x1 <= x0 || z1 <= z0)
+        {
+            return chunk;
+        }
+
+        // At most one tower per chunk, placed so its footprint stays inside the chunk.
+        const uint32_t towerHash = Hash(settings.seed, kSaltTower, chunkX, 0, chunkZ);
+        const bool hasTower = x1 - x0 > kTowerRadius * 2 && z1 - z0 > kTowerRadius * 2 && Unit(towerHash) < settings.towerChance;
+        int towerX = 0;
+        int towerZ = 0;
+        if (hasTower)
+        {
+            const uint32_t spanX = static_cast<uint32_t>(x1 - x0 - kTowerRadius * 2);
+            const uint32_t spanZ = static_cast<uint32_t>(z1 - z0 - kTowerRadius * 2);
+            towerX = x0 + kTowerRadius + static_cast<int>((towerHash >> 4) % spanX);
+            towerZ = z0 + kTowerRadius + static_cast<int>((towerHash >> 16) % spanZ);
+        }
+
+        chunk.cubes.reserve(static_cast<size_t>((x1 - x0) * (z1 - z0)) * static_cast<size_t>(settings.baseHeight + settings.heightRange / 2 + 1));
+        int towerBase = 0;
+        for (int z = z0; z < z1; ++z)
+        {
+            for (int x = x0; x < x1; ++x)
+            {
+                const int height = SurfaceHeight(settings, x, z);
+                const float tint = 0.92f + 0.16f * Unit(Hash(settings.seed, kSaltTint, x, 0, z));
+                for (int y = 0; y < height; ++y)
+                {
+                    // The bedrock layer and the surface crust stay solid so caves never open into the sky.
+                    if (y > 0 && y < height - 1 && IsCave(settings, x, y, z))
+                    {
+                        continue;
+                    }
+                    chunk.cubes.push_back(MakeCube(x, y, z, TerrainColor(settings, height, height - 1 - y), tint));
+                }
+
+                if (InTowerFootprint(hasTower, towerX, towerZ, x, z))
+                {
+                    towerBase = std::max(towerBase, height);
+                    continue;
+                }
+                if (Unit(Hash(settings.seed, kSaltGlow, x, 0, z)) < settings.glowChance)
+                {
+                    SceneCube glow = MakeCube(x, height, z, {1.0f, 0.92f, 0.5f}, 1.0f);
+                    glow.glowing = true;
+                    chunk.cubes.push_back(glow);
+                }
+                else
+                {
+                    const uint32_t glassHash = Hash(settings.seed, kSaltGlass, x, 0, z);
+                    if (Unit(glassHash) < settings.glassChance)
+                    {
+                        const int stack = 1 + static_cast<int>((glassHash >> 3) % 3u);
+                        for (int i = 0; i < stack; ++i)
+                        {
+                            SceneCube glass = MakeCube(x, height + i, z, {0.75f, 0.9f, 1.0f}, 1.0f);
+                            glass.transparent = true;
+                            chunk.cubes.push_back(glass);
+                        }
+                    }
+                }
+            }
+        }
+
+        if (hasTower)
+        {
+            // A hollow 5x5 stone ring standing on the highest ground under it, with glass windows
+            // every fourth course and a glow cube on top.
+            const int towerHeight = 6 + static_cast<int>((towerHash >> 24) % 9u);
+            const int top = towerBase + towerHeight;
+            for (int z = towerZ - kTowerRadius; z <= towerZ + kTowerRadius; ++z)
+            {
+                for (int x = towerX - kTowerRadius; x <= towerX + kTowerRadius; ++x)
+                {
+                    const bool wall = std::abs(x - towerX) == kTowerRadius || std::abs(z - towerZ) == kTowerRadius;
+                    if (!wall)
+                    {
+                        continue;
+                    }
+                    const bool middleOfSide = x == towerX || z == towerZ;
+                    for (int y = SurfaceHeight(settings, x, z); y < top; ++y)
+                    {
+                        if (middleOfSide && y > towerBase && (y - towerBase) % 4 == 2)
+                        {
+                            SceneCube window = MakeCube(x, y, z, {0.75f, 0.9f, 1.0f}, 1.0f);
+                            window.transparent = true;
+                            chunk.cubes.push_back(window);
+                            continue;
+                        }
+                        chunk.cubes.push_back(MakeCube(x, y, z, {0.6f, 0.58f, 0.55f}, 1.0f));
+                    }
+                }
+            }
+            SceneCube beacon = MakeCube(towerX, top, towerZ, {1.0f, 0.92f, 0.5f}, 1.0f);
+            beacon.glowing = true;
+            chunk.cubes.push_back(beacon);
+        }
+        return chunk;
+    }
+
+    WorldGenerator::~WorldGenerator()
+    {
+        Cancel();
+    }
+
+    void WorldGenerator::Start(const WorldGenSettings& settings)
+    {
+        Cancel();
+        m_settings = settings;
+        m_chunksX = WorldChunkCountX(settings);
+        const size_t chunkCount = static_cast<size_t>(m_chunksX) * static_cast<size_t>(WorldChunkCountZ(settings));
+        unsigned threads = settings.threads > 0 ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(chunkCount, 1)));
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_chunkCount = chunkCount;
+            m_nextClaim = 0;
+            m_nextDelivery = 0;
+            m_window = static_cast<size_t>(threads) * 4;
+            m_stopRequested = false;
+        }
+        for (unsigned i = 0; i < threads && chunkCount > 0; ++i)
+        {
+            m_threads.emplace_back(&WorldGenerator::Run, this);
+        }
+    }
+
+    void WorldGenerator::Cancel()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopRequested = true;
+        }
+        m_claimable.notify_all();
+        m_ready.notify_all();
+        for (std::thread& thread : m_threads)
+        {
+            thread.join();
+        }
+        m_threads.clear();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished.clear();
+        m_chunkCount = 0;
+        m_nextClaim = 0;
+        m_nextDelivery = 0;
+    }
+
+    bool WorldGenerator::Running() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_nextDelivery < m_chunkCount;
+    }
+
+    size_t WorldGenerator::ChunkCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_chunkCount;
+    }
+
+    size_t WorldGenerator::DeliveredChunkCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_nextDelivery;
+    }
+
+    bool WorldGenerator::PopReady(WorldChunk& chunk, bool wait)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (wait)
+        {
+            m_ready.wait(lock, [this] { return m_stopRequested || m_nextDelivery >= m_chunkCount || m_finished.count(m_nextDelivery) != 0; });
+        }
+        const auto found = m_finished.find(m_nextDelivery);
+        if (found == m_finished.end())
+        {
+            return false;
+        }
+        chunk = std::move(found->second);
+        m_finished.erase(found);
+        ++m_nextDelivery;
+        lock.unlock();
+        m_claimable.notify_all();
+        return true;
+    }
+
+    void WorldGenerator::Run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
+        {
+            m_claimable.wait(lock, [this] { return m_stopRequested || m_nextClaim >= m_chunkCount || m_nextClaim < m_nextDelivery + m_window; });
+            if (m_stopRequested || m_nextClaim >= m_chunkCount)
+            {
+                return;
+            }
+            const size_t index = m_nextClaim++;
+            const int chunkX = static_cast<int>(index % static_cast<size_t>(m_chunksX));
+            const int chunkZ = static_cast<int>(index / static_cast<size_t>(m_chunksX));
+
+            lock.unlock();
+            WorldChunk chunk = GenerateWorldChunk(m_settings, chunkX, chunkZ);
+            lock.lock();
+            m_finished.emplace(index, std::move(chunk));
+            if (index == m_nextDelivery)
+            {
+                m_ready.notify_all();
+            }
+        }
+    }
+}
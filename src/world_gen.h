@@ -0,0 +1,109 @@
+#pragma once
+
+#include "scene_file.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Seeded procedural worlds for load and stress tests. The world is a grid of square chunks; each
+// chunk is a pure function of the settings and its coordinates: fBm heightmap terrain with
+// sand/grass/rock/snow banding, caves carved from 3D noise, the odd hollow tower with glass
+// windows and a glow cube on top, and scattered glow and glass cubes. Towers are kept inside their
+// chunk, so chunks never depend on each other.
+//
+// WorldGenerator builds chunks on worker threads but hands them out strictly in chunk order, so
+// the same seed gives the same cube sequence on any number of threads. Only a few chunks per
+// worker are held in flight, which lets a world of any size stream into the caller's storage.
+namespace vengine
+{
+    struct WorldGenSettings
+    {
+        uint32_t seed = 1;
+        int sizeX = 128; // Cells, centred on the origin.
+        int sizeZ = 128;
+        int chunkSize = 16;
+        int baseHeight = 2;        // Lowest possible surface.
+        int heightRange = 12;      // The surface rises up to baseHeight + heightRange.
+        float caveDensity = 0.12f; // Roughly the fraction of underground cells carved away.
+        float towerChance = 0.15f; // Per chunk.
+        float glowChance = 0.006f; // Per surface column.
+        float glassChance = 0.01f; // Per surface column.
+        unsigned threads = 0;      // 0 uses every hardware thread.
+    };
+
+    struct WorldChunk
+    {
+        int chunkX = 0;
+        int chunkZ = 0;
+        std::vector<SceneCube> cubes;
+    };
+
+    int WorldChunkCountX(const WorldGenSettings& settings);
+    int WorldChunkCountZ(const WorldGenSettings& settings);
+
+    // Chunk (chunkX, chunkZ) of the bounded sizeX x sizeZ world.
+    WorldChunk GenerateWorldChunk(const WorldGenSettings& settings, int chunkX, int chunkZ);
+    // Chunk (chunkX, chunkZ) of an endless world whose chunk (0, 0) starts at cell (0, 0); sizeX
+    // and sizeZ are ignored. Used by the world streamer for chunks that were never saved.
+    WorldChunk GenerateUnboundedChunk(const WorldGenSettings& settings, int chunkX, int chunkZ);
+    // The cells [x0, x1) x [z0, z1); chunkX/chunkZ only key the chunk's tower.
+    WorldChunk GenerateWorldCells(const WorldGenSettings& settings, int chunkX, int chunkZ, int x0, int z0, int x1, int z1);
+
+    class WorldGenerator
+    {
+    public:
+        WorldGenerator() = default;
+        ~WorldGenerator();
+        WorldGenerator(const WorldGenerator&) = delete;
+        WorldGenerator& operator=(const WorldGenerator&) = delete;
+
+        // Cancels any generation in progress and starts a new one.
+        void Start(const WorldGenSettings& settings);
+
+        // Passes chunks that are already finished, in order, to sink(WorldChunk&), up to maxChunks.
+        // With wait set it blocks for each chunk instead, so the count delivered is deterministic.
+        template <typename Sink>
+        size_t Drain(Sink&& sink, size_t maxChunks = std::numeric_limits<size_t>::max(), bool wait = false)
+        {
+            size_t delivered = 0;
+            WorldChunk chunk;
+            while (delivered < maxChunks && PopReady(chunk, wait))
+            {
+                sink(chunk);
+                ++delivered;
+            }
+            return delivered;
+        }
+
+        // Drops pending chunks and joins the workers.
+        void Cancel();
+
+        bool Running() const;
+        size_t ChunkCount() const;
+        size_t DeliveredChunkCount() const;
+
+    private:
+        bool PopReady(WorldChunk& chunk, bool wait);
+        void Run();
+
+        WorldGenSettings m_settings;
+        int m_chunksX = 0;
+        std::vector<std::thread> m_threads;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_claimable;
+        std::condition_variable m_ready;
+        std::unordered_map<size_t, WorldChunk> m_finished;
+        size_t m_chunkCount = 0;
+        size_t m_nextClaim = 0;
+        size_t m_nextDelivery = 0;
+        size_t m_window = 0; // Chunks allowed past m_nextDelivery.
+        bool m_stopRequested = false;
+    };
+}
@@ -0,0 +1,353 @@
+#include "world_stream.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vengine
+{
+    namespace
+    {
+        // Container and bookkeeping cost of a chunk on top of its cubes.
+        constexpr size_t kChunkOverheadBytes = 256;
+        // Focus moves faster than this (cells per second) are jumps, not motion to extrapolate.
+        constexpr float kMaxTrackedSpeed = 400.0f;
+        // Centre-to-corner distance of a chunk, so any chunk touching the radius is included.
+        constexpr float kChunkReach = 0.7072f * static_cast<float>(kStreamChunkSize);
+
+        float ChunkCenter(int chunk)
+        {
+            // Cells are centred on integer coordinates, so chunk c spans [16c - 0.5, 16c + 15.5).
+            return static_cast<float>(chunk * kStreamChunkSize) + 0.5f * static_cast<float>(kStreamChunkSize) - 0.5f;
+        }
+    }
+
+    WorldStreamer::~WorldStreamer()
+    {
+        Stop();
+    }
+
+    void WorldStreamer::Start(std::unique_ptr<ChunkStore> store, const WorldStreamSettings& settings)
+    {
+        Stop();
+        m_settings = settings;
+        m_settings.generation.chunkSize = kStreamChunkSize;
+        m_store = std::move(store);
+        m_stopRequested = false;
+        m_thread = std::thread(&WorldStreamer::Run, this);
+    }
+
+    void WorldStreamer::Stop()
+    {
+        if (m_thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopRequested = true;
+            }
+            m_wake.notify_all();
+            m_thread.join();
+        }
+        m_store.reset();
+        m_resident.clear();
+        m_requested.clear();
+        m_loads.clear();
+        m_saves.clear();
+        m_loaded.clear();
+        m_residentBytes = 0;
+        m_averageChunkBytes = 0;
+        m_velocityX = m_velocityZ = 0.0f;
+        m_haveFocus = false;
+        m_budgetLimited = false;
+    }
+
+    size_t WorldStreamer::ChunkBytes(size_t cubeCount) const
+    {
+        return cubeCount * m_settings.bytesPerCube + kChunkOverheadBytes;
+    }
+
+    std::vector<ChunkCoord> WorldStreamer::Update(float focusX, float focusZ, float radiusCells, float deltaTime)
+    {
+        std::vector<ChunkCoord> unload;
+        if (!m_store)
+        {
+            return unload;
+        }
+
+        if (m_haveFocus && deltaTime > 0.0f)
+        {
+            float velocityX = (focusX - m_lastFocusX) / deltaTime;
+            float velocityZ = (focusZ - m_lastFocusZ) / deltaTime;
+            if (velocityX * velocityX + velocityZ * velocityZ > kMaxTrackedSpeed * kMaxTrackedSpeed)
+            {
+                velocityX = velocityZ = 0.0f;
+            }
+            const float blend = std::min(1.0f, deltaTime * 4.0f);
+            m_velocityX += (velocityX - m_velocityX) * blend;
+            m_velocityZ += (velocityZ - m_velocityZ) * blend;
+        }
+        m_lastFocusX = focusX;
+        m_lastFocusZ = focusZ;
+        m_haveFocus = true;
+
+        struct Candidate
+        {
+            ChunkCoord coord;
+            float distance = 0.0f; // From the focus, which sets the load order.
+            bool resident = false;
+        };
+        std::vector<Candidate> candidates;
+        std::unordered_set<uint64_t> seen;
+        const auto gather = [&](float anchorX, float anchorZ, float reach, bool residentOnly) {
+            const int minX = StreamChunkOf(static_cast<int>(std::floor(anchorX - reach)));
+            const int maxX = StreamChunkOf(static_cast<int>(std::ceil(anchorX + reach)));
+            const int minZ = StreamChunkOf(static_cast<int>(std::floor(anchorZ - reach)));
+            const int maxZ = StreamChunkOf(static_cast<int>(std::ceil(anchorZ + reach)));
+            for (int z = minZ; z <= maxZ; ++z)
+            {
+                for (int x = minX; x <= maxX; ++x)
+                {
+                    const float cx = ChunkCenter(x);
+                    const float cz = ChunkCenter(z);
+                    if (std::hypot(cx - anchorX, cz - anchorZ) > reach)
+                    {
+                        continue;
+                    }
+                    const ChunkCoord coord{x, z};
+                    const bool resident = m_resident.count(Key(coord)) != 0;
+                    if ((residentOnly && !resident) || !seen.insert(Key(coord)).second)
+                    {
+                        continue;
+                    }
+                    candidates.push_back(Candidate{coord, std::hypot(cx - focusX, cz - focusZ), resident});
+                }
+            }
+        };
+
+        const float loadReach = radiusCells + kChunkReach;
+        gather(focusX, focusZ, loadReach, false);
+        const float aheadX = focusX + m_velocityX * m_settings.prefetchSeconds;
+        const float aheadZ = focusZ + m_velocityZ * m_settings.prefetchSeconds;
+        if (std::hypot(aheadX - focusX, aheadZ - focusZ) > 0.5f * static_cast<float>(kStreamChunkSize))
+        {
+            gather(aheadX, aheadZ, loadReach, false);
+        }
+        // The hysteresis band keeps what is already resident but never loads.
+        gather(focusX, focusZ, loadReach + static_cast<float>(m_settings.hysteresisChunks * kStreamChunkSize), true);
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.distance < b.distance; });
+
+        // Spend the budget nearest first; chunks not yet loaded are costed at the running average.
+        const size_t estimate = m_averageChunkBytes > 0 ? m_averageChunkBytes : ChunkBytes(kStreamChunkSize * kStreamChunkSize * 4);
+        std::unordered_set<uint64_t> wanted;
+        std::vector<ChunkCoord> toLoad;
+        size_t spent = 0;
+        m_budgetLimited = false;
+        for (const Candidate& candidate : candidates)
+        {
+            const size_t cost = candidate.resident ? m_resident[Key(candidate.coord)].bytes : estimate;
+            if (spent + cost > m_settings.budgetBytes)
+            {
+                m_budgetLimited = true;
+                break;
+            }
+            spent += cost;
+            wanted.insert(Key(candidate.coord));
+            if (!candidate.resident)
+            {
+                toLoad.push_back(candidate.coord);
+            }
+        }
+
+        bool haveLoads = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::unordered_set<uint64_t> queued;
+            for (const ChunkCoord& coord : m_loads)
+            {
+                queued.insert(Key(coord));
+            }
+            m_loads.clear();
+            for (const ChunkCoord& coord : toLoad)
+            {
+                const uint64_t key = Key(coord);
+                // Requested but no longer queued: in flight or waiting to be drained.
+                if (m_requested.count(key) != 0 && queued.count(key) == 0)
+                {
+                    continue;
+                }
+                m_requested.insert(key);
+                m_loads.push_back(coord);
+            }
+            // Unwanted requests are forgotten; anything already in flight is dropped on arrival.
+            for (auto it = m_requested.begin(); it != m_requested.end();)
+            {
+                it = wanted.count(*it) != 0 ? std::next(it) : m_requested.erase(it);
+            }
+            haveLoads = !m_loads.empty();
+        }
+        if (haveLoads)
+        {
+            m_wake.notify_one();
+        }
+
+        std::vector<std::pair<float, ChunkCoord>> leaving;
+        for (const auto& entry : m_resident)
+        {
+            if (wanted.count(entry.first) == 0)
+            {
+                const ChunkCoord& coord = entry.second.coord;
+                leaving.emplace_back(std::hypot(ChunkCenter(coord.x) - focusX, ChunkCenter(coord.z) - focusZ), coord);
+            }
+        }
+        std::sort(leaving.begin(), leaving.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        unload.reserve(leaving.size());
+        for (const auto& entry : leaving)
+        {
+            unload.push_back(entry.second);
+        }
+        return unload;
+    }
+
+    bool WorldStreamer::PopLoaded(LoadResult& result)
+    {
+        for (;;)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_loaded.empty())
+                {
+                    return false;
+                }
+                result = std::move(m_loaded.front());
+                m_loaded.pop_front();
+            }
+            const uint64_t key = Key(result.coord);
+            if (m_requested.erase(key) == 0 || m_resident.count(key) != 0)
+            {
+                continue;
+            }
+            if (result.failed)
+            {
+                ++m_ioErrors;
+                continue;
+            }
+            const size_t bytes = ChunkBytes(result.cubes.size());
+            m_averageChunkBytes = m_averageChunkBytes == 0 ? bytes : (m_averageChunkBytes * 7 + bytes) / 8;
+            // Planned at the average but came in heavier: drop it rather than overrun the budget.
+            // The next Update frees farther chunks and asks for it again if it still fits.
+            if (m_residentBytes + bytes > m_settings.budgetBytes)
+            {
+                m_budgetLimited = true;
+                continue;
+            }
+            m_resident[key] = Resident{result.coord, bytes, false};
+            m_residentBytes += bytes;
+            ++m_loadsCompleted;
+            return true;
+        }
+    }
+
+    void WorldStreamer::Unload(const ChunkCoord& coord, std::vector<SceneCube> cubes)
+    {
+        const auto found = m_resident.find(Key(coord));
+        if (found == m_resident.end())
+        {
+            return;
+        }
+        m_residentBytes -= found->second.bytes;
+        const bool dirty = found->second.dirty;
+        m_resident.erase(found);
+        if (dirty)
+        {
+            QueueSave(coord, std::move(cubes));
+        }
+    }
+
+    void WorldStreamer::MarkDirty(int cellX, int cellZ)
+    {
+        const auto found = m_resident.find(Key(ChunkCoord{StreamChunkOf(cellX), StreamChunkOf(cellZ)}));
+        if (found != m_resident.end())
+        {
+            found->second.dirty = true;
+        }
+    }
+
+    bool WorldStreamer::IsResident(int cellX, int cellZ) const
+    {
+        return m_resident.count(Key(ChunkCoord{StreamChunkOf(cellX), StreamChunkOf(cellZ)})) != 0;
+    }
+
+    void WorldStreamer::QueueSave(const ChunkCoord& coord, std::vector<SceneCube> cubes)
+    {
+        if (m_settings.readOnly)
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_saves.push_back(SaveJob{coord, std::move(cubes)});
+        }
+        m_wake.notify_one();
+    }
+
+    WorldStreamStats WorldStreamer::Stats() const
+    {
+        WorldStreamStats stats;
+        stats.residentChunks = m_resident.size();
+        stats.residentBytes = m_residentBytes;
+        stats.requestedChunks = m_requested.size();
+        stats.loadsCompleted = m_loadsCompleted;
+        stats.budgetLimited = m_budgetLimited;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats.queuedSaves = m_saves.size();
+        stats.savesCompleted = m_savesCompleted;
+        stats.ioErrors = m_ioErrors + m_saveErrors;
+        stats.lastError = m_lastError;
+        return stats;
+    }
+
+    void WorldStreamer::Run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
+        {
+            m_wake.wait(lock, [this] { return m_stopRequested || !m_saves.empty() || !m_loads.empty(); });
+            std::string error;
+            if (!m_saves.empty())
+            {
+                SaveJob job = std::move(m_saves.front());
+                m_saves.pop_front();
+                lock.unlock();
+                const bool saved = m_store->SaveChunk(job.coord, job.cubes, error);
+                lock.lock();
+                ++(saved ? m_savesCompleted : m_saveErrors);
+                if (!saved)
+                {
+                    m_lastError = error;
+                }
+                continue;
+            }
+            if (m_stopRequested)
+            {
+                return;
+            }
+
+            LoadResult result;
+            result.coord = m_loads.front();
+            m_loads.pop_front();
+            lock.unlock();
+            bool found = false;
+            const bool loaded = m_store->LoadChunk(result.coord, result.cubes, found, error);
+            if (loaded && !found && m_settings.generateMissing)
+            {
+                result.cubes = GenerateUnboundedChunk(m_settings.generation, result.coord.x, result.coord.z).cubes;
+            }
+            result.failed = !loaded;
+            lock.lock();
+            if (!loaded)
+            {
+                m_lastError = error;
+            }
+            m_loaded.push_back(std::move(result));
+        }
+    }
+}
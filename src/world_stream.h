@@ -0,0 +1,198 @@
+#pragma once
+
+#include "scene_file.h"
+#include "world_gen.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Streams an unbounded cube world around a moving focus point. The world is cut into columns of
+// kStreamChunkSize x kStreamChunkSize cells (all heights); a background I/O thread pages them in
+// from a ChunkStore and writes edited ones back when they leave. Each frame Update works out
+// which chunks should be resident: nearest first, within a radius of the focus and of where the
+// focus is heading (prefetch along its smoothed velocity), until the resident-memory budget is
+// spent. Everything else resident is handed back to the caller to unload.
+//
+// The streamer only tracks chunks; the frontend owns the cubes. It installs loaded chunks from
+// DrainLoaded and returns a chunk's cubes through Unload, which queues a save if the chunk was
+// edited. Saves always run before loads, so a chunk that leaves and comes straight back is read
+// after its edits are on disk.
+namespace vengine
+{
+    constexpr int kStreamChunkSize = 16;
+
+    inline int StreamChunkOf(int cell)
+    {
+        return cell >= 0 ? cell / kStreamChunkSize : -((-cell + kStreamChunkSize - 1) / kStreamChunkSize);
+    }
+
+    struct ChunkCoord
+    {
+        int x = 0;
+        int z = 0;
+    };
+
+    // Where chunks live on disk; RegionChunkStore (region_file.h) packs them into region files.
+    class ChunkStore
+    {
+    public:
+        virtual ~ChunkStore() = default;
+        // found is false, and the call succeeds, for a chunk that was never saved.
+        virtual bool LoadChunk(const ChunkCoord& coord, std::vector<SceneCube>& cubes, bool& found, std::string& error) = 0;
+        virtual bool SaveChunk(const ChunkCoord& coord, const std::vector<SceneCube>& cubes, std::string& error) = 0;
+    };
+
+    struct WorldStreamSettings
+    {
+        size_t budgetBytes = size_t{256} << 20;
+        size_t bytesPerCube = 64;     // What one resident cube costs the frontend.
+        float prefetchSeconds = 1.5f; // How far ahead along the focus's motion to load.
+        int hysteresisChunks = 2;     // Resident chunks this far past the radius stay until the budget wants them.
+        bool generateMissing = false; // Fill never-saved chunks from the generator instead of leaving them empty.
+        bool readOnly = false;        // Edited chunks are dropped on unload instead of saved.
+        WorldGenSettings generation;  // chunkSize is forced to kStreamChunkSize.
+    };
+
+    struct WorldStreamStats
+    {
+        size_t residentChunks = 0;
+        size_t residentBytes = 0;
+        size_t requestedChunks = 0;
+        size_t queuedSaves = 0;
+        size_t loadsCompleted = 0;
+        size_t savesCompleted = 0;
+        size_t ioErrors = 0;
+        bool budgetLimited = false; // The last Update stopped short of its radius.
+        std::string lastError;
+    };
+
+    class WorldStreamer
+    {
+    public:
+        WorldStreamer() = default;
+        ~WorldStreamer();
+        WorldStreamer(const WorldStreamer&) = delete;
+        WorldStreamer& operator=(const WorldStreamer&) = delete;
+
+        void Start(std::unique_ptr<ChunkStore> store, const WorldStreamSettings& settings);
+        // Finishes every queued save, then joins the I/O thread. Resident chunks are forgotten,
+        // so call SaveDirty first.
+        void Stop();
+        bool Active() const { return m_store != nullptr; }
+
+        void SetBudgetBytes(size_t bytes) { m_settings.budgetBytes = bytes; }
+        size_t BudgetBytes() const { return m_settings.budgetBytes; }
+
+        // Plans one frame around the focus (in cells) and queues the loads it needs. Returns the
+        // resident chunks that should go, farthest first; pass each to Unload.
+        std::vector<ChunkCoord> Update(float focusX, float focusZ, float radiusCells, float deltaTime);
+
+        // Passes chunks the I/O thread has finished to sink(const ChunkCoord&, std::vector<SceneCube>&)
+        // and marks them resident. Loads cancelled since they were queued, or that no longer fit the
+        // budget, are dropped here.
+        template <typename Sink>
+        size_t DrainLoaded(Sink&& sink, size_t maxChunks = std::numeric_limits<size_t>::max())
+        {
+            size_t delivered = 0;
+            LoadResult loaded;
+            while (delivered < maxChunks && PopLoaded(loaded))
+            {
+                sink(loaded.coord, loaded.cubes);
+                ++delivered;
+            }
+            return delivered;
+        }
+
+        // Takes a chunk's cubes off the caller's hands; they are saved if the chunk was edited.
+        void Unload(const ChunkCoord& coord, std::vector<SceneCube> cubes);
+
+        void MarkDirty(int cellX, int cellZ);
+        bool IsResident(int cellX, int cellZ) const;
+
+        // Queues a save of every edited resident chunk; collect(coord) returns the chunk's cubes.
+        template <typename Collect>
+        void SaveDirty(Collect&& collect)
+        {
+            for (auto& entry : m_resident)
+            {
+                if (entry.second.dirty)
+                {
+                    entry.second.dirty = false;
+                    QueueSave(entry.second.coord, collect(entry.second.coord));
+                }
+            }
+        }
+
+        WorldStreamStats Stats() const;
+
+    private:
+        struct Resident
+        {
+            ChunkCoord coord;
+            size_t bytes = 0;
+            bool dirty = false;
+        };
+
+        struct LoadResult
+        {
+            ChunkCoord coord;
+            std::vector<SceneCube> cubes;
+            bool failed = false;
+        };
+
+        struct SaveJob
+        {
+            ChunkCoord coord;
+            std::vector<SceneCube> cubes;
+        };
+
+        static uint64_t Key(const ChunkCoord& coord)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(coord.x)) << 32) | static_cast<uint32_t>(coord.z);
+        }
+
+        size_t ChunkBytes(size_t cubeCount) const;
+        bool PopLoaded(LoadResult& result);
+        void QueueSave(const ChunkCoord& coord, std::vector<SceneCube> cubes);
+        void Run();
+
+        WorldStreamSettings m_settings;
+        std::unique_ptr<ChunkStore> m_store;
+
+        // Main thread only.
+        std::unordered_map<uint64_t, Resident> m_resident;
+        std::unordered_set<uint64_t> m_requested; // Queued or in flight, not yet delivered.
+        size_t m_residentBytes = 0;
+        size_t m_averageChunkBytes = 0;
+        float m_lastFocusX = 0.0f;
+        float m_lastFocusZ = 0.0f;
+        float m_velocityX = 0.0f;
+        float m_velocityZ = 0.0f;
+        bool m_haveFocus = false;
+        bool m_budgetLimited = false;
+        size_t m_loadsCompleted = 0;
+        size_t m_ioErrors = 0;
+
+        // Shared with the I/O thread.
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::deque<ChunkCoord> m_loads; // Nearest first; rebuilt by every Update.
+        std::deque<SaveJob> m_saves;
+        std::deque<LoadResult> m_loaded;
+        size_t m_savesCompleted = 0;
+        size_t m_saveErrors = 0;
+        std::string m_lastError;
+        bool m_stopRequested = false;
+        std::thread m_thread;
+    };
+}
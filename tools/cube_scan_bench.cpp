@@ -0,0 +1,368 @@
+// Times the Win32 frontend's whole-scene cube scans (player collision, light occlusion and
+// picking rays) over the old array of CubeRecords and over CubeStore's split arrays, and reports
+// the bytes each scan streams per cube. Both layouts must give the same answers. Collision and
+// picking are then timed through the CubeChunkIndex the frontend answers them from now, which
+// must agree with the store scans.
+//
+//   cube_scan_bench [--size columns] [--iterations count]
+//
+// The scene is a --size x --size heightfield (default 400, about a million cubes) with some
+// glass, some glowing cubes and a texture path on every 50th cube, like a textured level.
+
+#include "cube_store.h"
+#include "frustum.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Vec3
+    {
+        float x;
+        float y;
+        float z;
+    };
+
+    // Slab test; t is the entry distance along dir (0 when origin is inside).
+    bool RayHitsCell(const Vec3& origin, const Vec3& dir, int x, int y, int z, float& t)
+    {
+        const float minB[3] = {static_cast<float>(x) - 0.5f, static_cast<float>(y), static_cast<float>(z) - 0.5f};
+        const float maxB[3] = {static_cast<float>(x) + 0.5f, static_cast<float>(y) + 1.0f, static_cast<float>(z) + 0.5f};
+        const float o[3] = {origin.x, origin.y, origin.z};
+        const float d[3] = {dir.x, dir.y, dir.z};
+        float tMin = 0.0f;
+        float tMax = std::numeric_limits<float>::max();
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (std::fabs(d[axis]) < 1e-6f)
+            {
+                if (o[axis] < minB[axis] || o[axis] > maxB[axis])
+                {
+                    return false;
+                }
+                continue;
+            }
+            const float invD = 1.0f / d[axis];
+            float t1 = (minB[axis] - o[axis]) * invD;
+            float t2 = (maxB[axis] - o[axis]) * invD;
+            if (t1 > t2)
+            {
+                std::swap(t1, t2);
+            }
+            tMin = std::max(tMin, t1);
+            tMax = std::min(tMax, t2);
+            if (tMax < tMin)
+            {
+                return false;
+            }
+        }
+        t = tMin;
+        return true;
+    }
+
+    bool BoxHitsCell(const Vec3& boxMin, const Vec3& boxMax, int x, int y, int z)
+    {
+        return boxMax.x > static_cast<float>(x) - 0.5f && boxMin.x < static_cast<float>(x) + 0.5f && boxMax.y > static_cast<float>(y) &&
+               boxMin.y < static_cast<float>(y) + 1.0f && boxMax.z > static_cast<float>(z) - 0.5f && boxMin.z < static_cast<float>(z) + 0.5f;
+    }
+
+    // The three scans, once per layout. Each returns something derived from every cube it tests so
+    // the compiler cannot drop the loop, and so the layouts can be compared.
+    size_t CollisionAos(const std::vector<vengine::CubeRecord>& cubes, const Vec3& boxMin, const Vec3& boxMax)
+    {
+        size_t hits = 0;
+        for (const vengine::CubeRecord& cube : cubes)
+        {
+            hits += BoxHitsCell(boxMin, boxMax, cube.gridX, cube.gridY, cube.gridZ) ? 1 : 0;
+        }
+        return hits;
+    }
+
+    size_t CollisionSoa(const vengine::CubeStore& cubes, const Vec3& boxMin, const Vec3& boxMax)
+    {
+        size_t hits = 0;
+        for (uint64_t cell : cubes.Cells())
+        {
+            int x, y, z;
+            vengine::UnpackCubeCell(cell, x, y, z);
+            hits += BoxHitsCell(boxMin, boxMax, x, y, z) ? 1 : 0;
+        }
+        return hits;
+    }
+
+    size_t OcclusionAos(const std::vector<vengine::CubeRecord>& cubes, const Vec3& origin, const Vec3& segment)
+    {
+        size_t blockers = 0;
+        for (const vengine::CubeRecord& cube : cubes)
+        {
+            float t = 0.0f;
+            if (!cube.transparent && RayHitsCell(origin, segment, cube.gridX, cube.gridY, cube.gridZ, t) && t > 1e-4f && t < 1.0f)
+            {
+                ++blockers;
+            }
+        }
+        return blockers;
+    }
+
+    size_t OcclusionSoa(const vengine::CubeStore& cubes, const Vec3& origin, const Vec3& segment)
+    {
+        size_t blockers = 0;
+        const std::vector<uint64_t>& cells = cubes.Cells();
+        const std::vector<uint8_t>& flags = cubes.Flags();
+        for (size_t i = 0; i < cells.size(); ++i)
+        {
+            if ((flags[i] & vengine::kCubeTransparent) != 0)
+            {
+                continue;
+            }
+            int x, y, z;
+            vengine::UnpackCubeCell(cells[i], x, y, z);
+            float t = 0.0f;
+            if (RayHitsCell(origin, segment, x, y, z, t) && t > 1e-4f && t < 1.0f)
+            {
+                ++blockers;
+            }
+        }
+        return blockers;
+    }
+
+    float PickAos(const std::vector<vengine::CubeRecord>& cubes, const Vec3& origin, const Vec3& dir)
+    {
+        float nearest = std::numeric_limits<float>::max();
+        for (const vengine::CubeRecord& cube : cubes)
+        {
+            float t = 0.0f;
+            if (RayHitsCell(origin, dir, cube.gridX, cube.gridY, cube.gridZ, t) && t > 0.0f && t < nearest)
+            {
+                nearest = t;
+            }
+        }
+        return nearest;
+    }
+
+    float PickSoa(const vengine::CubeStore& cubes, const Vec3& origin, const Vec3& dir)
+    {
+        float nearest = std::numeric_limits<float>::max();
+        for (uint64_t cell : cubes.Cells())
+        {
+            int x, y, z;
+            vengine::UnpackCubeCell(cell, x, y, z);
+            float t = 0.0f;
+            if (RayHitsCell(origin, dir, x, y, z, t) && t > 0.0f && t < nearest)
+            {
+                nearest = t;
+            }
+        }
+        return nearest;
+    }
+
+    // The frontend's queries: only the chunks overlapping the box, and only the chunks along the
+    // ray until one holds a hit nearer than its far side.
+    size_t CollisionChunks(const vengine::CubeChunkIndex& index, const vengine::CubeStore& cubes, const Vec3& boxMin, const Vec3& boxMax)
+    {
+        size_t hits = 0;
+        const auto centred = [](float v) { return static_cast<int>(std::floor(v + 0.5f)); };
+        index.ForEachInCellBox(centred(boxMin.x), static_cast<int>(std::floor(boxMin.y)), centred(boxMin.z), centred(boxMax.x),
+                               static_cast<int>(std::floor(boxMax.y)), centred(boxMax.z), [&](uint32_t item) {
+            int x, y, z;
+            cubes.Cell(item, x, y, z);
+            hits += BoxHitsCell(boxMin, boxMax, x, y, z) ? 1 : 0;
+        });
+        return hits;
+    }
+
+    float PickChunks(const vengine::CubeChunkIndex& index, const vengine::CubeStore& cubes, const Vec3& origin, const Vec3& dir)
+    {
+        float nearest = std::numeric_limits<float>::max();
+        const float o[3] = {origin.x, origin.y, origin.z};
+        const float d[3] = {dir.x, dir.y, dir.z};
+        index.ForEachChunkAlongRay(o, d, std::numeric_limits<float>::max(), [&](const std::vector<uint32_t>& items, float tExit) {
+            for (uint32_t item : items)
+            {
+                int x, y, z;
+                cubes.Cell(item, x, y, z);
+                float t = 0.0f;
+                if (RayHitsCell(origin, dir, x, y, z, t) && t > 0.0f && t < nearest)
+                {
+                    nearest = t;
+                }
+            }
+            return nearest > tExit;
+        });
+        return nearest;
+    }
+
+    // Best of iterations, in milliseconds; the result of the last run goes to out.
+    template <typename Scan, typename Result>
+    double TimeScan(int iterations, Scan scan, Result& out)
+    {
+        double best = std::numeric_limits<double>::max();
+        for (int i = 0; i < iterations; ++i)
+        {
+            const Clock::time_point start = Clock::now();
+            out = scan();
+            best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+        return best;
+    }
+
+    uint32_t Hash(int x, int z)
+    {
+        uint32_t h = static_cast<uint32_t>(x) * 0x8DA6B343u ^ static_cast<uint32_t>(z) * 0xD8163841u;
+        h ^= h >> 13;
+        h *= 0x85EBCA6Bu;
+        return h ^ (h >> 16);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int size = 400;
+    int iterations = 10;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--size" && hasValue)
+        {
+            size = std::clamp(std::atoi(argv[++i]), 8, 4096);
+        }
+        else if (arg == "--iterations" && hasValue)
+        {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown or incomplete argument: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    std::vector<vengine::CubeRecord> records;
+    for (int x = 0; x < size; ++x)
+    {
+        for (int z = 0; z < size; ++z)
+        {
+            const int height = 3 + static_cast<int>(Hash(x, z) % 6);
+            for (int y = 0; y < height; ++y)
+            {
+                vengine::CubeRecord cube;
+                cube.gridX = x - size / 2;
+                cube.gridY = y;
+                cube.gridZ = z - size / 2;
+                const float shade = 0.5f + 0.1f * static_cast<float>(y % 4);
+                cube.r = shade;
+                cube.g = shade * 0.9f;
+                cube.b = shade * 0.8f;
+                cube.transparent = records.size() % 37 == 0;
+                cube.glowing = records.size() % 997 == 0;
+                cube.presetIndex = static_cast<int>(records.size() % 6);
+                if (records.size() % 50 == 0)
+                {
+                    cube.texturePath = "textures/brick_wall_mossy.png";
+                }
+                records.push_back(std::move(cube));
+            }
+        }
+    }
+    vengine::CubeStore store;
+    store.Reserve(records.size());
+    for (const vengine::CubeRecord& cube : records)
+    {
+        store.Append(cube);
+    }
+
+    const size_t count = records.size();
+    std::printf("%zu cubes, %zu palette colours; record %zu bytes, store %zu bytes per cube\n", count, store.Palette().size(), sizeof(vengine::CubeRecord),
+                vengine::CubeStore::BytesPerCube());
+
+    // A player standing on top of the terrain, a glow lighting a point across the level, and a
+    // picking ray looking down at the middle: the shapes the frontend tests every frame.
+    const Vec3 boxMin{-0.35f, 9.0f, -0.35f};
+    const Vec3 boxMax{0.35f, 10.0f, 0.35f};
+    const float half = static_cast<float>(size) * 0.25f;
+    const Vec3 lightPos{-half, 9.5f, -half};
+    const Vec3 lightSegment{2.0f * half, -0.5f, 2.0f * half};
+    const Vec3 eye{0.0f, 40.0f, -30.0f};
+    const Vec3 pickDir{0.0f, -0.8f, 0.6f};
+
+    struct Row
+    {
+        const char* name;
+        double aosMs;
+        double soaMs;
+        size_t soaBytes;
+        bool same;
+    };
+    Row rows[3];
+    size_t aosHits = 0;
+    size_t soaHits = 0;
+    rows[0] = {"collision", TimeScan(iterations, [&] { return CollisionAos(records, boxMin, boxMax); }, aosHits),
+               TimeScan(iterations, [&] { return CollisionSoa(store, boxMin, boxMax); }, soaHits), sizeof(uint64_t), false};
+    rows[0].same = aosHits == soaHits;
+    const size_t collisionHits = soaHits;
+    rows[1] = {"occlusion", TimeScan(iterations, [&] { return OcclusionAos(records, lightPos, lightSegment); }, aosHits),
+               TimeScan(iterations, [&] { return OcclusionSoa(store, lightPos, lightSegment); }, soaHits), sizeof(uint64_t) + sizeof(uint8_t), false};
+    rows[1].same = aosHits == soaHits;
+    float aosT = 0.0f;
+    float soaT = 0.0f;
+    rows[2] = {"pick ray", TimeScan(iterations, [&] { return PickAos(records, eye, pickDir); }, aosT),
+               TimeScan(iterations, [&] { return PickSoa(store, eye, pickDir); }, soaT), sizeof(uint64_t), false};
+    rows[2].same = aosT == soaT;
+
+    vengine::CubeChunkIndex chunks;
+    const Clock::time_point indexStart = Clock::now();
+    for (size_t i = 0; i < store.Size(); ++i)
+    {
+        int x, y, z;
+        store.Cell(i, x, y, z);
+        chunks.Insert(static_cast<uint32_t>(i), x, y, z);
+    }
+    const double indexMs = std::chrono::duration<double, std::milli>(Clock::now() - indexStart).count();
+    size_t chunkHits = 0;
+    float chunkT = 0.0f;
+    const double chunkCollisionMs = TimeScan(iterations, [&] { return CollisionChunks(chunks, store, boxMin, boxMax); }, chunkHits);
+    const double chunkPickMs = TimeScan(iterations, [&] { return PickChunks(chunks, store, eye, pickDir); }, chunkT);
+
+    bool ok = true;
+    std::printf("  scan            records               store            speedup\n");
+    for (const Row& row : rows)
+    {
+        const double aosMb = static_cast<double>(count * sizeof(vengine::CubeRecord)) / (1024.0 * 1024.0);
+        const double soaMb = static_cast<double>(count * row.soaBytes) / (1024.0 * 1024.0);
+        std::printf("  %-9s %7.2f ms %6.1f MB read  %7.2f ms %6.1f MB read  %5.2fx%s\n", row.name, row.aosMs, aosMb, row.soaMs, soaMb,
+                    row.aosMs / row.soaMs, row.same ? "" : "  MISMATCH");
+        ok = ok && row.same;
+    }
+    std::printf("  chunk index: %zu chunks built in %.1f ms; collision %.2f us (%.0fx the store scan)%s, pick ray %.2f us (%.0fx)%s\n",
+                chunks.ChunkCount(), indexMs, chunkCollisionMs * 1000.0, rows[0].soaMs / chunkCollisionMs, chunkHits == collisionHits ? "" : "  MISMATCH",
+                chunkPickMs * 1000.0, rows[2].soaMs / chunkPickMs, chunkT == soaT ? "" : "  MISMATCH");
+    ok = ok && chunkHits == collisionHits && chunkT == soaT;
+
+    // The store must hand back exactly what went in.
+    for (size_t i = 0; i < count && ok; i += 101)
+    {
+        const vengine::CubeRecord back = store.Record(i);
+        const vengine::CubeRecord& cube = records[i];
+        ok = back.gridX == cube.gridX && back.gridY == cube.gridY && back.gridZ == cube.gridZ && back.r == cube.r && back.g == cube.g &&
+             back.b == cube.b && back.glowing == cube.glowing && back.transparent == cube.transparent && back.presetIndex == cube.presetIndex &&
+             back.texturePath == cube.texturePath;
+    }
+    // A cell past 2^20 would pack onto an existing one; the store must refuse it, not alias it.
+    vengine::CubeRecord far = records[0];
+    far.gridX += 1 << 21;
+    ok = ok && !store.Append(far) && store.Size() == count && store.Find(far.gridX, far.gridY, far.gridZ) == -1;
+    store.RemoveIf([&](size_t index) { return records[index].gridX < 0; });
+    ok = ok && store.Size() == static_cast<size_t>(std::count_if(records.begin(), records.end(), [](const vengine::CubeRecord& cube) { return cube.gridX >= 0; }));
+    std::printf("  round trip and removal %s\n", ok ? "check out" : "MISMATCH");
+    return ok ? 0 : 1;
+}
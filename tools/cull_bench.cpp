@@ -0,0 +1,147 @@
+// Compares per-cube frustum tests against CubeChunkIndex's chunk-then-cube walk on a large level
+// viewed from close to one corner, the case where most of the level is off screen.
+//
+//   cull_bench [grid_half_size] [iterations]
+//
+// The chunked walk must accept exactly the cubes the per-cube test accepts.
+
+#include "frustum.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Cell
+    {
+        int x;
+        int y;
+        int z;
+    };
+
+    // Column-major gluPerspective * gluLookAt, built the way the Win32 frontend's fixed-function
+    // stack composes them.
+    void BuildViewProjection(float eyeX, float eyeY, float eyeZ, float targetX, float targetZ, float* clip)
+    {
+        const float fovRadians = 60.0f * 3.1415926535f / 180.0f;
+        const float aspect = 16.0f / 9.0f;
+        const float zNear = 0.1f;
+        const float zFar = 100.0f;
+        const float f = 1.0f / std::tan(fovRadians * 0.5f);
+        float projection[16] = {};
+        projection[0] = f / aspect;
+        projection[5] = f;
+        projection[10] = -(zFar + zNear) / (zFar - zNear);
+        projection[11] = -1.0f;
+        projection[14] = -(2.0f * zFar * zNear) / (zFar - zNear);
+
+        float fx = targetX - eyeX;
+        float fy = -eyeY;
+        float fz = targetZ - eyeZ;
+        const float fl = std::sqrt(fx * fx + fy * fy + fz * fz);
+        fx /= fl;
+        fy /= fl;
+        fz /= fl;
+        float sx = -fz;
+        float sz = fx;
+        const float sl = std::sqrt(sx * sx + sz * sz);
+        sx /= sl;
+        sz /= sl;
+        const float ux = -sz * fy;
+        const float uy = sz * fx - sx * fz;
+        const float uz = sx * fy;
+
+        float view[16] = {};
+        view[0] = sx;
+        view[4] = 0.0f;
+        view[8] = sz;
+        view[1] = ux;
+        view[5] = uy;
+        view[9] = uz;
+        view[2] = -fx;
+        view[6] = -fy;
+        view[10] = -fz;
+        view[12] = -(sx * eyeX + sz * eyeZ);
+        view[13] = -(ux * eyeX + uy * eyeY + uz * eyeZ);
+        view[14] = fx * eyeX + fy * eyeY + fz * eyeZ;
+        view[15] = 1.0f;
+        vengine::MultiplyColumnMajor(projection, view, clip);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int halfSize = argc > 1 ? std::max(4, std::atoi(argv[1])) : 128;
+    const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 50;
+
+    std::vector<Cell> cells;
+    for (int z = -halfSize; z <= halfSize; ++z)
+    {
+        for (int x = -halfSize; x <= halfSize; ++x)
+        {
+            cells.push_back({x, 0, z});
+            if (((x * 7 + z * 13) & 15) == 0)
+            {
+                cells.push_back({x, 1, z});
+            }
+        }
+    }
+
+    vengine::CubeChunkIndex index;
+    const Clock::time_point buildStart = Clock::now();
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        index.Insert(static_cast<uint32_t>(i), cells[i].x, cells[i].y, cells[i].z);
+    }
+    const double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - buildStart).count();
+
+    float clip[16];
+    const float corner = static_cast<float>(halfSize) - 6.0f;
+    BuildViewProjection(corner + 6.0f, 9.0f, corner + 6.0f, corner, corner, clip);
+    vengine::Frustum frustum;
+    frustum.Extract(clip);
+
+    std::vector<uint32_t> bruteVisible;
+    std::vector<uint32_t> chunkVisible;
+    const Clock::time_point bruteStart = Clock::now();
+    for (int it = 0; it < iterations; ++it)
+    {
+        bruteVisible.clear();
+        for (size_t i = 0; i < cells.size(); ++i)
+        {
+            if (frustum.Intersects(vengine::CubeCellBounds(cells[i].x, cells[i].y, cells[i].z)))
+            {
+                bruteVisible.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+    const double bruteMs = std::chrono::duration<double, std::milli>(Clock::now() - bruteStart).count() / iterations;
+
+    const Clock::time_point chunkStart = Clock::now();
+    for (int it = 0; it < iterations; ++it)
+    {
+        chunkVisible.clear();
+        index.ForEachInFrustum(frustum, 0.0f, [&](uint32_t item) {
+            const Cell& cell = cells[item];
+            if (frustum.Intersects(vengine::CubeCellBounds(cell.x, cell.y, cell.z)))
+            {
+                chunkVisible.push_back(item);
+            }
+        });
+    }
+    const double chunkMs = std::chrono::duration<double, std::milli>(Clock::now() - chunkStart).count() / iterations;
+
+    std::sort(chunkVisible.begin(), chunkVisible.end());
+    const bool matches = chunkVisible == bruteVisible;
+    std::printf("%zu cubes in %zu chunks (index build %.2f ms)\n", cells.size(), index.ChunkCount(), buildMs);
+    std::printf("  visible     %zu (%.1f%%)\n", bruteVisible.size(), 100.0 * static_cast<double>(bruteVisible.size()) / static_cast<double>(cells.size()));
+    std::printf("  per-cube    %8.3f ms\n", bruteMs);
+    std::printf("  chunked     %8.3f ms%s\n", chunkMs, matches ? "" : "  MISMATCH");
+    return matches && !bruteVisible.empty() ? 0 : 1;
+}
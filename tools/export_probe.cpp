@@ -0,0 +1,270 @@
+// Exports a scene to OBJ and binary glTF with ExportScene and checks the output against the scene:
+// the culled face count must match an independent cell-by-cell count, the OBJ triangles must cover
+// exactly that many unit faces (so merging neither dropped nor doubled any), and the GLB header,
+// chunk lengths and JSON nesting must be consistent.
+//
+//   export_probe [--scene path] [--size cells] [--out dir]
+//
+// Without --scene it exports a generated world of --size x --size cells (default 360, about a
+// million cubes), with some glass and glowing cubes so materials split.
+
+#include "scene_export.h"
+#include "scene_file.h"
+#include "world_gen.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t CellKey(int x, int y, int z)
+    {
+        constexpr uint64_t kMask = (uint64_t{1} << 21) - 1;
+        return ((static_cast<uint64_t>(x) & kMask) << 42) | ((static_cast<uint64_t>(y) & kMask) << 21) | (static_cast<uint64_t>(z) & kMask);
+    }
+
+    size_t CountVisibleFaces(const std::vector<vengine::SceneCube>& cubes)
+    {
+        std::unordered_map<uint64_t, size_t> cells;
+        cells.reserve(cubes.size());
+        for (size_t i = 0; i < cubes.size(); ++i)
+        {
+            cells.emplace(CellKey(cubes[i].gridX, cubes[i].gridY, cubes[i].gridZ), i);
+        }
+        const int offsets[6][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+        size_t faces = 0;
+        for (const auto& cell : cells)
+        {
+            const vengine::SceneCube& cube = cubes[cell.second];
+            for (const auto& offset : offsets)
+            {
+                const auto other = cells.find(CellKey(cube.gridX + offset[0], cube.gridY + offset[1], cube.gridZ + offset[2]));
+                if (other == cells.end() || (cubes[other->second].transparent && !cube.transparent))
+                {
+                    ++faces;
+                }
+            }
+        }
+        return faces;
+    }
+
+    // Sums triangle areas in an OBJ; every vertex line is read, so it streams the file once.
+    bool ObjArea(const std::string& path, double& area, size_t& triangles)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            return false;
+        }
+        std::vector<float> positions;
+        std::string line;
+        area = 0.0;
+        triangles = 0;
+        while (std::getline(file, line))
+        {
+            if (line.rfind("v ", 0) == 0)
+            {
+                float x = 0.0f;
+                float y = 0.0f;
+                float z = 0.0f;
+                std::sscanf(line.c_str() + 2, "%f %f %f", &x, &y, &z);
+                positions.insert(positions.end(), {x, y, z});
+            }
+            else if (line.rfind("f ", 0) == 0)
+            {
+                size_t v[3] = {};
+                size_t ignored[6] = {};
+                if (std::sscanf(line.c_str() + 2, "%zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu", &v[0], &ignored[0], &ignored[1], &v[1], &ignored[2], &ignored[3],
+                                &v[2], &ignored[4], &ignored[5]) != 9)
+                {
+                    return false;
+                }
+                const float* a = &positions[(v[0] - 1) * 3];
+                const float* b = &positions[(v[1] - 1) * 3];
+                const float* c = &positions[(v[2] - 1) * 3];
+                const double e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+                const double e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+                const double cross[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+                area += 0.5 * std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+                ++triangles;
+            }
+        }
+        return true;
+    }
+
+    uint32_t ReadU32(const unsigned char* bytes)
+    {
+        return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) | (static_cast<uint32_t>(bytes[2]) << 16) |
+               (static_cast<uint32_t>(bytes[3]) << 24);
+    }
+
+    bool CheckGlb(const std::string& path, std::string& problem)
+    {
+        std::ifstream file(path, std::ios::binary);
+        unsigned char header[20];
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)))
+        {
+            problem = "short file";
+            return false;
+        }
+        std::error_code ec;
+        const uint64_t size = std::filesystem::file_size(path, ec);
+        if (ReadU32(header) != 0x46546C67u || ReadU32(header + 4) != 2 || ReadU32(header + 8) != size || ReadU32(header + 16) != 0x4E4F534Au)
+        {
+            problem = "bad GLB header";
+            return false;
+        }
+        std::string json(ReadU32(header + 12), '\0');
+        file.read(json.data(), static_cast<std::streamsize>(json.size()));
+        int depth = 0;
+        bool inString = false;
+        for (size_t i = 0; i < json.size(); ++i)
+        {
+            const char c = json[i];
+            if (inString)
+            {
+                i += c == '\\' ? 1 : 0;
+                inString = c != '"';
+            }
+            else if (c == '"')
+            {
+                inString = true;
+            }
+            else if (c == '{' || c == '[')
+            {
+                ++depth;
+            }
+            else if (c == '}' || c == ']')
+            {
+                depth -= depth > 0 ? 1 : 1000;
+            }
+        }
+        if (depth != 0 || inString)
+        {
+            problem = "unbalanced JSON";
+            return false;
+        }
+        unsigned char binHeader[8];
+        file.read(reinterpret_cast<char*>(binHeader), sizeof(binHeader));
+        const std::string lengthKey = "\"buffers\":[{\"byteLength\":";
+        const size_t at = json.find(lengthKey);
+        const uint64_t bufferLength = at == std::string::npos ? 0 : std::strtoull(json.c_str() + at + lengthKey.size(), nullptr, 10);
+        if (!file || ReadU32(binHeader + 4) != 0x004E4942u || ReadU32(binHeader) != (bufferLength + 3) / 4 * 4 ||
+            20 + json.size() + 8 + ReadU32(binHeader) != size)
+        {
+            problem = "BIN chunk does not match the buffer";
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string scenePath;
+    std::string outDir = std::filesystem::temp_directory_path().string();
+    int size = 360;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--scene" && hasValue)
+        {
+            scenePath = argv[++i];
+        }
+        else if (arg == "--size" && hasValue)
+        {
+            size = std::clamp(std::atoi(argv[++i]), 16, 4096);
+        }
+        else if (arg == "--out" && hasValue)
+        {
+            outDir = argv[++i];
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown or incomplete argument: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    std::vector<vengine::SceneCube> cubes;
+    std::string error;
+    if (!scenePath.empty())
+    {
+        if (!vengine::LoadSceneFile(scenePath, cubes, error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+    else
+    {
+        vengine::WorldGenSettings settings;
+        settings.seed = 5;
+        settings.sizeX = settings.sizeZ = size;
+        vengine::WorldGenerator generator;
+        generator.Start(settings);
+        generator.Drain(
+            [&](vengine::WorldChunk& chunk) {
+                for (vengine::SceneCube& cube : chunk.cubes)
+                {
+                    const size_t n = cubes.size();
+                    cube.transparent = cube.transparent || n % 211 == 0;
+                    cube.glowing = cube.glowing || n % 307 == 0;
+                    cubes.push_back(std::move(cube));
+                }
+            },
+            std::numeric_limits<size_t>::max(), true);
+    }
+
+    const size_t expectedFaces = CountVisibleFaces(cubes);
+    std::printf("%zu cubes, %zu visible unit faces\n", cubes.size(), expectedFaces);
+
+    bool ok = true;
+    const char* extensions[] = {".obj", ".glb"};
+    for (const char* extension : extensions)
+    {
+        const std::string path = (std::filesystem::path(outDir) / (std::string("vengine_export_probe") + extension)).string();
+        vengine::SceneExportStats stats;
+        const Clock::time_point start = Clock::now();
+        if (!vengine::ExportScene(cubes, path, vengine::SceneExportFormatForPath(path), stats, error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::printf("  %s  %8.1f ms  %zu chunks, %zu quads (%.1f%% of faces), %zu materials, %.1f MB\n", extension, seconds * 1000.0, stats.chunks, stats.quads,
+                    100.0 * static_cast<double>(stats.quads) / static_cast<double>(std::max<size_t>(1, stats.visibleFaces)), stats.materials,
+                    static_cast<double>(stats.bytesWritten) / (1024.0 * 1024.0));
+        bool same = stats.visibleFaces == expectedFaces;
+        std::string problem = same ? "" : "culled face count differs";
+        if (same && std::strcmp(extension, ".obj") == 0)
+        {
+            double area = 0.0;
+            size_t triangles = 0;
+            same = ObjArea(path, area, triangles) && std::fabs(area - static_cast<double>(expectedFaces)) < 0.5 && triangles == stats.quads * 2;
+            problem = same ? "" : "triangle area " + std::to_string(area) + " does not cover the visible faces";
+        }
+        else if (same)
+        {
+            same = CheckGlb(path, problem);
+        }
+        std::printf("    %s\n", same ? "output checks out" : ("MISMATCH: " + problem).c_str());
+        ok = ok && same;
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        std::filesystem::remove(std::filesystem::path(path).replace_extension(".mtl"), ec);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+// Exercises vengine::FileWatcher on a scratch directory: bursts of writes to the same file must
+// collapse into one debounced change, files in directories created after Start must be seen, and
+// the time from the last write to the change being available is reported.
+//
+//   file_watch_probe [debounce_ms]
+
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    namespace fs = std::filesystem;
+
+    void WriteFile(const fs::path& path, int value)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "revision " << value << '\n';
+    }
+
+    // Polls the watcher the way the frontends do once per frame, until expected paths arrived or
+    // the timeout passed. Returns everything received.
+    std::vector<std::string> CollectChanges(vengine::FileWatcher& watcher, size_t expected, std::chrono::milliseconds timeout, double& latencyMs)
+    {
+        std::vector<std::string> received;
+        std::vector<std::string> batch;
+        const Clock::time_point start = Clock::now();
+        latencyMs = -1.0;
+        while (Clock::now() - start < timeout)
+        {
+            watcher.TakeChanges(batch);
+            if (!batch.empty() && latencyMs < 0.0)
+            {
+                latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            }
+            received.insert(received.end(), batch.begin(), batch.end());
+            if (received.size() >= expected)
+            {
+                // Linger one more debounce window so duplicate reports would be caught.
+                std::this_thread::sleep_for(timeout / 4);
+                watcher.TakeChanges(batch);
+                received.insert(received.end(), batch.begin(), batch.end());
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(16));
+        }
+        std::sort(received.begin(), received.end());
+        return received;
+    }
+
+    bool Expect(const char* label, std::vector<std::string> received, std::vector<std::string> expected, double latencyMs)
+    {
+        std::sort(expected.begin(), expected.end());
+        const bool ok = received == expected;
+        std::printf("  %-28s %s (first change after %.1f ms)\n", label, ok ? "ok" : "FAILED", latencyMs);
+        if (!ok)
+        {
+            for (const std::string& path : received)
+            {
+                std::printf("    got %s\n", path.c_str());
+            }
+        }
+        return ok;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int debounceMs = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100;
+    if (!vengine::FileWatcher::Supported())
+    {
+        std::printf("file watching is not supported on this platform\n");
+        return 0;
+    }
+
+    std::error_code ec;
+    const fs::path root = fs::temp_directory_path(ec) / ("vengine_watch_probe_" + std::to_string(Clock::now().time_since_epoch().count()));
+    fs::create_directories(root / "textures", ec);
+    if (ec)
+    {
+        std::printf("unable to create %s\n", root.string().c_str());
+        return 1;
+    }
+
+    vengine::FileWatcher watcher;
+    if (!watcher.Start(root.string(), std::chrono::milliseconds(debounceMs)))
+    {
+        std::printf("watcher failed to start: %s\n", watcher.LastError().c_str());
+        return 1;
+    }
+    std::printf("file watcher, debounce %d ms, root %s\n", debounceMs, root.string().c_str());
+    const std::chrono::milliseconds timeout(debounceMs * 10 + 500);
+    bool ok = true;
+    double latencyMs = 0.0;
+    std::vector<std::string> received;
+
+    for (int i = 0; i < 20; ++i)
+    {
+        WriteFile(root / "notes.txt", i);
+    }
+    received = CollectChanges(watcher, 1, timeout, latencyMs);
+    ok = Expect("burst of 20 writes", received, {"notes.txt"}, latencyMs) && ok;
+
+    WriteFile(root / "textures" / "brick.png", 1);
+    WriteFile(root / "notes.txt", 100);
+    received = CollectChanges(watcher, 2, timeout, latencyMs);
+    ok = Expect("two files", received, {"notes.txt", "textures/brick.png"}, latencyMs) && ok;
+
+    fs::create_directories(root / "textures" / "new", ec);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    WriteFile(root / "textures" / "new" / "stone.png", 1);
+    received = CollectChanges(watcher, 1, timeout, latencyMs);
+    ok = Expect("directory created later", received, {"textures/new/stone.png"}, latencyMs) && ok;
+
+    watcher.Stop();
+    fs::remove_all(root, ec);
+    return ok ? 0 : 1;
+}
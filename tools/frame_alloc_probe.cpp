@@ -0,0 +1,207 @@
+// Runs a frame loop shaped like the renderers' (cull a cube list into transparent, glowing and
+// per-atlas-page batches, then queue and flush draw commands) and counts heap allocations per
+// frame with the counter frame_arena.cpp installs. Once warmed up, the FrameVector version must
+// make none; the std::vector version is timed alongside it for comparison. The render queue's
+// submission order for equal keys is checked too, since its sort is no longer stable_sort.
+//
+//   frame_alloc_probe [--cubes count] [--frames count]
+
+#include "frame_arena.h"
+#include "render_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr size_t kAtlasPages = 4;
+    constexpr int kWarmupFrames = 4;
+
+    struct Cube
+    {
+        int gridX = 0;
+        int gridZ = 0;
+        int page = 0;
+        bool transparent = false;
+        bool glowing = false;
+    };
+
+    class CheckingBackend : public vengine::RenderCommandBackend
+    {
+    public:
+        void SetBlendMode(vengine::BlendMode) override {}
+        void BindProgram(uint32_t) override {}
+        void BindVertexArray(uint32_t) override {}
+        void BindTexture(uint32_t) override {}
+        void Draw(const vengine::DrawCommand& command) override
+        {
+            // Every command of a key carries its submission index in first; it must only rise.
+            const uint64_t key = (static_cast<uint64_t>(command.blend) << 40) | (static_cast<uint64_t>(command.texture) << 20) | command.program;
+            ordered = ordered && (key != lastKey || command.first > lastFirst);
+            lastKey = key;
+            lastFirst = command.first;
+            ++draws;
+        }
+        void Restore() override { lastKey = ~uint64_t{0}; }
+
+        bool ordered = true;
+        size_t draws = 0;
+
+    private:
+        uint64_t lastKey = ~uint64_t{0};
+        int32_t lastFirst = -1;
+    };
+
+    // The frame varies which cubes are "visible" so list sizes move around like a moving camera's.
+    bool Visible(const Cube& cube, int frame)
+    {
+        return (cube.gridX + cube.gridZ + frame) % 5 != 0;
+    }
+
+    // makeList returns an empty list of cube pointers; makeBatches a list of kAtlasPages + 1 of them.
+    template <typename MakeList, typename MakeBatches>
+    size_t CullFrame(const std::vector<Cube>& cubes, int frame, MakeList makeList, MakeBatches makeBatches, vengine::RenderQueue& queue,
+                     CheckingBackend& backend)
+    {
+        auto transparentCubes = makeList();
+        auto glowingCubes = makeList();
+        auto batches = makeBatches();
+        for (const Cube& cube : cubes)
+        {
+            if (!Visible(cube, frame))
+            {
+                continue;
+            }
+            if (cube.glowing)
+            {
+                glowingCubes.push_back(&cube);
+            }
+            (cube.transparent ? transparentCubes : batches[static_cast<size_t>(cube.page)]).push_back(&cube);
+        }
+
+        queue.BeginFrame();
+        int32_t submitted = 0;
+        for (size_t page = 0; page < batches.size(); ++page)
+        {
+            for (const Cube* cube : batches[page])
+            {
+                vengine::DrawCommand command;
+                command.program = 1 + static_cast<uint32_t>(cube->gridZ & 1);
+                command.texture = static_cast<uint32_t>(page);
+                command.first = submitted++;
+                queue.Submit(command);
+            }
+        }
+        for (const Cube* cube : transparentCubes)
+        {
+            vengine::DrawCommand command;
+            command.blend = vengine::BlendMode::Alpha;
+            command.program = 1 + static_cast<uint32_t>(cube->gridX & 1);
+            command.first = submitted++;
+            queue.Submit(command);
+        }
+        queue.Flush(backend);
+        return static_cast<size_t>(submitted) + glowingCubes.size();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t cubeCount = 200000;
+    int frames = 60;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--cubes" && hasValue)
+        {
+            cubeCount = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "--frames" && hasValue)
+        {
+            frames = std::max(kWarmupFrames + 1, std::atoi(argv[++i]));
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown or incomplete argument: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    std::vector<Cube> cubes(cubeCount);
+    for (size_t i = 0; i < cubes.size(); ++i)
+    {
+        cubes[i].gridX = static_cast<int>(i % 512);
+        cubes[i].gridZ = static_cast<int>(i / 512);
+        cubes[i].page = static_cast<int>(i % (kAtlasPages + 1));
+        cubes[i].transparent = i % 13 == 0;
+        cubes[i].glowing = i % 97 == 0;
+    }
+
+    bool ok = true;
+    vengine::RenderQueue queue;
+    CheckingBackend backend;
+
+    // Heap-backed lists, as the renderers used to build them.
+    double heapSeconds = 0.0;
+    uint64_t heapAllocations = 0;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        const uint64_t before = vengine::ThreadHeapAllocationCount();
+        const Clock::time_point start = Clock::now();
+        CullFrame(
+            cubes, frame, [] { return std::vector<const Cube*>(); }, [] { return std::vector<std::vector<const Cube*>>(kAtlasPages + 1); }, queue,
+            backend);
+        if (frame >= kWarmupFrames)
+        {
+            heapSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+            heapAllocations += vengine::ThreadHeapAllocationCount() - before;
+        }
+    }
+
+    vengine::FrameArena arena;
+    double arenaSeconds = 0.0;
+    uint64_t arenaAllocations = 0;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        const uint64_t before = vengine::ThreadHeapAllocationCount();
+        const Clock::time_point start = Clock::now();
+        arena.Reset();
+        const vengine::ArenaAllocator<const Cube*> allocator(arena);
+        using List = vengine::FrameVector<const Cube*>;
+        CullFrame(
+            cubes, frame, [&] { return List(allocator); }, [&] { return vengine::FrameVector<List>(kAtlasPages + 1, List(allocator), allocator); },
+            queue, backend);
+        if (frame >= kWarmupFrames)
+        {
+            arenaSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+            arenaAllocations += vengine::ThreadHeapAllocationCount() - before;
+        }
+    }
+
+    const int measured = frames - kWarmupFrames;
+    const double heapPerFrame = static_cast<double>(heapAllocations) / measured;
+    const double arenaPerFrame = static_cast<double>(arenaAllocations) / measured;
+    std::printf("%zu cubes, %d frames after %d warm-up\n", cubes.size(), measured, kWarmupFrames);
+    std::printf("  std::vector   %7.3f ms/frame  %6.1f heap allocations/frame\n", heapSeconds * 1000.0 / measured, heapPerFrame);
+    std::printf("  FrameVector   %7.3f ms/frame  %6.1f heap allocations/frame  (arena %.0f KB)\n", arenaSeconds * 1000.0 / measured, arenaPerFrame,
+                static_cast<double>(arena.LastFrameBytes()) / 1024.0);
+    if (arenaPerFrame != 0.0)
+    {
+        std::printf("    MISMATCH: arena frames still allocate\n");
+        ok = false;
+    }
+    if (!backend.ordered)
+    {
+        std::printf("    MISMATCH: render queue reordered commands with equal keys\n");
+        ok = false;
+    }
+    std::printf("  %zu draws replayed, equal keys %s\n", backend.draws, backend.ordered ? "kept submission order" : "reordered");
+    return ok ? 0 : 1;
+}
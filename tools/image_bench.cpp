@@ -0,0 +1,194 @@
+// Times the R/B swizzle kernels and the portable PNG decoder on 4K (3840x2160) images.
+//
+//   image_bench [iterations] [file.png ...]
+//
+// Without file arguments the decoder runs on a generated PNG that uses stored deflate blocks, which
+// isolates unfiltering and pixel conversion; pass real PNGs to include Huffman decoding.
+
+#include "image_decode.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr int kWidth = 3840;
+    constexpr int kHeight = 2160;
+
+    using Clock = std::chrono::steady_clock;
+
+    double MillisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void AppendBigEndian32(std::vector<uint8_t>& out, uint32_t value)
+    {
+        out.push_back(static_cast<uint8_t>(value >> 24));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void AppendChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& payload)
+    {
+        AppendBigEndian32(out, static_cast<uint32_t>(payload.size()));
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), payload.begin(), payload.end());
+        AppendBigEndian32(out, 0); // The decoder does not check CRCs.
+    }
+
+    // RGBA8 PNG with Sub-filtered rows wrapped in stored (uncompressed) deflate blocks.
+    std::vector<uint8_t> BuildStoredPng(const std::vector<uint8_t>& rgba, int width, int height)
+    {
+        const size_t rowBytes = static_cast<size_t>(width) * 4u;
+        std::vector<uint8_t> filtered;
+        filtered.reserve(static_cast<size_t>(height) * (rowBytes + 1u));
+        for (int y = 0; y < height; ++y)
+        {
+            const uint8_t* row = rgba.data() + static_cast<size_t>(y) * rowBytes;
+            filtered.push_back(1);
+            for (size_t i = 0; i < rowBytes; ++i)
+            {
+                filtered.push_back(static_cast<uint8_t>(row[i] - (i >= 4 ? row[i - 4] : 0)));
+            }
+        }
+
+        std::vector<uint8_t> zlib = {0x78, 0x01};
+        for (size_t offset = 0; offset < filtered.size(); offset += 0xFFFFu)
+        {
+            const size_t length = std::min<size_t>(0xFFFFu, filtered.size() - offset);
+            zlib.push_back(offset + length == filtered.size() ? 1 : 0);
+            zlib.push_back(static_cast<uint8_t>(length));
+            zlib.push_back(static_cast<uint8_t>(length >> 8));
+            zlib.push_back(static_cast<uint8_t>(~length));
+            zlib.push_back(static_cast<uint8_t>(~length >> 8));
+            zlib.insert(zlib.end(), filtered.begin() + static_cast<std::ptrdiff_t>(offset), filtered.begin() + static_cast<std::ptrdiff_t>(offset + length));
+        }
+        AppendBigEndian32(zlib, 0); // Adler-32, unchecked.
+
+        std::vector<uint8_t> header;
+        AppendBigEndian32(header, static_cast<uint32_t>(width));
+        AppendBigEndian32(header, static_cast<uint32_t>(height));
+        header.insert(header.end(), {8, 6, 0, 0, 0});
+
+        std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+        AppendChunk(png, "IHDR", header);
+        AppendChunk(png, "IDAT", zlib);
+        AppendChunk(png, "IEND", {});
+        return png;
+    }
+
+    bool BenchSwizzle(int iterations)
+    {
+        std::vector<uint8_t> source(static_cast<size_t>(kWidth) * kHeight * 4u);
+        std::mt19937 rng(1234);
+        for (uint8_t& byte : source)
+        {
+            byte = static_cast<uint8_t>(rng());
+        }
+        const size_t stride = static_cast<size_t>(kWidth) * 4u;
+
+        std::vector<uint8_t> reference(source.size());
+        vengine::SwizzleRedBlueRowsWith(vengine::SwizzleKernel::Scalar, source.data(), stride, reference.data(), stride, kWidth, kHeight);
+
+        std::printf("swizzle %dx%d, %d iterations (active kernel: %s)\n", kWidth, kHeight, iterations,
+                    vengine::SwizzleKernelName(vengine::ActiveSwizzleKernel()));
+        bool ok = true;
+        std::vector<uint8_t> output(source.size());
+        for (vengine::SwizzleKernel kernel : {vengine::SwizzleKernel::Scalar, vengine::SwizzleKernel::Ssse3, vengine::SwizzleKernel::Avx2})
+        {
+            if (!vengine::SwizzleKernelSupported(kernel))
+            {
+                std::printf("  %-7s unsupported on this CPU\n", vengine::SwizzleKernelName(kernel));
+                continue;
+            }
+            const Clock::time_point start = Clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                vengine::SwizzleRedBlueRowsWith(kernel, source.data(), stride, output.data(), stride, kWidth, kHeight);
+            }
+            const double ms = MillisecondsSince(start) / iterations;
+            const bool matches = output == reference;
+            ok = ok && matches;
+            std::printf("  %-7s %8.3f ms/image %7.2f GB/s%s\n", vengine::SwizzleKernelName(kernel), ms,
+                        static_cast<double>(source.size()) / (ms * 1.0e6), matches ? "" : "  MISMATCH");
+        }
+        return ok;
+    }
+
+    bool BenchDecode(const std::string& label, const std::vector<uint8_t>& png, int iterations)
+    {
+        vengine::DecodedImage image;
+        std::string error;
+        const Clock::time_point start = Clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            if (!vengine::DecodePng(png.data(), png.size(), image, error))
+            {
+                std::printf("  %s: %s\n", label.c_str(), error.c_str());
+                return false;
+            }
+        }
+        const double decodeMs = MillisecondsSince(start) / iterations;
+
+        const Clock::time_point swizzleStart = Clock::now();
+        vengine::ConvertPixelOrder(image, vengine::PixelOrder::Bgra);
+        const double swizzleMs = MillisecondsSince(swizzleStart);
+        std::printf("  %s (%dx%d): decode %.2f ms, to BGRA %.3f ms\n", label.c_str(), image.width, image.height, decodeMs, swizzleMs);
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+    bool ok = BenchSwizzle(iterations);
+
+    std::printf("png decode, %d iterations\n", iterations);
+    if (argc > 2)
+    {
+        for (int i = 2; i < argc; ++i)
+        {
+            std::FILE* file = std::fopen(argv[i], "rb");
+            if (!file)
+            {
+                std::printf("  %s: unable to open\n", argv[i]);
+                ok = false;
+                continue;
+            }
+            std::vector<uint8_t> bytes;
+            uint8_t buffer[64 * 1024];
+            size_t read = 0;
+            while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+            {
+                bytes.insert(bytes.end(), buffer, buffer + read);
+            }
+            std::fclose(file);
+            ok = BenchDecode(argv[i], bytes, iterations) && ok;
+        }
+    }
+    else
+    {
+        std::vector<uint8_t> rgba(static_cast<size_t>(kWidth) * kHeight * 4u);
+        for (int y = 0; y < kHeight; ++y)
+        {
+            for (int x = 0; x < kWidth; ++x)
+            {
+                uint8_t* px = &rgba[(static_cast<size_t>(y) * kWidth + static_cast<size_t>(x)) * 4u];
+                px[0] = static_cast<uint8_t>(x);
+                px[1] = static_cast<uint8_t>(y);
+                px[2] = static_cast<uint8_t>(x ^ y);
+                px[3] = 255;
+            }
+        }
+        ok = BenchDecode("generated 4K stored PNG", BuildStoredPng(rgba, kWidth, kHeight), iterations) && ok;
+    }
+    return ok ? 0 : 1;
+}
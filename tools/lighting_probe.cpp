@@ -0,0 +1,251 @@
+// Checks CubeLightField against the editor's original glow lighting (every glow against every
+// cube's box) on random cube piles, then times both on a larger scene and the field alone on a
+// generated-world-sized floor.
+//
+//   lighting_probe [--seeds count]
+//
+// The reference tests each light-to-receiver segment against every opaque cube's box, so rays
+// grazing an edge or corner count as blocked; the field's cell walk must agree exactly. Given the
+// field's reach the reference must match it exactly too, and without one it must stay within a
+// shade step (1/255) of it.
+
+#include "cube_lighting.h"
+#include "cube_store.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Slab test; t is the entry distance along dir (0 when origin is inside).
+    bool RayHitsCell(const float origin[3], const float dir[3], int x, int y, int z, float& t)
+    {
+        const float minB[3] = {static_cast<float>(x) - 0.5f, static_cast<float>(y), static_cast<float>(z) - 0.5f};
+        const float maxB[3] = {static_cast<float>(x) + 0.5f, static_cast<float>(y) + 1.0f, static_cast<float>(z) + 0.5f};
+        float tMin = 0.0f;
+        float tMax = std::numeric_limits<float>::max();
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (std::fabs(dir[axis]) < 1e-8f)
+            {
+                if (origin[axis] < minB[axis] || origin[axis] > maxB[axis])
+                {
+                    return false;
+                }
+                continue;
+            }
+            float t0 = (minB[axis] - origin[axis]) / dir[axis];
+            float t1 = (maxB[axis] - origin[axis]) / dir[axis];
+            if (t0 > t1)
+            {
+                std::swap(t0, t1);
+            }
+            tMin = std::max(tMin, t0);
+            tMax = std::min(tMax, t1);
+            if (tMin > tMax)
+            {
+                return false;
+            }
+        }
+        t = tMin;
+        return true;
+    }
+
+    // The editor's ComputeLightAtPoint before CubeLightField, for the cube at index receiver.
+    // Glows further than reach are skipped, as the field skips them; pass infinity for none.
+    float ReferenceLight(const vengine::CubeStore& cubes, size_t receiver, float reach)
+    {
+        int x, y, z;
+        cubes.Cell(receiver, x, y, z);
+        const float point[3] = {static_cast<float>(x), static_cast<float>(y) + 0.5f, static_cast<float>(z)};
+        float total = 0.2f;
+        bool hasGlow = false;
+        for (size_t light = 0; light < cubes.Size(); ++light)
+        {
+            if (!cubes.Glowing(light))
+            {
+                continue;
+            }
+            hasGlow = true;
+            int gx, gy, gz;
+            cubes.Cell(light, gx, gy, gz);
+            const float origin[3] = {static_cast<float>(gx), static_cast<float>(gy) + 0.5f, static_cast<float>(gz)};
+            const float dir[3] = {point[0] - origin[0], point[1] - origin[1], point[2] - origin[2]};
+            const float distSq = dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2];
+            if (distSq > reach * reach)
+            {
+                continue;
+            }
+            bool occluded = false;
+            for (size_t i = 0; i < cubes.Size() && distSq >= 1e-6f && !occluded; ++i)
+            {
+                if (cubes.Transparent(i) || i == light || i == receiver)
+                {
+                    continue;
+                }
+                int cx, cy, cz;
+                cubes.Cell(i, cx, cy, cz);
+                float t = 0.0f;
+                occluded = RayHitsCell(origin, dir, cx, cy, cz, t) && t > 1e-4f && t < 1.0f;
+            }
+            if (!occluded)
+            {
+                total += distSq < 1e-4f ? 1.0f : 2.6f / (1.0f + distSq * 0.45f);
+            }
+        }
+        return hasGlow ? std::clamp(total, 0.0f, 1.0f) : 0.35f;
+    }
+
+    void BuildPile(vengine::CubeStore& cubes, unsigned seed, int halfSize, int height, int glowEvery)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> column(-halfSize, halfSize);
+        std::uniform_int_distribution<int> level(0, height - 1);
+        const int attempts = (2 * halfSize + 1) * (2 * halfSize + 1) * height / 2;
+        for (int i = 0; i < attempts; ++i)
+        {
+            vengine::CubeRecord cube;
+            cube.gridX = column(rng);
+            cube.gridY = level(rng);
+            cube.gridZ = column(rng);
+            if (cubes.Find(cube.gridX, cube.gridY, cube.gridZ) >= 0)
+            {
+                continue;
+            }
+            cube.glowing = i % glowEvery == 0;
+            cube.transparent = i % 11 == 0;
+            cubes.Append(cube);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int seeds = 8;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--seeds" && i + 1 < argc)
+        {
+            seeds = std::max(1, std::atoi(argv[++i]));
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown or incomplete argument: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    const float kReach = static_cast<float>(vengine::CubeLightField::kGlowReach);
+    const float kUnbounded = std::numeric_limits<float>::infinity();
+    bool ok = true;
+    size_t checked = 0;
+    size_t mismatches = 0;
+    for (int seed = 0; seed < seeds; ++seed)
+    {
+        vengine::CubeStore cubes;
+        BuildPile(cubes, static_cast<unsigned>(seed), 6, 5, 17);
+        vengine::CubeLightField field;
+        field.Build(cubes);
+        for (size_t i = 0; i < cubes.Size(); ++i)
+        {
+            int x, y, z;
+            cubes.Cell(i, x, y, z);
+            const float expected = ReferenceLight(cubes, i, kReach);
+            const float actual = field.LightAtCube(x, y, z);
+            ++checked;
+            if (std::fabs(expected - actual) > 1e-4f)
+            {
+                if (++mismatches <= 4)
+                {
+                    std::printf("    cube (%d, %d, %d): reference %.4f, field %.4f\n", x, y, z, expected, actual);
+                }
+            }
+        }
+    }
+    std::printf("%zu cubes over %d piles: %zu differ from the reference\n", checked, seeds, mismatches);
+    ok = ok && mismatches == 0;
+
+    vengine::CubeStore large;
+    BuildPile(large, 1234u, 24, 6, 97);
+    const Clock::time_point buildStart = Clock::now();
+    vengine::CubeLightField field;
+    field.Build(large);
+    const double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - buildStart).count();
+    const size_t sampled = std::min<size_t>(large.Size(), 400);
+    std::vector<float> reference(sampled);
+    const Clock::time_point referenceStart = Clock::now();
+    for (size_t i = 0; i < sampled; ++i)
+    {
+        reference[i] = ReferenceLight(large, i, kUnbounded);
+    }
+    const double referenceMs = std::chrono::duration<double, std::milli>(Clock::now() - referenceStart).count();
+    std::vector<float> lit(sampled);
+    const Clock::time_point fieldStart = Clock::now();
+    for (size_t i = 0; i < sampled; ++i)
+    {
+        int x, y, z;
+        large.Cell(i, x, y, z);
+        lit[i] = field.LightAtCube(x, y, z);
+    }
+    const double fieldMs = std::chrono::duration<double, std::milli>(Clock::now() - fieldStart).count();
+    size_t reachMismatches = 0;
+    float worstShade = 0.0f;
+    for (size_t i = 0; i < sampled; ++i)
+    {
+        reachMismatches += std::fabs(ReferenceLight(large, i, kReach) - lit[i]) > 1e-4f ? 1 : 0;
+        worstShade = std::max(worstShade, std::fabs(vengine::CubeShadeForLight(reference[i]) - vengine::CubeShadeForLight(lit[i])));
+    }
+    std::printf("%zu cubes: field built in %.2f ms; %zu lookups take %.2f ms against %.2f ms for the reference\n", large.Size(), buildMs, sampled,
+                fieldMs, referenceMs);
+    std::printf("    %zu differ from the reference at reach %d; leaving out glows past it moves a shade by at most %.5f\n", reachMismatches,
+                vengine::CubeLightField::kGlowReach, worstShade);
+    ok = ok && reachMismatches == 0 && worstShade < 1.0f / 255.0f;
+
+    // A flat 512 x 512 floor, two layers deep, with a glow every 37 cubes: the size the world
+    // generator tops out at.
+    vengine::CubeStore world;
+    for (int z = -256; z < 256; ++z)
+    {
+        for (int x = -256; x < 256; ++x)
+        {
+            for (int y = 0; y < 2; ++y)
+            {
+                vengine::CubeRecord cube;
+                cube.gridX = x;
+                cube.gridY = y;
+                cube.gridZ = z;
+                cube.glowing = world.Size() % 37 == 0;
+                world.Append(cube);
+            }
+        }
+    }
+    const Clock::time_point worldBuildStart = Clock::now();
+    vengine::CubeLightField worldField;
+    worldField.Build(world);
+    const double worldBuildMs = std::chrono::duration<double, std::milli>(Clock::now() - worldBuildStart).count();
+    std::mt19937 rng(99u);
+    std::uniform_int_distribution<size_t> pick(0, world.Size() - 1);
+    const size_t worldSamples = 10000;
+    double worldSum = 0.0;
+    const Clock::time_point worldStart = Clock::now();
+    for (size_t i = 0; i < worldSamples; ++i)
+    {
+        int x, y, z;
+        world.Cell(pick(rng), x, y, z);
+        worldSum += worldField.LightAtCube(x, y, z);
+    }
+    const double worldMs = std::chrono::duration<double, std::milli>(Clock::now() - worldStart).count();
+    std::printf("%zu cubes: field built in %.1f ms; %zu lookups take %.2f ms (mean light %.3f)\n", world.Size(), worldBuildMs, worldSamples, worldMs,
+                worldSum / static_cast<double>(worldSamples));
+    return ok ? 0 : 1;
+}
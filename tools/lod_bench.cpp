@@ -0,0 +1,174 @@
+// Triangle counts for a 512x512 rolling terrain viewed from increasing camera distances, drawn at
+// full detail and with the frontend's distance-banded chunk LOD. The view footprint is taken as a
+// disc around the focus point whose radius grows with the camera distance, which is how the
+// orbit camera's ground coverage widens as it pulls back.
+//
+//   lod_bench [grid_half_size]
+//
+// Meshes go through ChunkLodCache's worker with a CubeLightField of the terrain and a scatter of
+// glowing cubes, so the run also reports how long the first zoom-out takes to land every mesh it
+// asks for, glow lighting included, and how much of each frame the render thread spends queuing.
+
+#include "chunk_lod.h"
+#include "cube_lighting.h"
+#include "cube_store.h"
+#include "frustum.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Must match kLodDistances in src/main.cpp.
+    constexpr float kLodDistances[vengine::kLodLevelCount - 1] = {48.0f, 96.0f};
+    constexpr int kTrianglesPerCube = 12;
+
+    struct Chunk
+    {
+        float centerX = 0.0f;
+        float centerY = 0.0f;
+        float centerZ = 0.0f;
+        std::vector<vengine::LodCell> cells;
+    };
+
+    int TerrainHeight(int x, int z)
+    {
+        const float h = 3.0f + 2.0f * std::sin(static_cast<float>(x) * 0.07f) + 2.0f * std::cos(static_cast<float>(z) * 0.05f);
+        return std::max(1, static_cast<int>(h));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int halfSize = argc > 1 ? std::max(16, std::atoi(argv[1])) : 256;
+
+    std::unordered_map<uint64_t, Chunk> chunks;
+    vengine::CubeStore store;
+    size_t cubeCount = 0;
+    size_t glowCount = 0;
+    for (int z = -halfSize; z < halfSize; ++z)
+    {
+        for (int x = -halfSize; x < halfSize; ++x)
+        {
+            const int height = TerrainHeight(x, z);
+            for (int y = 0; y < height; ++y)
+            {
+                const float shade = 0.5f + 0.1f * static_cast<float>(y);
+                // A lantern on top of every 24th column in each direction.
+                const bool glowing = y == height - 1 && x % 24 == 0 && z % 24 == 0;
+                const vengine::LodCell cell{x, y, z, 0.3f * shade, 0.7f * shade, 0.3f * shade, glowing};
+                chunks[vengine::CubeChunkIndex::KeyForCell(x, y, z)].cells.push_back(cell);
+                vengine::CubeRecord record;
+                record.gridX = x;
+                record.gridY = y;
+                record.gridZ = z;
+                record.r = cell.r;
+                record.g = cell.g;
+                record.b = cell.b;
+                record.glowing = glowing;
+                store.Append(record);
+                ++cubeCount;
+                glowCount += glowing ? 1 : 0;
+            }
+        }
+    }
+    const Clock::time_point lightingStart = Clock::now();
+    auto lighting = std::make_shared<vengine::CubeLightField>();
+    lighting->Build(store);
+    const double lightingMs = std::chrono::duration<double, std::milli>(Clock::now() - lightingStart).count();
+    for (auto& entry : chunks)
+    {
+        Chunk& chunk = entry.second;
+        for (const vengine::LodCell& cell : chunk.cells)
+        {
+            chunk.centerX += static_cast<float>(cell.x);
+            chunk.centerY += static_cast<float>(cell.y) + 0.5f;
+            chunk.centerZ += static_cast<float>(cell.z);
+        }
+        const float inv = 1.0f / static_cast<float>(chunk.cells.size());
+        chunk.centerX *= inv;
+        chunk.centerY *= inv;
+        chunk.centerZ *= inv;
+    }
+    std::printf("%zu cubes (%zu glowing) in %zu chunks, light field built in %.1f ms\n", cubeCount, glowCount, chunks.size(), lightingMs);
+    std::printf("  distance   chunks   full-detail tris   LOD tris   (L0/L1/L2 chunks)\n");
+
+    vengine::ChunkLodCache cache;
+    const float distances[] = {8.0f, 16.0f, 32.0f, 64.0f, 128.0f, 200.0f};
+    bool ok = true;
+    for (float distance : distances)
+    {
+        // Orbit camera at 45 degrees pitch looking at the origin.
+        const float eyeY = distance * 0.7071f;
+        const float eyeZ = distance * 0.7071f;
+        const float footprint = 1.5f * distance + 8.0f;
+
+        const Clock::time_point start = Clock::now();
+        size_t visibleChunks = 0;
+        size_t fullTriangles = 0;
+        size_t lodTriangles = 0;
+        size_t perLevel[vengine::kLodLevelCount] = {};
+        double slowestFrameMs = 0.0;
+        // Keep asking until every requested mesh has landed, as the renderer would frame by frame.
+        for (bool missing = true; missing;)
+        {
+            missing = false;
+            visibleChunks = fullTriangles = lodTriangles = 0;
+            std::fill(std::begin(perLevel), std::end(perLevel), size_t{0});
+            const Clock::time_point frameStart = Clock::now();
+            cache.BeginFrame();
+            for (const auto& entry : chunks)
+            {
+                const Chunk& chunk = entry.second;
+                if (std::hypot(chunk.centerX, chunk.centerZ) > footprint)
+                {
+                    continue;
+                }
+                ++visibleChunks;
+                fullTriangles += chunk.cells.size() * kTrianglesPerCube;
+
+                const float d = std::sqrt(chunk.centerX * chunk.centerX + (chunk.centerY - eyeY) * (chunk.centerY - eyeY) +
+                                          (chunk.centerZ - eyeZ) * (chunk.centerZ - eyeZ));
+                int level = 0;
+                while (level < vengine::kLodLevelCount - 1 && d >= kLodDistances[level])
+                {
+                    ++level;
+                }
+                ++perLevel[level];
+                if (level == 0)
+                {
+                    lodTriangles += chunk.cells.size() * kTrianglesPerCube;
+                    continue;
+                }
+                const vengine::LodMesh* mesh = cache.Acquire(entry.first, level, 0, [&chunk] { return chunk.cells; }, lighting);
+                if (!mesh)
+                {
+                    missing = true;
+                    continue;
+                }
+                lodTriangles += mesh->QuadCount() * 2;
+            }
+            cache.EndFrame();
+            slowestFrameMs = std::max(slowestFrameMs, std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count());
+            if (missing)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        const double landMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        std::printf("  %8.0f %8zu %18zu %10zu   (%zu/%zu/%zu)  meshes landed in %.1f ms, slowest frame %.1f ms\n", distance, visibleChunks,
+                    fullTriangles, lodTriangles, perLevel[0], perLevel[1], perLevel[2], landMs, slowestFrameMs);
+        ok = ok && lodTriangles <= fullTriangles;
+    }
+    cache.Stop();
+    return ok ? 0 : 1;
+}
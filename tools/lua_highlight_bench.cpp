@@ -0,0 +1,117 @@
+// Compares full re-lexing against LuaHighlightCache's incremental update on a 10k-line script.
+//
+//   lua_highlight_bench [edits]
+//
+// Each edit inserts or deletes a few bytes at a random position, the way typing does; the cache
+// result is checked against a from-scratch lex after every edit.
+
+#include "lua_highlighter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::string BuildScript(int lineCount)
+    {
+        static const char* kLines[] = {
+            "local function update_%d(dt, speed) -- advance the animation",
+            "    if state.timer > 0x1F and not paused then",
+            "        state.timer = state.timer - dt * 1.5",
+            "        print(\"tick %d\", state.timer)",
+            "    elseif state.mode == 'idle' then return nil end",
+            "end",
+        };
+        std::string script;
+        char buffer[128];
+        for (int i = 0; i < lineCount; ++i)
+        {
+            std::snprintf(buffer, sizeof(buffer), kLines[i % 6], i);
+            script += buffer;
+            script += '\n';
+        }
+        return script;
+    }
+
+    bool SameTokens(const vengine::LuaHighlightCache& a, const vengine::LuaHighlightCache& b)
+    {
+        const auto& linesA = a.Lines();
+        const auto& linesB = b.Lines();
+        if (linesA.size() != linesB.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < linesA.size(); ++i)
+        {
+            if (linesA[i].offset != linesB[i].offset || linesA[i].length != linesB[i].length ||
+                linesA[i].tokens.size() != linesB[i].tokens.size())
+            {
+                return false;
+            }
+            for (size_t t = 0; t < linesA[i].tokens.size(); ++t)
+            {
+                const vengine::LuaToken& x = linesA[i].tokens[t];
+                const vengine::LuaToken& y = linesB[i].tokens[t];
+                if (x.begin != y.begin || x.length != y.length || x.kind != y.kind)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int edits = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+    std::string script = BuildScript(10000);
+
+    vengine::LuaHighlightCache cache;
+    Clock::time_point start = Clock::now();
+    cache.Update(script);
+    const double fullMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::printf("full lex: %zu lines, %zu bytes, %.3f ms\n", cache.Lines().size(), script.size(), fullMs);
+
+    std::mt19937 rng(42);
+    static const char* kInserts[] = {"x", "\n", "end", "-- ", "\"", "  ", "0x1", "\n\n"};
+    double incrementalMs = 0.0;
+    size_t relexed = 0;
+    bool ok = true;
+    for (int i = 0; i < edits; ++i)
+    {
+        const size_t pos = rng() % (script.size() + 1);
+        if (rng() % 3 == 0 && pos < script.size())
+        {
+            script.erase(pos, std::min<size_t>(1 + rng() % 4, script.size() - pos));
+        }
+        else
+        {
+            script.insert(pos, kInserts[rng() % 8]);
+        }
+
+        start = Clock::now();
+        cache.Update(script);
+        incrementalMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        relexed += cache.LastRelexedLineCount();
+
+        vengine::LuaHighlightCache reference;
+        reference.Update(script);
+        if (!SameTokens(cache, reference))
+        {
+            std::printf("edit %d at byte %zu: incremental tokens differ from a full lex\n", i, pos);
+            ok = false;
+            break;
+        }
+    }
+    std::printf("incremental: %d edits, %.4f ms/edit, %.2f lines re-lexed/edit\n", edits, incrementalMs / edits,
+                static_cast<double>(relexed) / edits);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,304 @@
+// Exercises the mesh importer: the bundled cube, a large shuffled sphere for the vertex cache
+// optimiser, OBJ and GLB files written by the scene exporter, an embedded-buffer .gltf, and the
+// binary mesh cache.
+//
+//   mesh_probe [--cube path/to/cube.obj] [--segments N]
+//
+// Every mesh is checked for in-range indices, unit normals and triangles wound the way their
+// normals face; exported scenes must import with the exporter's triangle count and surface area.
+
+#include "mesh_import.h"
+#include "scene_export.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    bool g_ok = true;
+
+    void Check(bool condition, const char* what)
+    {
+        std::printf("    %-58s %s\n", what, condition ? "ok" : "FAILED");
+        g_ok = g_ok && condition;
+    }
+
+    double TriangleArea(const vengine::MeshData& mesh, size_t t, double normalDot[1])
+    {
+        const float* a = mesh.vertices[mesh.indices[t]].position;
+        const float* b = mesh.vertices[mesh.indices[t + 1]].position;
+        const float* c = mesh.vertices[mesh.indices[t + 2]].position;
+        const double e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        const double e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        const double cross[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        const float* n = mesh.vertices[mesh.indices[t]].normal;
+        normalDot[0] = cross[0] * n[0] + cross[1] * n[1] + cross[2] * n[2];
+        return 0.5 * std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+    }
+
+    // Returns the surface area; checks indices, normals and winding on the way.
+    double CheckMesh(const vengine::MeshData& mesh)
+    {
+        bool indicesInRange = mesh.indices.size() % 3 == 0;
+        for (const uint32_t index : mesh.indices)
+        {
+            indicesInRange = indicesInRange && index < mesh.vertices.size();
+        }
+        Check(indicesInRange, "indices in range");
+        if (!indicesInRange)
+        {
+            return 0.0;
+        }
+        bool unitNormals = true;
+        for (const vengine::MeshVertex& vertex : mesh.vertices)
+        {
+            const float* n = vertex.normal;
+            unitNormals = unitNormals && std::fabs(std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) - 1.0f) < 1e-3f;
+        }
+        Check(unitNormals, "unit normals");
+        double area = 0.0;
+        size_t backwards = 0;
+        for (size_t t = 0; t < mesh.indices.size(); t += 3)
+        {
+            double dot = 0.0;
+            area += TriangleArea(mesh, t, &dot);
+            backwards += dot < 0.0 ? 1 : 0;
+        }
+        Check(backwards == 0, "triangles wound counter-clockwise about their normals");
+        return area;
+    }
+
+    std::string SphereObj(int segments)
+    {
+        const int rings = segments / 2;
+        std::string text;
+        char line[128];
+        for (int r = 0; r <= rings; ++r)
+        {
+            const double phi = 3.14159265358979 * r / rings;
+            for (int s = 0; s <= segments; ++s)
+            {
+                const double theta = 2.0 * 3.14159265358979 * s / segments;
+                const double x = std::sin(phi) * std::cos(theta);
+                const double y = std::cos(phi);
+                const double z = -std::sin(phi) * std::sin(theta);
+                std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvn %.6f %.6f %.6f\nvt %.6f %.6f\n", x, y, z, x, y, z,
+                              static_cast<double>(s) / segments, 1.0 - static_cast<double>(r) / rings);
+                text += line;
+            }
+        }
+        // Quads as triangles, shuffled so the input has no cache locality left to lean on.
+        std::vector<std::string> faces;
+        const int row = segments + 1;
+        for (int r = 0; r < rings; ++r)
+        {
+            for (int s = 0; s < segments; ++s)
+            {
+                const int a = r * row + s + 1;
+                const int b = a + row;
+                std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, b + 1, b + 1, b + 1);
+                faces.push_back(line);
+                std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b + 1, b + 1, b + 1, a + 1, a + 1, a + 1);
+                faces.push_back(line);
+            }
+        }
+        std::shuffle(faces.begin(), faces.end(), std::mt19937(7));
+        for (const std::string& face : faces)
+        {
+            text += face;
+        }
+        return text;
+    }
+
+    bool WriteFile(const std::string& path, const std::string& text)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        return static_cast<bool>(file);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string cubePath = "assets/cube.obj";
+    int segments = 256;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--cube" && hasValue)
+        {
+            cubePath = argv[++i];
+        }
+        else if (arg == "--segments" && hasValue)
+        {
+            segments = std::clamp(std::atoi(argv[++i]), 8, 2048);
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown or incomplete argument: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+    const std::filesystem::path temp = std::filesystem::temp_directory_path() / "vengine_mesh_probe";
+    std::error_code ec;
+    std::filesystem::remove_all(temp, ec);
+    std::filesystem::create_directories(temp, ec);
+    std::string error;
+
+    {
+        vengine::MeshData cube;
+        const bool loaded = vengine::LoadMesh(cubePath, std::string(), cube, error);
+        std::printf("%s: %zu vertices, %zu indices%s\n", cubePath.c_str(), cube.vertices.size(), cube.indices.size(), loaded ? "" : (" - " + error).c_str());
+        Check(loaded && cube.vertices.size() == 24 && cube.indices.size() == 36, "welded to 24 vertices and 36 indices");
+        Check(loaded && std::fabs(CheckMesh(cube) - 6.0) < 1e-4, "surface area 6");
+    }
+
+    {
+        // Out-of-range references, including ones strtol cannot represent, must fail cleanly.
+        const std::string triangle = "v 0 0 0\nv 1 0 0\nv 0 1 0\n";
+        vengine::MeshData mesh;
+        std::string rejected;
+        bool allRejected = true;
+        for (const char* face : {"f 1 2 4\n", "f -1 -2 -4\n", "f 1 2 -9223372036854775808\n", "f 1 2 99999999999999999999\n"})
+        {
+            allRejected = allRejected && !vengine::ParseObjMesh(triangle + face, mesh, rejected);
+        }
+        Check(vengine::ParseObjMesh(triangle + "f -3 -2 -1\n", mesh, error) && mesh.indices.size() == 3, "relative face references resolve");
+        Check(allRejected, "out-of-range and overflowing face references rejected");
+    }
+
+    {
+        const std::string text = SphereObj(segments);
+        vengine::MeshData sphere;
+        const Clock::time_point parseStart = Clock::now();
+        const bool parsed = vengine::ParseObjMesh(text, sphere, error);
+        const double parseMs = std::chrono::duration<double, std::milli>(Clock::now() - parseStart).count();
+        std::printf("sphere, %d segments: %zu vertices, %zu triangles, parsed in %.1f ms\n", segments, sphere.vertices.size(), sphere.indices.size() / 3, parseMs);
+        const double before16 = vengine::AverageCacheMissRatio(sphere.indices, sphere.vertices.size(), 16);
+        const double before32 = vengine::AverageCacheMissRatio(sphere.indices, sphere.vertices.size(), 32);
+        const double areaBefore = parsed ? CheckMesh(sphere) : 0.0;
+        const Clock::time_point optimizeStart = Clock::now();
+        vengine::OptimizeMesh(sphere);
+        const double optimizeMs = std::chrono::duration<double, std::milli>(Clock::now() - optimizeStart).count();
+        const double after16 = vengine::AverageCacheMissRatio(sphere.indices, sphere.vertices.size(), 16);
+        const double after32 = vengine::AverageCacheMissRatio(sphere.indices, sphere.vertices.size(), 32);
+        std::printf("  ACMR, FIFO 16: %.3f -> %.3f   FIFO 32: %.3f -> %.3f   (optimised in %.1f ms)\n", before16, after16, before32, after32, optimizeMs);
+        Check(parsed && std::fabs(CheckMesh(sphere) - areaBefore) < 1e-3, "optimising keeps every triangle");
+        Check(after16 < 0.8 && after16 < before16 * 0.5, "FIFO 16 ACMR under 0.8 and at least halved");
+
+        const std::string spherePath = (temp / "sphere.obj").string();
+        const std::string cacheDir = (temp / "mesh_cache").string();
+        WriteFile(spherePath, text);
+        vengine::MeshData first;
+        vengine::MeshData second;
+        bool firstFromCache = true;
+        bool secondFromCache = false;
+        const Clock::time_point coldStart = Clock::now();
+        const bool coldOk = vengine::LoadMesh(spherePath, cacheDir, first, error, &firstFromCache);
+        const double coldMs = std::chrono::duration<double, std::milli>(Clock::now() - coldStart).count();
+        const Clock::time_point warmStart = Clock::now();
+        const bool warmOk = vengine::LoadMesh(spherePath, cacheDir, second, error, &secondFromCache);
+        const double warmMs = std::chrono::duration<double, std::milli>(Clock::now() - warmStart).count();
+        std::printf("  LoadMesh: %.1f ms parsing and optimising, %.1f ms from the cache\n", coldMs, warmMs);
+        Check(coldOk && warmOk && !firstFromCache && secondFromCache, "second load comes from the cache");
+        Check(first.vertices.size() == second.vertices.size() && first.indices == second.indices &&
+                  std::memcmp(first.vertices.data(), second.vertices.data(), first.vertices.size() * sizeof(vengine::MeshVertex)) == 0,
+              "cached mesh is identical");
+        WriteFile(spherePath, text + "# touched\n");
+        bool thirdFromCache = true;
+        vengine::LoadMesh(spherePath, cacheDir, second, error, &thirdFromCache);
+        Check(!thirdFromCache, "an edited source is parsed again");
+
+        // A truncated blob whose source was only touched must still fall back to a full parse.
+        const std::string trianglePath = (temp / "touched.obj").string();
+        const std::string touchedCacheDir = (temp / "mesh_cache_touched").string();
+        WriteFile(trianglePath, "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n");
+        vengine::MeshData original;
+        vengine::LoadMesh(trianglePath, touchedCacheDir, original, error);
+        for (const auto& entry : std::filesystem::directory_iterator(touchedCacheDir))
+        {
+            std::filesystem::resize_file(entry.path(), std::filesystem::file_size(entry.path()) - 4);
+        }
+        std::filesystem::last_write_time(trianglePath, std::filesystem::last_write_time(trianglePath) + std::chrono::hours(1));
+        vengine::MeshData reparsed;
+        bool truncatedFromCache = true;
+        const bool reparsedOk = vengine::LoadMesh(trianglePath, touchedCacheDir, reparsed, error, &truncatedFromCache);
+        vengine::MeshData recached;
+        bool recachedFromCache = false;
+        const bool recachedOk = vengine::LoadMesh(trianglePath, touchedCacheDir, recached, error, &recachedFromCache);
+        Check(reparsedOk && !truncatedFromCache && reparsed.indices == original.indices, "a truncated blob with a touched source is parsed again");
+        Check(recachedOk && recachedFromCache && recached.indices == original.indices, "the rebuilt blob loads intact");
+    }
+
+    {
+        // A staircase of cubes with a glass step, so exports have several materials and merged quads.
+        std::vector<vengine::SceneCube> cubes;
+        for (int x = 0; x < 40; ++x)
+        {
+            for (int y = 0; y <= x / 4; ++y)
+            {
+                for (int z = 0; z < 12; ++z)
+                {
+                    vengine::SceneCube cube;
+                    cube.gridX = x - 20;
+                    cube.gridY = y;
+                    cube.gridZ = z;
+                    cube.r = 0.2f + 0.05f * static_cast<float>(y);
+                    cube.g = 0.5f;
+                    cube.b = 0.7f;
+                    cube.transparent = x == 17;
+                    cube.glowing = x == 31;
+                    cubes.push_back(cube);
+                }
+            }
+        }
+        for (const char* extension : {".obj", ".glb"})
+        {
+            const std::string path = (temp / (std::string("stairs") + extension)).string();
+            vengine::SceneExportStats stats;
+            vengine::MeshData imported;
+            const bool exported = vengine::ExportScene(cubes, path, vengine::SceneExportFormatForPath(path), stats, error);
+            const bool loaded = exported && vengine::LoadMesh(path, std::string(), imported, error);
+            std::printf("exported staircase%s: %zu quads over %zu faces -> %zu vertices, %zu triangles%s\n", extension, stats.quads, stats.visibleFaces,
+                        imported.vertices.size(), imported.indices.size() / 3, loaded ? "" : (" - " + error).c_str());
+            Check(loaded && imported.indices.size() == stats.quads * 6, "one triangle pair per exported quad");
+            Check(loaded && std::fabs(CheckMesh(imported) - static_cast<double>(stats.visibleFaces)) < 1e-3, "area equals the exported visible faces");
+        }
+    }
+
+    {
+        // One triangle in an embedded base64 buffer, under a node that mirrors it in x.
+        const std::string gltf =
+            "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],"
+            "\"nodes\":[{\"scale\":[-1,1,1],\"translation\":[0,2,0],\"mesh\":0}],"
+            "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0}}]}],"
+            "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\"}],"
+            "\"bufferViews\":[{\"buffer\":0,\"byteLength\":36}],"
+            "\"buffers\":[{\"byteLength\":36,\"uri\":\"data:application/octet-stream;base64,"
+            "AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAgD8AAAAA\"}]}";
+        const std::string path = (temp / "triangle.gltf").string();
+        WriteFile(path, gltf);
+        vengine::MeshData triangle;
+        const bool loaded = vengine::LoadMesh(path, std::string(), triangle, error);
+        std::printf("embedded .gltf: %zu vertices%s\n", triangle.vertices.size(), loaded ? "" : (" - " + error).c_str());
+        Check(loaded && triangle.vertices.size() == 3 && std::fabs(CheckMesh(triangle) - 0.5) < 1e-6, "mirrored node keeps its winding");
+        Check(loaded && triangle.boundsMin[0] == -1.0f && triangle.boundsMin[1] == 2.0f && triangle.vertices[0].normal[2] == 1.0f,
+              "node transform applied, flat normal generated");
+    }
+
+    std::filesystem::remove_all(temp, ec);
+    std::printf("%s\n", g_ok ? "all checks passed" : "SOME CHECKS FAILED");
+    return g_ok ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+// Headless CPU render of an editor scene with the Compile Scene preview's path tracer.
+//
+//   raytrace_render [scene.txt] [--out image.png|image.ppm] [--size WxH] [--spp N] [--threads N]
+//                   [--tile N] [--eye x y z] [--target x y z] [--fov degrees] [--verify]
+//
+// Without a scene file a generated demo scene (rolling terrain, a tower, glow and glass cubes) is
+// rendered. The default camera orbits the scene bounds at 45 degrees like the editor's. --verify
+// renders a small image on one thread and again on several with a different tile size, and fails
+// unless they match exactly.
+
+#include "image_encode.h"
+#include "scene_file.h"
+#include "software_raytracer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::vector<vengine::SceneCube> BuildDemoScene()
+    {
+        std::vector<vengine::SceneCube> cubes;
+        for (int z = -24; z <= 24; ++z)
+        {
+            for (int x = -24; x <= 24; ++x)
+            {
+                const int height = 1 + static_cast<int>(1.5f + 1.5f * std::sin(static_cast<float>(x) * 0.25f) * std::cos(static_cast<float>(z) * 0.2f));
+                for (int y = 0; y < height; ++y)
+                {
+                    const float shade = 0.45f + 0.12f * static_cast<float>(y);
+                    cubes.push_back(vengine::SceneCube{x, y, z, 0.35f * shade, 0.75f * shade, 0.35f * shade, false, false, -1, {}});
+                }
+            }
+        }
+        for (int y = 0; y < 12; ++y)
+        {
+            cubes.push_back(vengine::SceneCube{0, y, 0, 0.7f, 0.7f, 0.75f, false, false, -1, {}});
+        }
+        for (int i = 0; i < 12; ++i)
+        {
+            const float angle = static_cast<float>(i) * 0.5236f;
+            const int x = static_cast<int>(std::lround(12.0f * std::cos(angle)));
+            const int z = static_cast<int>(std::lround(12.0f * std::sin(angle)));
+            const bool glow = (i % 3) == 0;
+            cubes.push_back(vengine::SceneCube{x, 5, z, glow ? 1.0f : 0.4f, glow ? 0.8f : 0.7f, glow ? 0.4f : 1.0f, glow, !glow, -1, {}});
+        }
+        return cubes;
+    }
+
+    bool ParseInts(const char* text, int& a, int& b)
+    {
+        return std::sscanf(text, "%dx%d", &a, &b) == 2 && a > 0 && b > 0;
+    }
+
+    void PrintStats(const char* label, const vengine::RaytraceStats& stats)
+    {
+        const double raysPerSecond = stats.milliseconds > 0.0 ? static_cast<double>(stats.primaryRays) / (stats.milliseconds / 1000.0) : 0.0;
+        std::printf("  %-10s %9.1f ms  %2d threads  %5zu tiles  %6.2f M paths/s\n", label, stats.milliseconds, stats.threads, stats.tiles,
+                    raysPerSecond / 1e6);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string scenePath;
+    std::string outPath = "raytrace.png";
+    vengine::RaytraceSettings settings;
+    float eye[3] = {0.0f, 0.0f, 0.0f};
+    float target[3] = {0.0f, 0.0f, 0.0f};
+    bool haveEye = false;
+    bool haveTarget = false;
+    float fov = 60.0f;
+    bool verify = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--out" && hasValue)
+        {
+            outPath = argv[++i];
+        }
+        else if (arg == "--size" && hasValue)
+        {
+            if (!ParseInts(argv[++i], settings.width, settings.height))
+            {
+                std::fprintf(stderr, "--size expects WxH\n");
+                return 2;
+            }
+        }
+        else if (arg == "--spp" && hasValue)
+        {
+            settings.samplesPerPixel = std::atoi(argv[++i]);
+        }
+        else if (arg == "--threads" && hasValue)
+        {
+            settings.threadCount = std::atoi(argv[++i]);
+        }
+        else if (arg == "--tile" && hasValue)
+        {
+            settings.tileSize = std::atoi(argv[++i]);
+        }
+        else if ((arg == "--eye" || arg == "--target") && i + 3 < argc)
+        {
+            float* dst = arg == "--eye" ? eye : target;
+            for (int a = 0; a < 3; ++a)
+            {
+                dst[a] = static_cast<float>(std::atof(argv[++i]));
+            }
+            (arg == "--eye" ? haveEye : haveTarget) = true;
+        }
+        else if (arg == "--fov" && hasValue)
+        {
+            fov = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (arg == "--verify")
+        {
+            verify = true;
+        }
+        else if (!arg.empty() && arg[0] != '-' && scenePath.empty())
+        {
+            scenePath = arg;
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown or incomplete argument: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    std::vector<vengine::SceneCube> cubes;
+    std::string error;
+    if (scenePath.empty())
+    {
+        cubes = BuildDemoScene();
+    }
+    else if (!vengine::LoadSceneFile(scenePath, cubes, error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    vengine::RaytraceScene scene;
+    if (!scene.Build(cubes, error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    float center[3];
+    float extent = 0.0f;
+    scene.Bounds(center, extent);
+    if (!haveTarget)
+    {
+        target[0] = center[0];
+        target[1] = 0.0f;
+        target[2] = center[2];
+    }
+    if (!haveEye)
+    {
+        const float distance = extent * 0.9f + 6.0f;
+        eye[0] = target[0];
+        eye[1] = target[1] + distance * 0.7071f;
+        eye[2] = target[2] + distance * 0.7071f;
+    }
+    const vengine::RaytraceCamera camera = vengine::RaytraceCamera::LookAt(eye, target, fov);
+    std::printf("%zu cubes, %d glow, grid %dx%dx%d\n", scene.CubeCount(), static_cast<int>(scene.GlowCells().size()), scene.Size()[0], scene.Size()[1],
+                scene.Size()[2]);
+
+    if (verify)
+    {
+        vengine::RaytraceSettings small = settings;
+        small.width = 96;
+        small.height = 64;
+        small.samplesPerPixel = 4;
+        small.tileSize = 16;
+        small.threadCount = 1;
+        const vengine::RaytraceImage serial = vengine::RenderRaytrace(scene, camera, small);
+        small.tileSize = 7;
+        small.threadCount = 4;
+        const vengine::RaytraceImage parallel = vengine::RenderRaytrace(scene, camera, small);
+        const bool same = serial.rgb.size() == parallel.rgb.size() && std::memcmp(serial.rgb.data(), parallel.rgb.data(), serial.rgb.size() * sizeof(float)) == 0;
+        std::printf("thread/tile verify: %s\n", same ? "identical" : "MISMATCH");
+        if (!same)
+        {
+            return 1;
+        }
+    }
+
+    std::printf("rendering %dx%d at %d spp\n", settings.width, settings.height, settings.samplesPerPixel);
+    vengine::RaytraceStats stats;
+    const vengine::RaytraceImage image = vengine::RenderRaytrace(scene, camera, settings, &stats);
+    PrintStats("render", stats);
+
+    const std::vector<uint8_t> pixels = image.ToRgba8();
+    if (!vengine::SaveImageFile(outPath, pixels.data(), image.width, image.height, error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::printf("wrote %s\n", outPath.c_str());
+    return 0;
+}
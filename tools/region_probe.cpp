@@ -0,0 +1,212 @@
+// Packs a generated world into region files and checks the container does what the streamer needs:
+//
+//   region_probe [--chunks N] [--seed N] [--dir path]
+//
+// Writes an N x N block of chunks (default 48, so it straddles region boundaries), then compares the
+// region bytes with what the text scene format would take. A fresh store reads every chunk back in a
+// shuffled order and checks each against the generator. Finally it moves one cube and checks the
+// save wrote one chunk and that the edit reads back. Fails on any mismatch.
+
+#include "region_file.h"
+#include "world_gen.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double SecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void SortCubes(std::vector<vengine::SceneCube>& cubes)
+    {
+        std::sort(cubes.begin(), cubes.end(), [](const vengine::SceneCube& a, const vengine::SceneCube& b) {
+            return std::tie(a.gridX, a.gridZ, a.gridY) < std::tie(b.gridX, b.gridZ, b.gridY);
+        });
+    }
+
+    bool SameCubes(std::vector<vengine::SceneCube> a, std::vector<vengine::SceneCube> b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        SortCubes(a);
+        SortCubes(b);
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            const vengine::SceneCube& x = a[i];
+            const vengine::SceneCube& y = b[i];
+            if (x.gridX != y.gridX || x.gridY != y.gridY || x.gridZ != y.gridZ || x.r != y.r || x.g != y.g || x.b != y.b || x.glowing != y.glowing ||
+                x.transparent != y.transparent || x.presetIndex != y.presetIndex || x.texturePath != y.texturePath)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint64_t DirectoryBytes(const std::string& directory)
+    {
+        uint64_t total = 0;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec))
+        {
+            total += entry.file_size(ec);
+        }
+        return total;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int chunks = 48;
+    vengine::WorldGenSettings settings;
+    settings.seed = 7;
+    settings.chunkSize = vengine::kStreamChunkSize;
+    std::string directory;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--chunks" && hasValue)
+        {
+            chunks = std::clamp(std::atoi(argv[++i]), 1, 512);
+        }
+        else if (arg == "--seed" && hasValue)
+        {
+            settings.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--dir" && hasValue)
+        {
+            directory = argv[++i];
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown or incomplete argument: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+    if (directory.empty())
+    {
+        directory = (std::filesystem::temp_directory_path() / "vengine_region_probe").string();
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+
+    // Centred on the origin so negative region coordinates are exercised too.
+    std::vector<vengine::ChunkCoord> coords;
+    for (int z = -chunks / 2; z < chunks - chunks / 2; ++z)
+    {
+        for (int x = -chunks / 2; x < chunks - chunks / 2; ++x)
+        {
+            coords.push_back(vengine::ChunkCoord{x, z});
+        }
+    }
+
+    size_t cubeCount = 0;
+    size_t textBytes = 0;
+    double writeSeconds = 0.0;
+    {
+        vengine::RegionChunkStore store(directory);
+        for (const vengine::ChunkCoord& coord : coords)
+        {
+            const vengine::WorldChunk chunk = vengine::GenerateUnboundedChunk(settings, coord.x, coord.z);
+            cubeCount += chunk.cubes.size();
+            textBytes += vengine::SerializeScene(chunk.cubes).size();
+            std::string error;
+            const Clock::time_point start = Clock::now();
+            if (!store.SaveChunk(coord, chunk.cubes, error))
+            {
+                std::fprintf(stderr, "Save failed: %s\n", error.c_str());
+                return 1;
+            }
+            writeSeconds += SecondsSince(start);
+        }
+    }
+    const uint64_t regionBytes = DirectoryBytes(directory);
+    std::printf("%zu chunks, %zu cubes: text scene %.1f MB, regions %.2f MB (%.1fx smaller, %.0f bytes per chunk), written in %.0f ms\n", coords.size(),
+                cubeCount, static_cast<double>(textBytes) / (1024.0 * 1024.0), static_cast<double>(regionBytes) / (1024.0 * 1024.0),
+                static_cast<double>(textBytes) / static_cast<double>(std::max<uint64_t>(1, regionBytes)),
+                static_cast<double>(regionBytes) / static_cast<double>(coords.size()), writeSeconds * 1000.0);
+
+    bool ok = true;
+    {
+        vengine::RegionChunkStore store(directory);
+        std::vector<vengine::ChunkCoord> shuffled = coords;
+        std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(12345));
+        double readSeconds = 0.0;
+        size_t mismatches = 0;
+        for (const vengine::ChunkCoord& coord : shuffled)
+        {
+            std::vector<vengine::SceneCube> cubes;
+            bool found = false;
+            std::string error;
+            const Clock::time_point start = Clock::now();
+            if (!store.LoadChunk(coord, cubes, found, error) || !found)
+            {
+                std::fprintf(stderr, "Load of (%d, %d) failed: %s\n", coord.x, coord.z, found ? error.c_str() : "not found");
+                return 1;
+            }
+            readSeconds += SecondsSince(start);
+            mismatches += SameCubes(cubes, vengine::GenerateUnboundedChunk(settings, coord.x, coord.z).cubes) ? 0 : 1;
+        }
+        const vengine::RegionStoreStats stats = store.Stats();
+        std::printf("read back in random order: %.0f ms (%.1f us per chunk), %zu regions opened, %zu mismatched chunks\n", readSeconds * 1000.0,
+                    readSeconds * 1e6 / static_cast<double>(shuffled.size()), stats.regionsOpened, mismatches);
+        ok = ok && mismatches == 0;
+
+        bool found = false;
+        std::vector<vengine::SceneCube> absent;
+        std::string error;
+        const int far = chunks * 4;
+        if (!store.LoadChunk(vengine::ChunkCoord{far, far}, absent, found, error) || found)
+        {
+            std::fprintf(stderr, "A chunk that was never saved should load as not found\n");
+            ok = false;
+        }
+    }
+
+    {
+        // Move one cube up a cell and save just its chunk.
+        const vengine::ChunkCoord coord = coords[coords.size() / 2 + static_cast<size_t>(chunks / 2)];
+        vengine::RegionChunkStore store(directory);
+        std::vector<vengine::SceneCube> cubes;
+        bool found = false;
+        std::string error;
+        store.LoadChunk(coord, cubes, found, error);
+        const auto top = std::max_element(cubes.begin(), cubes.end(), [](const auto& a, const auto& b) { return a.gridY < b.gridY; });
+        top->gridY += 1;
+        const uint64_t sizeBefore = DirectoryBytes(directory);
+        if (!store.SaveChunk(coord, cubes, error))
+        {
+            std::fprintf(stderr, "Edit save failed: %s\n", error.c_str());
+            return 1;
+        }
+        const vengine::RegionStoreStats stats = store.Stats();
+        std::printf("one-cube edit: %zu chunk written, %zu bytes (file grew %lld bytes)\n", stats.chunksWritten, stats.bytesWritten,
+                    static_cast<long long>(DirectoryBytes(directory)) - static_cast<long long>(sizeBefore));
+        ok = ok && stats.chunksWritten == 1;
+
+        vengine::RegionChunkStore reopened(directory);
+        std::vector<vengine::SceneCube> reloaded;
+        reopened.LoadChunk(coord, reloaded, found, error);
+        const bool editKept = SameCubes(cubes, reloaded);
+        std::printf("edit %s\n", editKept ? "reloaded" : "LOST");
+        ok = ok && editKept;
+    }
+
+    std::filesystem::remove_all(directory, ec);
+    return ok ? 0 : 1;
+}
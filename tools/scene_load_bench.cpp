@@ -0,0 +1,243 @@
+// Times loading a large text scene with ParseScene on one thread against the pipelined
+// SceneLoader at several thread counts, and checks every run produces the same cubes in the same
+// order.
+//
+//   scene_load_bench [--scene path] [--size cells] [--runs N]
+//
+// Without --scene it writes a generated world of --size x --size cells (default 360, about a
+// million cubes) to a temporary file, with a few texture paths sprinkled in so the texture stage
+// has work to deduplicate. The index stage builds the same CubeChunkIndex the editor culls with.
+
+#include "frustum.h"
+#include "scene_file.h"
+#include "scene_loader.h"
+#include "world_gen.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    void HashBytes(uint64_t& hash, const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    void HashCube(uint64_t& hash, const vengine::SceneCube& cube)
+    {
+        const int cell[4] = {cube.gridX, cube.gridY, cube.gridZ, cube.presetIndex};
+        const float color[3] = {cube.r, cube.g, cube.b};
+        const unsigned char flags = static_cast<unsigned char>((cube.glowing ? 1 : 0) | (cube.transparent ? 2 : 0));
+        HashBytes(hash, cell, sizeof(cell));
+        HashBytes(hash, color, sizeof(color));
+        HashBytes(hash, &flags, 1);
+        HashBytes(hash, cube.texturePath.data(), cube.texturePath.size());
+    }
+
+    class BenchSink : public vengine::SceneLoadSink
+    {
+    public:
+        void PrepareTexture(const std::string&) override { ++textures; }
+
+        void IndexBatch(size_t firstItem, const std::vector<vengine::SceneCube>& cubes) override
+        {
+            for (size_t i = 0; i < cubes.size(); ++i)
+            {
+                index.Insert(static_cast<uint32_t>(firstItem + i), cubes[i].gridX, cubes[i].gridY, cubes[i].gridZ);
+            }
+        }
+
+        size_t textures = 0;
+        vengine::CubeChunkIndex index;
+    };
+
+    struct RunResult
+    {
+        double seconds = 0.0;
+        size_t cubes = 0;
+        size_t textures = 0;
+        size_t chunks = 0;
+        uint64_t hash = 1469598103934665603ull;
+    };
+
+    RunResult LoadSerial(const std::string& path)
+    {
+        RunResult result;
+        const Clock::time_point start = Clock::now();
+        std::vector<vengine::SceneCube> cubes;
+        std::string error;
+        if (!vengine::LoadSceneFile(path, cubes, error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            std::exit(1);
+        }
+        vengine::CubeChunkIndex index;
+        for (size_t i = 0; i < cubes.size(); ++i)
+        {
+            index.Insert(static_cast<uint32_t>(i), cubes[i].gridX, cubes[i].gridY, cubes[i].gridZ);
+        }
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        for (const vengine::SceneCube& cube : cubes)
+        {
+            HashCube(result.hash, cube);
+        }
+        result.cubes = cubes.size();
+        result.chunks = index.ChunkCount();
+        return result;
+    }
+
+    RunResult LoadPipelined(const std::string& path, unsigned threads)
+    {
+        RunResult result;
+        BenchSink sink;
+        const Clock::time_point start = Clock::now();
+        vengine::SceneLoader loader;
+        loader.Start(path, sink, threads);
+        // What the editor does with each block: take the cubes over into its own storage.
+        std::vector<vengine::SceneCube> cubes;
+        loader.Drain(
+            [&](vengine::SceneLoadBatch& batch) {
+                if (cubes.empty())
+                {
+                    cubes = std::move(batch.cubes);
+                }
+                else
+                {
+                    cubes.insert(cubes.end(), std::make_move_iterator(batch.cubes.begin()), std::make_move_iterator(batch.cubes.end()));
+                }
+            },
+            std::numeric_limits<size_t>::max(), true);
+        const vengine::SceneLoadProgress progress = loader.Progress();
+        loader.Cancel();
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (progress.failed)
+        {
+            std::fprintf(stderr, "%s\n", progress.error.c_str());
+            std::exit(1);
+        }
+        for (const vengine::SceneCube& cube : cubes)
+        {
+            HashCube(result.hash, cube);
+        }
+        result.cubes = cubes.size();
+        result.textures = sink.textures;
+        result.chunks = sink.index.ChunkCount();
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string scenePath;
+    int size = 360;
+    int runs = 3;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--scene" && hasValue)
+        {
+            scenePath = argv[++i];
+        }
+        else if (arg == "--size" && hasValue)
+        {
+            size = std::clamp(std::atoi(argv[++i]), 16, 4096);
+        }
+        else if (arg == "--runs" && hasValue)
+        {
+            runs = std::max(1, std::atoi(argv[++i]));
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown or incomplete argument: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    const bool generated = scenePath.empty();
+    if (generated)
+    {
+        scenePath = (std::filesystem::temp_directory_path() / "vengine_scene_load_bench.txt").string();
+        vengine::WorldGenSettings settings;
+        settings.seed = 11;
+        settings.sizeX = settings.sizeZ = size;
+        vengine::SceneFileWriter writer;
+        std::string error;
+        if (!writer.Open(scenePath, error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        vengine::WorldGenerator generator;
+        generator.Start(settings);
+        size_t written = 0;
+        generator.Drain(
+            [&](vengine::WorldChunk& chunk) {
+                for (vengine::SceneCube& cube : chunk.cubes)
+                {
+                    if (written++ % 97 == 0)
+                    {
+                        cube.texturePath = "textures/bench_" + std::to_string(written % 12) + ".png";
+                    }
+                    writer.Write(cube);
+                }
+            },
+            std::numeric_limits<size_t>::max(), true);
+        if (!writer.Close(error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    std::error_code ec;
+    const double megabytes = static_cast<double>(std::filesystem::file_size(scenePath, ec)) / (1024.0 * 1024.0);
+    const auto best = [&](auto&& load) {
+        RunResult fastest = load();
+        for (int run = 1; run < runs; ++run)
+        {
+            const RunResult result = load();
+            fastest = result.seconds < fastest.seconds ? result : fastest;
+        }
+        return fastest;
+    };
+
+    const RunResult serial = best([&] { return LoadSerial(scenePath); });
+    std::printf("%s: %.1f MB, %zu cubes, %zu index chunks\n", scenePath.c_str(), megabytes, serial.cubes, serial.chunks);
+    std::printf("  ParseScene, 1 thread      %8.1f ms\n", serial.seconds * 1000.0);
+
+    bool ok = true;
+    std::vector<unsigned> threadCounts = {1, 2, 4};
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    if (std::find(threadCounts.begin(), threadCounts.end(), hardware) == threadCounts.end())
+    {
+        threadCounts.push_back(hardware);
+    }
+    for (unsigned threads : threadCounts)
+    {
+        const RunResult result = best([&] { return LoadPipelined(scenePath, threads); });
+        const bool same = result.hash == serial.hash && result.cubes == serial.cubes && result.chunks == serial.chunks;
+        std::printf("  SceneLoader, %2u parsers   %8.1f ms  %5.2fx  %zu textures  %s\n", threads, result.seconds * 1000.0, serial.seconds / result.seconds,
+                    result.textures, same ? "same cubes" : "MISMATCH");
+        ok = ok && same;
+    }
+    std::printf("  (%u hardware threads)\n", hardware);
+
+    if (generated)
+    {
+        std::filesystem::remove(scenePath, ec);
+    }
+    return ok ? 0 : 1;
+}
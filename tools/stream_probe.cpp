@@ -0,0 +1,228 @@
+// Flies a focus point across an endless generated world through WorldStreamer, paced like a
+// 60 Hz frame loop, and reports how much of the view radius was resident each frame with and
+// without motion prefetch. Along the way it edits a chunk, flies far enough for that chunk to be
+// unloaded, comes back and checks the edit was saved and reloaded.
+//
+//   stream_probe [--budget MB] [--radius cells] [--speed cells/s] [--frames N] [--dir path]
+//
+// Region files are written under --dir (default: a temporary directory that is cleared first).
+
+#include "region_file.h"
+#include "world_stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int kMarkerY = 200;
+
+    struct Options
+    {
+        size_t budgetBytes = size_t{48} << 20;
+        float radius = 96.0f;
+        float speed = 90.0f;
+        int frames = 480;
+        std::string directory;
+    };
+
+    struct RunResult
+    {
+        double meanCoverage = 0.0;
+        double worstCoverage = 1.0;
+        size_t peakBytes = 0;
+        size_t loads = 0;
+        size_t saves = 0;
+        bool markerSurvived = false;
+        bool budgetHeld = true;
+    };
+
+    uint64_t Key(int x, int z)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+    }
+
+    RunResult Fly(const Options& options, float prefetchSeconds, const std::string& directory)
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+
+        vengine::WorldStreamSettings settings;
+        settings.budgetBytes = options.budgetBytes;
+        settings.bytesPerCube = 64;
+        settings.prefetchSeconds = prefetchSeconds;
+        settings.generateMissing = true;
+        settings.generation.seed = 7;
+        vengine::WorldStreamer streamer;
+        streamer.Start(std::make_unique<vengine::RegionChunkStore>(directory), settings);
+
+        std::unordered_map<uint64_t, std::vector<vengine::SceneCube>> world;
+        const float dt = 1.0f / 60.0f;
+        RunResult result;
+        double coverageSum = 0.0;
+        bool markerPlaced = false;
+        int markerX = 0;
+        int markerZ = 0;
+        // Out along +x for the first half, back along -x for the second.
+        float focusX = 0.0f;
+        const float focusZ = 8.0f;
+        const int half = options.frames / 2;
+        for (int frame = 0; frame < options.frames; ++frame)
+        {
+            const Clock::time_point frameStart = Clock::now();
+            focusX += (frame < half ? options.speed : -options.speed) * dt;
+
+            for (const vengine::ChunkCoord& coord : streamer.Update(focusX, focusZ, options.radius, dt))
+            {
+                const auto found = world.find(Key(coord.x, coord.z));
+                if (found != world.end())
+                {
+                    streamer.Unload(coord, std::move(found->second));
+                    world.erase(found);
+                }
+            }
+            streamer.DrainLoaded([&](const vengine::ChunkCoord& coord, std::vector<vengine::SceneCube>& cubes) {
+                world[Key(coord.x, coord.z)] = std::move(cubes);
+            });
+
+            // Edit the chunk under the focus once it has arrived.
+            const int cellX = static_cast<int>(std::lround(focusX));
+            const int cellZ = static_cast<int>(std::lround(focusZ));
+            if (!markerPlaced && frame > 10 && streamer.IsResident(cellX, cellZ))
+            {
+                markerX = cellX;
+                markerZ = cellZ;
+                vengine::SceneCube marker;
+                marker.gridX = markerX;
+                marker.gridY = kMarkerY;
+                marker.gridZ = markerZ;
+                marker.glowing = true;
+                world[Key(vengine::StreamChunkOf(markerX), vengine::StreamChunkOf(markerZ))].push_back(marker);
+                streamer.MarkDirty(markerX, markerZ);
+                markerPlaced = true;
+            }
+
+            int inRadius = 0;
+            int resident = 0;
+            const int reach = static_cast<int>(options.radius);
+            for (int z = vengine::StreamChunkOf(cellZ - reach); z <= vengine::StreamChunkOf(cellZ + reach); ++z)
+            {
+                for (int x = vengine::StreamChunkOf(cellX - reach); x <= vengine::StreamChunkOf(cellX + reach); ++x)
+                {
+                    const float cx = static_cast<float>(x * vengine::kStreamChunkSize + vengine::kStreamChunkSize / 2);
+                    const float cz = static_cast<float>(z * vengine::kStreamChunkSize + vengine::kStreamChunkSize / 2);
+                    if (std::hypot(cx - focusX, cz - focusZ) > options.radius)
+                    {
+                        continue;
+                    }
+                    ++inRadius;
+                    resident += world.count(Key(x, z)) != 0 ? 1 : 0;
+                }
+            }
+            const double coverage = inRadius > 0 ? static_cast<double>(resident) / inRadius : 1.0;
+            // The first second is the initial fill, not streaming.
+            if (frame >= 60)
+            {
+                coverageSum += coverage;
+                result.worstCoverage = std::min(result.worstCoverage, coverage);
+            }
+
+            const vengine::WorldStreamStats stats = streamer.Stats();
+            result.peakBytes = std::max(result.peakBytes, stats.residentBytes);
+            result.budgetHeld = result.budgetHeld && stats.residentBytes <= options.budgetBytes;
+
+            std::this_thread::sleep_until(frameStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(dt)));
+        }
+
+        // Back where the marker was placed: let the streamer settle and look for it.
+        for (int settle = 0; settle < 120; ++settle)
+        {
+            for (const vengine::ChunkCoord& coord : streamer.Update(static_cast<float>(markerX), static_cast<float>(markerZ), options.radius, dt))
+            {
+                const auto found = world.find(Key(coord.x, coord.z));
+                if (found != world.end())
+                {
+                    streamer.Unload(coord, std::move(found->second));
+                    world.erase(found);
+                }
+            }
+            streamer.DrainLoaded([&](const vengine::ChunkCoord& coord, std::vector<vengine::SceneCube>& cubes) {
+                world[Key(coord.x, coord.z)] = std::move(cubes);
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        const auto chunk = world.find(Key(vengine::StreamChunkOf(markerX), vengine::StreamChunkOf(markerZ)));
+        if (markerPlaced && chunk != world.end())
+        {
+            for (const vengine::SceneCube& cube : chunk->second)
+            {
+                result.markerSurvived = result.markerSurvived || (cube.gridX == markerX && cube.gridY == kMarkerY && cube.gridZ == markerZ);
+            }
+        }
+
+        const vengine::WorldStreamStats stats = streamer.Stats();
+        result.meanCoverage = coverageSum / std::max(1, options.frames - 60);
+        result.loads = stats.loadsCompleted;
+        result.saves = stats.savesCompleted + stats.queuedSaves;
+        streamer.Stop();
+        std::filesystem::remove_all(directory, ec);
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--budget" && hasValue)
+        {
+            options.budgetBytes = static_cast<size_t>(std::max(1, std::atoi(argv[++i]))) << 20;
+        }
+        else if (arg == "--radius" && hasValue)
+        {
+            options.radius = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (arg == "--speed" && hasValue)
+        {
+            options.speed = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (arg == "--frames" && hasValue)
+        {
+            options.frames = std::max(120, std::atoi(argv[++i]));
+        }
+        else if (arg == "--dir" && hasValue)
+        {
+            options.directory = argv[++i];
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown or incomplete argument: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+    const std::string directory = options.directory.empty() ? (std::filesystem::temp_directory_path() / "vengine_stream_probe").string() : options.directory;
+
+    std::printf("radius %.0f cells, %.0f cells/s, %d frames, budget %zu MB\n", options.radius, options.speed, options.frames, options.budgetBytes >> 20);
+    bool ok = true;
+    for (float prefetch : {0.0f, 1.5f})
+    {
+        const RunResult result = Fly(options, prefetch, directory);
+        std::printf("  prefetch %.1fs: coverage mean %5.1f%% worst %5.1f%%  peak %6.1f MB  %5zu loads  %3zu saves  budget %s  edit %s\n", prefetch,
+                    result.meanCoverage * 100.0, result.worstCoverage * 100.0, static_cast<double>(result.peakBytes) / (1024.0 * 1024.0), result.loads,
+                    result.saves, result.budgetHeld ? "held" : "EXCEEDED", result.markerSurvived ? "reloaded" : "LOST");
+        ok = ok && result.budgetHeld && result.markerSurvived;
+    }
+    return ok ? 0 : 1;
+}
@@ -1,12 +1,16 @@
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iterator>
+#include <sstream>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
 #include <SDL.h>
@@ -17,6 +21,10 @@
 #endif
 #include <GLES3/gl3.h>
 #include <emscripten.h>
+#elif defined(VENGINE_GOLDEN_HARNESS)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
 #else
 #include <SDL_opengl.h>
 #endif
@@ -26,6 +34,20 @@
 #include "imgui_impl_sdl2.h"
 #include "imgui_stdlib.h"
 
+#include "frame_arena.h"
+#include "frustum.h"
+#include "input_recording.h"
+#include "lua_highlighter.h"
+#include "occlusion.h"
+#include "render_queue.h"
+#include "script_runtime.h"
+
+#if defined(VENGINE_GOLDEN_HARNESS)
+#include "image_decode.h"
+#include "image_encode.h"
+#include "scene_file.h"
+#endif
+
 namespace
 {
     struct Vec3
@@ -89,6 +111,7 @@ namespace
         }
     };
 
+    // a * b with column-major storage (element (row, col) at m[col * 4 + row]), as GL expects.
     Mat4 Multiply(const Mat4& a, const Mat4& b)
     {
         Mat4 result{};
@@ -99,9 +122,9 @@ namespace
                 float value = 0.0f;
                 for (int k = 0; k < 4; ++k)
                 {
-                    value += a.m[row * 4 + k] * b.m[k * 4 + col];
+                    value += a.m[k * 4 + row] * b.m[col * 4 + k];
                 }
-                result.m[row * 4 + col] = value;
+                result.m[col * 4 + row] = value;
             }
         }
         return result;
@@ -201,6 +224,7 @@ namespace
         float b;
         bool glowing = false;
         bool transparent = false;
+        int presetIndex = 0;
     };
 
     struct SpawnPreset
@@ -220,7 +244,22 @@ namespace
         {"Glow Cube", 1.0f, 0.92f, 0.50f, true, false},
         {"Glass Cube", 0.75f, 0.90f, 1.0f, false, true},
     };
-    constexpr int kMaxRaytraceCubes = 64;
+    // Voxel kinds in the alpha channel of the raytrace grid; must match KIND_* in the shader.
+    constexpr int kRaytraceVoxelSolid = 1;
+    constexpr int kRaytraceVoxelGlow = 2;
+    constexpr int kRaytraceVoxelGlass = 3;
+    constexpr int kRaytraceLightTextureWidth = 256; // LIGHT_TEXTURE_WIDTH in the shader.
+    constexpr int kRaytraceSamplesPerFrame = 2;
+    constexpr int kRaytraceMaxSamples = 512;
+
+    // Uniform locations of one program, resolved once after linking; -1 where it lacks one.
+    struct ProgramUniforms
+    {
+        GLint mvp = -1;
+        GLint model = -1;
+        GLint color = -1;
+        GLint alpha = -1;
+    };
 
     struct AppState
     {
@@ -234,6 +273,17 @@ namespace
         float deltaTime = 0.016f;
         double previousTime = 0.0;
 
+        // --record / --replay sessions; see HandleEvents.
+        vengine::InputRecorder inputRecorder;
+        vengine::InputReplayer inputReplayer;
+        std::string inputRecordPath;
+        std::string inputReplayPath;
+        std::chrono::steady_clock::time_point frameStart;
+        // Last cursor position the replay delivered; ImGui gets this instead of the OS cursor.
+        bool replayMouseKnown = false;
+        float replayMouseX = 0.0f;
+        float replayMouseY = 0.0f;
+
         Vec3 cameraFocus{0.0f, 0.0f, 0.0f};
         float cameraDistance = 8.0f;
         bool cameraForward = false;
@@ -250,6 +300,9 @@ namespace
             "function tick(dt)\n"
             "    -- update logic here\n"
             "end\n";
+        vengine::LuaHighlightCache codeHighlight;
+        vengine::ScriptRuntime script;
+        bool scriptEnabled = true;
         bool codeDirty = false;
         std::string docsContent =
             "VEngine WebGL Docs\n"
@@ -263,12 +316,22 @@ namespace
             "  Code     - edit lua scripts (auto indent, 4 spaces)\n"
             "  Docs     - read-only documentation (copy button)\n"
             "  Content  - choose cube presets (Glow Cube emits light, Glass Cube lets it through)\n"
-            "  Compile  - raytraced preview of lighting\n";
+            "  Compile  - path-traced preview of lighting (refines while open)\n\n"
+            "Scripting (Lua, runs on Save):\n"
+            "  function tick(dt) ... end   -- called every frame\n"
+            "  world.place(x, 0, z [, preset]), world.remove(x, 0, z)\n"
+            "  world.get(x, 0, z) -> preset or nil, world.count()\n"
+            "  player.position(), player.move(dx, 0, dz), player.teleport(x, 0, z)\n";
 
         bool showDocs = false;
         bool showContent = false;
 
         std::vector<PlacedCube> cubes;
+        uint64_t cubeLayoutVersion = 0; // Bumped on every add/remove so the culling chunks rebuild.
+        vengine::CubeChunkIndex cubeChunks;
+        uint64_t cubeChunksVersion = UINT64_MAX;
+        vengine::ChunkOcclusionCuller chunkOcclusion;
+        bool occlusionCulling = true;
         int selectedPreset = 2;
 
         GLuint cubeVao = 0;
@@ -284,7 +347,16 @@ namespace
         GLuint glowVao = 0;
         GLuint glowVbo = 0;
         GLuint glowProgram = 0;
+        ProgramUniforms litUniforms;
+        ProgramUniforms gridUniforms;
+        ProgramUniforms glowUniforms;
         int glowFanVertexCount = 0;
+        vengine::RenderQueue renderQueue;
+        // Per-frame scratch, reset at the top of RunFrame. frameHeapAllocations is how many heap
+        // allocations the previous frame made on this thread; steady state should be 0.
+        vengine::FrameArena frameArena;
+        uint64_t frameHeapAllocationMark = 0;
+        int frameHeapAllocations = 0;
         bool showRaytrace = false;
         GLuint raytraceTexture = 0;
         GLuint raytraceFbo = 0;
@@ -297,11 +369,23 @@ namespace
         GLint raytraceLocCameraRight = -1;
         GLint raytraceLocCameraUp = -1;
         GLint raytraceLocFovTan = -1;
-        GLint raytraceLocCubeCount = -1;
-        GLint raytraceLocCubeData = -1;
-        GLint raytraceLocCubeColor = -1;
-        GLint raytraceLocCubeGlow = -1;
-        GLint raytraceLocCubeTransparent = -1;
+        GLint raytraceLocVoxels = -1;
+        GLint raytraceLocGridOrigin = -1;
+        GLint raytraceLocGridSize = -1;
+        GLint raytraceLocGlowLights = -1;
+        GLint raytraceLocGlowCount = -1;
+        GLint raytraceLocSampleIndex = -1;
+        GLint raytraceLocSamplesPerPass = -1;
+        GLuint raytraceVoxelTexture = 0; // 3D RGBA8: colour plus kRaytraceVoxel* kind.
+        GLuint raytraceLightTexture = 0; // RGBA32F glow cube centres, kRaytraceLightTextureWidth per row.
+        GLint raytraceMaxGridSize = 0;
+        int raytraceCubeCount = 0;
+        bool raytraceFloatTarget = false;
+        int raytraceSampleCount = 0;
+        // What the accumulated samples were traced from; a mismatch restarts accumulation.
+        Vec3 raytraceCameraEye{0.0f, 0.0f, 0.0f};
+        Vec3 raytraceCameraDir{0.0f, 0.0f, 0.0f};
+        uint64_t raytraceSceneVersion = UINT64_MAX;
 
         Mat4 projection{};
         Mat4 view{};
@@ -350,6 +434,35 @@ namespace
         return program;
     }
 
+    // Every program takes uMVP and uColor; lit ones also uModel and uAlpha. Draws skip a uniform
+    // whose location is -1, so a renamed or optimised-out uniform would otherwise fail silently.
+    ProgramUniforms ResolveUniforms(GLuint program, const char* name, bool lit)
+    {
+        ProgramUniforms uniforms;
+        if (program == 0)
+        {
+            return uniforms;
+        }
+        uniforms.mvp = glGetUniformLocation(program, "uMVP");
+        uniforms.model = glGetUniformLocation(program, "uModel");
+        uniforms.color = glGetUniformLocation(program, "uColor");
+        uniforms.alpha = glGetUniformLocation(program, "uAlpha");
+        const struct
+        {
+            const char* uniform;
+            GLint location;
+            bool required;
+        } checks[] = {{"uMVP", uniforms.mvp, true}, {"uColor", uniforms.color, true}, {"uModel", uniforms.model, lit}, {"uAlpha", uniforms.alpha, lit}};
+        for (const auto& check : checks)
+        {
+            if (check.required && check.location < 0)
+            {
+                SDL_Log("%s program has no %s uniform", name, check.uniform);
+            }
+        }
+        return uniforms;
+    }
+
     void CreateBackground(AppState& app)
     {
         const float vertices[] = {
@@ -495,6 +608,7 @@ namespace
         GLuint vs = CompileShader(GL_VERTEX_SHADER, vsSource);
         GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fsSource);
         app.litProgram = LinkProgram(vs, fs);
+        app.litUniforms = ResolveUniforms(app.litProgram, "Lit", true);
         glDeleteShader(vs);
         glDeleteShader(fs);
     }
@@ -550,14 +664,17 @@ namespace
         GLuint vs = CompileShader(GL_VERTEX_SHADER, vsSource);
         GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fsSource);
         app.gridProgram = LinkProgram(vs, fs);
+        app.gridUniforms = ResolveUniforms(app.gridProgram, "Grid", false);
         glDeleteShader(vs);
         glDeleteShader(fs);
     }
 
+    constexpr float kGlowAuraRadius = 1.8f;
+
     void CreateGlowGeometry(AppState& app)
     {
         constexpr int kSegments = 32;
-        constexpr float radius = 1.8f;
+        constexpr float radius = kGlowAuraRadius;
 
         app.glowFanVertexCount = kSegments + 2;
         std::vector<float> vertices;
@@ -638,76 +755,85 @@ namespace
         GLuint vs = CompileShader(GL_VERTEX_SHADER, vsSource);
         GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fsSource);
         app.glowProgram = LinkProgram(vs, fs);
+        app.glowUniforms = ResolveUniforms(app.glowProgram, "Glow", false);
         glDeleteShader(vs);
         glDeleteShader(fs);
     }
 
-    void RenderGlowEffects(AppState& app, const Mat4& vp)
+    void SubmitGlowEffects(AppState& app, const vengine::Frustum& frustum)
     {
         if (app.glowProgram == 0 || app.glowVao == 0 || app.glowFanVertexCount == 0)
         {
             return;
         }
 
-        const GLsizei fanCount = app.glowFanVertexCount;
-        const GLint offsets[3] = {0, fanCount, fanCount * 2};
-
-        glUseProgram(app.glowProgram);
-        GLint mvpLoc = glGetUniformLocation(app.glowProgram, "uMVP");
-        GLint colorLoc = glGetUniformLocation(app.glowProgram, "uColor");
-
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-        glDepthMask(GL_FALSE);
-        glDisable(GL_CULL_FACE);
-
-        glBindVertexArray(app.glowVao);
-
-        for (const PlacedCube& cube : app.cubes)
-        {
-            if (!cube.glowing)
+        vengine::DrawCommand command;
+        command.blend = vengine::BlendMode::Additive;
+        command.program = app.glowProgram;
+        command.vertexArray = app.glowVao;
+        command.primitive = GL_TRIANGLE_FAN;
+        command.count = app.glowFanVertexCount;
+        command.model[13] = 0.5f;
+
+        app.cubeChunks.ForEachInFrustum(frustum, kGlowAuraRadius, [&](uint32_t index) {
+            const PlacedCube& cube = app.cubes[index];
+            if (!cube.glowing || !frustum.Intersects(vengine::CubeCellBounds(cube.gridX, 0, cube.gridZ, kGlowAuraRadius)))
             {
-                continue;
+                return;
             }
-            Mat4 model = Mat4::Identity();
-            model.m[12] = static_cast<float>(cube.gridX);
-            model.m[13] = 0.5f;
-            model.m[14] = static_cast<float>(cube.gridZ);
-            Mat4 mvp = Multiply(vp, model);
-            glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, mvp.m);
-            glUniform3f(colorLoc, cube.r, cube.g, cube.b);
+            command.model[12] = static_cast<float>(cube.gridX);
+            command.model[14] = static_cast<float>(cube.gridZ);
+            command.color[0] = cube.r;
+            command.color[1] = cube.g;
+            command.color[2] = cube.b;
+            // Three crossed fans per aura.
             for (int i = 0; i < 3; ++i)
             {
-                glDrawArrays(GL_TRIANGLE_FAN, offsets[i], fanCount);
+                command.first = app.glowFanVertexCount * i;
+                app.renderQueue.Submit(command);
             }
-        }
-
-        glBindVertexArray(0);
-        glDepthMask(GL_TRUE);
-        glDisable(GL_BLEND);
-        glEnable(GL_CULL_FACE);
-        glUseProgram(0);
+        });
     }
 
-    void EnsureRaytraceResources(AppState& app)
+    // Creates the accumulation target, preferring RGBA16F so hundreds of averaged samples keep
+    // their precision; without a float-renderable format (EXT_color_buffer_float) it falls back
+    // to RGBA8, which converges to a slightly banded image.
+    void CreateRaytraceTarget(AppState& app, bool floatTarget)
     {
-        if (app.raytraceTexture == 0)
+        glGenTextures(1, &app.raytraceTexture);
+        glBindTexture(GL_TEXTURE_2D, app.raytraceTexture);
+        if (floatTarget)
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, app.raytraceWidth, app.raytraceHeight, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+        }
+        else
         {
-            glGenTextures(1, &app.raytraceTexture);
-            glBindTexture(GL_TEXTURE_2D, app.raytraceTexture);
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, app.raytraceWidth, app.raytraceHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glBindTexture(GL_TEXTURE_2D, 0);
         }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &app.raytraceFbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, app.raytraceFbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, app.raytraceTexture, 0);
+        app.raytraceFloatTarget = floatTarget;
+    }
 
-        if (app.raytraceFbo == 0)
+    void EnsureRaytraceResources(AppState& app)
+    {
+        if (app.raytraceTexture == 0)
         {
-            glGenFramebuffers(1, &app.raytraceFbo);
-            glBindFramebuffer(GL_FRAMEBUFFER, app.raytraceFbo);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, app.raytraceTexture, 0);
+            CreateRaytraceTarget(app, true);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glDeleteFramebuffers(1, &app.raytraceFbo);
+                glDeleteTextures(1, &app.raytraceTexture);
+                CreateRaytraceTarget(app, false);
+            }
             GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
             if (status != GL_FRAMEBUFFER_COMPLETE)
             {
@@ -725,171 +851,272 @@ namespace
                 "    gl_Position = vec4(aPos, 0.0, 1.0);\n"
                 "}\n";
 
+            // One pass traces uSamplesPerPass paths per pixel; the host blends the pass into the
+            // accumulation target with weight samples / total, so the target always holds the
+            // running mean. Glow cubes are area lights sampled explicitly at every diffuse hit
+            // (soft shadows); bounces pick cosine-weighted directions; glass passes light through
+            // tinted about half the time, matching its 0.45 alpha in the raster view.
+            //
+            // The scene is a voxel grid in uVoxels (rgb = colour, a = kind) walked cell by cell
+            // with a DDA, so a ray costs the cells it crosses rather than the number of cubes.
+            // uGlowLights lists the glow cube centres for light sampling.
             const char* fsSource =
                 "#version 300 es\n"
                 "precision highp float;\n"
-                "#define MAX_RAYTRACE_CUBES 64\n"
+                "precision highp int;\n"
+                "precision highp sampler2D;\n"
+                "precision highp sampler3D;\n"
+                "#define MAX_BOUNCES 3\n"
+                "#define MAX_SEGMENTS 8\n"
+                "#define KIND_EMPTY 0\n"
+                "#define KIND_SOLID 1\n"
+                "#define KIND_GLOW 2\n"
+                "#define KIND_GLASS 3\n"
+                "#define LIGHT_TEXTURE_WIDTH 256\n"
                 "uniform vec2 uResolution;\n"
                 "uniform vec3 uCameraPos;\n"
                 "uniform vec3 uCameraDir;\n"
                 "uniform vec3 uCameraRight;\n"
                 "uniform vec3 uCameraUp;\n"
                 "uniform float uFovTan;\n"
-                "uniform int uCubeCount;\n"
-                "uniform vec4 uCubeData[MAX_RAYTRACE_CUBES];\n"
-                "uniform vec4 uCubeColor[MAX_RAYTRACE_CUBES];\n"
-                "uniform int uCubeGlow[MAX_RAYTRACE_CUBES];\n"
-                "uniform int uCubeTransparent[MAX_RAYTRACE_CUBES];\n"
+                "uniform sampler3D uVoxels;\n"
+                "uniform vec3 uGridOrigin;\n"
+                "uniform ivec3 uGridSize;\n"
+                "uniform sampler2D uGlowLights;\n"
+                "uniform int uGlowCount;\n"
+                "uniform int uSampleIndex;\n"
+                "uniform int uSamplesPerPass;\n"
                 "out vec4 FragColor;\n"
                 "\n"
-                "bool IntersectCube(vec3 ro, vec3 rd, vec3 center, out float tHit, out vec3 normal)\n"
+                "uint gRngState;\n"
+                "\n"
+                "float Random()\n"
                 "{\n"
-                "    vec3 minB = center + vec3(-0.5, 0.0, -0.5);\n"
-                "    vec3 maxB = center + vec3(0.5, 1.0, 0.5);\n"
-                "    vec3 invDir = 1.0 / rd;\n"
-                "    vec3 t0 = (minB - ro) * invDir;\n"
-                "    vec3 t1 = (maxB - ro) * invDir;\n"
-                "    vec3 tmin = min(t0, t1);\n"
-                "    vec3 tmax = max(t0, t1);\n"
-                "    float tNear = max(max(tmin.x, tmin.y), tmin.z);\n"
-                "    float tFar = min(min(tmax.x, tmax.y), tmax.z);\n"
-                "    if (tNear > tFar || tFar < 0.0)\n"
-                "        return false;\n"
-                "    tHit = max(tNear, 0.0);\n"
-                "    vec3 hit = ro + rd * tHit;\n"
-                "    const float eps = 0.001;\n"
-                "    if (abs(hit.x - minB.x) < eps) normal = vec3(-1.0, 0.0, 0.0);\n"
-                "    else if (abs(hit.x - maxB.x) < eps) normal = vec3(1.0, 0.0, 0.0);\n"
-                "    else if (abs(hit.y - minB.y) < eps) normal = vec3(0.0, -1.0, 0.0);\n"
-                "    else if (abs(hit.y - maxB.y) < eps) normal = vec3(0.0, 1.0, 0.0);\n"
-                "    else if (abs(hit.z - minB.z) < eps) normal = vec3(0.0, 0.0, -1.0);\n"
-                "    else normal = vec3(0.0, 0.0, 1.0);\n"
-                "    return true;\n"
+                "    gRngState = gRngState * 747796405u + 2891336453u;\n"
+                "    uint word = ((gRngState >> ((gRngState >> 28u) + 4u)) ^ gRngState) * 277803737u;\n"
+                "    word = (word >> 22u) ^ word;\n"
+                "    return float(word) / 4294967296.0;\n"
                 "}\n"
                 "\n"
-                "bool Occluded(vec3 origin, vec3 dir, float maxT, int ignoreIndex)\n"
+                "int VoxelKind(vec4 voxel)\n"
                 "{\n"
-                "    float tTmp;\n"
-                "    vec3 nTmp;\n"
-                "    for (int i = 0; i < uCubeCount; ++i)\n"
-                "    {\n"
-                "        if (i == ignoreIndex)\n"
-                "            continue;\n"
-                "        if (uCubeTransparent[i] == 1)\n"
-                "            continue;\n"
-                "        if (IntersectCube(origin, dir, uCubeData[i].xyz, tTmp, nTmp))\n"
-                "        {\n"
-                "            if (tTmp > 0.02 && tTmp < maxT - 0.02)\n"
-                "                return true;\n"
-                "        }\n"
-                "    }\n"
-                "    return false;\n"
+                "    return int(voxel.a * 255.0 + 0.5);\n"
                 "}\n"
                 "\n"
-                "vec3 Shade(vec3 pos, vec3 normal, vec3 baseColor, int selfIndex)\n"
+                "// Walks the grid from ro along rd up to maxT, skipping skipCell. Returns the first occupied\n"
+                "// voxel's kind (KIND_EMPTY when none) with its colour, cell, entry distance and entry face.\n"
+                "// With glassTint set, glass is stepped through and its tint multiplied into transmittance.\n"
+                "int MarchVoxels(vec3 ro, vec3 rd, float maxT, ivec3 skipCell, bool glassTint, out float tHit, out vec3 normal,\n"
+                "                out ivec3 cell, out vec4 voxel, inout vec3 transmittance)\n"
                 "{\n"
-                "    vec3 result = baseColor * 0.15;\n"
-                "    for (int i = 0; i < uCubeCount; ++i)\n"
+                "    tHit = maxT;\n"
+                "    normal = vec3(0.0, 1.0, 0.0);\n"
+                "    cell = ivec3(-1);\n"
+                "    voxel = vec4(0.0);\n"
+                "    vec3 gridSize = vec3(uGridSize);\n"
+                "    vec3 p = ro - uGridOrigin;\n"
+                "    vec3 dir = vec3(abs(rd.x) < 1e-6 ? 1e-6 : rd.x, abs(rd.y) < 1e-6 ? 1e-6 : rd.y, abs(rd.z) < 1e-6 ? 1e-6 : rd.z);\n"
+                "    vec3 invDir = 1.0 / dir;\n"
+                "    vec3 t0 = -p * invDir;\n"
+                "    vec3 t1 = (gridSize - p) * invDir;\n"
+                "    vec3 tmin = min(t0, t1);\n"
+                "    vec3 tmax = max(t0, t1);\n"
+                "    float tEnter = max(max(tmin.x, tmin.y), tmin.z);\n"
+                "    float tExit = min(min(tmax.x, tmax.y), tmax.z);\n"
+                "    if (tEnter > tExit || tExit < 0.0)\n"
+                "        return KIND_EMPTY;\n"
+                "    float t = max(tEnter, 0.0);\n"
+                "    vec3 stepSign = sign(dir);\n"
+                "    // The face crossed to enter the first cell; only matters when it is occupied.\n"
+                "    vec3 lastStep = tEnter == tmin.x ? vec3(stepSign.x, 0.0, 0.0) : (tEnter == tmin.y ? vec3(0.0, stepSign.y, 0.0) : vec3(0.0, 0.0, stepSign.z));\n"
+                "    ivec3 c = clamp(ivec3(floor(p + dir * (t + 1e-4))), ivec3(0), uGridSize - 1);\n"
+                "    ivec3 stepDir = ivec3(stepSign);\n"
+                "    vec3 tDelta = abs(invDir);\n"
+                "    vec3 tNext = (vec3(c) + max(stepSign, 0.0) - p) * invDir;\n"
+                "    int maxSteps = uGridSize.x + uGridSize.y + uGridSize.z;\n"
+                "    for (int i = 0; i < maxSteps; ++i)\n"
                 "    {\n"
-                "        if (uCubeGlow[i] == 0)\n"
-                "            continue;\n"
-                "        vec3 lightPos = uCubeData[i].xyz;\n"
-                "        vec3 L = lightPos - pos;\n"
-                "        float dist = length(L);\n"
-                "        if (dist < 0.0001)\n"
-                "            continue;\n"
-                "        L /= dist;\n"
-                "        if (Occluded(pos + normal * 0.02, L, dist, i))\n"
-                "            continue;\n"
-                "        float diff = max(dot(normal, L), 0.0);\n"
-                "        float attenuation = 1.0 / (1.0 + dist * 0.6 + dist * dist * 0.15);\n"
-                "        result += baseColor * diff * attenuation * 2.0;\n"
-                "        if (selfIndex == i)\n"
+                "        if (t >= maxT)\n"
+                "            break;\n"
+                "        vec4 v = texelFetch(uVoxels, c, 0);\n"
+                "        int kind = VoxelKind(v);\n"
+                "        if (kind != KIND_EMPTY && c != skipCell)\n"
+                "        {\n"
+                "            if (glassTint && kind == KIND_GLASS)\n"
+                "            {\n"
+                "                transmittance *= mix(vec3(1.0), v.rgb, 0.5);\n"
+                "            }\n"
+                "            else\n"
+                "            {\n"
+                "                tHit = t;\n"
+                "                normal = -lastStep;\n"
+                "                cell = c;\n"
+                "                voxel = v;\n"
+                "                return kind;\n"
+                "            }\n"
+                "        }\n"
+                "        if (tNext.x < tNext.y && tNext.x < tNext.z)\n"
                 "        {\n"
-                "            result += uCubeColor[i].rgb * 0.8;\n"
+                "            t = tNext.x;\n"
+                "            tNext.x += tDelta.x;\n"
+                "            c.x += stepDir.x;\n"
+                "            lastStep = vec3(stepSign.x, 0.0, 0.0);\n"
                 "        }\n"
+                "        else if (tNext.y < tNext.z)\n"
+                "        {\n"
+                "            t = tNext.y;\n"
+                "            tNext.y += tDelta.y;\n"
+                "            c.y += stepDir.y;\n"
+                "            lastStep = vec3(0.0, stepSign.y, 0.0);\n"
+                "        }\n"
+                "        else\n"
+                "        {\n"
+                "            t = tNext.z;\n"
+                "            tNext.z += tDelta.z;\n"
+                "            c.z += stepDir.z;\n"
+                "            lastStep = vec3(0.0, 0.0, stepSign.z);\n"
+                "        }\n"
+                "        if (any(lessThan(c, ivec3(0))) || any(greaterThanEqual(c, uGridSize)))\n"
+                "            break;\n"
                 "    }\n"
-                "    if (selfIndex >= 0 && uCubeTransparent[selfIndex] == 1)\n"
-                "    {\n"
-                "        result = mix(result, vec3(0.9, 0.95, 1.0), 0.5);\n"
-                "    }\n"
-                "    return clamp(result, 0.0, 1.0);\n"
+                "    return KIND_EMPTY;\n"
                 "}\n"
                 "\n"
-                "vec3 ShadeGround(vec3 pos)\n"
+                "// Nearest surface: a voxel kind, KIND_EMPTY for the ground (normal +y), or -1 for the sky.\n"
+                "int Trace(vec3 ro, vec3 rd, ivec3 skipCell, out float tHit, out vec3 normal, out ivec3 cell, out vec4 voxel)\n"
                 "{\n"
-                "    vec3 base = mix(vec3(0.08, 0.08, 0.09), vec3(0.28, 0.29, 0.32), 0.4 + 0.6 * clamp((pos.y + 0.01) * 10.0, 0.0, 1.0));\n"
-                "    vec3 normal = vec3(0.0, 1.0, 0.0);\n"
-                "    vec3 shaded = base * 0.15;\n"
-                "    for (int i = 0; i < uCubeCount; ++i)\n"
+                "    float tGround = 1e9;\n"
+                "    if (rd.y < -1e-4 && ro.y > 0.0)\n"
+                "        tGround = -ro.y / rd.y;\n"
+                "    vec3 unused = vec3(1.0);\n"
+                "    int kind = MarchVoxels(ro, rd, tGround, skipCell, false, tHit, normal, cell, voxel, unused);\n"
+                "    if (kind != KIND_EMPTY)\n"
+                "        return kind;\n"
+                "    if (tGround < 1e9)\n"
                 "    {\n"
-                "        if (uCubeGlow[i] == 0)\n"
-                "            continue;\n"
-                "        vec3 lightPos = uCubeData[i].xyz;\n"
-                "        vec3 L = lightPos - pos;\n"
-                "        float dist = length(L);\n"
-                "        if (dist < 0.0001)\n"
-                "            continue;\n"
-                "        L /= dist;\n"
-                "        if (Occluded(pos + normal * 0.02, L, dist, i))\n"
-                "            continue;\n"
-                "        float diff = max(dot(normal, L), 0.0);\n"
-                "        float attenuation = 1.0 / (1.0 + dist * 0.6 + dist * dist * 0.15);\n"
-                "        shaded += vec3(0.9, 0.9, 1.0) * diff * attenuation * 1.5;\n"
+                "        tHit = tGround;\n"
+                "        normal = vec3(0.0, 1.0, 0.0);\n"
+                "        return KIND_EMPTY;\n"
                 "    }\n"
-                "    return clamp(shaded, 0.0, 1.0);\n"
+                "    return -1;\n"
                 "}\n"
                 "\n"
-                "void main()\n"
+                "// Next-event estimate from one glow cube picked at random, aimed at a random point inside it.\n"
+                "vec3 SampleGlowLight(vec3 pos, vec3 normal, ivec3 selfCell)\n"
                 "{\n"
-                "    vec2 uv = (gl_FragCoord.xy / uResolution) * 2.0 - 1.0;\n"
-                "    uv.x *= uResolution.x / uResolution.y;\n"
-                "    vec3 rd = normalize(uCameraDir + uv.x * uCameraRight * uFovTan + uv.y * uCameraUp * uFovTan);\n"
-                "    vec3 ro = uCameraPos;\n"
+                "    if (uGlowCount == 0)\n"
+                "        return vec3(0.0);\n"
+                "    int lightIndex = min(int(Random() * float(uGlowCount)), uGlowCount - 1);\n"
+                "    vec3 center = texelFetch(uGlowLights, ivec2(lightIndex % LIGHT_TEXTURE_WIDTH, lightIndex / LIGHT_TEXTURE_WIDTH), 0).xyz;\n"
+                "    ivec3 lightCell = ivec3(floor(center - uGridOrigin));\n"
+                "    if (lightCell == selfCell)\n"
+                "        return vec3(0.0);\n"
+                "    vec3 target = center + vec3(Random(), Random(), Random()) - 0.5;\n"
+                "    vec3 L = target - pos;\n"
+                "    float dist = length(L);\n"
+                "    if (dist < 0.0001)\n"
+                "        return vec3(0.0);\n"
+                "    L /= dist;\n"
+                "    float diff = dot(normal, L);\n"
+                "    if (diff <= 0.0)\n"
+                "        return vec3(0.0);\n"
+                "    vec3 visible = vec3(1.0);\n"
+                "    float tBlock;\n"
+                "    vec3 nBlock;\n"
+                "    ivec3 cBlock;\n"
+                "    vec4 vBlock;\n"
+                "    if (MarchVoxels(pos + normal * 0.02, L, dist - 0.02, lightCell, true, tBlock, nBlock, cBlock, vBlock, visible) != KIND_EMPTY)\n"
+                "        return vec3(0.0);\n"
+                "    float attenuation = 1.0 / (1.0 + dist * 0.6 + dist * dist * 0.15);\n"
+                "    vec3 lightColor = texelFetch(uVoxels, lightCell, 0).rgb;\n"
+                "    return lightColor * visible * diff * attenuation * 2.0 * float(uGlowCount);\n"
+                "}\n"
+                "\n"
+                "vec3 CosineDirection(vec3 normal)\n"
+                "{\n"
+                "    float u = Random();\n"
+                "    float phi = 6.2831853 * Random();\n"
+                "    float r = sqrt(u);\n"
+                "    vec3 tangent = normalize(abs(normal.y) < 0.9 ? cross(normal, vec3(0.0, 1.0, 0.0)) : cross(normal, vec3(1.0, 0.0, 0.0)));\n"
+                "    vec3 bitangent = cross(normal, tangent);\n"
+                "    return normalize(tangent * (r * cos(phi)) + bitangent * (r * sin(phi)) + normal * sqrt(1.0 - u));\n"
+                "}\n"
                 "\n"
-                "    float closestT = 1e9;\n"
-                "    vec3 hitColor = vec3(0.0);\n"
-                "    bool hitSomething = false;\n"
+                "vec3 Sky(vec3 rd)\n"
+                "{\n"
+                "    vec3 top = vec3(0.18, 0.13, 0.25);\n"
+                "    vec3 bottom = vec3(0.03, 0.05, 0.12);\n"
+                "    return mix(bottom, top, clamp(rd.y * 0.5 + 0.5, 0.0, 1.0));\n"
+                "}\n"
                 "\n"
-                "    float tCube;\n"
-                "    vec3 normalCube;\n"
-                "    int hitIndex = -1;\n"
-                "    for (int i = 0; i < uCubeCount; ++i)\n"
+                "vec3 TracePath(vec3 ro, vec3 rd)\n"
+                "{\n"
+                "    vec3 radiance = vec3(0.0);\n"
+                "    vec3 throughput = vec3(1.0);\n"
+                "    ivec3 skipCell = ivec3(-1);\n"
+                "    int bounces = 0;\n"
+                "    for (int segment = 0; segment < MAX_SEGMENTS; ++segment)\n"
                 "    {\n"
-                "        if (IntersectCube(ro, rd, uCubeData[i].xyz, tCube, normalCube))\n"
+                "        float t;\n"
+                "        vec3 normal;\n"
+                "        ivec3 cell;\n"
+                "        vec4 voxel;\n"
+                "        int kind = Trace(ro, rd, skipCell, t, normal, cell, voxel);\n"
+                "        if (kind < 0)\n"
                 "        {\n"
-                "            if (tCube < closestT)\n"
-                "            {\n"
-                "                closestT = tCube;\n"
-                "                vec3 pos = ro + rd * tCube;\n"
-                "                hitColor = Shade(pos, normalCube, uCubeColor[i].rgb, i);\n"
-                "                hitSomething = true;\n"
-                "                hitIndex = i;\n"
-                "            }\n"
+                "            radiance += throughput * Sky(rd);\n"
+                "            break;\n"
                 "        }\n"
-                "    }\n"
-                "\n"
-                "    vec3 groundNormal = vec3(0.0, 1.0, 0.0);\n"
-                "    if (abs(rd.y) > 1e-4)\n"
-                "    {\n"
-                "        float tGround = (-ro.y) / rd.y;\n"
-                "        if (tGround > 0.0 && tGround < closestT)\n"
+                "        vec3 pos = ro + rd * t;\n"
+                "        vec3 albedo = vec3(0.22, 0.22, 0.25);\n"
+                "        if (kind == KIND_GLOW)\n"
                 "        {\n"
-                "            vec3 pos = ro + rd * tGround;\n"
-                "            hitColor = ShadeGround(pos);\n"
-                "            hitSomething = true;\n"
+                "            // Later bounces already counted this light through SampleGlowLight.\n"
+                "            if (bounces == 0)\n"
+                "                radiance += throughput * voxel.rgb;\n"
+                "            break;\n"
                 "        }\n"
+                "        if (kind != KIND_EMPTY)\n"
+                "        {\n"
+                "            albedo = voxel.rgb;\n"
+                "        }\n"
+                "        if (kind == KIND_GLASS)\n"
+                "        {\n"
+                "            if (Random() < 0.55)\n"
+                "            {\n"
+                "                throughput *= mix(vec3(1.0), voxel.rgb, 0.5);\n"
+                "                ro = pos;\n"
+                "                skipCell = cell;\n"
+                "                continue;\n"
+                "            }\n"
+                "            albedo = mix(albedo, vec3(0.9, 0.95, 1.0), 0.5);\n"
+                "        }\n"
+                "        radiance += throughput * albedo * (SampleGlowLight(pos, normal, cell) + 0.05);\n"
+                "        if (bounces == MAX_BOUNCES)\n"
+                "            break;\n"
+                "        ++bounces;\n"
+                "        throughput *= albedo;\n"
+                "        ro = pos + normal * 0.002;\n"
+                "        rd = CosineDirection(normal);\n"
+                "        skipCell = ivec3(-1);\n"
                 "    }\n"
+                "    return radiance;\n"
+                "}\n"
                 "\n"
-                "    if (!hitSomething)\n"
+                "void main()\n"
+                "{\n"
+                "    gRngState = (uint(gl_FragCoord.x) * 1973u + uint(gl_FragCoord.y) * 9277u + uint(uSampleIndex) * 26699u) | 1u;\n"
+                "    vec3 sum = vec3(0.0);\n"
+                "    for (int s = 0; s < uSamplesPerPass; ++s)\n"
                 "    {\n"
-                "        vec3 top = vec3(0.18, 0.13, 0.25);\n"
-                "        vec3 bottom = vec3(0.03, 0.05, 0.12);\n"
-                "        float t = clamp(uv.y * 0.5 + 0.5, 0.0, 1.0);\n"
-                "        hitColor = mix(bottom, top, t);\n"
+                "        vec2 jitter = vec2(Random(), Random()) - 0.5;\n"
+                "        vec2 uv = ((gl_FragCoord.xy + jitter) / uResolution) * 2.0 - 1.0;\n"
+                "        uv.x *= uResolution.x / uResolution.y;\n"
+                "        vec3 rd = normalize(uCameraDir + uv.x * uCameraRight * uFovTan + uv.y * uCameraUp * uFovTan);\n"
+                "        // Clamped per path so a rare bright bounce cannot leave a lasting speck.\n"
+                "        sum += min(TracePath(uCameraPos, rd), vec3(4.0));\n"
                 "    }\n"
-                "\n"
-                "    FragColor = vec4(hitColor, 1.0);\n"
+                "    FragColor = vec4(sum / float(uSamplesPerPass), 1.0);\n"
                 "}\n";
 
             GLuint vs = CompileShader(GL_VERTEX_SHADER, vsSource);
@@ -905,59 +1132,86 @@ namespace
                 app.raytraceLocCameraRight = glGetUniformLocation(app.raytraceProgram, "uCameraRight");
                 app.raytraceLocCameraUp = glGetUniformLocation(app.raytraceProgram, "uCameraUp");
                 app.raytraceLocFovTan = glGetUniformLocation(app.raytraceProgram, "uFovTan");
-                app.raytraceLocCubeCount = glGetUniformLocation(app.raytraceProgram, "uCubeCount");
-                app.raytraceLocCubeData = glGetUniformLocation(app.raytraceProgram, "uCubeData");
-                app.raytraceLocCubeColor = glGetUniformLocation(app.raytraceProgram, "uCubeColor");
-                app.raytraceLocCubeGlow = glGetUniformLocation(app.raytraceProgram, "uCubeGlow");
-                app.raytraceLocCubeTransparent = glGetUniformLocation(app.raytraceProgram, "uCubeTransparent");
+                app.raytraceLocVoxels = glGetUniformLocation(app.raytraceProgram, "uVoxels");
+                app.raytraceLocGridOrigin = glGetUniformLocation(app.raytraceProgram, "uGridOrigin");
+                app.raytraceLocGridSize = glGetUniformLocation(app.raytraceProgram, "uGridSize");
+                app.raytraceLocGlowLights = glGetUniformLocation(app.raytraceProgram, "uGlowLights");
+                app.raytraceLocGlowCount = glGetUniformLocation(app.raytraceProgram, "uGlowCount");
+                app.raytraceLocSampleIndex = glGetUniformLocation(app.raytraceProgram, "uSampleIndex");
+                app.raytraceLocSamplesPerPass = glGetUniformLocation(app.raytraceProgram, "uSamplesPerPass");
             }
         }
+
+        if (app.raytraceVoxelTexture == 0)
+        {
+            glGenTextures(1, &app.raytraceVoxelTexture);
+            glGenTextures(1, &app.raytraceLightTexture);
+            glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &app.raytraceMaxGridSize);
+        }
     }
 
-    void CompileRaytracedScene(AppState& app)
+    // Rebuilds the voxel grid and glow light list, and uploads them with the camera uniforms.
+    // Uniforms live in the program object, so this runs only when accumulation restarts.
+    void UploadRaytraceScene(AppState& app)
     {
-        EnsureRaytraceResources(app);
-        if (app.raytraceProgram == 0 || app.raytraceFbo == 0)
+        // The grid spans the cubes' bounding box plus one empty cell of margin; rays outside it
+        // only ever see the ground and the sky.
+        int minX = 0;
+        int maxX = 0;
+        int minZ = 0;
+        int maxZ = 0;
+        for (size_t i = 0; i < app.cubes.size(); ++i)
         {
-            return;
+            const PlacedCube& cube = app.cubes[i];
+            minX = i == 0 ? cube.gridX : std::min(minX, cube.gridX);
+            maxX = i == 0 ? cube.gridX : std::max(maxX, cube.gridX);
+            minZ = i == 0 ? cube.gridZ : std::min(minZ, cube.gridZ);
+            maxZ = i == 0 ? cube.gridZ : std::max(maxZ, cube.gridZ);
         }
-
-        std::array<float, kMaxRaytraceCubes * 4> cubeData{};
-        std::array<float, kMaxRaytraceCubes * 4> cubeColors{};
-        std::array<int, kMaxRaytraceCubes> cubeGlow{};
-        std::array<int, kMaxRaytraceCubes> cubeTransparent{};
-
-        int cubeCount = 0;
+        const int maxSize = std::max(1, app.raytraceMaxGridSize);
+        const int sizeX = std::min(maxX - minX + 1, maxSize);
+        const int sizeY = 1; // Cubes stand only on the ground layer.
+        const int sizeZ = std::min(maxZ - minZ + 1, maxSize);
+
+        std::vector<uint8_t> voxels(static_cast<size_t>(sizeX) * sizeY * sizeZ * 4, 0);
+        std::vector<float> lights;
+        app.raytraceCubeCount = 0;
         for (const PlacedCube& cube : app.cubes)
         {
-            if (cubeCount >= kMaxRaytraceCubes)
+            const int x = cube.gridX - minX;
+            const int z = cube.gridZ - minZ;
+            if (x >= sizeX || z >= sizeZ)
             {
-                break;
+                continue;
             }
-            const int index = cubeCount * 4;
-            cubeData[index + 0] = static_cast<float>(cube.gridX);
-            cubeData[index + 1] = 0.5f;
-            cubeData[index + 2] = static_cast<float>(cube.gridZ);
-            cubeData[index + 3] = 1.0f;
-
-            cubeColors[index + 0] = cube.r;
-            cubeColors[index + 1] = cube.g;
-            cubeColors[index + 2] = cube.b;
-            cubeColors[index + 3] = 1.0f;
-
-            cubeGlow[cubeCount] = cube.glowing ? 1 : 0;
-            cubeTransparent[cubeCount] = cube.transparent ? 1 : 0;
-            ++cubeCount;
+            const size_t offset = (static_cast<size_t>(z) * sizeX + static_cast<size_t>(x)) * 4;
+            const int kind = cube.glowing ? kRaytraceVoxelGlow : (cube.transparent ? kRaytraceVoxelGlass : kRaytraceVoxelSolid);
+            voxels[offset + 0] = static_cast<uint8_t>(std::clamp(cube.r, 0.0f, 1.0f) * 255.0f + 0.5f);
+            voxels[offset + 1] = static_cast<uint8_t>(std::clamp(cube.g, 0.0f, 1.0f) * 255.0f + 0.5f);
+            voxels[offset + 2] = static_cast<uint8_t>(std::clamp(cube.b, 0.0f, 1.0f) * 255.0f + 0.5f);
+            voxels[offset + 3] = static_cast<uint8_t>(kind);
+            if (cube.glowing)
+            {
+                lights.insert(lights.end(), {static_cast<float>(cube.gridX), 0.5f, static_cast<float>(cube.gridZ), 0.0f});
+            }
+            ++app.raytraceCubeCount;
         }
-
-        GLint previousFbo = 0;
-        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFbo);
-        GLint previousViewport[4];
-        glGetIntegerv(GL_VIEWPORT, previousViewport);
-
-        glBindFramebuffer(GL_FRAMEBUFFER, app.raytraceFbo);
-        glViewport(0, 0, app.raytraceWidth, app.raytraceHeight);
-        glUseProgram(app.raytraceProgram);
+        const int glowCount = static_cast<int>(lights.size() / 4);
+        const int lightRows = std::max(1, (glowCount + kRaytraceLightTextureWidth - 1) / kRaytraceLightTextureWidth);
+        lights.resize(static_cast<size_t>(kRaytraceLightTextureWidth) * lightRows * 4, 0.0f);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_3D, app.raytraceVoxelTexture);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8, sizeX, sizeY, sizeZ, 0, GL_RGBA, GL_UNSIGNED_BYTE, voxels.data());
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_3D, 0);
+        glBindTexture(GL_TEXTURE_2D, app.raytraceLightTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, kRaytraceLightTextureWidth, lightRows, 0, GL_RGBA, GL_FLOAT, lights.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
         if (app.raytraceLocResolution >= 0)
         {
@@ -984,132 +1238,209 @@ namespace
             float tanHalfFov = std::tan(60.0f * (3.1415926535f / 180.0f) * 0.5f);
             glUniform1f(app.raytraceLocFovTan, tanHalfFov);
         }
-        if (app.raytraceLocCubeCount >= 0)
+        if (app.raytraceLocVoxels >= 0)
         {
-            glUniform1i(app.raytraceLocCubeCount, cubeCount);
+            glUniform1i(app.raytraceLocVoxels, 0);
         }
-        if (cubeCount > 0)
+        if (app.raytraceLocGlowLights >= 0)
         {
-            if (app.raytraceLocCubeData >= 0)
-            {
-                glUniform4fv(app.raytraceLocCubeData, cubeCount, cubeData.data());
-            }
-            if (app.raytraceLocCubeColor >= 0)
-            {
-                glUniform4fv(app.raytraceLocCubeColor, cubeCount, cubeColors.data());
-            }
-            if (app.raytraceLocCubeGlow >= 0)
-            {
-                glUniform1iv(app.raytraceLocCubeGlow, cubeCount, cubeGlow.data());
-            }
-            if (app.raytraceLocCubeTransparent >= 0)
-            {
-                glUniform1iv(app.raytraceLocCubeTransparent, cubeCount, cubeTransparent.data());
-            }
+            glUniform1i(app.raytraceLocGlowLights, 1);
+        }
+        if (app.raytraceLocGridOrigin >= 0)
+        {
+            // Cell (i, 0, k) covers [origin + (i, 0, k), origin + (i + 1, 1, k + 1)].
+            glUniform3f(app.raytraceLocGridOrigin, static_cast<float>(minX) - 0.5f, 0.0f, static_cast<float>(minZ) - 0.5f);
+        }
+        if (app.raytraceLocGridSize >= 0)
+        {
+            glUniform3i(app.raytraceLocGridSize, sizeX, sizeY, sizeZ);
+        }
+        if (app.raytraceLocGlowCount >= 0)
+        {
+            glUniform1i(app.raytraceLocGlowCount, glowCount);
+        }
+        if (app.raytraceLocSamplesPerPass >= 0)
+        {
+            glUniform1i(app.raytraceLocSamplesPerPass, kRaytraceSamplesPerFrame);
+        }
+    }
+
+    // "Compile Scene": opens the preview and restarts accumulation from scratch.
+    void CompileRaytracedScene(AppState& app)
+    {
+        EnsureRaytraceResources(app);
+        if (app.raytraceProgram == 0 || app.raytraceFbo == 0)
+        {
+            return;
+        }
+        app.raytraceSampleCount = 0;
+        app.showRaytrace = true;
+    }
+
+    // Adds kRaytraceSamplesPerFrame samples per pixel while the preview is open, until
+    // kRaytraceMaxSamples. Any camera move or cube edit restarts the accumulation.
+    void AccumulateRaytracedScene(AppState& app)
+    {
+        if (!app.showRaytrace || app.raytraceProgram == 0 || app.raytraceFbo == 0)
+        {
+            return;
+        }
+
+        auto same = [](const Vec3& a, const Vec3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; };
+        const bool cameraMoved = !same(app.cameraEye, app.raytraceCameraEye) || !same(app.cameraDir, app.raytraceCameraDir);
+        if (cameraMoved || app.raytraceSceneVersion != app.cubeLayoutVersion)
+        {
+            app.raytraceSampleCount = 0;
+            app.raytraceCameraEye = app.cameraEye;
+            app.raytraceCameraDir = app.cameraDir;
+            app.raytraceSceneVersion = app.cubeLayoutVersion;
+        }
+        if (app.raytraceSampleCount >= kRaytraceMaxSamples)
+        {
+            return;
+        }
+
+        GLint previousFbo = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFbo);
+        GLint previousViewport[4];
+        glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, app.raytraceFbo);
+        glViewport(0, 0, app.raytraceWidth, app.raytraceHeight);
+        glUseProgram(app.raytraceProgram);
+        if (app.raytraceSampleCount == 0)
+        {
+            UploadRaytraceScene(app);
+        }
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, app.raytraceLightTexture);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_3D, app.raytraceVoxelTexture);
+        if (app.raytraceLocSampleIndex >= 0)
+        {
+            glUniform1i(app.raytraceLocSampleIndex, app.raytraceSampleCount);
         }
 
+        // Running mean: the new pass gets weight n / (total + n). The first pass replaces
+        // whatever the target held, so it draws unblended.
+        const int total = app.raytraceSampleCount + kRaytraceSamplesPerFrame;
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        if (app.raytraceSampleCount > 0)
+        {
+            glEnable(GL_BLEND);
+            glBlendColor(0.0f, 0.0f, 0.0f, static_cast<float>(kRaytraceSamplesPerFrame) / static_cast<float>(total));
+            glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+        }
         glBindVertexArray(app.backgroundVao);
         glDrawArrays(GL_TRIANGLES, 0, 3);
         glBindVertexArray(0);
+        glDisable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+        glBindTexture(GL_TEXTURE_3D, 0);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+        app.raytraceSampleCount = total;
 
         glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
         glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
         glUseProgram(0);
-
-        app.showRaytrace = true;
     }
 
-    bool HandleEvents(AppState& app)
+    // Applies one event to the app. Returns false when the app should quit.
+    bool ProcessEvent(AppState& app, SDL_Event& event)
     {
-        SDL_Event event;
-        while (SDL_PollEvent(&event))
+        ImGui_ImplSDL2_ProcessEvent(&event);
+        if (event.type == SDL_QUIT)
         {
-            ImGui_ImplSDL2_ProcessEvent(&event);
-            if (event.type == SDL_QUIT)
-            {
-                return false;
-            }
-            if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED)
+            return false;
+        }
+        if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED)
+        {
+            app.windowWidth = event.window.data1;
+            app.windowHeight = event.window.data2;
+            glViewport(0, 0, app.windowWidth, app.windowHeight);
+        }
+        if (event.type == SDL_MOUSEWHEEL)
+        {
+            if (!ImGui::GetIO().WantCaptureMouse)
             {
-                app.windowWidth = event.window.data1;
-                app.windowHeight = event.window.data2;
-                glViewport(0, 0, app.windowWidth, app.windowHeight);
+                app.cameraDistance -= static_cast<float>(event.wheel.y) * 0.6f;
+                app.cameraDistance = std::clamp(app.cameraDistance, 4.0f, 18.0f);
             }
-            if (event.type == SDL_MOUSEWHEEL)
+        }
+        if (event.type == SDL_MOUSEBUTTONDOWN)
+        {
+            if (!ImGui::GetIO().WantCaptureMouse)
             {
-                if (!ImGui::GetIO().WantCaptureMouse)
+                const int mouseX = event.button.x;
+                const int mouseY = event.button.y;
+
+                const Mat4 vp = Multiply(app.projection, app.view);
+                Mat4 invVP{};
+                if (!Invert(vp, invVP))
                 {
-                    app.cameraDistance -= static_cast<float>(event.wheel.y) * 0.6f;
-                    app.cameraDistance = std::clamp(app.cameraDistance, 4.0f, 18.0f);
+                    return true;
                 }
-            }
-            if (event.type == SDL_MOUSEBUTTONDOWN)
-            {
-                if (!ImGui::GetIO().WantCaptureMouse)
-                {
-                    const int mouseX = event.button.x;
-                    const int mouseY = event.button.y;
 
-                    const Mat4 vp = Multiply(app.projection, app.view);
-                    Mat4 invVP{};
-                    if (!Invert(vp, invVP))
-                    {
-                        continue;
-                    }
+                const float ndcX = (static_cast<float>(mouseX) / static_cast<float>(app.windowWidth) * 2.0f) - 1.0f;
+                const float ndcY = 1.0f - (static_cast<float>(mouseY) / static_cast<float>(app.windowHeight) * 2.0f);
 
-                    const float ndcX = (static_cast<float>(mouseX) / static_cast<float>(app.windowWidth) * 2.0f) - 1.0f;
-                    const float ndcY = 1.0f - (static_cast<float>(mouseY) / static_cast<float>(app.windowHeight) * 2.0f);
+                Vec3 nearPoint = TransformPoint(invVP, Vec3{ndcX, ndcY, -1.0f});
+                Vec3 farPoint = TransformPoint(invVP, Vec3{ndcX, ndcY, 1.0f});
 
-                    Vec3 nearPoint = TransformPoint(invVP, Vec3{ndcX, ndcY, -1.0f});
-                    Vec3 farPoint = TransformPoint(invVP, Vec3{ndcX, ndcY, 1.0f});
+                Vec3 direction = farPoint - nearPoint;
+                if (std::fabs(direction.y) < 1e-4f)
+                {
+                    return true;
+                }
 
-                    Vec3 direction = farPoint - nearPoint;
-                    if (std::fabs(direction.y) < 1e-4f)
-                    {
-                        continue;
-                    }
+                const float t = -nearPoint.y / direction.y;
+                if (t < 0.0f)
+                {
+                    return true;
+                }
 
-                    const float t = -nearPoint.y / direction.y;
-                    if (t < 0.0f)
-                    {
-                        continue;
-                    }
+                Vec3 hitPoint = nearPoint + direction * t;
+                const int gridX = static_cast<int>(std::round(hitPoint.x));
+                const int gridZ = static_cast<int>(std::round(hitPoint.z));
+
+                if (std::abs(gridX) > 10 || std::abs(gridZ) > 10)
+                {
+                    return true;
+                }
 
-                    Vec3 hitPoint = nearPoint + direction * t;
-                    const int gridX = static_cast<int>(std::round(hitPoint.x));
-                    const int gridZ = static_cast<int>(std::round(hitPoint.z));
+                auto it = std::find_if(app.cubes.begin(), app.cubes.end(), [gridX, gridZ](const PlacedCube& cube) {
+                    return cube.gridX == gridX && cube.gridZ == gridZ;
+                });
 
-                    if (std::abs(gridX) > 10 || std::abs(gridZ) > 10)
+                if (event.button.button == SDL_BUTTON_LEFT)
+                {
+                    const int presetIndex = std::clamp(app.selectedPreset, 0, static_cast<int>(std::size(kSpawnPresets)) - 1);
+                    const SpawnPreset preset = GetPreset(presetIndex);
+                    if (it == app.cubes.end())
                     {
-                        continue;
+                        app.cubes.push_back({gridX, gridZ, preset.r, preset.g, preset.b, preset.glowing, preset.transparent, presetIndex});
+                        ++app.cubeLayoutVersion;
                     }
-
-                    auto it = std::find_if(app.cubes.begin(), app.cubes.end(), [gridX, gridZ](const PlacedCube& cube) {
-                        return cube.gridX == gridX && cube.gridZ == gridZ;
-                    });
-
-                    if (event.button.button == SDL_BUTTON_LEFT)
+                    else
                     {
-                        const SpawnPreset preset = GetPreset(app.selectedPreset);
-                        if (it == app.cubes.end())
-                        {
-                            app.cubes.push_back({gridX, gridZ, preset.r, preset.g, preset.b, preset.glowing, preset.transparent});
-                        }
-                        else
-                        {
-                            it->r = preset.r;
-                            it->g = preset.g;
-                            it->b = preset.b;
-                            it->glowing = preset.glowing;
-                            it->transparent = preset.transparent;
-                        }
+                        it->r = preset.r;
+                        it->g = preset.g;
+                        it->b = preset.b;
+                        it->glowing = preset.glowing;
+                        it->transparent = preset.transparent;
+                        it->presetIndex = presetIndex;
                     }
-                    else if (event.button.button == SDL_BUTTON_RIGHT)
+                }
+                else if (event.button.button == SDL_BUTTON_RIGHT)
+                {
+                    if (it != app.cubes.end())
                     {
-                        if (it != app.cubes.end())
-                        {
-                            app.cubes.erase(it);
-                        }
+                        app.cubes.erase(it);
+                        ++app.cubeLayoutVersion;
                     }
                 }
             }
@@ -1117,38 +1448,184 @@ namespace
         return true;
     }
 
-    void UpdateCamera(AppState& app)
+    bool IsRecordedInputEvent(Uint32 type)
     {
-        float moveX = 0.0f;
-        float moveZ = 0.0f;
-        if (app.cameraForward)
-        {
-            moveZ -= 1.0f;
-        }
-        if (app.cameraBackward)
+        return type == SDL_KEYDOWN || type == SDL_KEYUP || type == SDL_TEXTINPUT || type == SDL_MOUSEMOTION || type == SDL_MOUSEBUTTONDOWN ||
+               type == SDL_MOUSEBUTTONUP || type == SDL_MOUSEWHEEL;
+    }
+
+    int64_t PackPair(int32_t high, int32_t low)
+    {
+        return static_cast<int64_t>((static_cast<uint64_t>(static_cast<uint32_t>(high)) << 32) | static_cast<uint32_t>(low));
+    }
+
+    void RecordInputEvent(vengine::InputRecorder& recorder, const SDL_Event& event)
+    {
+        switch (event.type)
         {
-            moveZ += 1.0f;
-        }
-        if (app.cameraLeft)
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            recorder.Record(event.type, event.key.keysym.sym, event.key.keysym.scancode, event.key.keysym.mod, event.key.repeat);
+            break;
+        case SDL_TEXTINPUT:
         {
-            moveX -= 1.0f;
+            int64_t words[4] = {};
+            static_assert(sizeof(words) == SDL_TEXTINPUTEVENT_TEXT_SIZE, "text input no longer fits the payload");
+            std::memcpy(words, event.text.text, sizeof(words));
+            recorder.Record(event.type, words[0], words[1], words[2], words[3]);
+            break;
         }
-        if (app.cameraRight)
-        {
-            moveX += 1.0f;
+        case SDL_MOUSEMOTION:
+            recorder.Record(event.type, event.motion.x, event.motion.y, PackPair(event.motion.xrel, event.motion.yrel), event.motion.state);
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            recorder.Record(event.type, event.button.button, event.button.x, event.button.y, event.button.clicks);
+            break;
+        case SDL_MOUSEWHEEL:
+            recorder.Record(event.type, event.wheel.x, event.wheel.y, event.wheel.direction);
+            break;
+        default:
+            break;
         }
-        if (std::fabs(moveX) > 0.0f || std::fabs(moveZ) > 0.0f)
+    }
+
+    SDL_Event RebuildInputEvent(const AppState& app, const vengine::InputEvent& recorded)
+    {
+        SDL_Event event{};
+        event.type = recorded.kind;
+        const int64_t* p = recorded.payload;
+        // The ImGui backend drops events addressed to a window it does not know.
+        const Uint32 windowId = SDL_GetWindowID(app.window);
+        const Uint32 timestamp = SDL_GetTicks();
+        switch (recorded.kind)
         {
-            const float len = std::sqrt(moveX * moveX + moveZ * moveZ);
-            moveX /= len;
-            moveZ /= len;
-            app.cameraFocus.x += moveX * app.deltaTime * 6.0f;
-            app.cameraFocus.z += moveZ * app.deltaTime * 6.0f;
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            event.key.timestamp = timestamp;
+            event.key.windowID = windowId;
+            event.key.state = recorded.kind == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+            event.key.repeat = static_cast<Uint8>(p[3]);
+            event.key.keysym.sym = static_cast<SDL_Keycode>(p[0]);
+            event.key.keysym.scancode = static_cast<decltype(event.key.keysym.scancode)>(p[1]);
+            event.key.keysym.mod = static_cast<decltype(event.key.keysym.mod)>(p[2]);
+            break;
+        case SDL_TEXTINPUT:
+            event.text.timestamp = timestamp;
+            event.text.windowID = windowId;
+            std::memcpy(event.text.text, p, SDL_TEXTINPUTEVENT_TEXT_SIZE);
+            event.text.text[SDL_TEXTINPUTEVENT_TEXT_SIZE - 1] = '\0';
+            break;
+        case SDL_MOUSEMOTION:
+            event.motion.timestamp = timestamp;
+            event.motion.windowID = windowId;
+            event.motion.x = static_cast<Sint32>(p[0]);
+            event.motion.y = static_cast<Sint32>(p[1]);
+            event.motion.xrel = static_cast<Sint32>(p[2] >> 32);
+            event.motion.yrel = static_cast<Sint32>(p[2]);
+            event.motion.state = static_cast<Uint32>(p[3]);
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            event.button.timestamp = timestamp;
+            event.button.windowID = windowId;
+            event.button.state = recorded.kind == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED;
+            event.button.button = static_cast<Uint8>(p[0]);
+            event.button.x = static_cast<Sint32>(p[1]);
+            event.button.y = static_cast<Sint32>(p[2]);
+            event.button.clicks = static_cast<Uint8>(p[3]);
+            break;
+        case SDL_MOUSEWHEEL:
+            event.wheel.timestamp = timestamp;
+            event.wheel.windowID = windowId;
+            event.wheel.x = static_cast<Sint32>(p[0]);
+            event.wheel.y = static_cast<Sint32>(p[1]);
+            event.wheel.direction = static_cast<Uint32>(p[2]);
+            break;
+        default:
+            break;
         }
+        return event;
+    }
 
-        const float pitchRadians = 65.0f * (3.1415926535f / 180.0f);
-        const float cameraHeight = std::sin(pitchRadians) * app.cameraDistance;
-        const float cameraForward = std::cos(pitchRadians) * app.cameraDistance;
+    // While recording, every input event is logged on the frame it arrived. While replaying, live
+    // input is dropped (window and quit events still go through) and the recorded frame's events
+    // are fed through the same path instead.
+    bool HandleEvents(AppState& app)
+    {
+        app.inputRecorder.BeginFrame();
+        SDL_Event event;
+        while (SDL_PollEvent(&event))
+        {
+            if (IsRecordedInputEvent(event.type))
+            {
+                if (app.inputReplayer.Active())
+                {
+                    continue;
+                }
+                RecordInputEvent(app.inputRecorder, event);
+            }
+            if (!ProcessEvent(app, event))
+            {
+                return false;
+            }
+        }
+        if (app.inputReplayer.Active())
+        {
+            if (!app.inputReplayer.BeginFrame())
+            {
+                return false;
+            }
+            for (const vengine::InputEvent* recorded = app.inputReplayer.FrameEventsBegin(); recorded != app.inputReplayer.FrameEventsEnd(); ++recorded)
+            {
+                SDL_Event replayed = RebuildInputEvent(app, *recorded);
+                if (replayed.type == SDL_MOUSEMOTION || replayed.type == SDL_MOUSEBUTTONDOWN || replayed.type == SDL_MOUSEBUTTONUP)
+                {
+                    app.replayMouseKnown = true;
+                    app.replayMouseX = static_cast<float>(replayed.type == SDL_MOUSEMOTION ? replayed.motion.x : replayed.button.x);
+                    app.replayMouseY = static_cast<float>(replayed.type == SDL_MOUSEMOTION ? replayed.motion.y : replayed.button.y);
+                }
+                if (!ProcessEvent(app, replayed))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void UpdateCamera(AppState& app)
+    {
+        float moveX = 0.0f;
+        float moveZ = 0.0f;
+        if (app.cameraForward)
+        {
+            moveZ -= 1.0f;
+        }
+        if (app.cameraBackward)
+        {
+            moveZ += 1.0f;
+        }
+        if (app.cameraLeft)
+        {
+            moveX -= 1.0f;
+        }
+        if (app.cameraRight)
+        {
+            moveX += 1.0f;
+        }
+        if (std::fabs(moveX) > 0.0f || std::fabs(moveZ) > 0.0f)
+        {
+            const float len = std::sqrt(moveX * moveX + moveZ * moveZ);
+            moveX /= len;
+            moveZ /= len;
+            app.cameraFocus.x += moveX * app.deltaTime * 6.0f;
+            app.cameraFocus.z += moveZ * app.deltaTime * 6.0f;
+        }
+
+        const float pitchRadians = 65.0f * (3.1415926535f / 180.0f);
+        const float cameraHeight = std::sin(pitchRadians) * app.cameraDistance;
+        const float cameraForward = std::cos(pitchRadians) * app.cameraDistance;
         const Vec3 eye{app.cameraFocus.x, cameraHeight, app.cameraFocus.z + cameraForward};
         const Vec3 target{app.cameraFocus.x, 0.0f, app.cameraFocus.z};
         const Vec3 forward = Vec3::Normalize(target - eye);
@@ -1163,219 +1640,487 @@ namespace
         app.projection = Perspective(60.0f * (3.1415926535f / 180.0f), aspect, 0.1f, 100.0f);
     }
 
-    void RenderScene(AppState& app)
+    // Occlusion queries for the chunk culler. Boxes go through the grid program and the unit cube
+    // mesh, scaled to the chunk bounds. ANY_SAMPLES_PASSED_CONSERVATIVE lets the driver stop counting
+    // at the first sample.
+    class Gles3OcclusionQueries : public vengine::OcclusionQueryBackend
     {
-        glEnable(GL_DEPTH_TEST);
-        glCullFace(GL_BACK);
-        glEnable(GL_CULL_FACE);
+    public:
+        Gles3OcclusionQueries(const AppState& app, const Mat4& vp)
+            : m_app(app)
+            , m_vp(vp)
+        {
+        }
 
-        RenderGradientBackground(app);
+        uint32_t CreateQuery() override
+        {
+            GLuint query = 0;
+            glGenQueries(1, &query);
+            return query;
+        }
 
-        const Mat4 vp = Multiply(app.projection, app.view);
+        void DestroyQuery(uint32_t query) override
+        {
+            const GLuint id = query;
+            glDeleteQueries(1, &id);
+        }
 
-        glUseProgram(app.gridProgram);
-        GLint mvpLoc = glGetUniformLocation(app.gridProgram, "uMVP");
-        GLint colorLoc = glGetUniformLocation(app.gridProgram, "uColor");
-        glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, vp.m);
-        glUniform3f(colorLoc, 0.35f, 0.35f, 0.4f);
-        glBindVertexArray(app.gridVao);
-        glDrawArrays(GL_LINES, 0, (10 * 2 + 2) * 2);
-        glBindVertexArray(0);
+        bool QueryResultReady(uint32_t query) override
+        {
+            GLuint available = 0;
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            return available != 0;
+        }
 
-        glUseProgram(app.litProgram);
-        GLint litMvpLoc = glGetUniformLocation(app.litProgram, "uMVP");
-        GLint litModelLoc = glGetUniformLocation(app.litProgram, "uModel");
-        GLint litColorLoc = glGetUniformLocation(app.litProgram, "uColor");
-        GLint litAlphaLoc = glGetUniformLocation(app.litProgram, "uAlpha");
+        bool QueryAnySamplesPassed(uint32_t query) override
+        {
+            GLuint passed = 0;
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT, &passed);
+            return passed != 0;
+        }
+
+        void BeginBoxPass() override
+        {
+            glUseProgram(m_app.gridProgram);
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            glDepthMask(GL_FALSE);
+            glDisable(GL_CULL_FACE);
+            glBindVertexArray(m_app.cubeVao);
+        }
 
-        auto renderCubeAt = [&](float x, float y, float z, const Vec3& color, float alpha) {
+        void DrawQueryBox(uint32_t query, const vengine::Aabb& box) override
+        {
             Mat4 model = Mat4::Identity();
-            model.m[12] = x;
-            model.m[13] = y;
-            model.m[14] = z;
-            Mat4 mvp = Multiply(vp, model);
-            glUniformMatrix4fv(litMvpLoc, 1, GL_FALSE, mvp.m);
-            glUniformMatrix4fv(litModelLoc, 1, GL_FALSE, model.m);
-            glUniform3f(litColorLoc, color.x, color.y, color.z);
-            if (litAlphaLoc >= 0)
-            {
-                glUniform1f(litAlphaLoc, alpha);
-            }
-            glBindVertexArray(app.cubeVao);
+            model.m[0] = box.maxX - box.minX;
+            model.m[5] = box.maxY - box.minY;
+            model.m[10] = box.maxZ - box.minZ;
+            model.m[12] = (box.minX + box.maxX) * 0.5f;
+            model.m[13] = (box.minY + box.maxY) * 0.5f;
+            model.m[14] = (box.minZ + box.maxZ) * 0.5f;
+            const Mat4 mvp = Multiply(m_vp, model);
+            glUniformMatrix4fv(m_app.gridUniforms.mvp, 1, GL_FALSE, mvp.m);
+            glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, query);
             glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, nullptr);
+            glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+        }
+
+        void EndBoxPass() override
+        {
             glBindVertexArray(0);
-        };
+            glEnable(GL_CULL_FACE);
+            glDepthMask(GL_TRUE);
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        }
 
-        std::vector<const PlacedCube*> transparentCubes;
+    private:
+        const AppState& m_app;
+        const Mat4& m_vp;
+    };
 
-        for (const PlacedCube& cube : app.cubes)
+    // Replays RenderQueue commands. Blend modes carry their depth-write and culling state with
+    // them; Restore leaves the opaque defaults RenderScene starts from.
+    class Gles3RenderBackend : public vengine::RenderCommandBackend
+    {
+    public:
+        Gles3RenderBackend(const AppState& app, const Mat4& vp)
+            : m_app(app), m_vp(vp)
+        {
+        }
+
+        void SetBlendMode(vengine::BlendMode mode) override
         {
-            if (cube.transparent)
+            switch (mode)
             {
-                transparentCubes.push_back(&cube);
-                continue;
+            case vengine::BlendMode::Opaque:
+                glDisable(GL_BLEND);
+                glDepthMask(GL_TRUE);
+                glEnable(GL_CULL_FACE);
+                break;
+            case vengine::BlendMode::Alpha:
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                glDepthMask(GL_FALSE);
+                glEnable(GL_CULL_FACE);
+                break;
+            case vengine::BlendMode::Additive:
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+                glDepthMask(GL_FALSE);
+                glDisable(GL_CULL_FACE);
+                break;
             }
-            renderCubeAt(static_cast<float>(cube.gridX), 0.5f, static_cast<float>(cube.gridZ), Vec3{cube.r, cube.g, cube.b}, 1.0f);
         }
 
-        if (!transparentCubes.empty())
+        void BindProgram(uint32_t program) override
         {
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glDepthMask(GL_FALSE);
-            for (const PlacedCube* cube : transparentCubes)
+            glUseProgram(program);
+            if (program == m_app.litProgram)
             {
-                renderCubeAt(static_cast<float>(cube->gridX), 0.5f, static_cast<float>(cube->gridZ), Vec3{cube->r, cube->g, cube->b}, 0.45f);
+                m_uniforms = &m_app.litUniforms;
             }
-            glDepthMask(GL_TRUE);
-            glDisable(GL_BLEND);
-            if (litAlphaLoc >= 0)
+            else if (program == m_app.glowProgram)
+            {
+                m_uniforms = &m_app.glowUniforms;
+            }
+            else if (program == m_app.gridProgram)
             {
-                glUniform1f(litAlphaLoc, 1.0f);
+                m_uniforms = &m_app.gridUniforms;
+            }
+            else
+            {
+                // A program nobody resolved uniforms for: draw it without any rather than with
+                // another program's locations, and say so once.
+                static bool reported = false;
+                if (!reported)
+                {
+                    SDL_Log("Render queue bound unknown program %u; its uniforms are not set", program);
+                    reported = true;
+                }
+                m_uniforms = &m_noUniforms;
             }
         }
 
-        renderCubeAt(app.cameraFocus.x, 0.5f, app.cameraFocus.z, Vec3{0.6f, 0.7f, 1.0f}, 1.0f);
+        void BindVertexArray(uint32_t vertexArray) override
+        {
+            glBindVertexArray(vertexArray);
+        }
 
-        RenderGlowEffects(app, vp);
-    }
+        void BindTexture(uint32_t texture) override
+        {
+            glBindTexture(GL_TEXTURE_2D, texture);
+        }
 
-    const std::unordered_set<std::string> kLuaKeywords = {
-        "and", "break", "do", "else", "elseif", "end", "false", "for",
-        "function", "goto", "if", "in", "local", "nil", "not", "or",
-        "repeat", "return", "then", "true", "until", "while"};
+        void Draw(const vengine::DrawCommand& command) override
+        {
+            Mat4 model;
+            std::copy(std::begin(command.model), std::end(command.model), model.m);
+            if (m_uniforms->mvp >= 0)
+            {
+                const Mat4 mvp = Multiply(m_vp, model);
+                glUniformMatrix4fv(m_uniforms->mvp, 1, GL_FALSE, mvp.m);
+            }
+            if (m_uniforms->model >= 0)
+            {
+                glUniformMatrix4fv(m_uniforms->model, 1, GL_FALSE, model.m);
+            }
+            if (m_uniforms->color >= 0)
+            {
+                glUniform3f(m_uniforms->color, command.color[0], command.color[1], command.color[2]);
+            }
+            if (m_uniforms->alpha >= 0)
+            {
+                glUniform1f(m_uniforms->alpha, command.alpha);
+            }
+            if (command.indexed)
+            {
+                glDrawElements(command.primitive, command.count, GL_UNSIGNED_SHORT,
+                               reinterpret_cast<const void*>(static_cast<uintptr_t>(command.first)));
+            }
+            else
+            {
+                glDrawArrays(command.primitive, command.first, command.count);
+            }
+        }
 
-    bool IsIdentifierChar(char c)
-    {
-        return static_cast<bool>(std::isalnum(static_cast<unsigned char>(c)) || c == '_');
-    }
+        void Restore() override
+        {
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glBindVertexArray(0);
+            glUseProgram(0);
+            SetBlendMode(vengine::BlendMode::Opaque);
+        }
+
+    private:
+        const AppState& m_app;
+        const Mat4& m_vp;
+        const ProgramUniforms* m_uniforms = nullptr;
+        const ProgramUniforms m_noUniforms;
+    };
 
-    void RenderLuaToken(ImDrawList* drawList, const char* begin, const char* end, ImVec2& cursor, ImU32 color)
+    void RefreshCubeChunks(AppState& app)
     {
-        if (begin >= end)
+        if (app.cubeChunksVersion == app.cubeLayoutVersion)
         {
             return;
         }
-        drawList->AddText(cursor, color, begin, end);
-        const ImVec2 size = ImGui::CalcTextSize(begin, end, false);
-        cursor.x += size.x;
+        app.cubeChunks.Clear();
+        for (size_t i = 0; i < app.cubes.size(); ++i)
+        {
+            app.cubeChunks.Insert(static_cast<uint32_t>(i), app.cubes[i].gridX, 0, app.cubes[i].gridZ);
+        }
+        app.cubeChunksVersion = app.cubeLayoutVersion;
     }
 
-    void RenderLuaLineTokens(ImDrawList* drawList,
-                             const char* lineStart,
-                             const char* lineEnd,
-                             ImVec2& cursor,
-                             ImU32 defaultColor,
-                             ImU32 keywordColor,
-                             ImU32 stringColor,
-                             ImU32 commentColor,
-                             ImU32 numberColor)
+    void RenderScene(AppState& app)
     {
-        const char* ptr = lineStart;
-        while (ptr < lineEnd)
-        {
-            if (*ptr == '\r')
-            {
-                ++ptr;
-                continue;
-            }
-            if (*ptr == '-' && (ptr + 1) < lineEnd && *(ptr + 1) == '-')
-            {
-                RenderLuaToken(drawList, ptr, lineEnd, cursor, commentColor);
-                break;
-            }
-            if (*ptr == '"' || *ptr == '\'')
+        glEnable(GL_DEPTH_TEST);
+        glCullFace(GL_BACK);
+        glEnable(GL_CULL_FACE);
+
+        RenderGradientBackground(app);
+
+        const Mat4 vp = Multiply(app.projection, app.view);
+        // vp is exactly what the shaders receive as uMVP, so its planes match what ends up on screen.
+        vengine::Frustum frustum;
+        frustum.Extract(vp.m);
+        RefreshCubeChunks(app);
+
+        app.renderQueue.BeginFrame();
+        Gles3RenderBackend backend(app, vp);
+
+        vengine::DrawCommand grid;
+        grid.program = app.gridProgram;
+        grid.vertexArray = app.gridVao;
+        grid.primitive = GL_LINES;
+        grid.count = (10 * 2 + 2) * 2;
+        grid.color[0] = 0.35f;
+        grid.color[1] = 0.35f;
+        grid.color[2] = 0.4f;
+        app.renderQueue.Submit(grid);
+
+        auto submitCubeAt = [&](float x, float y, float z, const Vec3& color, bool transparent) {
+            vengine::DrawCommand command;
+            command.blend = transparent ? vengine::BlendMode::Alpha : vengine::BlendMode::Opaque;
+            command.program = app.litProgram;
+            command.vertexArray = app.cubeVao;
+            command.primitive = GL_TRIANGLES;
+            command.count = 36;
+            command.indexed = true;
+            command.model[12] = x;
+            command.model[13] = y;
+            command.model[14] = z;
+            command.color[0] = color.x;
+            command.color[1] = color.y;
+            command.color[2] = color.z;
+            command.alpha = transparent ? 0.45f : 1.0f;
+            app.renderQueue.Submit(command);
+        };
+
+        submitCubeAt(app.cameraFocus.x, 0.5f, app.cameraFocus.z, Vec3{0.6f, 0.7f, 1.0f}, false);
+
+        vengine::FrameVector<const PlacedCube*> transparentCubes{vengine::ArenaAllocator<const PlacedCube*>(app.frameArena)};
+
+        Gles3OcclusionQueries queries(app, vp);
+        app.chunkOcclusion.BeginFrame(app.cameraEye.x, app.cameraEye.y, app.cameraEye.z);
+        app.cubeChunks.ForEachChunkInFrustum(frustum, 0.0f, [&](uint64_t key, const vengine::Aabb& bounds, const std::vector<uint32_t>& items) {
+            if (!app.chunkOcclusion.IsVisible(queries, key, bounds))
             {
-                const char quote = *ptr;
-                const char* start = ptr++;
-                while (ptr < lineEnd)
-                {
-                    if (*ptr == '\\' && (ptr + 1) < lineEnd)
-                    {
-                        ptr += 2;
-                        continue;
-                    }
-                    if (*ptr == quote)
-                    {
-                        ++ptr;
-                        break;
-                    }
-                    ++ptr;
-                }
-                RenderLuaToken(drawList, start, ptr, cursor, stringColor);
-                continue;
+                return;
             }
-            if (std::isdigit(static_cast<unsigned char>(*ptr)))
+            for (uint32_t index : items)
             {
-                const char* start = ptr++;
-                while (ptr < lineEnd && (std::isdigit(static_cast<unsigned char>(*ptr)) || *ptr == '.' || *ptr == 'x' || *ptr == 'X'))
+                const PlacedCube& cube = app.cubes[index];
+                if (!frustum.Intersects(vengine::CubeCellBounds(cube.gridX, 0, cube.gridZ)))
                 {
-                    ++ptr;
+                    continue;
                 }
-                RenderLuaToken(drawList, start, ptr, cursor, numberColor);
-                continue;
-            }
-            if (IsIdentifierChar(*ptr))
-            {
-                const char* start = ptr++;
-                while (ptr < lineEnd && IsIdentifierChar(*ptr))
+                if (cube.transparent)
                 {
-                    ++ptr;
+                    transparentCubes.push_back(&cube);
+                    continue;
                 }
-                std::string identifier(start, ptr);
-                const bool isKeyword = kLuaKeywords.find(identifier) != kLuaKeywords.end();
-                RenderLuaToken(drawList, start, ptr, cursor, isKeyword ? keywordColor : defaultColor);
-                continue;
+                submitCubeAt(static_cast<float>(cube.gridX), 0.5f, static_cast<float>(cube.gridZ), Vec3{cube.r, cube.g, cube.b}, false);
             }
-            RenderLuaToken(drawList, ptr, ptr + 1, cursor, defaultColor);
-            ++ptr;
+        });
+        app.renderQueue.Flush(backend);
+        // Opaque depth is complete; queue this frame's chunk tests and read them next frame.
+        app.chunkOcclusion.IssueQueries(queries);
+        app.chunkOcclusion.EndFrame(queries);
+
+        for (const PlacedCube* cube : transparentCubes)
+        {
+            submitCubeAt(static_cast<float>(cube->gridX), 0.5f, static_cast<float>(cube->gridZ), Vec3{cube->r, cube->g, cube->b}, true);
         }
+        SubmitGlowEffects(app, frustum);
+        app.renderQueue.Flush(backend);
     }
 
-    void RenderLuaHighlightedText(const std::string& text, const ImVec2& origin, const ImVec2& size)
+    // Draws the cached tokens of the lines inside the clip rect. Token offsets are measured once per
+    // line after it changes, so steady-state cost is one AddText per visible token.
+    void RenderLuaHighlightedText(vengine::LuaHighlightCache& cache, const std::string& text, const ImVec2& origin, const ImVec2& size)
     {
+        cache.Update(text);
+        cache.SetLayoutKey(ImGui::GetFont(), ImGui::GetFontSize());
+
         ImDrawList* drawList = ImGui::GetWindowDrawList();
         ImGuiStyle& style = ImGui::GetStyle();
-        ImVec2 cursor = ImVec2(origin.x + style.FramePadding.x, origin.y + style.FramePadding.y);
+        const ImVec2 cursor = ImVec2(origin.x + style.FramePadding.x, origin.y + style.FramePadding.y);
         const float lineHeight = ImGui::GetTextLineHeight();
-        const ImU32 defaultColor = ImGui::GetColorU32(ImGui::GetStyleColorVec4(ImGuiCol_Text));
-        const ImU32 keywordColor = ImGui::GetColorU32(ImVec4(0.70f, 0.55f, 1.0f, 1.0f));
-        const ImU32 stringColor = ImGui::GetColorU32(ImVec4(0.90f, 0.80f, 0.45f, 1.0f));
-        const ImU32 commentColor = ImGui::GetColorU32(ImVec4(0.45f, 0.80f, 0.45f, 1.0f));
-        const ImU32 numberColor = ImGui::GetColorU32(ImVec4(0.90f, 0.60f, 0.45f, 1.0f));
+        const ImU32 colors[] = {
+            ImGui::GetColorU32(ImGui::GetStyleColorVec4(ImGuiCol_Text)), // Default
+            ImGui::GetColorU32(ImVec4(0.70f, 0.55f, 1.0f, 1.0f)),      // Keyword
+            ImGui::GetColorU32(ImVec4(0.90f, 0.80f, 0.45f, 1.0f)),     // String
+            ImGui::GetColorU32(ImVec4(0.45f, 0.80f, 0.45f, 1.0f)),     // Comment
+            ImGui::GetColorU32(ImVec4(0.90f, 0.60f, 0.45f, 1.0f)),     // Number
+        };
 
         const ImVec2 clipMax = ImVec2(origin.x + size.x, origin.y + size.y);
         drawList->PushClipRect(origin, clipMax, true);
+        const ImVec2 visibleMin = drawList->GetClipRectMin();
+        const ImVec2 visibleMax = drawList->GetClipRectMax();
 
-        const char* ptr = text.c_str();
-        while (*ptr)
+        std::vector<vengine::LuaLine>& lines = cache.Lines();
+        const int firstLine = std::max(0, static_cast<int>(std::floor((visibleMin.y - cursor.y) / lineHeight)));
+        const int endLine = std::min(static_cast<int>(lines.size()), static_cast<int>(std::ceil((visibleMax.y - cursor.y) / lineHeight)));
+        for (int lineIndex = firstLine; lineIndex < endLine; ++lineIndex)
         {
-            const char* lineStart = ptr;
-            while (*ptr && *ptr != '\n')
+            vengine::LuaLine& line = lines[static_cast<size_t>(lineIndex)];
+            const char* lineText = text.data() + line.offset;
+            if (!line.measured)
             {
-                ++ptr;
+                float x = 0.0f;
+                const char* measuredEnd = lineText;
+                for (vengine::LuaToken& token : line.tokens)
+                {
+                    const char* tokenBegin = lineText + token.begin;
+                    x += ImGui::CalcTextSize(measuredEnd, tokenBegin, false).x;
+                    token.x = x;
+                    measuredEnd = tokenBegin + token.length;
+                    x += ImGui::CalcTextSize(tokenBegin, measuredEnd, false).x;
+                }
+                line.measured = true;
             }
-            const char* lineEnd = ptr;
-            ImVec2 lineCursor = cursor;
-            RenderLuaLineTokens(drawList, lineStart, lineEnd, lineCursor, defaultColor, keywordColor, stringColor, commentColor, numberColor);
-            cursor.y += lineHeight;
-            if (*ptr == '\n')
+
+            const float y = cursor.y + static_cast<float>(lineIndex) * lineHeight;
+            for (const vengine::LuaToken& token : line.tokens)
             {
-                ++ptr;
+                const float x = cursor.x + token.x;
+                if (x > visibleMax.x)
+                {
+                    break;
+                }
+                const char* tokenBegin = lineText + token.begin;
+                drawList->AddText(ImVec2(x, y), colors[static_cast<size_t>(token.kind)], tokenBegin, tokenBegin + token.length);
             }
-            else
+        }
+
+        drawList->PopClipRect();
+    }
+
+    // The Code panel's script sees the single ground layer of cubes; the camera focus stands in
+    // for the player. Edits are queued by the VM and applied here after each tick.
+    class AppScriptWorld : public vengine::ScriptWorldView
+    {
+    public:
+        explicit AppScriptWorld(const AppState& app)
+            : m_app(app)
+        {
+        }
+
+        int CubePresetAt(int x, int y, int z) const override
+        {
+            if (y != 0)
+            {
+                return -1;
+            }
+            for (const PlacedCube& cube : m_app.cubes)
+            {
+                if (cube.gridX == x && cube.gridZ == z)
+                {
+                    return cube.presetIndex;
+                }
+            }
+            return -1;
+        }
+
+        int CubeCount() const override
+        {
+            return static_cast<int>(m_app.cubes.size());
+        }
+
+        void PlayerPosition(float& x, float& y, float& z) const override
+        {
+            x = m_app.cameraFocus.x;
+            y = 0.0f;
+            z = m_app.cameraFocus.z;
+        }
+
+    private:
+        const AppState& m_app;
+    };
+
+    void ApplyScriptCommands(AppState& app)
+    {
+        for (const vengine::ScriptCommand& command : app.script.Commands())
+        {
+            switch (command.type)
+            {
+            case vengine::ScriptCommandType::PlaceCube:
             {
+                const bool inBounds = command.y == 0 && std::abs(command.x) <= 10 && std::abs(command.z) <= 10;
+                const bool validPreset = command.preset >= 0 && command.preset < static_cast<int>(std::size(kSpawnPresets));
+                const bool occupied = std::any_of(app.cubes.begin(), app.cubes.end(), [&](const PlacedCube& cube) {
+                    return cube.gridX == command.x && cube.gridZ == command.z;
+                });
+                if (inBounds && validPreset && !occupied)
+                {
+                    const SpawnPreset preset = GetPreset(command.preset);
+                    app.cubes.push_back({command.x, command.z, preset.r, preset.g, preset.b, preset.glowing, preset.transparent, command.preset});
+                    ++app.cubeLayoutVersion;
+                }
+                break;
+            }
+            case vengine::ScriptCommandType::RemoveCube:
+                if (command.y == 0)
+                {
+                    app.cubes.erase(std::remove_if(app.cubes.begin(), app.cubes.end(), [&](const PlacedCube& cube) {
+                                        return cube.gridX == command.x && cube.gridZ == command.z;
+                                    }),
+                                    app.cubes.end());
+                    ++app.cubeLayoutVersion;
+                }
+                break;
+            case vengine::ScriptCommandType::MovePlayer:
+                app.cameraFocus.x += command.px;
+                app.cameraFocus.z += command.pz;
+                break;
+            case vengine::ScriptCommandType::TeleportPlayer:
+                app.cameraFocus.x = command.px;
+                app.cameraFocus.z = command.pz;
                 break;
             }
         }
+        app.script.ClearCommands();
+    }
 
-        drawList->PopClipRect();
+    void ReloadScript(AppState& app)
+    {
+        if (app.script.Load(app.codeContent, "code", AppScriptWorld(app)))
+        {
+            ApplyScriptCommands(app);
+        }
+    }
+
+    // Scripts that error or exceed their frame budget are stopped; Save or Run starts them again.
+    void TickScript(AppState& app)
+    {
+        if (!app.scriptEnabled || !app.script.Loaded())
+        {
+            return;
+        }
+        if (app.script.Tick(app.deltaTime, AppScriptWorld(app)))
+        {
+            ApplyScriptCommands(app);
+        }
+        else
+        {
+            app.script.Unload();
+        }
     }
 
     void UpdateImGui(AppState& app)
     {
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplSDL2_NewFrame();
+        if (app.inputReplayer.Active())
+        {
+            ImGui::GetIO().DeltaTime = app.deltaTime;
+            // The backend polls the global cursor in NewFrame; queue the recorded one after it.
+            if (app.replayMouseKnown)
+            {
+                ImGui::GetIO().AddMousePosEvent(app.replayMouseX, app.replayMouseY);
+            }
+        }
         ImGui::NewFrame();
 
         ImGuiWindowFlags overlayFlags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
@@ -1446,9 +2191,23 @@ namespace
                 if (ImGui::Button("Save##CodePanel"))
                 {
                     app.codeDirty = false;
+                    ReloadScript(app);
                 }
                 ImGui::SameLine();
                 ImGui::TextUnformatted(app.codeDirty ? "Modified" : "Saved");
+                ImGui::SameLine();
+                if (ImGui::Checkbox("Run##CodePanel", &app.scriptEnabled) && app.scriptEnabled)
+                {
+                    ReloadScript(app);
+                }
+                if (!app.script.LastError().empty())
+                {
+                    ImGui::TextColored(ImVec4(0.95f, 0.45f, 0.45f, 1.0f), "%s", app.script.LastError().c_str());
+                }
+                else if (app.scriptEnabled && app.script.Loaded())
+                {
+                    ImGui::TextDisabled("tick: %u instructions, %.2f ms", app.script.LastInstructionCount(), app.script.LastMilliseconds());
+                }
                 ImGui::Spacing();
 
                 ImVec2 size = ImGui::GetContentRegionAvail();
@@ -1538,7 +2297,7 @@ namespace
                 {
                     app.codeDirty = true;
                 }
-                RenderLuaHighlightedText(app.codeContent, editorPos, size);
+                RenderLuaHighlightedText(app.codeHighlight, app.codeContent, editorPos, size);
             }
 
             ImGui::End();
@@ -1580,6 +2339,21 @@ namespace
                 }
                 ImGui::PopID();
             }
+            ImGui::Spacing();
+            if (ImGui::Checkbox("Occlusion culling", &app.occlusionCulling))
+            {
+                app.chunkOcclusion.SetEnabled(app.occlusionCulling);
+            }
+            ImGui::SameLine();
+            ImGui::TextDisabled("%d of %d chunks hidden", static_cast<int>(app.chunkOcclusion.LastOccludedChunkCount()),
+                                static_cast<int>(app.chunkOcclusion.LastTestedChunkCount()));
+            const vengine::RenderQueueStats& stats = app.renderQueue.FrameStats();
+            ImGui::TextDisabled("%d draws, %d state changes (program %d, VAO %d, texture %d, blend %d)",
+                                static_cast<int>(stats.draws), static_cast<int>(stats.StateChanges()),
+                                static_cast<int>(stats.programBinds), static_cast<int>(stats.vertexArrayBinds),
+                                static_cast<int>(stats.textureBinds), static_cast<int>(stats.blendChanges));
+            ImGui::TextDisabled("Frame: %d heap allocations, %.0f KB scratch", app.frameHeapAllocations,
+                                static_cast<double>(app.frameArena.LastFrameBytes()) / 1024.0);
             ImGui::End();
         }
 
@@ -1589,6 +2363,9 @@ namespace
             if (ImGui::Begin("Raytrace Preview", &app.showRaytrace, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoSavedSettings))
             {
                 ImGui::TextUnformatted("Path-traced lighting preview");
+                ImGui::SameLine();
+                ImGui::TextDisabled("%d cubes, %d / %d samples%s", app.raytraceCubeCount, app.raytraceSampleCount, kRaytraceMaxSamples,
+                                    app.raytraceFloatTarget ? "" : " (8-bit target)");
                 ImGui::Separator();
                 ImVec2 avail = ImGui::GetContentRegionAvail();
                 float aspect = static_cast<float>(app.raytraceHeight) > 0 ? static_cast<float>(app.raytraceWidth) / static_cast<float>(app.raytraceHeight) : 1.0f;
@@ -1610,8 +2387,11 @@ namespace
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
     }
 
-    void Cleanup(AppState& app)
+    void ReleaseGlResources(AppState& app)
     {
+        const Mat4 identity = Mat4::Identity();
+        Gles3OcclusionQueries queries(app, identity);
+        app.chunkOcclusion.Reset(queries);
         if (app.litProgram)
             glDeleteProgram(app.litProgram);
         if (app.gridProgram)
@@ -1644,6 +2424,15 @@ namespace
             glDeleteTextures(1, &app.raytraceTexture);
         if (app.raytraceFbo)
             glDeleteFramebuffers(1, &app.raytraceFbo);
+        if (app.raytraceVoxelTexture)
+            glDeleteTextures(1, &app.raytraceVoxelTexture);
+        if (app.raytraceLightTexture)
+            glDeleteTextures(1, &app.raytraceLightTexture);
+    }
+
+    void Cleanup(AppState& app)
+    {
+        ReleaseGlResources(app);
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplSDL2_Shutdown();
         ImGui::DestroyContext();
@@ -1654,34 +2443,579 @@ namespace
         SDL_Quit();
     }
 
+#if defined(VENGINE_GOLDEN_HARNESS)
+#ifndef VENGINE_GOLDEN_DEFAULT_MANIFEST
+#define VENGINE_GOLDEN_DEFAULT_MANIFEST "golden/cases.txt"
+#endif
+
+    // Golden-image regression runs (the vengine_golden target). Each case loads a scene, frames it
+    // with the orbit camera and renders it through RenderScene into an offscreen target on a
+    // headless EGL context (Mesa llvmpipe in CI). The last frame is compared to a stored PNG and
+    // the frame times are reported alongside, so one run checks a renderer change for both output
+    // and speed.
+    struct GoldenCase
+    {
+        std::string name;
+        std::string scenePath;
+        float focusX = 0.0f;
+        float focusZ = 0.0f;
+        float distance = 8.0f;
+        int width = 320;
+        int height = 180;
+    };
+
+    struct GoldenOptions
+    {
+        std::string manifestPath = VENGINE_GOLDEN_DEFAULT_MANIFEST;
+        std::string outputDir = ".";
+        std::string reportPath;
+        int tolerance = 2;              // Per-channel difference still counted as a match.
+        double maxBadFraction = 0.001;  // Share of pixels allowed outside the tolerance.
+        int warmupFrames = 3;           // Occlusion results land a frame late; let them settle.
+        int timedFrames = 30;
+        bool update = false;
+    };
+
+    std::string DirectoryOf(const std::string& path)
+    {
+        const size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+    }
+
+    // One case per line: name scene focusX focusZ distance width height. '#' starts a comment.
+    bool LoadGoldenManifest(const std::string& path, std::vector<GoldenCase>& cases, std::string& errorMessage)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            errorMessage = "Unable to open " + path;
+            return false;
+        }
+        const std::string baseDir = DirectoryOf(path);
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line))
+        {
+            ++lineNumber;
+            const size_t comment = line.find('#');
+            if (comment != std::string::npos)
+            {
+                line.erase(comment);
+            }
+            std::istringstream iss(line);
+            GoldenCase entry;
+            if (!(iss >> entry.name))
+            {
+                continue;
+            }
+            if (!(iss >> entry.scenePath >> entry.focusX >> entry.focusZ >> entry.distance >> entry.width >> entry.height) || entry.width <= 0 ||
+                entry.height <= 0)
+            {
+                errorMessage = path + ":" + std::to_string(lineNumber) + ": expected name scene focusX focusZ distance width height";
+                return false;
+            }
+            entry.scenePath = baseDir + "/" + entry.scenePath;
+            cases.push_back(std::move(entry));
+        }
+        return true;
+    }
+
+    struct HeadlessContext
+    {
+        EGLDisplay display = EGL_NO_DISPLAY;
+        EGLSurface surface = EGL_NO_SURFACE;
+        EGLContext context = EGL_NO_CONTEXT;
+    };
+
+    // Prefers Mesa's surfaceless platform, which needs no display server; otherwise falls back to
+    // the default display with a 1x1 pbuffer. Rendering always goes to an FBO either way.
+    bool CreateHeadlessContext(HeadlessContext& ctx, std::string& errorMessage)
+    {
+        const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay && clientExtensions && std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless"))
+        {
+            ctx.display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if (ctx.display == EGL_NO_DISPLAY)
+        {
+            ctx.display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        if (ctx.display == EGL_NO_DISPLAY || !eglInitialize(ctx.display, nullptr, nullptr))
+        {
+            errorMessage = "No EGL display";
+            return false;
+        }
+        eglBindAPI(EGL_OPENGL_ES_API);
+
+        const EGLint configAttribs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR, EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8,
+                                        EGL_BLUE_SIZE, 8, EGL_NONE};
+        EGLConfig config = nullptr;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(ctx.display, configAttribs, &config, 1, &configCount) || configCount == 0)
+        {
+            errorMessage = "No EGL config with OpenGL ES 3 and pbuffer support";
+            return false;
+        }
+        const EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
+        ctx.context = eglCreateContext(ctx.display, config, EGL_NO_CONTEXT, contextAttribs);
+        if (ctx.context == EGL_NO_CONTEXT)
+        {
+            errorMessage = "eglCreateContext failed";
+            return false;
+        }
+        const EGLint pbufferAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        ctx.surface = eglCreatePbufferSurface(ctx.display, config, pbufferAttribs);
+        if (!eglMakeCurrent(ctx.display, ctx.surface, ctx.surface, ctx.context))
+        {
+            errorMessage = "eglMakeCurrent failed";
+            return false;
+        }
+        return true;
+    }
+
+    void DestroyHeadlessContext(HeadlessContext& ctx)
+    {
+        if (ctx.display == EGL_NO_DISPLAY)
+        {
+            return;
+        }
+        eglMakeCurrent(ctx.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (ctx.context != EGL_NO_CONTEXT)
+            eglDestroyContext(ctx.display, ctx.context);
+        if (ctx.surface != EGL_NO_SURFACE)
+            eglDestroySurface(ctx.display, ctx.surface);
+        eglTerminate(ctx.display);
+        ctx = HeadlessContext{};
+    }
+
+    struct OffscreenTarget
+    {
+        GLuint fbo = 0;
+        GLuint color = 0;
+        GLuint depth = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    bool ResizeOffscreenTarget(OffscreenTarget& target, int width, int height)
+    {
+        if (target.fbo && target.width == width && target.height == height)
+        {
+            return true;
+        }
+        if (!target.fbo)
+        {
+            glGenFramebuffers(1, &target.fbo);
+            glGenRenderbuffers(1, &target.color);
+            glGenRenderbuffers(1, &target.depth);
+        }
+        glBindRenderbuffer(GL_RENDERBUFFER, target.color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, target.depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.color);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target.depth);
+        target.width = width;
+        target.height = height;
+        return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    void DestroyOffscreenTarget(OffscreenTarget& target)
+    {
+        if (target.fbo)
+            glDeleteFramebuffers(1, &target.fbo);
+        if (target.color)
+            glDeleteRenderbuffers(1, &target.color);
+        if (target.depth)
+            glDeleteRenderbuffers(1, &target.depth);
+        target = OffscreenTarget{};
+    }
+
+    // WebGL cubes have no height; any gridY in the scene file is ignored.
+    void LoadGoldenScene(AppState& app, const std::vector<vengine::SceneCube>& records)
+    {
+        app.cubes.clear();
+        app.cubes.reserve(records.size());
+        for (const vengine::SceneCube& record : records)
+        {
+            PlacedCube cube{record.gridX, record.gridZ, record.r, record.g, record.b};
+            cube.glowing = record.glowing;
+            cube.transparent = record.transparent;
+            cube.presetIndex = std::max(0, record.presetIndex);
+            app.cubes.push_back(cube);
+        }
+        ++app.cubeLayoutVersion;
+    }
+
+    // Rows come back bottom-up from GL; the result is top row first like the PNGs.
+    std::vector<uint8_t> ReadFramePixels(int width, int height)
+    {
+        const size_t rowBytes = static_cast<size_t>(width) * 4u;
+        std::vector<uint8_t> raw(rowBytes * static_cast<size_t>(height));
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, raw.data());
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        std::vector<uint8_t> pixels(raw.size());
+        for (int y = 0; y < height; ++y)
+        {
+            std::memcpy(&pixels[static_cast<size_t>(y) * rowBytes], &raw[static_cast<size_t>(height - 1 - y) * rowBytes], rowBytes);
+        }
+        return pixels;
+    }
+
+    struct ImageDifference
+    {
+        size_t badPixels = 0;
+        int maxDelta = 0;
+    };
+
+    // Colour channels only; the offscreen target's alpha is not part of the picture. diffImage
+    // shows the actual frame dimmed with out-of-tolerance pixels in red.
+    ImageDifference CompareFrames(const std::vector<uint8_t>& actual, const std::vector<uint8_t>& golden, int tolerance, std::vector<uint8_t>& diffImage)
+    {
+        ImageDifference result;
+        diffImage.assign(actual.size(), 255);
+        for (size_t i = 0; i + 3 < actual.size(); i += 4)
+        {
+            int delta = 0;
+            for (size_t c = 0; c < 3; ++c)
+            {
+                delta = std::max(delta, std::abs(static_cast<int>(actual[i + c]) - static_cast<int>(golden[i + c])));
+            }
+            result.maxDelta = std::max(result.maxDelta, delta);
+            const bool bad = delta > tolerance;
+            result.badPixels += bad ? 1 : 0;
+            for (size_t c = 0; c < 3; ++c)
+            {
+                diffImage[i + c] = static_cast<uint8_t>(actual[i + c] / 4);
+            }
+            if (bad)
+            {
+                diffImage[i] = static_cast<uint8_t>(std::min(255, 96 + delta * 4));
+            }
+        }
+        return result;
+    }
+
+    struct FrameTimings
+    {
+        double mean = 0.0;
+        double median = 0.0;
+        double p95 = 0.0;
+        double max = 0.0;
+    };
+
+    FrameTimings SummarizeTimings(std::vector<double> samples)
+    {
+        FrameTimings timings;
+        if (samples.empty())
+        {
+            return timings;
+        }
+        std::sort(samples.begin(), samples.end());
+        double total = 0.0;
+        for (double sample : samples)
+        {
+            total += sample;
+        }
+        timings.mean = total / static_cast<double>(samples.size());
+        timings.median = samples[samples.size() / 2];
+        timings.p95 = samples[std::min(samples.size() - 1, (samples.size() * 95) / 100)];
+        timings.max = samples.back();
+        return timings;
+    }
+
+    bool ParseGoldenOptions(int argc, char** argv, GoldenOptions& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--update")
+                options.update = true;
+            else if (arg == "--out" && hasValue)
+                options.outputDir = argv[++i];
+            else if (arg == "--report" && hasValue)
+                options.reportPath = argv[++i];
+            else if (arg == "--tolerance" && hasValue)
+                options.tolerance = std::max(0, std::atoi(argv[++i]));
+            else if (arg == "--max-bad" && hasValue)
+                options.maxBadFraction = std::max(0.0, std::atof(argv[++i]));
+            else if (arg == "--frames" && hasValue)
+                options.timedFrames = std::max(1, std::atoi(argv[++i]));
+            else if (!arg.empty() && arg[0] != '-')
+                options.manifestPath = arg;
+            else
+            {
+                std::fprintf(stderr,
+                             "usage: vengine_golden [manifest] [--update] [--out dir] [--report timings.csv] [--tolerance N] [--max-bad fraction] "
+                             "[--frames N]\n");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int RunGoldenHarness(int argc, char** argv)
+    {
+        GoldenOptions options;
+        if (!ParseGoldenOptions(argc, argv, options))
+        {
+            return 2;
+        }
+        std::vector<GoldenCase> cases;
+        std::string error;
+        if (!LoadGoldenManifest(options.manifestPath, cases, error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+
+        HeadlessContext context;
+        if (!CreateHeadlessContext(context, error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+        std::printf("GL_RENDERER: %s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+
+        AppState app{};
+        app.scriptEnabled = false;
+        CreateBackground(app);
+        CreateCube(app);
+        CreateGrid(app, 10, 1.0f);
+        CreateGlowGeometry(app);
+
+        const std::string imageDir = DirectoryOf(options.manifestPath) + "/images";
+        OffscreenTarget target;
+        std::string report = "case,cubes,frames,mean_ms,median_ms,p95_ms,max_ms,bad_pixels,max_delta,result\n";
+        int failures = 0;
+        std::printf("%-20s %7s %9s %9s %9s  %s\n", "case", "cubes", "median", "p95", "max", "result");
+        for (const GoldenCase& entry : cases)
+        {
+            std::vector<vengine::SceneCube> records;
+            if (!vengine::LoadSceneFile(entry.scenePath, records, error))
+            {
+                std::fprintf(stderr, "%s: %s\n", entry.name.c_str(), error.c_str());
+                ++failures;
+                continue;
+            }
+            LoadGoldenScene(app, records);
+            app.windowWidth = entry.width;
+            app.windowHeight = entry.height;
+            app.cameraFocus = Vec3{entry.focusX, 0.0f, entry.focusZ};
+            app.cameraDistance = entry.distance;
+            app.deltaTime = 0.0f;
+            UpdateCamera(app);
+            if (!ResizeOffscreenTarget(target, entry.width, entry.height))
+            {
+                std::fprintf(stderr, "%s: offscreen target incomplete\n", entry.name.c_str());
+                ++failures;
+                continue;
+            }
+
+            std::vector<double> frameMs;
+            frameMs.reserve(static_cast<size_t>(options.timedFrames));
+            for (int frame = 0; frame < options.warmupFrames + options.timedFrames; ++frame)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+                glViewport(0, 0, entry.width, entry.height);
+                glEnable(GL_DEPTH_TEST);
+                glClearColor(0.05f, 0.06f, 0.10f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                RenderScene(app);
+                glFinish();
+                if (frame >= options.warmupFrames)
+                {
+                    frameMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                }
+            }
+            const FrameTimings timings = SummarizeTimings(frameMs);
+            const std::vector<uint8_t> actual = ReadFramePixels(entry.width, entry.height);
+
+            const std::string goldenPath = imageDir + "/" + entry.name + ".png";
+            std::string result;
+            ImageDifference difference;
+            vengine::DecodedImage golden;
+            std::string goldenError;
+            if (options.update)
+            {
+                result = vengine::SavePngFile(goldenPath, actual.data(), entry.width, entry.height, error) ? "updated" : "write-failed";
+            }
+            else if (!vengine::LoadPngFile(goldenPath, golden, goldenError))
+            {
+                result = "missing-golden";
+            }
+            else if (golden.width != entry.width || golden.height != entry.height)
+            {
+                result = "size-mismatch";
+            }
+            else
+            {
+                vengine::ConvertPixelOrder(golden, vengine::PixelOrder::Rgba);
+                std::vector<uint8_t> diffImage;
+                difference = CompareFrames(actual, golden.pixels, options.tolerance, diffImage);
+                const double badFraction = static_cast<double>(difference.badPixels) / (static_cast<double>(entry.width) * static_cast<double>(entry.height));
+                result = badFraction <= options.maxBadFraction ? "pass" : "FAIL";
+                if (result != "pass")
+                {
+                    vengine::SavePngFile(options.outputDir + "/" + entry.name + ".actual.png", actual.data(), entry.width, entry.height, error);
+                    vengine::SavePngFile(options.outputDir + "/" + entry.name + ".diff.png", diffImage.data(), entry.width, entry.height, error);
+                }
+            }
+            if (result != "pass" && result != "updated")
+            {
+                ++failures;
+            }
+
+            std::printf("%-20s %7zu %7.2fms %7.2fms %7.2fms  %s", entry.name.c_str(), app.cubes.size(), timings.median, timings.p95, timings.max, result.c_str());
+            if (difference.badPixels > 0)
+            {
+                std::printf(" (%zu px over tolerance, max delta %d)", difference.badPixels, difference.maxDelta);
+            }
+            std::printf("\n");
+            char row[256];
+            std::snprintf(row, sizeof(row), "%s,%zu,%zu,%.3f,%.3f,%.3f,%.3f,%zu,%d,%s\n", entry.name.c_str(), app.cubes.size(), frameMs.size(), timings.mean,
+                          timings.median, timings.p95, timings.max, difference.badPixels, difference.maxDelta, result.c_str());
+            report += row;
+        }
+
+        if (!options.reportPath.empty())
+        {
+            std::ofstream file(options.reportPath, std::ios::binary | std::ios::trunc);
+            file << report;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        DestroyOffscreenTarget(target);
+        ReleaseGlResources(app);
+        DestroyHeadlessContext(context);
+        std::printf("%zu cases, %d failed\n", cases.size(), failures);
+        return failures == 0 ? 0 : 1;
+    }
+#endif
+
     AppState* g_app = nullptr;
 
-#if defined(__EMSCRIPTEN__)
-    void MainLoop()
+#if !defined(VENGINE_GOLDEN_HARNESS)
+    void ParseInputReplayArguments(AppState& app, int argc, char** argv)
     {
-        AppState& app = *g_app;
+        float replayDeltaTime = 0.0f;
+        for (int i = 1; i + 1 < argc; ++i)
+        {
+            const std::string argument = argv[i];
+            if (argument == "--record")
+            {
+                app.inputRecordPath = argv[++i];
+            }
+            else if (argument == "--replay")
+            {
+                app.inputReplayPath = argv[++i];
+            }
+            else if (argument == "--replay-dt")
+            {
+                replayDeltaTime = std::strtof(argv[++i], nullptr);
+            }
+        }
+
+        std::string error;
+        if (!app.inputReplayPath.empty() && !app.inputReplayer.Start(app.inputReplayPath, vengine::InputSource::Sdl, replayDeltaTime, error))
+        {
+            SDL_Log("input replay: %s", error.c_str());
+            app.inputReplayPath.clear();
+        }
+        if (app.inputReplayer.Active())
+        {
+            // Mouse picking only lines up at the recorded window size.
+            app.windowWidth = std::max(1, static_cast<int>(app.inputReplayer.Recording().viewportWidth));
+            app.windowHeight = std::max(1, static_cast<int>(app.inputReplayer.Recording().viewportHeight));
+        }
+        else if (!app.inputRecordPath.empty())
+        {
+            app.inputRecorder.Start(vengine::InputSource::Sdl, app.windowWidth, app.windowHeight);
+        }
+    }
+
+    // Writes the recording, or the replay's per-frame timings next to the replayed file.
+    void FinishInputSession(AppState& app)
+    {
+        std::string error;
+        if (app.inputRecorder.Active() && !app.inputRecorder.Stop(app.inputRecordPath, error))
+        {
+            SDL_Log("input recording: %s", error.c_str());
+        }
+        if (!app.inputReplayPath.empty())
+        {
+            if (app.inputReplayer.WriteTimingReport(app.inputReplayPath + ".timings.csv", error))
+            {
+                SDL_Log("input replay: %s", app.inputReplayer.TimingSummary().c_str());
+            }
+            else
+            {
+                SDL_Log("input replay: %s", error.c_str());
+            }
+            app.inputReplayPath.clear();
+        }
+    }
+
+    // Returns false when the app should quit.
+    bool RunFrame(AppState& app)
+    {
+        app.frameStart = std::chrono::steady_clock::now();
+        const uint64_t heapAllocations = vengine::ThreadHeapAllocationCount();
+        app.frameHeapAllocations = static_cast<int>(heapAllocations - app.frameHeapAllocationMark);
+        app.frameHeapAllocationMark = heapAllocations;
+        app.frameArena.Reset();
         if (!HandleEvents(app))
         {
-            emscripten_cancel_main_loop();
-            return;
+            return false;
         }
         const double now = SDL_GetTicks() / 1000.0;
-        app.deltaTime = static_cast<float>(now - app.previousTime);
+        app.deltaTime = app.inputReplayer.Active() ? app.inputReplayer.FixedDeltaTime() : static_cast<float>(now - app.previousTime);
         app.previousTime = now;
         UpdateCamera(app);
+        TickScript(app);
+        AccumulateRaytracedScene(app);
         glViewport(0, 0, app.windowWidth, app.windowHeight);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         RenderScene(app);
         UpdateImGui(app);
         SDL_GL_SwapWindow(app.window);
+        if (app.inputReplayer.Active())
+        {
+            app.inputReplayer.AddFrameTime(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - app.frameStart).count());
+        }
+        return true;
+    }
+
+#if defined(__EMSCRIPTEN__)
+    void MainLoop()
+    {
+        AppState& app = *g_app;
+        if (!RunFrame(app))
+        {
+            FinishInputSession(app);
+            emscripten_cancel_main_loop();
+        }
     }
 #endif
+#endif
 } // namespace
 
-int main(int, char**)
+#if defined(VENGINE_GOLDEN_HARNESS)
+int main(int argc, char** argv)
+{
+    return RunGoldenHarness(argc, argv);
+}
+#else
+int main(int argc, char** argv)
 {
     AppState app{};
     g_app = &app;
+    ParseInputReplayArguments(app, argc, argv);
 
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0)
     {
@@ -1743,28 +3077,18 @@ int main(int, char**)
 #endif
 
     app.previousTime = SDL_GetTicks() / 1000.0;
+    ReloadScript(app);
 
 #if defined(__EMSCRIPTEN__)
     emscripten_set_main_loop(MainLoop, 0, 1);
 #else
-    while (app.running)
+    while (app.running && RunFrame(app))
     {
-        if (!HandleEvents(app))
-        {
-            break;
-        }
-        const double now = SDL_GetTicks() / 1000.0;
-        app.deltaTime = static_cast<float>(now - app.previousTime);
-        app.previousTime = now;
-        UpdateCamera(app);
-        glViewport(0, 0, app.windowWidth, app.windowHeight);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        RenderScene(app);
-        UpdateImGui(app);
-        SDL_GL_SwapWindow(app.window);
     }
+    FinishInputSession(app);
 #endif
 
     Cleanup(app);
     return 0;
 }
+#endif